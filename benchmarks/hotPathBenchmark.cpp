@@ -0,0 +1,635 @@
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <iostream>
+#include <fstream>
+#include <random>
+
+#include "microBenchmark.cpp"
+
+#include "../lib/Jobs/jobSystem.cpp"
+#include "../lib/Profiler/profiler.cpp"
+#include "../lib/Shader/shaderPreprocessor.cpp"
+#include "../lib/Texture/stb_image.cpp"
+#include "../lib/Camera/camera.cpp"
+#include "../lib/ECS/ecs.cpp"
+#include "../lib/ECS/components.h"
+#include "../lib/Math/batchMath.cpp"
+#include "../lib/Scene/transformHierarchy.cpp"
+#include "../lib/Culling/frustum.cpp"
+#include "../lib/Culling/entityCuller.cpp"
+#include "../lib/Render/commandList.cpp"
+#include "../lib/Render/renderQueue.cpp"
+#include "../lib/Platform/mappedFile.cpp"
+#include "../lib/Platform/asyncFileReader.cpp"
+#include "../lib/Mesh/mesh.cpp"
+#include "../lib/Mesh/objLoader.cpp"
+#include "../lib/Mesh/bakedMesh.cpp"
+
+/*  Micro benchmarks of the CPU side hot paths, no GL context needed.
+    Run from the repository root so the asset and shader paths resolve:
+
+        hotPathBenchmark [--filter NAME] [--repetitions N] [--min-time SECONDS] [--json FILE] */
+
+// Decoded by the image benchmarks, in the order of their arguments
+const char* imageAssets[] = {
+    "assets/Textures/wood_container.jpg",
+    "assets/Textures/awesome_face.png",
+    "assets/Textures/diffuse_wood_container.png",
+    "assets/Textures/specular_wood_container.png"
+};
+
+// Shared by every benchmark using jobs, created on first use
+JobSystem &getJobSystem()
+{
+    static JobSystem jobSystem;
+    return jobSystem;
+}
+
+std::vector<unsigned char> readFile(const char* path)
+{
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<unsigned char>((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+// Scatters `count` unit cubes over a square field, the same layout as the stress scenes
+void populateField(const uint32_t count, World &world, TransformHierarchy &hierarchy)
+{
+    const MeshRef cubeMesh = { 1, 0, 36, false };
+    const MaterialRef material = { 1, 1, 2, 32.0f };
+    const Bounds cubeBounds = { glm::vec3(0.0f), glm::vec3(0.5f) };
+
+    uint32_t side = (uint32_t)std::ceil(std::sqrt((float)count));
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        glm::vec3 position = glm::vec3((i % side) * 2.0f - side, -2.0f, side - (i / side) * 2.0f);
+
+        SceneNode node = { hierarchy.createNode(InvalidNode, position) };
+        world.createEntity(Transform { position, glm::vec3(0.0f), glm::vec3(1.0f) }, node, cubeMesh, material, cubeBounds);
+    }
+
+    hierarchy.update();
+}
+
+/* Camera */
+
+void cameraGetViewMatrix(BenchmarkState &state)
+{
+    Camera camera;
+    while (state.keepRunning())
+    {
+        doNotOptimize(camera.getViewMatrix());
+        clobberMemory();
+    }
+}
+MICRO_BENCHMARK(cameraGetViewMatrix);
+
+void cameraProcessMouseMovement(BenchmarkState &state)
+{
+    Camera camera;
+    float direction = 1.0f;
+    while (state.keepRunning())
+    {
+        // Sweep back and forth so the pitch clamp doesn't turn it into a no-op
+        camera.processMouseMovement(3.0f * direction, 1.5f * direction);
+        direction = -direction;
+        doNotOptimize(camera.front);
+    }
+}
+MICRO_BENCHMARK(cameraProcessMouseMovement);
+
+// The per cube matrix main.cpp's getMVPMatrix builds
+void mvpMatrix(BenchmarkState &state)
+{
+    Camera camera;
+    glm::vec3 position(1.5f, 0.2f, -1.5f);
+    float time = 0.0f;
+
+    while (state.keepRunning())
+    {
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), position);
+        model = glm::rotate(model, time * glm::radians(-55.0f), glm::vec3(1.0f, 1.0f, 0.0f));
+
+        glm::mat4 view = camera.getViewMatrix();
+        glm::mat4 proj = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f);
+
+        doNotOptimize(proj * view * model);
+        time += 0.016f;
+    }
+}
+MICRO_BENCHMARK(mvpMatrix);
+
+/* Image decoding */
+
+// stbi_load as Texture::decode calls it, including reading the file
+void stbiLoad(BenchmarkState &state)
+{
+    const char* path = imageAssets[state.arg()];
+    std::vector<unsigned char> file = readFile(path);
+    if (file.empty())
+    {
+        state.skip(std::string("missing ") + path);
+        return;
+    }
+
+    while (state.keepRunning())
+    {
+        int width, height, channels;
+        unsigned char* pixels = stbi_load(path, &width, &height, &channels, 0);
+        doNotOptimize(pixels);
+        stbi_image_free(pixels);
+    }
+
+    state.setBytesProcessed(file.size() * state.getIterations());
+    state.setLabel(path);
+}
+MICRO_BENCHMARK(stbiLoad)->arg(0)->arg(1)->arg(2)->arg(3);
+
+// Decoding alone, from a file already in memory
+void stbiLoadFromMemory(BenchmarkState &state)
+{
+    const char* path = imageAssets[state.arg()];
+    std::vector<unsigned char> file = readFile(path);
+    if (file.empty())
+    {
+        state.skip(std::string("missing ") + path);
+        return;
+    }
+
+    while (state.keepRunning())
+    {
+        int width, height, channels;
+        unsigned char* pixels = stbi_load_from_memory(file.data(), file.size(), &width, &height, &channels, 0);
+        doNotOptimize(pixels);
+        stbi_image_free(pixels);
+    }
+
+    state.setBytesProcessed(file.size() * state.getIterations());
+    state.setLabel(path);
+}
+MICRO_BENCHMARK(stbiLoadFromMemory)->arg(0)->arg(1)->arg(2)->arg(3);
+
+/* Shader sources */
+
+// Everything Shader::Shader does before handing the source to the driver
+void shaderPreprocess(BenchmarkState &state)
+{
+    const ShaderDefines defines = { { "POINT_LIGHTS", "4" }, { "SHADOWS", "" } };
+    if (ShaderPreprocessor::process("shaders/lighting.frag", defines).empty())
+    {
+        state.skip("missing shaders/lighting.frag");
+        return;
+    }
+
+    size_t bytes = 0;
+    while (state.keepRunning())
+    {
+        std::string source = ShaderPreprocessor::process("shaders/lighting.frag", defines);
+        bytes += source.size();
+        doNotOptimize(source.data());
+    }
+
+    state.setBytesProcessed(bytes);
+}
+MICRO_BENCHMARK(shaderPreprocess);
+
+// The permutation and program keys ShaderCache computes
+void shaderSourceHash(BenchmarkState &state)
+{
+    std::string source = ShaderPreprocessor::process("shaders/lighting.frag", ShaderDefines());
+    if (source.empty())
+    {
+        state.skip("missing shaders/lighting.frag");
+        return;
+    }
+
+    while (state.keepRunning())
+        doNotOptimize(ShaderPreprocessor::hash(source));
+
+    state.setBytesProcessed(source.size() * state.getIterations());
+}
+MICRO_BENCHMARK(shaderSourceHash);
+
+/* Culling and transforms */
+
+void frustumExtract(BenchmarkState &state)
+{
+    Camera camera;
+    glm::mat4 viewProj = camera.getProjectionMatrix(800.0f / 600.0f) * camera.getViewMatrix();
+
+    while (state.keepRunning())
+    {
+        Frustum frustum(viewProj);
+        doNotOptimize(frustum.planes);
+    }
+}
+MICRO_BENCHMARK(frustumExtract);
+
+void frustumContainsAABB(BenchmarkState &state)
+{
+    const size_t count = state.arg();
+
+    Camera camera;
+    Frustum frustum(camera.getProjectionMatrix(800.0f / 600.0f) * camera.getViewMatrix());
+
+    // Seeded so roughly the same share of boxes is visible in every run
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> coordinate(-60.0f, 60.0f);
+    std::vector<glm::vec3> centers(count);
+    for (glm::vec3 &center : centers)
+        center = glm::vec3(coordinate(random), coordinate(random), coordinate(random));
+
+    while (state.keepRunning())
+    {
+        uint32_t visible = 0;
+        for (const glm::vec3 &center : centers)
+            visible += frustum.containsAABB(center, glm::vec3(0.5f));
+        doNotOptimize(visible);
+    }
+
+    state.setItemsProcessed(count * state.getIterations());
+}
+MICRO_BENCHMARK(frustumContainsAABB)->arg(1024)->arg(65536);
+
+void cullEntitiesField(BenchmarkState &state)
+{
+    World world;
+    TransformHierarchy hierarchy;
+    hierarchy.jobSystem = &getJobSystem();
+    populateField(state.arg(), world, hierarchy);
+
+    Camera camera;
+    camera.pos = glm::vec3(0.0f, 4.0f, 0.0f);
+    Frustum frustum(camera.getProjectionMatrix(800.0f / 600.0f) * camera.getViewMatrix());
+
+    std::vector<Entity> visible;
+    while (state.keepRunning())
+    {
+        cullEntities(world, hierarchy, frustum, getJobSystem(), visible);
+        doNotOptimize(visible.data());
+    }
+
+    state.setItemsProcessed(state.arg() * state.getIterations());
+}
+MICRO_BENCHMARK(cullEntitiesField)->arg(10000)->arg(100000);
+
+// Every node moved every frame, the worst case for the dirty tracking
+void transformHierarchyUpdate(BenchmarkState &state)
+{
+    const uint32_t count = state.arg();
+
+    TransformHierarchy hierarchy;
+    hierarchy.jobSystem = &getJobSystem();
+
+    // Chains of four, so depth levels and parent lookups are part of the work
+    std::vector<NodeHandle> roots;
+    NodeHandle parent = InvalidNode;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        parent = hierarchy.createNode(i % 4 == 0 ? InvalidNode : parent, glm::vec3(1.0f, 0.0f, 0.0f));
+        if (i % 4 == 0)
+            roots.push_back(parent);
+    }
+    hierarchy.update();
+
+    float offset = 0.0f;
+    while (state.keepRunning())
+    {
+        state.pauseTiming();
+        offset += 0.01f;
+        for (NodeHandle root : roots)
+            hierarchy.setPosition(root, glm::vec3(offset, 0.0f, 0.0f));
+        state.resumeTiming();
+
+        hierarchy.update();
+    }
+
+    state.setItemsProcessed((uint64_t)count * state.getIterations());
+}
+MICRO_BENCHMARK(transformHierarchyUpdate)->arg(1024)->arg(65536);
+
+/* Batch math, the argument is the SimdLevel */
+
+const size_t batchMathCount = 100000;
+
+// Sets the level for the benchmark, false when the CPU can't run it
+bool selectSimdLevel(BenchmarkState &state)
+{
+    SimdLevel level = (SimdLevel)state.arg();
+    if (level > BatchMath::getSupportedLevel())
+    {
+        state.skip(std::string(BatchMath::getLevelName(level)) + " not supported");
+        return false;
+    }
+
+    BatchMath::setLevel(level);
+    return true;
+}
+
+std::vector<glm::mat4> randomMatrices(const size_t count)
+{
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+
+    std::vector<glm::mat4> matrices(count);
+    for (glm::mat4 &matrix : matrices)
+        for (int column = 0; column < 4; ++column)
+            matrix[column] = glm::vec4(value(random), value(random), value(random), column == 3 ? 1.0f : 0.0f);
+    return matrices;
+}
+
+// viewProjection * model for every instance
+void batchMultiply(BenchmarkState &state)
+{
+    if (!selectSimdLevel(state))
+        return;
+
+    Camera camera;
+    glm::mat4 viewProjection = camera.getProjectionMatrix(800.0f / 600.0f) * camera.getViewMatrix();
+    std::vector<glm::mat4> models = randomMatrices(batchMathCount);
+    std::vector<glm::mat4> mvps(batchMathCount);
+
+    while (state.keepRunning())
+    {
+        BatchMath::multiply(viewProjection, models.data(), mvps.data(), batchMathCount);
+        doNotOptimize(mvps.data());
+        clobberMemory();
+    }
+
+    state.setItemsProcessed(batchMathCount * state.getIterations());
+    BatchMath::setLevel(BatchMath::getSupportedLevel());
+}
+MICRO_BENCHMARK(batchMultiply)->arg(0)->arg(1)->arg(2)->arg(3);
+
+void batchTransformPointsSoA(BenchmarkState &state)
+{
+    if (!selectSimdLevel(state))
+        return;
+
+    glm::mat4 matrix = randomMatrices(1)[0];
+    std::vector<float> x(batchMathCount, 1.0f), y(batchMathCount, 2.0f), z(batchMathCount, 3.0f);
+    std::vector<float> outX(batchMathCount), outY(batchMathCount), outZ(batchMathCount);
+
+    while (state.keepRunning())
+    {
+        BatchMath::transformPoints(matrix, x.data(), y.data(), z.data(), outX.data(), outY.data(), outZ.data(), batchMathCount);
+        doNotOptimize(outX.data());
+        clobberMemory();
+    }
+
+    state.setItemsProcessed(batchMathCount * state.getIterations());
+    BatchMath::setLevel(BatchMath::getSupportedLevel());
+}
+MICRO_BENCHMARK(batchTransformPointsSoA)->arg(0)->arg(1)->arg(2)->arg(3);
+
+// The world space bounds cullEntities computes
+void batchTransformAABBs(BenchmarkState &state)
+{
+    if (!selectSimdLevel(state))
+        return;
+
+    std::vector<glm::mat4> matrices = randomMatrices(batchMathCount);
+    std::vector<Bounds> local(batchMathCount, Bounds { glm::vec3(0.0f), glm::vec3(0.5f) });
+    std::vector<Bounds> world(batchMathCount);
+
+    while (state.keepRunning())
+    {
+        BatchMath::transformAABBs(matrices.data(), local.data(), world.data(), batchMathCount);
+        doNotOptimize(world.data());
+        clobberMemory();
+    }
+
+    state.setItemsProcessed(batchMathCount * state.getIterations());
+    BatchMath::setLevel(BatchMath::getSupportedLevel());
+}
+MICRO_BENCHMARK(batchTransformAABBs)->arg(0)->arg(1)->arg(2)->arg(3);
+
+// The local matrices TransformHierarchy::update builds
+void batchComposeTRS(BenchmarkState &state)
+{
+    if (!selectSimdLevel(state))
+        return;
+
+    std::vector<glm::vec3> positions(batchMathCount, glm::vec3(1.0f, 2.0f, 3.0f));
+    std::vector<glm::quat> rotations(batchMathCount, glm::quat(0.9f, 0.1f, 0.3f, 0.3f));
+    std::vector<glm::vec3> scales(batchMathCount, glm::vec3(1.0f, 2.0f, 1.0f));
+    std::vector<glm::mat4> matrices(batchMathCount);
+
+    while (state.keepRunning())
+    {
+        BatchMath::composeTRS(positions.data(), rotations.data(), scales.data(), matrices.data(), batchMathCount);
+        doNotOptimize(matrices.data());
+        clobberMemory();
+    }
+
+    state.setItemsProcessed(batchMathCount * state.getIterations());
+    BatchMath::setLevel(BatchMath::getSupportedLevel());
+}
+MICRO_BENCHMARK(batchComposeTRS)->arg(0)->arg(1)->arg(2)->arg(3);
+
+/* Render queue and command recording */
+
+void renderQueueSort(BenchmarkState &state)
+{
+    const uint32_t count = state.arg();
+
+    std::mt19937 random(1234);
+    std::uniform_int_distribution<uint32_t> programs(1, 8), textures(1, 32);
+    std::uniform_real_distribution<float> depth(0.1f, 100.0f);
+
+    std::vector<DrawPacket> packets(count);
+    std::vector<float> depths(count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        packets[i] = DrawPacket();
+        packets[i].program = programs(random);
+        packets[i].diffuseMap = textures(random);
+        packets[i].specularMap = textures(random);
+        packets[i].vertexArray = 1;
+        packets[i].count = 36;
+        depths[i] = depth(random);
+    }
+
+    RenderQueue queue;
+    while (state.keepRunning())
+    {
+        state.pauseTiming();
+        queue.reset();
+        for (uint32_t i = 0; i < count; ++i)
+            queue.submit(packets[i], RenderPass::Opaque, false, depths[i]);
+        state.resumeTiming();
+
+        queue.sort();
+    }
+
+    state.setItemsProcessed((uint64_t)count * state.getIterations());
+}
+MICRO_BENCHMARK(renderQueueSort)->arg(1024)->arg(65536);
+
+// Per draw cost of the command list, as RenderQueue::record emits it
+void commandListRecord(BenchmarkState &state)
+{
+    const uint32_t count = state.arg();
+    const glm::mat4 model(1.0f);
+    const glm::mat3 normalMatrix(1.0f);
+
+    CommandList commands;
+    while (state.keepRunning())
+    {
+        commands.reset();
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            commands.setUniform("model", model);
+            commands.setUniform("normalMatrix", normalMatrix);
+            commands.drawArrays(PrimitiveType::Triangles, 0, 36);
+        }
+        doNotOptimize(commands.size());
+    }
+
+    state.setItemsProcessed((uint64_t)count * state.getIterations());
+}
+MICRO_BENCHMARK(commandListRecord)->arg(1024);
+
+/* Asset loading */
+
+// Writes a side x side grid of quads with positions, texture coordinates and normals, returns its path
+std::string writeGridObj(const uint32_t side)
+{
+    std::string path = "hotPathBenchmark_grid" + std::to_string(side) + ".obj";
+    std::ofstream file(path, std::ios::binary);
+
+    for (uint32_t y = 0; y <= side; ++y)
+        for (uint32_t x = 0; x <= side; ++x)
+            file << "v " << x * 0.01f << " " << std::sin(x * 0.1f) * 0.05f << " " << y * 0.01f << "\n"
+                 << "vt " << (float)x / side << " " << (float)y / side << "\n";
+    file << "vn 0 1 0\n";
+
+    for (uint32_t y = 0; y < side; ++y)
+    {
+        for (uint32_t x = 0; x < side; ++x)
+        {
+            uint32_t corner = y * (side + 1) + x + 1;
+            file << "f " << corner << "/" << corner << "/1 " << corner + 1 << "/" << corner + 1 << "/1 "
+                 << corner + side + 2 << "/" << corner + side + 2 << "/1 " << corner + side + 1 << "/" << corner + side + 1 << "/1\n";
+        }
+    }
+
+    return path;
+}
+
+// Parse, weld and assemble, the argument is the grid side
+void objLoad(BenchmarkState &state)
+{
+    const uint32_t side = state.arg();
+    std::string path = writeGridObj(side);
+
+    ObjLoader loader(getJobSystem());
+    Mesh mesh;
+    while (state.keepRunning())
+    {
+        loader.load(path.c_str(), mesh);
+        doNotOptimize(mesh.indices.data());
+    }
+
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    state.setBytesProcessed((uint64_t)file.tellg() * state.getIterations());
+    file.close();
+    std::remove(path.c_str());
+}
+MICRO_BENCHMARK(objLoad)->arg(256)->arg(1024);
+
+// Map, validate and read through the same grid baked, what an upload costs on the CPU side
+void bakedMeshLoad(BenchmarkState &state)
+{
+    const uint32_t side = state.arg();
+    std::string objPath = writeGridObj(side);
+    std::string bakedPath = "hotPathBenchmark_grid" + std::to_string(side) + ".bmesh";
+
+    ObjLoader loader(getJobSystem());
+    Mesh mesh;
+    loader.load(objPath.c_str(), mesh);
+    writeBakedMesh(bakedPath.c_str(), mesh);
+
+    BakedMesh bakedMesh;
+    uint64_t fileSize = 0;
+    while (state.keepRunning())
+    {
+        bakedMesh.open(bakedPath.c_str());
+
+        // Stands in for glBufferData reading the vertex section out of the mapping
+        const uint32_t* words = (const uint32_t*)bakedMesh.getVertices();
+        uint32_t checksum = 0;
+        for (size_t i = 0; i < bakedMesh.getHeader().vertexCount * sizeof(MeshVertex) / sizeof(uint32_t); ++i)
+            checksum ^= words[i];
+        doNotOptimize(checksum);
+
+        fileSize = bakedMesh.getHeader().sections[BakedStrings].offset + bakedMesh.getHeader().sections[BakedStrings].size;
+    }
+
+    state.setBytesProcessed(fileSize * state.getIterations());
+    bakedMesh.close();
+    std::remove(objPath.c_str());
+    std::remove(bakedPath.c_str());
+}
+MICRO_BENCHMARK(bakedMeshLoad)->arg(256)->arg(1024);
+
+// Reads 64 files of 256 KB one after another (0) or as one batch on an AsyncFileReader (1),
+// touching every byte where a decode would. The files are in the page cache after the first pass
+void fileReadBatch(BenchmarkState &state)
+{
+    const bool async = state.arg() == 1;
+    const size_t fileCount = 64;
+    const size_t fileSize = 256 * 1024;
+
+    std::vector<std::string> paths;
+    std::vector<unsigned char> contents(fileSize);
+    for (size_t i = 0; i < fileCount; ++i)
+    {
+        for (size_t byte = 0; byte < fileSize; ++byte)
+            contents[byte] = (unsigned char)(byte * 31 + i);
+
+        paths.push_back("hotPathBenchmark_file" + std::to_string(i) + ".bin");
+        std::ofstream(paths.back(), std::ios::binary).write((const char*)contents.data(), contents.size());
+    }
+
+    AsyncFileReader reader(getJobSystem());
+    std::atomic<uint32_t> checksum { 0 };
+    auto consume = [&checksum](const unsigned char* data, const size_t size)
+    {
+        uint32_t sum = 0;
+        for (size_t byte = 0; byte < size; byte += 64)
+            sum += data[byte];
+        checksum += sum;
+    };
+
+    while (state.keepRunning())
+    {
+        if (async)
+        {
+            JobCounter counter { 0 };
+            for (const std::string &path : paths)
+                reader.readFile(path.c_str(), consume, &counter);
+            getJobSystem().wait(counter);
+        }
+        else
+        {
+            for (const std::string &path : paths)
+            {
+                std::vector<unsigned char> data = readFile(path.c_str());
+                consume(data.data(), data.size());
+            }
+        }
+        doNotOptimize(checksum.load());
+    }
+
+    state.setBytesProcessed((uint64_t)(fileCount * fileSize) * state.getIterations());
+    for (const std::string &path : paths)
+        std::remove(path.c_str());
+}
+MICRO_BENCHMARK(fileReadBatch)->arg(0)->arg(1);
+
+int main(int argc, char** argv)
+{
+    return MicroBenchmarks::run(argc, argv);
+}
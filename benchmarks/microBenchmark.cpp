@@ -0,0 +1,254 @@
+#include "microBenchmark.h"
+
+/* Constructor */
+BenchmarkState::BenchmarkState(const uint64_t iterations, const int64_t argument)
+    : iterations { iterations }
+    , remaining { iterations }
+    , argument { argument }
+    , timing { false }
+    , elapsedNanoseconds { 0.0 }
+    , itemsProcessed { 0 }
+    , bytesProcessed { 0 }
+{}
+
+void BenchmarkState::pauseTiming()
+{
+    if (!timing)
+        return;
+
+    elapsedNanoseconds += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    timing = false;
+}
+
+void BenchmarkState::resumeTiming()
+{
+    if (timing)
+        return;
+
+    timing = true;
+    start = std::chrono::steady_clock::now();
+}
+
+int64_t BenchmarkState::arg() const
+{
+    return argument;
+}
+
+uint64_t BenchmarkState::getIterations() const
+{
+    return iterations;
+}
+
+void BenchmarkState::setItemsProcessed(const uint64_t items)
+{
+    itemsProcessed = items;
+}
+
+void BenchmarkState::setBytesProcessed(const uint64_t bytes)
+{
+    bytesProcessed = bytes;
+}
+
+void BenchmarkState::setLabel(const std::string &text)
+{
+    label = text;
+}
+
+void BenchmarkState::skip(const std::string &reason)
+{
+    skipReason = reason;
+    remaining = 0;
+}
+
+/* Constructor */
+BenchmarkRegistration::BenchmarkRegistration(const char* name, BenchmarkFunction function)
+    : name { name }
+    , function { function }
+{}
+
+BenchmarkRegistration* BenchmarkRegistration::arg(const int64_t value)
+{
+    arguments.push_back(value);
+    return this;
+}
+
+BenchmarkRegistration* MicroBenchmarks::add(const char* name, BenchmarkFunction function)
+{
+    /* Registrations live for the whole program */
+    registry().push_back(new BenchmarkRegistration(name, function));
+    return registry().back();
+}
+
+int MicroBenchmarks::run(int argc, char** argv)
+{
+    const char* filter = "";
+    const char* jsonPath = NULL;
+    int repetitions = 10;
+    double minTime = 0.01;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "--filter") && i + 1 < argc)
+            filter = argv[++i];
+        else if (!strcmp(argv[i], "--repetitions") && i + 1 < argc)
+            repetitions = std::max(atoi(argv[++i]), 2);
+        else if (!strcmp(argv[i], "--min-time") && i + 1 < argc)
+            minTime = std::max(atof(argv[++i]), 0.0001);
+        else if (!strcmp(argv[i], "--json") && i + 1 < argc)
+            jsonPath = argv[++i];
+        else
+        {
+            std::cout << "ERROR: MicroBenchmarks -> Unknown argument " << argv[i] << std::endl;
+            return -1;
+        }
+    }
+
+    printf("%-40s %12s %12s %12s %8s %12s  %s\n", "Benchmark", "Median ns", "Mean ns", "Min ns", "CV", "Iterations", "Throughput");
+
+    std::vector<Result> results;
+    for (const BenchmarkRegistration* benchmark : registry())
+    {
+        std::vector<int64_t> arguments = benchmark->arguments;
+        if (arguments.empty())
+            arguments.push_back(0);
+
+        for (int64_t argument : arguments)
+        {
+            std::string name = benchmark->name;
+            if (!benchmark->arguments.empty())
+                name += "/" + std::to_string(argument);
+
+            if (name.find(filter) == std::string::npos)
+                continue;
+
+            Result result = measure(*benchmark, argument, repetitions, minTime);
+            result.name = name;
+            results.push_back(result);
+
+            if (!result.skipReason.empty())
+            {
+                printf("%-40s skipped: %s\n", name.c_str(), result.skipReason.c_str());
+                continue;
+            }
+
+            char throughput[64] = "";
+            if (result.bytesPerSecond > 0.0)
+                snprintf(throughput, sizeof(throughput), "%.1f MB/s", result.bytesPerSecond / (1024.0 * 1024.0));
+            else if (result.itemsPerSecond > 0.0)
+                snprintf(throughput, sizeof(throughput), "%.2f M items/s", result.itemsPerSecond / 1e6);
+
+            printf("%-40s %12.1f %12.1f %12.1f %7.2f%% %12llu  %s%s%s%s\n", name.c_str(), result.median, result.mean, result.min,
+                   result.cv, (unsigned long long)result.iterations, throughput, result.label.empty() ? "" : "  ",
+                   result.label.c_str(), result.cv > 5.0 ? "  (noisy)" : "");
+        }
+    }
+
+    if (jsonPath && !writeJSON(jsonPath, results))
+        return -1;
+
+    return 0;
+}
+
+/* Private */
+std::vector<BenchmarkRegistration*> &MicroBenchmarks::registry()
+{
+    static std::vector<BenchmarkRegistration*> benchmarks;
+    return benchmarks;
+}
+
+MicroBenchmarks::Result MicroBenchmarks::measure(const BenchmarkRegistration &benchmark, const int64_t argument,
+                                                 const int repetitions, const double minTime)
+{
+    Result result = { "", "", 0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, "" };
+    const double targetNanoseconds = minTime * 1e9;
+
+    /* Grow the iteration count until a single run is long enough for the clock to be irrelevant */
+    uint64_t iterations = 1;
+    for (;;)
+    {
+        BenchmarkState state(iterations, argument);
+        benchmark.function(state);
+
+        if (!state.skipReason.empty())
+        {
+            result.skipReason = state.skipReason;
+            return result;
+        }
+
+        if (state.elapsedNanoseconds >= targetNanoseconds || iterations >= 1000000000ull)
+            break;
+
+        /* Aim a little past the target so the next run usually is the last */
+        double scale = state.elapsedNanoseconds > 0.0 ? targetNanoseconds * 1.4 / state.elapsedNanoseconds : 10.0;
+        iterations = (uint64_t)(iterations * std::min(std::max(scale, 2.0), 100.0));
+    }
+
+    /* Repetitions with the calibrated count, the spread between them is the noise estimate */
+    std::vector<double> samples;
+    double items = 0.0, bytes = 0.0, seconds = 0.0;
+    for (int r = 0; r < repetitions; ++r)
+    {
+        BenchmarkState state(iterations, argument);
+        benchmark.function(state);
+
+        samples.push_back(state.elapsedNanoseconds / iterations);
+        items += state.itemsProcessed;
+        bytes += state.bytesProcessed;
+        seconds += state.elapsedNanoseconds / 1e9;
+        result.label = state.label;
+    }
+
+    std::sort(samples.begin(), samples.end());
+
+    double sum = 0.0;
+    for (double sample : samples)
+        sum += sample;
+
+    result.iterations = iterations;
+    result.mean = sum / samples.size();
+    result.min = samples.front();
+    result.median = samples.size() % 2 ? samples[samples.size() / 2]
+                                       : (samples[samples.size() / 2 - 1] + samples[samples.size() / 2]) * 0.5;
+
+    double variance = 0.0;
+    for (double sample : samples)
+        variance += (sample - result.mean) * (sample - result.mean);
+    result.stddev = std::sqrt(variance / (samples.size() - 1));
+    result.cv = result.mean > 0.0 ? result.stddev / result.mean * 100.0 : 0.0;
+
+    result.itemsPerSecond = seconds > 0.0 ? items / seconds : 0.0;
+    result.bytesPerSecond = seconds > 0.0 ? bytes / seconds : 0.0;
+
+    return result;
+}
+
+bool MicroBenchmarks::writeJSON(const char* path, const std::vector<Result> &results)
+{
+    FILE* file = fopen(path, "w");
+    if (!file)
+    {
+        std::cout << "ERROR: MicroBenchmarks -> Unable to open " << path << std::endl;
+        return false;
+    }
+
+    fprintf(file, "{\n  \"benchmarks\": [\n");
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const Result &result = results[i];
+        fprintf(file, "    { \"name\": \"%s\", ", result.name.c_str());
+
+        if (!result.skipReason.empty())
+            fprintf(file, "\"skipped\": \"%s\" }", result.skipReason.c_str());
+        else
+            fprintf(file, "\"iterations\": %llu, \"medianNs\": %.3f, \"meanNs\": %.3f, \"stddevNs\": %.3f, \"minNs\": %.3f, "
+                          "\"cvPercent\": %.3f, \"itemsPerSecond\": %.1f, \"bytesPerSecond\": %.1f }",
+                    (unsigned long long)result.iterations, result.median, result.mean, result.stddev, result.min,
+                    result.cv, result.itemsPerSecond, result.bytesPerSecond);
+
+        fprintf(file, "%s\n", i + 1 < results.size() ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+
+    fclose(file);
+    return true;
+}
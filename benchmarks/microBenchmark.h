@@ -0,0 +1,149 @@
+#ifndef MICRO_BENCHMARK_HARNESS
+#define MICRO_BENCHMARK_HARNESS
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+
+/*  Minimal micro benchmark harness in the spirit of Google Benchmark.
+
+        void cameraViewMatrix(BenchmarkState &state)
+        {
+            Camera camera;                      // Setup is not timed
+            while (state.keepRunning())
+                doNotOptimize(camera.getViewMatrix());
+        }
+        MICRO_BENCHMARK(cameraViewMatrix);
+
+    The iteration count is calibrated until one repetition runs for at least the minimum
+    time, then the benchmark is repeated and the spread of the per iteration times is
+    reported: median, mean, standard deviation, coefficient of variation and minimum.
+    Runs whose CV exceeds 5% are flagged as noisy. Arguments registered with arg() run
+    the function once per value, read back through state.arg(). */
+
+class BenchmarkState
+{
+    public:
+        /* Constructor */
+        BenchmarkState(const uint64_t iterations, const int64_t argument);
+
+        /* Loop condition, the timer starts on the first call and stops on the last */
+        inline bool keepRunning()
+        {
+            if (remaining == 0)
+            {
+                pauseTiming();
+                return false;
+            }
+
+            if (remaining == iterations)
+                resumeTiming();
+
+            --remaining;
+            return true;
+        }
+
+        /* Exclude per iteration setup from the measurement. Each pair costs two clock reads */
+        void pauseTiming();
+        void resumeTiming();
+
+        int64_t arg() const;
+        uint64_t getIterations() const;
+
+        /* Throughput, totals over all iterations */
+        void setItemsProcessed(const uint64_t items);
+        void setBytesProcessed(const uint64_t bytes);
+
+        void setLabel(const std::string &label);
+
+        /* Marks the benchmark as not runnable, e.g. when an input file is missing */
+        void skip(const std::string &reason);
+
+    private:
+        friend class MicroBenchmarks;
+
+        uint64_t iterations;
+        uint64_t remaining;
+        int64_t argument;
+
+        bool timing;
+        std::chrono::steady_clock::time_point start;
+        double elapsedNanoseconds;
+
+        uint64_t itemsProcessed;
+        uint64_t bytesProcessed;
+        std::string label;
+        std::string skipReason;
+};
+
+typedef void (*BenchmarkFunction)(BenchmarkState&);
+
+class BenchmarkRegistration
+{
+    public:
+        /* Constructor */
+        BenchmarkRegistration(const char* name, BenchmarkFunction function);
+
+        /* Adds a value to run the benchmark with, calls can be chained */
+        BenchmarkRegistration* arg(const int64_t value);
+
+    private:
+        friend class MicroBenchmarks;
+
+        std::string name;
+        BenchmarkFunction function;
+        std::vector<int64_t> arguments;
+};
+
+class MicroBenchmarks
+{
+    public:
+        static BenchmarkRegistration* add(const char* name, BenchmarkFunction function);
+
+        /* --filter SUBSTRING  --repetitions N  --min-time SECONDS  --json FILE */
+        static int run(int argc, char** argv);
+
+    private:
+        struct Result
+        {
+            std::string name;
+            std::string label;
+            uint64_t iterations;
+            double median, mean, stddev, min, cv;       /* Nanoseconds per iteration, cv in percent */
+            double itemsPerSecond, bytesPerSecond;
+            std::string skipReason;
+        };
+
+        static std::vector<BenchmarkRegistration*> &registry();
+
+        static Result measure(const BenchmarkRegistration &benchmark, const int64_t argument,
+                              const int repetitions, const double minTime);
+        static bool writeJSON(const char* path, const std::vector<Result> &results);
+};
+
+/* Keep the compiler from discarding a computed value or a store, without costing anything */
+template<typename T>
+inline void doNotOptimize(const T &value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+inline void clobberMemory()
+{
+    asm volatile("" : : : "memory");
+}
+
+#define BENCHMARK_CONCAT_INNER(a, b) a##b
+#define BENCHMARK_CONCAT(a, b) BENCHMARK_CONCAT_INNER(a, b)
+
+#define MICRO_BENCHMARK(function) \
+    static BenchmarkRegistration* BENCHMARK_CONCAT(benchmarkRegistration, __LINE__) = MicroBenchmarks::add(#function, function)
+
+#endif
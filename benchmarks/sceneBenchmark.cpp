@@ -0,0 +1,737 @@
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <random>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "../lib/Jobs/jobSystem.cpp"
+#include "../lib/Profiler/profiler.cpp"
+#include "../lib/Profiler/frameStats.cpp"
+#include "../lib/Shader/shaderPreprocessor.cpp"
+#include "../lib/Shader/shader.cpp"
+#include "../lib/Shader/shaderWatcher.cpp"
+#include "../lib/Shader/shaderCache.cpp"
+#include "../lib/Texture/texture.cpp"
+#include "../lib/Camera/camera.cpp"
+#include "../lib/ECS/ecs.cpp"
+#include "../lib/ECS/components.h"
+#include "../lib/Math/batchMath.cpp"
+#include "../lib/Scene/transformHierarchy.cpp"
+#include "../lib/Culling/frustum.cpp"
+#include "../lib/Culling/entityCuller.cpp"
+#include "../lib/Render/commandList.cpp"
+#include "../lib/Render/glBackend.cpp"
+#include "../lib/Render/renderQueue.cpp"
+#include "../lib/Render/frameRingBuffer.cpp"
+#include "../lib/Lighting/cascadedShadows.cpp"
+#include "../lib/Lighting/clusteredLighting.cpp"
+#include "../lib/Platform/headlessContext.cpp"
+
+/*  Replays scripted camera paths through the sample scenes and scaled up variants of
+    them, offscreen, and reports frame times, render counters and memory as JSON.
+
+    Every run is deterministic: fixed camera paths, a fixed animation step and seeded
+    scene generation, so results of two commits can be diffed directly.
+
+        sceneBenchmark [--scene NAME]... [--frames N] [--warmup N] [--size WxH] [--output FILE]
+
+    A summary is printed as scenes finish, the JSON goes to benchmark.json unless --output
+    says otherwise ("-" for stdout).
+
+    Scenes: main, lighting, cubes10k, cubes100k, lights1k. All of them run by default. */
+
+// Must match the size of the pointLights array the forward lighting.frag is built with
+#define POINT_LIGHTS 4
+
+Camera camera;
+
+enum class ScenePipeline
+{
+    Unlit,          // main.cpp: textured cubes straight into a command list
+    Forward,        // lightingDemo: render queue, depth pre-pass, cascaded shadows, 4 point lights
+    Clustered       // clusteredLightingDemo: render queue, clustered point lights
+};
+
+struct CameraKey
+{
+    glm::vec3 position;
+    glm::vec3 target;
+};
+
+struct SceneConfig
+{
+    const char* name;
+    ScenePipeline pipeline;
+    uint32_t cubeCount;         // 0 places the hand made cube layout of the samples
+    uint32_t lightCount;        // 0 places the samples' 4 lamps
+    int frames;
+    std::vector<CameraKey> path;
+};
+
+struct SceneResult
+{
+    const char* name;
+    FrameTimeStats cpu;         // Simulation, recording and submission
+    FrameTimeStats frame;       // Including waiting for the GPU to finish
+
+    // Per frame averages and maximums of the backend's counters
+    double drawCalls, programChanges, textureBinds, vertexArrayBinds, visibleEntities, commandBytes;
+    uint32_t maxDrawCalls, maxStateChanges;
+
+    long residentBeforeKB, residentAfterKB, peakResidentKB;
+};
+
+// Geometry and textures shared by every scene
+struct SharedResources
+{
+    unsigned int cubeVAO, lampVAO;
+    unsigned int containerMap, faceMap, diffuseMap, specularMap;
+    ShaderCache shaderCache;
+};
+
+// World space cube positions of main.cpp and lightingDemo
+const glm::vec3 demoCubePositions[] = {
+    glm::vec3( 0.0f,  0.0f,  0.0f),
+    glm::vec3( 2.0f,  5.0f, -15.0f),
+    glm::vec3(-1.5f, -2.2f, -2.5f),
+    glm::vec3(-3.8f, -2.0f, -12.3f),
+    glm::vec3( 2.4f, -0.4f, -3.5f),
+    glm::vec3(-1.7f,  3.0f, -7.5f),
+    glm::vec3( 1.3f, -2.0f, -2.5f),
+    glm::vec3( 1.5f,  2.0f, -2.5f),
+    glm::vec3( 1.5f,  0.2f, -1.5f),
+    glm::vec3(-1.3f,  1.0f, -1.5f)
+};
+
+const glm::vec3 demoLightPositions[] = {
+    glm::vec3( 0.7f,  0.2f,  2.0f),
+    glm::vec3( 2.3f, -3.3f, -4.0f),
+    glm::vec3(-4.0f,  2.0f, -12.0f),
+    glm::vec3( 0.0f,  0.0f, -3.0f)
+};
+
+const float FIELD_SPACING = 2.0f;
+
+long readResidentKB()
+{
+    long pages = 0, resident = 0;
+    FILE* statm = fopen("/proc/self/statm", "r");
+    if (!statm)
+        return 0;
+
+    if (fscanf(statm, "%ld %ld", &pages, &resident) != 2)
+        resident = 0;
+    fclose(statm);
+
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+long readPeakResidentKB()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+void defineCube(SharedResources &resources)
+{
+    float vertices[] = {
+        /* Vertex Position */ /* Normal Vector */ /* Texture Co-ordinates */
+        -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f, 0.0f,
+        0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f, 0.0f,
+        0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f, 1.0f,
+        0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f, 1.0f,
+        -0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f, 1.0f,
+        -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f, 0.0f,
+
+        -0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   0.0f, 0.0f,
+        0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   1.0f, 0.0f,
+        0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   1.0f, 1.0f,
+        0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   1.0f, 1.0f,
+        -0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   0.0f, 1.0f,
+        -0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   0.0f, 0.0f,
+
+        -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
+        -0.5f,  0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  1.0f, 1.0f,
+        -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
+        -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
+        -0.5f, -0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  0.0f, 0.0f,
+        -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
+
+        0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
+        0.5f,  0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f,
+        0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
+        0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
+        0.5f, -0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  0.0f, 0.0f,
+        0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
+
+        -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f, 1.0f,
+        0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  1.0f, 1.0f,
+        0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f, 0.0f,
+        0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f, 0.0f,
+        -0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  0.0f, 0.0f,
+        -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f, 1.0f,
+
+        -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f, 1.0f,
+        0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  1.0f, 1.0f,
+        0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f, 0.0f,
+        0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f, 0.0f,
+        -0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  0.0f, 0.0f,
+        -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f, 1.0f
+    };
+
+    unsigned int VBO;
+    glGenVertexArrays(1, &resources.cubeVAO);
+    glGenBuffers(1, &VBO);
+
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+
+    glBindVertexArray(resources.cubeVAO);
+
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 8, (void*)0);
+    glEnableVertexAttribArray(0);
+
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 8, (void*)(sizeof(float) * 3));
+    glEnableVertexAttribArray(1);
+
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 8, (void*)(sizeof(float) * 6));
+    glEnableVertexAttribArray(2);
+
+    glGenVertexArrays(1, &resources.lampVAO);
+    glBindVertexArray(resources.lampVAO);
+
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 8, (void*)0);
+    glEnableVertexAttribArray(0);
+}
+
+// Linear interpolation through the keys, t in [0, 1] covers the whole path
+void placeCamera(const std::vector<CameraKey> &path, const float t)
+{
+    if (path.size() == 1)
+    {
+        camera.pos = path[0].position;
+        camera.front = glm::normalize(path[0].target - path[0].position);
+        return;
+    }
+
+    float scaled = glm::clamp(t, 0.0f, 1.0f) * (path.size() - 1);
+    size_t key = std::min((size_t)scaled, path.size() - 2);
+    float blend = scaled - key;
+
+    glm::vec3 position = path[key].position + (path[key + 1].position - path[key].position) * blend;
+    glm::vec3 target = path[key].target + (path[key + 1].target - path[key].target) * blend;
+
+    camera.pos = position;
+    camera.front = glm::normalize(target - position);
+}
+
+// Closed loop around `center`, for the small hand made scenes
+std::vector<CameraKey> orbitPath(const glm::vec3 &center, const float radius, const float height)
+{
+    std::vector<CameraKey> path;
+    for (int i = 0; i <= 16; ++i)
+    {
+        float angle = glm::radians(360.0f * i / 16.0f);
+        path.push_back({ center + glm::vec3(glm::sin(angle) * radius, height, glm::cos(angle) * radius), center });
+    }
+    return path;
+}
+
+// Low pass across a field of cubes, looking ahead and slightly down
+std::vector<CameraKey> flyoverPath(const uint32_t cubeCount)
+{
+    uint32_t side = (uint32_t)std::ceil(std::sqrt((float)std::max(cubeCount, 1u)));
+    float extent = side * FIELD_SPACING;
+
+    return {
+        { glm::vec3(-extent * 0.45f, 6.0f,  extent * 0.45f), glm::vec3(0.0f, 0.0f, 0.0f) },
+        { glm::vec3( 0.0f,           4.0f,  0.0f),           glm::vec3(extent * 0.45f, 0.0f, -extent * 0.45f) },
+        { glm::vec3( extent * 0.45f, 8.0f, -extent * 0.45f), glm::vec3(extent, 0.0f, -extent) },
+        { glm::vec3( extent * 0.30f, 12.0f, -extent * 0.20f), glm::vec3(0.0f, 0.0f, 0.0f) }
+    };
+}
+
+// Fills the world with cubes and lamps, a grid centered on the origin for the stress scenes
+void populateScene(const SceneConfig &config, const SharedResources &resources, const uint32_t cubeProgram,
+                   const uint32_t lampProgram, World &world, TransformHierarchy &hierarchy)
+{
+    const MeshRef cubeMesh = { resources.cubeVAO, 0, 36, false };
+    const MaterialRef woodMaterial = { cubeProgram, resources.diffuseMap, resources.specularMap, 0.4f * 128.0f };
+    const Bounds cubeBounds = { glm::vec3(0.0f), glm::vec3(0.5f) };
+
+    if (config.cubeCount == 0)
+    {
+        for (const glm::vec3 &position : demoCubePositions)
+        {
+            SceneNode node = { hierarchy.createNode(InvalidNode, position) };
+            world.createEntity(Transform { position, glm::vec3(0.0f), glm::vec3(1.0f) }, node, cubeMesh, woodMaterial, cubeBounds);
+        }
+    }
+
+    uint32_t side = (uint32_t)std::ceil(std::sqrt((float)config.cubeCount));
+    float extent = side * FIELD_SPACING;
+
+    for (uint32_t i = 0; i < config.cubeCount; ++i)
+    {
+        glm::vec3 position = glm::vec3((i % side) * FIELD_SPACING - extent * 0.5f, -2.0f, -(float)(i / side) * FIELD_SPACING + extent * 0.5f);
+
+        SceneNode node = { hierarchy.createNode(InvalidNode, position) };
+        world.createEntity(Transform { position, glm::vec3(0.0f), glm::vec3(1.0f) }, node, cubeMesh, woodMaterial, cubeBounds);
+    }
+
+    const MeshRef lampMesh = { resources.lampVAO, 0, 36, false };
+    const MaterialRef lampMaterial = { lampProgram, 0, 0, 0.0f };
+
+    if (config.lightCount == 0)
+    {
+        const PointLight lampLight = {
+            glm::vec3(0.05f, 0.05f, 0.05f), glm::vec3(0.8f, 0.8f, 0.8f), glm::vec3(1.0f, 1.0f, 1.0f),
+            1.0f, 0.09f, 0.032f
+        };
+
+        for (const glm::vec3 &position : demoLightPositions)
+        {
+            SceneNode node = { hierarchy.createNode(InvalidNode, position, glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(0.2f)) };
+            world.createEntity(Transform { position, glm::vec3(0.0f), glm::vec3(0.2f) }, node, lampMesh, lampMaterial, cubeBounds, lampLight);
+        }
+        return;
+    }
+
+    // Seeded so every run places the same lights
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    for (uint32_t i = 0; i < config.lightCount; ++i)
+    {
+        glm::vec3 position = glm::vec3((unit(random) - 0.5f) * extent, -1.5f + unit(random) * 1.5f, (unit(random) - 0.5f) * extent);
+        glm::vec3 color = glm::vec3(unit(random), unit(random), unit(random));
+
+        const PointLight light = { color * 0.02f, color, glm::vec3(1.0f), 1.0f, 0.35f, 0.44f };
+
+        SceneNode node = { hierarchy.createNode(InvalidNode, position, glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(0.1f)) };
+        world.createEntity(Transform { position, glm::vec3(0.0f), glm::vec3(0.1f) }, node, lampMesh, lampMaterial, cubeBounds, light);
+    }
+}
+
+// Uniforms of the forward lighting.frag that stay fixed for the whole run
+void applyForwardUniforms(Shader lightingShader, World &world, const glm::vec3 &dirLightDirection)
+{
+    lightingShader.use();
+
+    lightingShader.setVec3("material.specular", glm::vec3(0.628281f, 0.555802f, 0.366065f));
+    lightingShader.setFloat("material.shine", 0.4f * 128.0f);
+    lightingShader.setInt("material.diffuse", 0);
+    lightingShader.setInt("material.specular", 1);
+
+    int lightIndex = 0;
+    world.view<Transform, PointLight>().each([&](Transform &transform, PointLight &pointLight)
+    {
+        if (lightIndex >= POINT_LIGHTS)
+            return;
+
+        std::string name = "pointLights[" + std::to_string(lightIndex++) + "]";
+        lightingShader.setVec3(name + ".position", transform.position);
+        lightingShader.setVec3(name + ".ambient", pointLight.ambient);
+        lightingShader.setVec3(name + ".diffuse", pointLight.diffuse);
+        lightingShader.setVec3(name + ".specular", pointLight.specular);
+        lightingShader.setFloat(name + ".attConstant", pointLight.attConstant);
+        lightingShader.setFloat(name + ".attLinear", pointLight.attLinear);
+        lightingShader.setFloat(name + ".attQuadratic", pointLight.attQuadratic);
+    });
+
+    lightingShader.setVec3("dirLight.direction", dirLightDirection);
+    lightingShader.setVec3("dirLight.ambient", glm::vec3(0.05f, 0.05f, 0.05f));
+    lightingShader.setVec3("dirLight.diffuse", glm::vec3(0.4f, 0.4f, 0.4f));
+    lightingShader.setVec3("dirLight.specular", glm::vec3(0.5f, 0.5f, 0.5f));
+}
+
+void applyClusteredUniforms(Shader clusteredShader, const glm::vec3 &dirLightDirection)
+{
+    clusteredShader.use();
+
+    clusteredShader.setInt("material.diffuse", 0);
+    clusteredShader.setInt("material.specular", 1);
+    clusteredShader.setFloat("material.shine", 0.4f * 128.0f);
+
+    clusteredShader.setVec3("dirLight.direction", dirLightDirection);
+    clusteredShader.setVec3("dirLight.ambient", glm::vec3(0.02f, 0.02f, 0.02f));
+    clusteredShader.setVec3("dirLight.diffuse", glm::vec3(0.05f, 0.05f, 0.05f));
+    clusteredShader.setVec3("dirLight.specular", glm::vec3(0.1f, 0.1f, 0.1f));
+}
+
+SceneResult runScene(const SceneConfig &config, const int warmupFrames, HeadlessContext &context,
+                     SharedResources &resources, JobSystem &jobSystem)
+{
+    SceneResult result;
+    memset(&result, 0, sizeof(result));
+    result.name = config.name;
+    result.residentBeforeKB = readResidentKB();
+
+    const int viewportWidth = context.getWidth(), viewportHeight = context.getHeight();
+    const float aspectRatio = (float)viewportWidth / (float)viewportHeight;
+    const glm::vec3 dirLightDirection = glm::vec3(-0.2f, -1.0f, -0.3f);
+
+    const ShaderDefines forwardDefines = { { "POINT_LIGHTS", std::to_string(POINT_LIGHTS) }, { "SHADOWS", "" } };
+
+    Shader unlitShader = resources.shaderCache.get("shaders/v.vert", "shaders/f.frag");
+    Shader forwardShader = resources.shaderCache.get("shaders/lighting.vert", "shaders/lighting.frag", forwardDefines);
+    Shader clusteredShader = resources.shaderCache.get("shaders/lighting.vert", "shaders/clustered.frag");
+    Shader lampShader = resources.shaderCache.get("shaders/lamp.vert", "shaders/lamp.frag");
+    Shader depthShader = resources.shaderCache.get("shaders/depth.vert", "shaders/depth.frag");
+
+    const Shader &litShader = config.pipeline == ScenePipeline::Clustered ? clusteredShader : forwardShader;
+
+    World world;
+    TransformHierarchy hierarchy;
+    hierarchy.jobSystem = &jobSystem;
+
+    if (config.pipeline != ScenePipeline::Unlit)
+        populateScene(config, resources, litShader.shaderProgramID, lampShader.shaderProgramID, world, hierarchy);
+
+    if (config.pipeline == ScenePipeline::Forward)
+        applyForwardUniforms(forwardShader, world, dirLightDirection);
+    else if (config.pipeline == ScenePipeline::Clustered)
+        applyClusteredUniforms(clusteredShader, dirLightDirection);
+
+    if (config.pipeline == ScenePipeline::Unlit)
+    {
+        unlitShader.use();
+        unlitShader.setInt("texture0", 0);
+        unlitShader.setInt("texture1", 1);
+    }
+
+    const glm::mat4 proj = camera.getProjectionMatrix(aspectRatio);
+
+    std::vector<Entity> visibleEntities;
+    std::vector<GpuPointLight> frameLights;
+
+    RenderQueue renderQueue(camera.nearPlane, camera.farPlane);
+    renderQueue.depthPrepass = config.pipeline == ScenePipeline::Forward;
+    renderQueue.depthOnlyProgram = depthShader.shaderProgramID;
+
+    CommandList commands;
+    GLBackend backend;
+    FrameRingBuffer frameData(4 * 1024 * 1024);
+
+    std::unique_ptr<CascadedShadows> shadows;
+    if (config.pipeline == ScenePipeline::Forward)
+        shadows.reset(new CascadedShadows());
+
+    ClusteredLighting clusteredLighting;
+    clusteredLighting.setProjection(proj, camera.nearPlane, camera.farPlane, viewportWidth, viewportHeight);
+
+    std::vector<double> cpuTimes, frameTimes;
+    cpuTimes.reserve(config.frames);
+    frameTimes.reserve(config.frames);
+
+    uint64_t totalStateChanges = 0;
+    uint64_t totals[6] = { 0, 0, 0, 0, 0, 0 };
+
+    for (int frame = -warmupFrames; frame < config.frames; ++frame)
+    {
+        // Warm up frames replay the start of the path, compiling shaders and filling caches
+        const int pathFrame = std::max(frame, 0);
+        const float time = pathFrame / 60.0f;
+        placeCamera(config.path, config.frames > 1 ? (float)pathFrame / (config.frames - 1) : 0.0f);
+
+        uint64_t frameStart = Profiler::now();
+
+        const glm::mat4 view = camera.getViewMatrix();
+
+        frameData.beginFrame();
+        glm::mat4 frameMatrices[2] = { view, proj };
+        RingAllocation frameUniforms = frameData.allocateUniform(sizeof(frameMatrices));
+        memcpy(frameUniforms.data, frameMatrices, sizeof(frameMatrices));
+
+        commands.reset();
+        visibleEntities.clear();
+
+        if (config.pipeline == ScenePipeline::Unlit)
+        {
+            commands.bindFramebuffer(context.getFramebuffer());
+            commands.setViewport(0, 0, viewportWidth, viewportHeight);
+            commands.clear(glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
+
+            commands.useProgram(unlitShader.shaderProgramID);
+            commands.bindTexture(0, resources.containerMap);
+            commands.bindTexture(1, resources.faceMap);
+            commands.bindVertexArray(resources.cubeVAO);
+
+            for (const glm::vec3 &position : demoCubePositions)
+            {
+                glm::mat4 model = glm::translate(glm::mat4(1.0f), position);
+                model = glm::rotate(model, time * glm::radians(-55.0f), glm::vec3(1.0f, 1.0f, 0.0f));
+
+                commands.setUniform("mvp", proj * view * model);
+                commands.drawArrays(PrimitiveType::Triangles, 0, 36);
+            }
+        }
+        else
+        {
+            // Bob the lamps of the clustered scene so light assignment changes every frame
+            if (config.pipeline == ScenePipeline::Clustered)
+            {
+                frameLights.clear();
+                world.view<Transform, SceneNode, PointLight>().each([&](Transform &transform, SceneNode &node, PointLight &light)
+                {
+                    glm::vec3 position = transform.position + glm::vec3(0.0f, sinf(time + transform.position.x), 0.0f);
+                    hierarchy.setPosition(node.node, position);
+
+                    GpuPointLight gpuLight;
+                    gpuLight.positionRange = glm::vec4(position, ClusteredLighting::computeRange(light));
+                    gpuLight.ambient = glm::vec4(light.ambient, 0.0f);
+                    gpuLight.diffuse = glm::vec4(light.diffuse, 0.0f);
+                    gpuLight.specular = glm::vec4(light.specular, 0.0f);
+                    gpuLight.attenuation = glm::vec4(light.attConstant, light.attLinear, light.attQuadratic, 0.0f);
+                    frameLights.push_back(gpuLight);
+                });
+            }
+
+            hierarchy.update();
+
+            if (config.pipeline == ScenePipeline::Clustered)
+                clusteredLighting.assignLights(frameLights, view, jobSystem);
+
+            cullEntities(world, hierarchy, Frustum(proj * view), jobSystem, visibleEntities);
+
+            renderQueue.reset();
+            for (const Entity &entity : visibleEntities)
+            {
+                const SceneNode* node = world.getComponent<SceneNode>(entity);
+                const MeshRef* mesh = world.getComponent<MeshRef>(entity);
+                const MaterialRef* material = world.getComponent<MaterialRef>(entity);
+
+                if (!mesh || !material)
+                    continue;
+
+                DrawPacket packet;
+                packet.program = material->shaderProgramID;
+                packet.vertexArray = mesh->VAO;
+                packet.diffuseMap = material->diffuseMapID;
+                packet.specularMap = material->specularMapID;
+                packet.material = 0;
+                packet.shine = 0.0f;
+                packet.first = mesh->firstVertex;
+                packet.count = mesh->vertexCount;
+                packet.indexed = mesh->indexed;
+                packet.model = hierarchy.getWorldMatrix(node->node);
+                packet.normalMatrix = hierarchy.getNormalMatrix(node->node);
+
+                float viewDepth = glm::dot(glm::vec3(packet.model[3]) - camera.pos, camera.front);
+                renderQueue.submit(packet, RenderPass::Opaque, false, viewDepth);
+            }
+
+            renderQueue.sort();
+
+            // Shadow passes end on the default framebuffer, the offscreen one is bound after them
+            if (shadows)
+            {
+                shadows->update(camera, aspectRatio, dirLightDirection);
+                shadows->render(world, hierarchy, jobSystem, frameData, commands, depthShader.shaderProgramID);
+            }
+
+            commands.bindFramebuffer(context.getFramebuffer());
+            commands.setViewport(0, 0, viewportWidth, viewportHeight);
+            commands.clear(glm::vec4(0.1f, 0.1f, 0.1f, 1.0f));
+            commands.bindBufferRange(BufferTarget::Uniform, 0, frameUniforms.buffer, frameUniforms.offset, frameUniforms.size);
+
+            commands.useProgram(litShader.shaderProgramID);
+            commands.setUniform("cameraPos", camera.pos);
+
+            if (shadows)
+                shadows->apply(commands, forwardShader.shaderProgramID);
+            else
+                clusteredLighting.upload(frameData, commands, clusteredShader.shaderProgramID);
+
+            renderQueue.record(commands);
+        }
+
+        // Static uniforms above were set through the Shader API, behind the backend's back
+        backend.invalidateState();
+        RenderStats stats = backend.execute(commands);
+
+        uint64_t submitted = Profiler::now();
+        glFinish();
+        uint64_t frameEnd = Profiler::now();
+
+        frameData.endFrame();
+
+        if (frame < 0)
+            continue;
+
+        cpuTimes.push_back((submitted - frameStart) / 1000000.0);
+        frameTimes.push_back((frameEnd - frameStart) / 1000000.0);
+
+        uint32_t stateChanges = stats.programChanges + stats.textureBinds + stats.vertexArrayBinds;
+        result.maxDrawCalls = std::max(result.maxDrawCalls, stats.drawCalls);
+        result.maxStateChanges = std::max(result.maxStateChanges, stateChanges);
+        totalStateChanges += stateChanges;
+
+        totals[0] += stats.drawCalls;
+        totals[1] += stats.programChanges;
+        totals[2] += stats.textureBinds;
+        totals[3] += stats.vertexArrayBinds;
+        totals[4] += visibleEntities.size();
+        totals[5] += commands.size();
+    }
+
+    const double frames = std::max(config.frames, 1);
+    result.cpu = computeFrameTimeStats(cpuTimes);
+    result.frame = computeFrameTimeStats(frameTimes);
+    result.drawCalls = totals[0] / frames;
+    result.programChanges = totals[1] / frames;
+    result.textureBinds = totals[2] / frames;
+    result.vertexArrayBinds = totals[3] / frames;
+    result.visibleEntities = totals[4] / frames;
+    result.commandBytes = totals[5] / frames;
+
+    result.residentAfterKB = readResidentKB();
+    result.peakResidentKB = std::max(readPeakResidentKB(), result.residentAfterKB);
+
+    return result;
+}
+
+void writeFrameStats(FILE* out, const char* name, const FrameTimeStats &stats)
+{
+    fprintf(out, "      \"%s\": { \"mean\": %.4f, \"min\": %.4f, \"p50\": %.4f, \"p90\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f },\n",
+            name, stats.mean, stats.min, stats.p50, stats.p90, stats.p95, stats.p99, stats.max);
+}
+
+void writeResults(FILE* out, const std::vector<SceneResult> &results, const HeadlessContext &context)
+{
+    fprintf(out, "{\n");
+    fprintf(out, "  \"renderer\": \"%s\",\n", (const char*)glGetString(GL_RENDERER));
+    fprintf(out, "  \"resolution\": [%d, %d],\n", context.getWidth(), context.getHeight());
+    fprintf(out, "  \"scenes\": [\n");
+
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const SceneResult &result = results[i];
+
+        fprintf(out, "    {\n");
+        fprintf(out, "      \"name\": \"%s\",\n", result.name);
+        fprintf(out, "      \"frames\": %u,\n", result.cpu.frames);
+        writeFrameStats(out, "cpuMs", result.cpu);
+        writeFrameStats(out, "frameMs", result.frame);
+        fprintf(out, "      \"perFrame\": { \"drawCalls\": %.1f, \"programChanges\": %.1f, \"textureBinds\": %.1f, \"vertexArrayBinds\": %.1f, \"visibleEntities\": %.1f, \"commandBytes\": %.0f },\n",
+                result.drawCalls, result.programChanges, result.textureBinds, result.vertexArrayBinds, result.visibleEntities, result.commandBytes);
+        fprintf(out, "      \"max\": { \"drawCalls\": %u, \"stateChanges\": %u },\n", result.maxDrawCalls, result.maxStateChanges);
+        fprintf(out, "      \"memoryKB\": { \"residentBefore\": %ld, \"residentAfter\": %ld, \"peakResident\": %ld }\n",
+                result.residentBeforeKB, result.residentAfterKB, result.peakResidentKB);
+        fprintf(out, "    }%s\n", i + 1 < results.size() ? "," : "");
+    }
+
+    fprintf(out, "  ]\n}\n");
+}
+
+int main(int argc, char** argv)
+{
+    int frameOverride = 0, warmupFrames = 10;
+    int viewportWidth = 800, viewportHeight = 600;
+    const char* outputPath = "benchmark.json";
+    std::vector<std::string> selected;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "--scene") && i + 1 < argc)
+            selected.push_back(argv[++i]);
+        else if (!strcmp(argv[i], "--frames") && i + 1 < argc)
+            frameOverride = std::max(atoi(argv[++i]), 1);
+        else if (!strcmp(argv[i], "--warmup") && i + 1 < argc)
+            warmupFrames = std::max(atoi(argv[++i]), 0);
+        else if (!strcmp(argv[i], "--size") && i + 1 < argc)
+        {
+            if (sscanf(argv[++i], "%dx%d", &viewportWidth, &viewportHeight) != 2 || viewportWidth <= 0 || viewportHeight <= 0)
+            {
+                std::cout << "ERROR: SceneBenchmark -> Invalid --size, expected WIDTHxHEIGHT" << std::endl;
+                return -1;
+            }
+        }
+        else if (!strcmp(argv[i], "--output") && i + 1 < argc)
+            outputPath = argv[++i];
+        else
+        {
+            std::cout << "ERROR: SceneBenchmark -> Unknown argument " << argv[i] << std::endl;
+            return -1;
+        }
+    }
+
+    // Frame counts keep each scene at a few seconds on a software rasterizer
+    std::vector<SceneConfig> scenes = {
+        { "main",      ScenePipeline::Unlit,     0,      0,    600, orbitPath(glm::vec3(0.0f, 0.0f, -6.0f), 10.0f, 1.0f) },
+        { "lighting",  ScenePipeline::Forward,   0,      0,    300, orbitPath(glm::vec3(0.0f, 0.0f, -6.0f), 10.0f, 2.0f) },
+        { "cubes10k",  ScenePipeline::Forward,   10000,  4,    120, flyoverPath(10000) },
+        { "cubes100k", ScenePipeline::Forward,   100000, 4,    30,  flyoverPath(100000) },
+        { "lights1k",  ScenePipeline::Clustered, 1024,   1000, 120, flyoverPath(1024) }
+    };
+
+    HeadlessContext context(viewportWidth, viewportHeight);
+    if (!context.isValid())
+        return -1;
+
+    GLint majorVersion = 0, minorVersion = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &majorVersion);
+    glGetIntegerv(GL_MINOR_VERSION, &minorVersion);
+    if (majorVersion * 10 + minorVersion < 46)
+        ShaderPreprocessor::versionOverride = "#version 450 core";
+
+    glEnable(GL_DEPTH_TEST);
+
+    JobSystem jobSystem;
+
+    SharedResources resources;
+    defineCube(resources);
+
+    Texture textures;
+    std::vector<unsigned int> textureIDs = textures.loadBatch({
+        "assets/Textures/wood_container.jpg",
+        "assets/Textures/awesome_face.png",
+        "assets/Textures/diffuse_wood_container.png",
+        "assets/Textures/specular_wood_container.png"
+    }, jobSystem);
+
+    resources.containerMap = textureIDs[0];
+    resources.faceMap = textureIDs[1];
+    resources.diffuseMap = textureIDs[2];
+    resources.specularMap = textureIDs[3];
+
+    std::vector<SceneResult> results;
+    for (SceneConfig &scene : scenes)
+    {
+        if (!selected.empty() && std::find(selected.begin(), selected.end(), scene.name) == selected.end())
+            continue;
+
+        if (frameOverride)
+            scene.frames = frameOverride;
+
+        results.push_back(runScene(scene, warmupFrames, context, resources, jobSystem));
+        printFrameTimeStats(scene.name, results.back().frame);
+    }
+
+    if (results.empty())
+    {
+        std::cout << "ERROR: SceneBenchmark -> No scene matched" << std::endl;
+        return -1;
+    }
+
+    FILE* out = strcmp(outputPath, "-") ? fopen(outputPath, "w") : stdout;
+    if (!out)
+    {
+        std::cout << "ERROR: SceneBenchmark -> Unable to open " << outputPath << std::endl;
+        return -1;
+    }
+
+    writeResults(out, results, context);
+
+    if (out != stdout)
+        fclose(out);
+
+    return 0;
+}
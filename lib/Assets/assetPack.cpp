@@ -0,0 +1,548 @@
+#include "assetPack.h"
+
+/* FNV-1a, 64 bit */
+static uint64_t fnv1a(const unsigned char* data, const size_t size, uint64_t hash = 14695981039346656037ull)
+{
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= data[i];
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
+
+static const char* compressionName(const AssetCompression compression)
+{
+    switch (compression)
+    {
+        case AssetCompression::LZ4: return "LZ4";
+        case AssetCompression::Zstd: return "Zstd";
+        default: return "none";
+    }
+}
+
+/* Constructor */
+AssetPack::AssetPack()
+    : header { NULL },
+      entries { NULL },
+      blobs { NULL },
+      strings { NULL }
+{
+}
+
+/* Public */
+bool AssetPack::open(const char* path)
+{
+    PROFILE_SCOPE("AssetPack::open");
+
+    close();
+    if (!file.open(path))
+        return false;
+
+    this->path = path;
+    const size_t size = file.size();
+    const AssetPackHeader* candidate = (const AssetPackHeader*)file.data();
+
+    if (size < sizeof(AssetPackHeader) || candidate->magic != AssetPackMagic || candidate->byteOrder != AssetPackByteOrder
+        || candidate->version != AssetPackVersion)
+    {
+        std::cout << "ERROR: AssetPack -> " << path << " isn't an asset pack of this version" << std::endl;
+        close();
+        return false;
+    }
+
+    const uint64_t tocSize = sizeof(AssetPackHeader) + sizeof(AssetPackEntry) * (uint64_t)candidate->entryCount
+                           + sizeof(AssetPackBlob) * (uint64_t)candidate->blobCount + candidate->stringsSize;
+    if (tocSize > size)
+    {
+        std::cout << "ERROR: AssetPack -> " << path << " is truncated" << std::endl;
+        close();
+        return false;
+    }
+
+    entries = (const AssetPackEntry*)(file.data() + sizeof(AssetPackHeader));
+    blobs = (const AssetPackBlob*)(entries + candidate->entryCount);
+    strings = (const char*)(blobs + candidate->blobCount);
+
+    /* Everything the lookups and reads trust, checked once */
+    bool valid = true;
+    for (uint32_t i = 0; i < candidate->blobCount && valid; ++i)
+        valid = blobs[i].offset % AssetPackAlignment == 0 && blobs[i].offset <= size && blobs[i].storedSize <= size - blobs[i].offset;
+
+    for (uint32_t i = 0; i < candidate->entryCount && valid; ++i)
+        valid = entries[i].blob < candidate->blobCount && (uint64_t)entries[i].pathOffset + entries[i].pathLength <= candidate->stringsSize
+             && (i == 0 || entries[i - 1].id < entries[i].id);
+
+    if (!valid)
+    {
+        std::cout << "ERROR: AssetPack -> " << path << " has a corrupt table of contents" << std::endl;
+        close();
+        return false;
+    }
+
+    header = candidate;
+    file.adviseSequential();
+    return true;
+}
+
+void AssetPack::close()
+{
+    file.close();
+    path.clear();
+    header = NULL;
+    entries = NULL;
+    blobs = NULL;
+    strings = NULL;
+}
+
+bool AssetPack::isValid() const
+{
+    return header != NULL;
+}
+
+uint64_t AssetPack::hashPath(const char* path)
+{
+    std::string normalized = normalizePath(path);
+    return fnv1a((const unsigned char*)normalized.data(), normalized.size());
+}
+
+std::string AssetPack::normalizePath(const char* path)
+{
+    std::string normalized = path;
+    std::replace(normalized.begin(), normalized.end(), '\\', '/');
+
+    while (normalized.compare(0, 2, "./") == 0)
+        normalized.erase(0, 2);
+
+    return normalized;
+}
+
+bool AssetPack::contains(const char* path) const
+{
+    return find(path) != NULL;
+}
+
+bool AssetPack::read(const char* path, std::vector<unsigned char> &data) const
+{
+    const AssetPackEntry* entry = find(path);
+    if (!entry)
+    {
+        std::cout << "ERROR: AssetPack -> " << path << " isn't in " << this->path << std::endl;
+        return false;
+    }
+
+    return readBlob(entry->blob, data);
+}
+
+bool AssetPack::readBatch(const std::vector<const char*> &paths, std::vector<std::vector<unsigned char>> &data, JobSystem &jobSystem) const
+{
+    PROFILE_SCOPE("AssetPack::readBatch");
+
+    data.assign(paths.size(), std::vector<unsigned char>());
+
+    /* The first request of each blob decompresses it, the others copy the result */
+    std::vector<uint32_t> firstRequest(paths.size());
+    std::vector<uint32_t> unique;
+    std::unordered_map<uint32_t, uint32_t> requestsByBlob;
+    bool valid = true;
+
+    for (uint32_t i = 0; i < paths.size(); ++i)
+    {
+        const AssetPackEntry* entry = find(paths[i]);
+        if (!entry)
+        {
+            std::cout << "ERROR: AssetPack -> " << paths[i] << " isn't in " << path << std::endl;
+            firstRequest[i] = UINT32_MAX;
+            valid = false;
+            continue;
+        }
+
+        std::pair<std::unordered_map<uint32_t, uint32_t>::iterator, bool> inserted = requestsByBlob.emplace(entry->blob, i);
+        firstRequest[i] = inserted.first->second;
+        if (inserted.second)
+            unique.push_back(i);
+    }
+
+    std::vector<uint8_t> succeeded(paths.size(), 0);
+    jobSystem.parallelFor((uint32_t)unique.size(), 1, [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t u = begin; u < end; ++u)
+        {
+            uint32_t request = unique[u];
+            succeeded[request] = readBlob(find(paths[request])->blob, data[request]) ? 1 : 0;
+        }
+    });
+
+    for (uint32_t i = 0; i < paths.size(); ++i)
+    {
+        if (firstRequest[i] == UINT32_MAX)
+            continue;
+
+        if (firstRequest[i] != i)
+            data[i] = data[firstRequest[i]];
+
+        valid = valid && succeeded[firstRequest[i]];
+    }
+
+    return valid;
+}
+
+bool AssetPack::readAsync(const std::vector<const char*> &paths, AsyncFileReader &reader,
+                          std::function<void(const uint32_t index, const unsigned char* data, const size_t size)> onLoaded,
+                          JobCounter* counter) const
+{
+    PROFILE_SCOPE("AssetPack::readAsync");
+
+    std::unordered_map<uint32_t, std::vector<uint32_t>> requestsByBlob;
+    bool valid = true;
+
+    for (uint32_t i = 0; i < paths.size(); ++i)
+    {
+        const AssetPackEntry* entry = find(paths[i]);
+        if (entry)
+        {
+            requestsByBlob[entry->blob].push_back(i);
+            continue;
+        }
+
+        std::cout << "ERROR: AssetPack -> " << paths[i] << " isn't in " << path << std::endl;
+        onLoaded(i, NULL, 0);
+        valid = false;
+    }
+
+    if (requestsByBlob.empty())
+        return valid;
+
+    /* A descriptor of its own, closed once the last blob's job has released it */
+    int descriptor = reader.openFile(path.c_str(), true);
+    if (descriptor < 0)
+    {
+        for (const std::pair<const uint32_t, std::vector<uint32_t>> &blob : requestsByBlob)
+            for (uint32_t request : blob.second)
+                onLoaded(request, NULL, 0);
+        return false;
+    }
+
+    std::shared_ptr<int> file(new int(descriptor), [&reader](int* file)
+    {
+        reader.closeFile(*file);
+        delete file;
+    });
+
+    /* In file order, so the device sees one forward sweep */
+    std::vector<uint32_t> order;
+    for (const std::pair<const uint32_t, std::vector<uint32_t>> &blob : requestsByBlob)
+        order.push_back(blob.first);
+    std::sort(order.begin(), order.end(), [this](const uint32_t a, const uint32_t b) { return blobs[a].offset < blobs[b].offset; });
+
+    std::vector<FileReadRequest> reads;
+    for (uint32_t blob : order)
+    {
+        /* Blobs start on 4K boundaries and the file ends on one, so the rounded up read stays inside it */
+        const AssetPackBlob* stored = &blobs[blob];
+        std::shared_ptr<IOBuffer> buffer = std::make_shared<IOBuffer>((size_t)stored->storedSize);
+        std::vector<uint32_t> requests = std::move(requestsByBlob[blob]);
+
+        reads.push_back({ descriptor, stored->offset, buffer->size(), buffer->data(),
+                          [this, stored, buffer, requests, file, onLoaded](const int64_t result)
+        {
+            PROFILE_SCOPE("AssetPack decode");
+
+            static const unsigned char empty = 0;
+            const unsigned char* data = NULL;
+            std::vector<unsigned char> decoded;
+
+            if (result < (int64_t)stored->storedSize)
+                std::cout << "ERROR: AssetPack -> Reading a blob from " << path << " failed"
+                          << (result < 0 ? std::string(": ") + strerror((int)-result) : std::string(", it's truncated")) << std::endl;
+            else if (stored->compression == AssetCompression::None && stored->storedSize == stored->size)
+                data = stored->size > 0 ? buffer->data() : &empty;
+            else if (decodeBlob(*stored, (const char*)buffer->data(), decoded))
+                data = decoded.empty() ? &empty : decoded.data();
+
+            for (uint32_t request : requests)
+                onLoaded(request, data, data ? (size_t)stored->size : 0);
+        } });
+    }
+
+    reader.read(std::move(reads), counter);
+    return valid;
+}
+
+uint32_t AssetPack::getEntryCount() const
+{
+    return header ? header->entryCount : 0;
+}
+
+std::string AssetPack::getEntryPath(const uint32_t entry) const
+{
+    return std::string(strings + entries[entry].pathOffset, entries[entry].pathLength);
+}
+
+const AssetPackBlob &AssetPack::getEntryBlob(const uint32_t entry) const
+{
+    return blobs[entries[entry].blob];
+}
+
+/* Private */
+const AssetPackEntry* AssetPack::find(const char* path) const
+{
+    if (!header)
+        return NULL;
+
+    uint64_t id = hashPath(path);
+    const AssetPackEntry* end = entries + header->entryCount;
+    const AssetPackEntry* entry = std::lower_bound(entries, end, id, [](const AssetPackEntry &entry, const uint64_t id)
+    {
+        return entry.id < id;
+    });
+
+    return entry != end && entry->id == id ? entry : NULL;
+}
+
+bool AssetPack::readBlob(const uint32_t blob, std::vector<unsigned char> &data) const
+{
+    return decodeBlob(blobs[blob], file.data() + blobs[blob].offset, data);
+}
+
+bool AssetPack::decodeBlob(const AssetPackBlob &stored, const char* source, std::vector<unsigned char> &data) const
+{
+    data.resize(stored.size);
+    bool decoded = false;
+
+    switch (stored.compression)
+    {
+        case AssetCompression::None:
+            decoded = stored.storedSize == stored.size;
+            if (decoded && stored.size > 0)
+                memcpy(data.data(), source, stored.size);
+            break;
+
+        case AssetCompression::LZ4:
+#ifdef ASSET_PACK_LZ4
+            decoded = stored.storedSize <= INT32_MAX && stored.size <= INT32_MAX
+                   && LZ4_decompress_safe(source, (char*)data.data(), (int)stored.storedSize, (int)stored.size) == (int)stored.size;
+#endif
+            break;
+
+        case AssetCompression::Zstd:
+#ifdef ASSET_PACK_ZSTD
+            decoded = ZSTD_decompress(data.data(), stored.size, source, stored.storedSize) == stored.size;
+#endif
+            break;
+    }
+
+    if (!decoded)
+    {
+        std::cout << "ERROR: AssetPack -> Can't decode a " << compressionName(stored.compression) << " blob in " << path
+                  << ", it's corrupt or the codec wasn't compiled in" << std::endl;
+        data.clear();
+    }
+
+    return decoded;
+}
+
+/* Constructor */
+AssetPackWriter::AssetPackWriter()
+    : compression { AssetCompression::LZ4 },
+      level { 0 }
+{
+}
+
+/* Public */
+bool AssetPackWriter::add(const char* path, const unsigned char* data, const size_t size)
+{
+    std::string normalized = AssetPack::normalizePath(path);
+    uint64_t id = AssetPack::hashPath(path);
+
+    std::unordered_map<uint64_t, uint32_t>::const_iterator existingEntry = entriesById.find(id);
+    if (existingEntry != entriesById.end())
+    {
+        const std::string &existingPath = entries[existingEntry->second].path;
+        std::cout << "ERROR: AssetPackWriter -> " << normalized << (existingPath == normalized ? " was already added" : " has the same ID as " + existingPath) << std::endl;
+        return false;
+    }
+
+    /* Content addressed: a hash match is only a candidate, the bytes decide */
+    uint64_t contentHash = hashContent(data, size);
+    uint32_t blob = (uint32_t)blobs.size();
+
+    auto candidates = blobsByHash.equal_range(contentHash);
+    for (auto candidate = candidates.first; candidate != candidates.second; ++candidate)
+    {
+        const std::vector<unsigned char> &existing = blobs[candidate->second];
+        if (existing.size() == size && (size == 0 || memcmp(existing.data(), data, size) == 0))
+        {
+            blob = candidate->second;
+            break;
+        }
+    }
+
+    if (blob == blobs.size())
+    {
+        blobs.push_back(std::vector<unsigned char>(data, data + size));
+        blobsByHash.emplace(contentHash, blob);
+    }
+
+    entriesById.emplace(id, (uint32_t)entries.size());
+    entries.push_back(PendingEntry { id, normalized, blob });
+    return true;
+}
+
+bool AssetPackWriter::addFile(const char* path)
+{
+    MappedFile file;
+    if (!file.open(path))
+        return false;
+
+    return add(path, (const unsigned char*)file.data(), file.size());
+}
+
+bool AssetPackWriter::write(const char* path, JobSystem &jobSystem)
+{
+    PROFILE_SCOPE("AssetPackWriter::write");
+
+#ifndef ASSET_PACK_LZ4
+    if (compression == AssetCompression::LZ4)
+    {
+        std::cout << "WARNING: AssetPackWriter -> Built without LZ4, storing uncompressed" << std::endl;
+        compression = AssetCompression::None;
+    }
+#endif
+#ifndef ASSET_PACK_ZSTD
+    if (compression == AssetCompression::Zstd)
+    {
+        std::cout << "WARNING: AssetPackWriter -> Built without Zstd, storing uncompressed" << std::endl;
+        compression = AssetCompression::None;
+    }
+#endif
+
+    /* Compressed copies, empty where the blob stays uncompressed */
+    std::vector<std::vector<unsigned char>> compressed(blobs.size());
+    if (compression != AssetCompression::None)
+    {
+        jobSystem.parallelFor((uint32_t)blobs.size(), 1, [&](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t i = begin; i < end; ++i)
+                if (!compress(compression, level, blobs[i], compressed[i]) || compressed[i].size() >= blobs[i].size())
+                    compressed[i].clear();
+        });
+    }
+
+    std::vector<PendingEntry> sortedEntries = entries;
+    std::sort(sortedEntries.begin(), sortedEntries.end(), [](const PendingEntry &a, const PendingEntry &b) { return a.id < b.id; });
+
+    std::vector<AssetPackEntry> packEntries;
+    std::string strings;
+    for (const PendingEntry &entry : sortedEntries)
+    {
+        packEntries.push_back(AssetPackEntry { entry.id, entry.blob, (uint32_t)strings.size(), (uint32_t)entry.path.size(), 0 });
+        strings += entry.path;
+    }
+
+    AssetPackHeader header = { AssetPackMagic, AssetPackVersion, AssetPackByteOrder, (uint32_t)packEntries.size(),
+                               (uint32_t)blobs.size(), (uint32_t)strings.size() };
+
+    uint64_t offset = sizeof(header) + sizeof(AssetPackEntry) * packEntries.size() + sizeof(AssetPackBlob) * blobs.size() + strings.size();
+    std::vector<AssetPackBlob> packBlobs;
+    for (size_t i = 0; i < blobs.size(); ++i)
+    {
+        bool isCompressed = !compressed[i].empty();
+        offset = (offset + AssetPackAlignment - 1) / AssetPackAlignment * AssetPackAlignment;
+        packBlobs.push_back(AssetPackBlob { offset, isCompressed ? compressed[i].size() : blobs[i].size(), blobs[i].size(),
+                                            isCompressed ? compression : AssetCompression::None, 0 });
+        offset += packBlobs.back().storedSize;
+    }
+    const uint64_t fileSize = (offset + AssetPackAlignment - 1) / AssetPackAlignment * AssetPackAlignment;
+
+    FILE* file = fopen(path, "wb");
+    if (!file)
+    {
+        std::cout << "ERROR: AssetPackWriter -> Unable to open " << path << " for writing" << std::endl;
+        return false;
+    }
+
+    static const char padding[AssetPackAlignment] = {};
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1
+                && fwrite(packEntries.data(), sizeof(AssetPackEntry), packEntries.size(), file) == packEntries.size()
+                && fwrite(packBlobs.data(), sizeof(AssetPackBlob), packBlobs.size(), file) == packBlobs.size()
+                && fwrite(strings.data(), 1, strings.size(), file) == strings.size();
+
+    offset = sizeof(header) + sizeof(AssetPackEntry) * packEntries.size() + sizeof(AssetPackBlob) * blobs.size() + strings.size();
+    for (size_t i = 0; i <= blobs.size() && written; ++i)
+    {
+        /* The last round only pads the file's end */
+        uint64_t target = i < blobs.size() ? packBlobs[i].offset : fileSize;
+        written = fwrite(padding, 1, (size_t)(target - offset), file) == target - offset;
+        if (i == blobs.size() || !written)
+            break;
+
+        const std::vector<unsigned char> &stored = compressed[i].empty() ? blobs[i] : compressed[i];
+        written = fwrite(stored.data(), 1, stored.size(), file) == stored.size();
+        offset = target + stored.size();
+    }
+
+    written = fclose(file) == 0 && written;
+    if (!written)
+        std::cout << "ERROR: AssetPackWriter -> Failed writing " << path << std::endl;
+
+    return written;
+}
+
+uint32_t AssetPackWriter::getEntryCount() const
+{
+    return (uint32_t)entries.size();
+}
+
+uint32_t AssetPackWriter::getBlobCount() const
+{
+    return (uint32_t)blobs.size();
+}
+
+/* Private */
+uint64_t AssetPackWriter::hashContent(const unsigned char* data, const size_t size)
+{
+    return fnv1a(data, size);
+}
+
+bool AssetPackWriter::compress(const AssetCompression compression, const int level, const std::vector<unsigned char> &data, std::vector<unsigned char> &compressed)
+{
+    /* Only read by the codecs that are built in */
+    (void)level;
+    (void)data;
+    (void)compressed;
+
+    switch (compression)
+    {
+#ifdef ASSET_PACK_LZ4
+        case AssetCompression::LZ4:
+        {
+            if (data.size() > (size_t)LZ4_MAX_INPUT_SIZE)
+                return false;
+
+            compressed.resize(LZ4_compressBound((int)data.size()));
+            int size = LZ4_compress_HC((const char*)data.data(), (char*)compressed.data(), (int)data.size(), (int)compressed.size(),
+                                       level > 0 ? level : LZ4HC_CLEVEL_DEFAULT);
+            compressed.resize(size > 0 ? size : 0);
+            return size > 0;
+        }
+#endif
+
+#ifdef ASSET_PACK_ZSTD
+        case AssetCompression::Zstd:
+        {
+            compressed.resize(ZSTD_compressBound(data.size()));
+            size_t size = ZSTD_compress(compressed.data(), compressed.size(), data.data(), data.size(), level > 0 ? level : ZSTD_CLEVEL_DEFAULT);
+            if (ZSTD_isError(size))
+                return false;
+
+            compressed.resize(size);
+            return true;
+        }
+#endif
+
+        default:
+            return false;
+    }
+}
@@ -0,0 +1,180 @@
+#ifndef ASSET_PACK
+#define ASSET_PACK
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+#include <iostream>
+
+/*  Codecs are opt-in so builds without them link: define ASSET_PACK_WITH_LZ4 and link -llz4,
+    ASSET_PACK_WITH_ZSTD and link -lzstd. Packs using a codec that isn't built in can't be read */
+#if defined(ASSET_PACK_WITH_LZ4)
+#define ASSET_PACK_LZ4
+#include <lz4.h>
+#include <lz4hc.h>
+#endif
+#if defined(ASSET_PACK_WITH_ZSTD)
+#define ASSET_PACK_ZSTD
+#include <zstd.h>
+#endif
+
+#include "../Platform/mappedFile.h"
+#include "../Platform/asyncFileReader.h"
+#include "../Jobs/jobSystem.h"
+#include "../Profiler/profiler.h"
+
+enum class AssetCompression : uint32_t
+{
+    None,
+    LZ4,        /* Fast to decode, for data read every run */
+    Zstd        /* Smaller, for data that's streamed in rarely */
+};
+
+/*  Asset pack file (.pack), little endian:
+
+        AssetPackHeader
+        AssetPackEntry[entryCount]   sorted by id
+        AssetPackBlob[blobCount]
+        char[stringsSize]            the entries' paths
+        blob data, each blob starting on an AssetPackAlignment boundary
+
+    Entries are assets by ID, the FNV-1a hash of their path. Blobs are distinct contents:
+    identical files under different paths, within or across the packs' inputs, are stored
+    once and shared by their entries. Blob offsets and the file's end are 4K aligned so
+    blobs can be read with direct I/O. */
+const uint32_t AssetPackMagic = 0x4B415041;     /* "APAK" */
+const uint32_t AssetPackVersion = 1;
+const uint32_t AssetPackByteOrder = 0x01020304;
+const uint64_t AssetPackAlignment = 4096;
+
+struct AssetPackHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t entryCount;
+    uint32_t blobCount;
+    uint32_t stringsSize;
+};
+
+struct AssetPackEntry
+{
+    uint64_t id;
+    uint32_t blob;
+    uint32_t pathOffset;
+    uint32_t pathLength;
+    uint32_t reserved;
+};
+
+struct AssetPackBlob
+{
+    uint64_t offset;
+    uint64_t storedSize;    /* Compressed */
+    uint64_t size;
+    AssetCompression compression;
+    uint32_t reserved;
+};
+
+/*  Read only view of a pack. The table of contents is used in place from the mapping,
+    lookups are a binary search over the entry IDs. Reads decompress into the caller's
+    buffers; readBatch spreads them over the job system and decodes shared blobs once.
+    readAsync reads blobs with direct I/O instead of through the mapping, for streaming.
+
+    Paths are normalized before hashing ('\' to '/', no leading "./"), so the IDs match
+    the relative paths the engine already uses for loose files. */
+class AssetPack
+{
+    public:
+        /* Constructor */
+        AssetPack();
+
+        /* Closes the current pack first, false if the new one can't be opened or is invalid */
+        bool open(const char* path);
+        void close();
+
+        bool isValid() const;
+
+        static uint64_t hashPath(const char* path);
+        static std::string normalizePath(const char* path);
+
+        bool contains(const char* path) const;
+
+        /* Decompressed, false if the asset isn't in the pack or is corrupt */
+        bool read(const char* path, std::vector<unsigned char> &data) const;
+
+        /* One result per path, false if any of them failed (the others are still filled in) */
+        bool readBatch(const std::vector<const char*> &paths, std::vector<std::vector<unsigned char>> &data, JobSystem &jobSystem) const;
+
+        /*  Queues every distinct blob on the reader as one batch and decompresses each in its
+            completion job. onLoaded runs once per path, on that job, with NULL if the asset
+            failed; the data is only valid during the call. Paths the pack doesn't have get
+            their NULL right away and make it return false. The pack has to stay open until
+            the counter is zero */
+        bool readAsync(const std::vector<const char*> &paths, AsyncFileReader &reader,
+                       std::function<void(const uint32_t index, const unsigned char* data, const size_t size)> onLoaded,
+                       JobCounter* counter = NULL) const;
+
+        uint32_t getEntryCount() const;
+        std::string getEntryPath(const uint32_t entry) const;
+        const AssetPackBlob &getEntryBlob(const uint32_t entry) const;
+
+    private:
+        MappedFile file;
+        std::string path;
+
+        const AssetPackHeader* header;
+        const AssetPackEntry* entries;
+        const AssetPackBlob* blobs;
+        const char* strings;
+
+        const AssetPackEntry* find(const char* path) const;
+        bool readBlob(const uint32_t blob, std::vector<unsigned char> &data) const;
+        bool decodeBlob(const AssetPackBlob &stored, const char* source, std::vector<unsigned char> &data) const;
+};
+
+/*  Builds a pack in memory and writes it out. Contents are deduplicated as they're added,
+    compressed in parallel on write, and stored uncompressed wherever compressing doesn't
+    make them smaller (images that already are PNG or JPEG, mostly). */
+class AssetPackWriter
+{
+    public:
+        /* Constructor */
+        AssetPackWriter();
+
+        AssetCompression compression;
+        int level;      /* Codec specific, 0 for its default */
+
+        /* False if the path is already in the pack, or hashes like another path */
+        bool add(const char* path, const unsigned char* data, const size_t size);
+        bool addFile(const char* path);
+
+        bool write(const char* path, JobSystem &jobSystem);
+
+        uint32_t getEntryCount() const;
+        uint32_t getBlobCount() const;
+
+    private:
+        struct PendingEntry
+        {
+            uint64_t id;
+            std::string path;
+            uint32_t blob;
+        };
+
+        std::vector<PendingEntry> entries;
+        std::unordered_map<uint64_t, uint32_t> entriesById;
+        std::vector<std::vector<unsigned char>> blobs;
+        std::unordered_multimap<uint64_t, uint32_t> blobsByHash;
+
+        static uint64_t hashContent(const unsigned char* data, const size_t size);
+        static bool compress(const AssetCompression compression, const int level, const std::vector<unsigned char> &data, std::vector<unsigned char> &compressed);
+};
+
+#endif
@@ -0,0 +1,43 @@
+#include "assetTextures.h"
+
+std::vector<unsigned int> loadTextureBatch(const std::vector<const char*> &paths, const AssetPack &pack, Texture &textures,
+                                           AsyncFileReader &reader, JobSystem &jobSystem)
+{
+    PROFILE_SCOPE("loadTextureBatch");
+
+    /* stb's flip flag is global, so set it once before any decode job starts */
+    stbi_set_flip_vertically_on_load(true);
+
+    std::vector<DecodedImage> images(paths.size());
+    std::vector<const char*> packedPaths;
+    std::vector<uint32_t> packedImages;
+    JobCounter counter { 0 };
+
+    for (uint32_t i = 0; i < paths.size(); ++i)
+    {
+        if (pack.contains(paths[i]))
+        {
+            packedPaths.push_back(paths[i]);
+            packedImages.push_back(i);
+            continue;
+        }
+
+        reader.readFile(paths[i], [&images, i](const unsigned char* data, const size_t size)
+        {
+            images[i] = data ? Texture::decode(data, size) : DecodedImage { NULL, 0, 0, 0 };
+        }, &counter);
+    }
+
+    pack.readAsync(packedPaths, reader, [&images, &packedImages](const uint32_t index, const unsigned char* data, const size_t size)
+    {
+        images[packedImages[index]] = data ? Texture::decode(data, size) : DecodedImage { NULL, 0, 0, 0 };
+    }, &counter);
+
+    jobSystem.wait(counter);
+
+    std::vector<unsigned int> textureIDs;
+    for (size_t i = 0; i < paths.size(); ++i)
+        textureIDs.push_back(textures.upload(paths[i], images[i]));
+
+    return textureIDs;
+}
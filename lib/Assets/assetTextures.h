@@ -0,0 +1,19 @@
+#ifndef ASSET_TEXTURES
+#define ASSET_TEXTURES
+
+#include <string>
+#include <vector>
+
+#include "assetPack.h"
+#include "../Texture/texture.h"
+#include "../Jobs/jobSystem.h"
+#include "../Platform/asyncFileReader.h"
+
+/*  Texture::loadBatch reading from an asset pack: every image is queued on the reader at once
+    and decompressed and decoded in its completion job, then the textures are uploaded in order
+    on the calling thread. Paths the pack doesn't have (or every path, if it isn't open) are
+    read as loose files. */
+std::vector<unsigned int> loadTextureBatch(const std::vector<const char*> &paths, const AssetPack &pack, Texture &textures,
+                                           AsyncFileReader &reader, JobSystem &jobSystem);
+
+#endif
@@ -10,6 +10,9 @@ Camera::Camera()
     , minPitch { -89.0f }
     , maxPitch { 89.0f }
     , mouseSensitivity { 0.07f }
+    , fov { 45.0f }
+    , nearPlane { 0.1f }
+    , farPlane { 100.0f }
 {}
 
 const glm::vec3 Camera::getRight() const
@@ -22,6 +25,11 @@ const glm::mat4 Camera::getViewMatrix() const
     return glm::lookAt(pos, pos + front, up);
 }
 
+const glm::mat4 Camera::getProjectionMatrix(const float aspectRatio) const
+{
+    return glm::perspective(glm::radians(fov), aspectRatio, nearPlane, farPlane);
+}
+
 void Camera::moveForward(const float &speed)
 {
     Camera::addToPos(speed * front);
@@ -15,6 +15,7 @@ class Camera
         glm::vec3 pos, front, up;
         float pitch, yaw;
         float mouseSensitivity;
+        float fov, nearPlane, farPlane;
 
         /* Constructor */
         Camera();
@@ -22,6 +23,7 @@ class Camera
         /* Getters */
         const glm::vec3 getRight() const;
         const glm::mat4 getViewMatrix() const;
+        const glm::mat4 getProjectionMatrix(const float aspectRatio) const;
 
         /* Movement methods */
         void moveForward(const float &speed);
@@ -0,0 +1,48 @@
+#include "entityCuller.h"
+
+void cullEntities(const World &world, const TransformHierarchy &hierarchy, const Frustum &frustum,
+                  JobSystem &jobSystem, std::vector<Entity> &visible)
+{
+    PROFILE_SCOPE("cullEntities");
+
+    auto chunks = world.view<SceneNode, Bounds>().chunks();
+    std::vector<std::vector<Entity>> chunkResults(chunks.size());
+
+    const ComponentID nodeID = ComponentRegistry::id<SceneNode>();
+    const ComponentID boundsID = ComponentRegistry::id<Bounds>();
+
+    jobSystem.parallelFor(chunks.size(), 1, [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t c = begin; c < end; ++c)
+        {
+            Archetype* archetype = chunks[c].first;
+            const Chunk &chunk = *chunks[c].second;
+
+            const Entity* entities = archetype->entities(chunk);
+            const SceneNode* nodes = (const SceneNode*)archetype->column(chunk, nodeID);
+            const Bounds* bounds = (const Bounds*)archetype->column(chunk, boundsID);
+
+            /* World space AABBs enclosing the transformed local boxes, a block at a time */
+            const uint32_t blockSize = 256;
+            const glm::mat4* matrices[blockSize];
+            Bounds worldBounds[blockSize];
+
+            for (uint32_t blockBegin = 0; blockBegin < chunk.count; blockBegin += blockSize)
+            {
+                uint32_t blockCount = std::min(blockSize, chunk.count - blockBegin);
+                for (uint32_t i = 0; i < blockCount; ++i)
+                    matrices[i] = &hierarchy.getWorldMatrix(nodes[blockBegin + i].node);
+
+                BatchMath::transformAABBs(matrices, bounds + blockBegin, worldBounds, blockCount);
+
+                for (uint32_t i = 0; i < blockCount; ++i)
+                    if (frustum.containsAABB(worldBounds[i].center, worldBounds[i].extents))
+                        chunkResults[c].push_back(entities[blockBegin + i]);
+            }
+        }
+    });
+
+    visible.clear();
+    for (const std::vector<Entity> &result : chunkResults)
+        visible.insert(visible.end(), result.begin(), result.end());
+}
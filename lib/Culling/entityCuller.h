@@ -0,0 +1,20 @@
+#ifndef ENTITY_CULLER
+#define ENTITY_CULLER
+
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "frustum.h"
+#include "../ECS/ecs.h"
+#include "../ECS/components.h"
+#include "../Scene/transformHierarchy.h"
+#include "../Jobs/jobSystem.h"
+#include "../Profiler/profiler.h"
+
+/*  Frustum culls every entity with SceneNode and Bounds components on the CPU.
+    Chunks are distributed over the job system, visible entities are appended to
+    `visible` in chunk order. */
+void cullEntities(const World &world, const TransformHierarchy &hierarchy, const Frustum &frustum,
+                  JobSystem &jobSystem, std::vector<Entity> &visible);
+
+#endif
@@ -0,0 +1,64 @@
+#include "frustum.h"
+
+/* Constructor */
+Frustum::Frustum()
+{
+    for (int i = 0; i < 6; ++i)
+        planes[i] = glm::vec4(0.0f);
+}
+
+Frustum::Frustum(const glm::mat4 &viewProj)
+{
+    update(viewProj);
+}
+
+void Frustum::update(const glm::mat4 &viewProj)
+{
+    /*  Gribb-Hartmann plane extraction. glm matrices are column-major,
+        so row i of the matrix is (m[0][i], m[1][i], m[2][i], m[3][i]). */
+    glm::vec4 rowX = glm::vec4(viewProj[0][0], viewProj[1][0], viewProj[2][0], viewProj[3][0]);
+    glm::vec4 rowY = glm::vec4(viewProj[0][1], viewProj[1][1], viewProj[2][1], viewProj[3][1]);
+    glm::vec4 rowZ = glm::vec4(viewProj[0][2], viewProj[1][2], viewProj[2][2], viewProj[3][2]);
+    glm::vec4 rowW = glm::vec4(viewProj[0][3], viewProj[1][3], viewProj[2][3], viewProj[3][3]);
+
+    planes[0] = rowW + rowX;
+    planes[1] = rowW - rowX;
+    planes[2] = rowW + rowY;
+    planes[3] = rowW - rowY;
+    planes[4] = rowW + rowZ;
+    planes[5] = rowW - rowZ;
+
+    /* Normalize so that plane distances are in world units */
+    for (int i = 0; i < 6; ++i)
+    {
+        float normalLength = glm::length(glm::vec3(planes[i]));
+        planes[i] /= normalLength;
+    }
+}
+
+bool Frustum::containsSphere(const glm::vec3 &center, const float radius) const
+{
+    for (int i = 0; i < 6; ++i)
+    {
+        if (glm::dot(glm::vec3(planes[i]), center) + planes[i].w < -radius)
+            return false;
+    }
+
+    return true;
+}
+
+bool Frustum::containsAABB(const glm::vec3 &center, const glm::vec3 &extents) const
+{
+    for (int i = 0; i < 6; ++i)
+    {
+        glm::vec3 normal = glm::vec3(planes[i]);
+
+        /* Projected radius of the box onto the plane normal */
+        float radius = glm::dot(extents, glm::abs(normal));
+
+        if (glm::dot(normal, center) + planes[i].w < -radius)
+            return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,25 @@
+#ifndef FRUSTUM
+#define FRUSTUM
+
+#include <glm/glm.hpp>
+
+class Frustum
+{
+    public:
+        /* Plane order: left, right, bottom, top, near, far */
+        /* Each plane is stored as (normal.xyz, distance), normals point inwards */
+        glm::vec4 planes[6];
+
+        /* Constructor */
+        Frustum();
+        Frustum(const glm::mat4 &viewProj);
+
+        /* Extracts normalized clip planes from a combined view-projection matrix */
+        void update(const glm::mat4 &viewProj);
+
+        /* Visibility tests */
+        bool containsSphere(const glm::vec3 &center, const float radius) const;
+        bool containsAABB(const glm::vec3 &center, const glm::vec3 &extents) const;
+};
+
+#endif
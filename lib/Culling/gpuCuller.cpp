@@ -0,0 +1,226 @@
+#include "gpuCuller.h"
+
+#include <algorithm>
+#include <cmath>
+
+/* Buffer binding points shared with cull.comp */
+#define BOUNDS_BINDING          0
+#define DRAW_TEMPLATE_BINDING   1
+#define DRAW_COMMAND_BINDING    2
+#define DRAW_COUNT_BINDING      3
+
+#define CULL_GROUP_SIZE         64
+#define HIZ_GROUP_SIZE          8
+
+/* Constructor */
+GpuCuller::GpuCuller(const unsigned int maxObjects)
+    : occlusionCulling { false }
+    , cullShader { "shaders/cull.comp" }
+    , hiZShader { "shaders/hiz.comp" }
+    , maxObjects { maxObjects }
+    , objectCount { 0 }
+    , hiZTexture { 0 }
+    , hiZWidth { 0 }
+    , hiZHeight { 0 }
+    , hiZLevels { 0 }
+    , hiZViewProj { glm::mat4(1.0f) }
+{
+    /* glMultiDrawElementsIndirectCount is core from 4.6 on, the loader has no ARB_indirect_parameters entry point */
+    GLint majorVersion = 0, minorVersion = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &majorVersion);
+    glGetIntegerv(GL_MINOR_VERSION, &minorVersion);
+    indirectCount = majorVersion * 10 + minorVersion >= 46;
+
+    glGenBuffers(1, &boundsBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, boundsBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(ObjectBounds) * maxObjects, NULL, GL_DYNAMIC_DRAW);
+
+    glGenBuffers(1, &drawTemplateBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, drawTemplateBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(DrawElementsIndirectCommand) * maxObjects, NULL, GL_DYNAMIC_DRAW);
+
+    /* Written by the compute pass and consumed directly by the command processor */
+    glGenBuffers(1, &drawCommandBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, drawCommandBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(DrawElementsIndirectCommand) * maxObjects, NULL, GL_DYNAMIC_COPY);
+
+    /* Single atomic counter used as the draw count parameter */
+    glGenBuffers(1, &drawCountBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, drawCountBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GLuint), NULL, GL_DYNAMIC_COPY);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+GpuCuller::~GpuCuller()
+{
+    glDeleteBuffers(1, &boundsBuffer);
+    glDeleteBuffers(1, &drawTemplateBuffer);
+    glDeleteBuffers(1, &drawCommandBuffer);
+    glDeleteBuffers(1, &drawCountBuffer);
+
+    if (hiZTexture)
+        glDeleteTextures(1, &hiZTexture);
+}
+
+void GpuCuller::setObjects(const std::vector<ObjectBounds> &bounds, std::vector<DrawElementsIndirectCommand> draws)
+{
+    if (bounds.size() != draws.size())
+    {
+        std::cout << "GpuCuller -> Bounds and draw command counts differ" << std::endl;
+        return;
+    }
+
+    if (bounds.size() > maxObjects)
+    {
+        std::cout << "GpuCuller -> Maximum number of objects exceeded. Max = " << maxObjects << std::endl;
+        return;
+    }
+
+    objectCount = bounds.size();
+
+    for (unsigned int i = 0; i < objectCount; ++i)
+        draws[i].baseInstance = i;
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, boundsBuffer);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(ObjectBounds) * objectCount, bounds.data());
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, drawTemplateBuffer);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(DrawElementsIndirectCommand) * objectCount, draws.data());
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void GpuCuller::buildHiZ(const unsigned int depthTexture, const int width, const int height, const glm::mat4 &viewProj)
+{
+    if (width != hiZWidth || height != hiZHeight)
+        createHiZTexture(width, height);
+
+    hiZViewProj = viewProj;
+
+    hiZShader.use();
+    hiZShader.setInt("source", 0);
+
+    /* Level 0 is a straight copy of the depth buffer, every further level keeps the
+       farthest depth of the 2x2 (or 3x3 on odd edges) texels beneath it */
+    int srcWidth = width, srcHeight = height;
+    for (int level = 0; level < hiZLevels; ++level)
+    {
+        int dstWidth  = level == 0 ? width  : std::max(1, srcWidth  / 2);
+        int dstHeight = level == 0 ? height : std::max(1, srcHeight / 2);
+
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, level == 0 ? depthTexture : hiZTexture);
+        glBindImageTexture(0, hiZTexture, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+
+        hiZShader.setInt("srcLod", level == 0 ? 0 : level - 1);
+        hiZShader.setInt("copyLevel", level == 0);
+        hiZShader.setInt("srcWidth", srcWidth);
+        hiZShader.setInt("srcHeight", srcHeight);
+        hiZShader.setInt("dstWidth", dstWidth);
+        hiZShader.setInt("dstHeight", dstHeight);
+
+        glDispatchCompute((dstWidth + HIZ_GROUP_SIZE - 1) / HIZ_GROUP_SIZE, (dstHeight + HIZ_GROUP_SIZE - 1) / HIZ_GROUP_SIZE, 1);
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+
+        srcWidth = dstWidth;
+        srcHeight = dstHeight;
+    }
+}
+
+void GpuCuller::cull(const glm::mat4 &viewProj)
+{
+    Frustum frustum(viewProj);
+
+    /* Reset the visible draw counter */
+    GLuint zero = 0;
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, drawCountBuffer);
+    glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BOUNDS_BINDING, boundsBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DRAW_TEMPLATE_BINDING, drawTemplateBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DRAW_COMMAND_BINDING, drawCommandBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DRAW_COUNT_BINDING, drawCountBuffer);
+
+    cullShader.use();
+    cullShader.setUInt("objectCount", objectCount);
+    cullShader.setBool("compactCommands", indirectCount);
+
+    for (int i = 0; i < 6; ++i)
+        cullShader.setVec4("frustumPlanes[" + std::to_string(i) + "]", frustum.planes[i]);
+
+    /* Occlusion is only tested once a pyramid from a previous frame exists */
+    bool useHiZ = occlusionCulling && hiZTexture != 0;
+    cullShader.setBool("occlusionCulling", useHiZ);
+
+    if (useHiZ)
+    {
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, hiZTexture);
+        cullShader.setInt("hiZ", 0);
+        cullShader.setMat4("hiZViewProj", hiZViewProj);
+        cullShader.setFloat("hiZWidth", (float)hiZWidth);
+        cullShader.setFloat("hiZHeight", (float)hiZHeight);
+        cullShader.setFloat("hiZMaxLod", (float)(hiZLevels - 1));
+    }
+
+    glDispatchCompute((objectCount + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+
+    /* Make the commands and count visible to the indirect draw */
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+void GpuCuller::draw() const
+{
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, drawCommandBuffer);
+
+    if (indirectCount)
+    {
+        glBindBuffer(GL_PARAMETER_BUFFER, drawCountBuffer);
+
+        /* The atomically appended count lives in GPU memory, so the draw count is
+           sourced from the parameter buffer and never read back to the CPU */
+        glMultiDrawElementsIndirectCount(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)0, 0, objectCount, 0);
+
+        glBindBuffer(GL_PARAMETER_BUFFER, 0);
+    }
+    else
+    {
+        /* Every object keeps its slot, culled ones were written with no instances */
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)0, objectCount, 0);
+    }
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+unsigned int GpuCuller::getVisibleCount() const
+{
+    GLuint visibleCount = 0;
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, drawCountBuffer);
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(GLuint), &visibleCount);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    return visibleCount;
+}
+
+/* Private */
+void GpuCuller::createHiZTexture(const int width, const int height)
+{
+    if (hiZTexture)
+        glDeleteTextures(1, &hiZTexture);
+
+    hiZWidth = width;
+    hiZHeight = height;
+    hiZLevels = 1 + (int)floor(log2((float)std::max(width, height)));
+
+    glGenTextures(1, &hiZTexture);
+    glBindTexture(GL_TEXTURE_2D, hiZTexture);
+    glTexStorage2D(GL_TEXTURE_2D, hiZLevels, GL_R32F, width, height);
+
+    /* Every level is fetched explicitly, never filtered */
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+}
@@ -0,0 +1,79 @@
+#ifndef GPU_CULLER
+#define GPU_CULLER
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include <iostream>
+
+#include "frustum.h"
+#include "../Shader/shader.h"
+
+/* Per-object bounding volume, laid out to match the std430 struct in cull.comp */
+struct ObjectBounds
+{
+    glm::vec4 centerRadius;     /* xyz = world space AABB center, w = bounding sphere radius */
+    glm::vec4 extents;          /* xyz = AABB half extents, w = unused */
+};
+
+/* Matches the layout expected by glMultiDrawElementsIndirect */
+struct DrawElementsIndirectCommand
+{
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint  baseVertex;
+    GLuint baseInstance;
+};
+
+class GpuCuller
+{
+    public:
+        /* Constructor / Destructor */
+        GpuCuller(const unsigned int maxObjects);
+        ~GpuCuller();
+
+        /*  Uploads the bounds and draw command of every object. The baseInstance of each
+            command is overwritten with the object's index so that vertex shaders can fetch
+            per-object data with gl_BaseInstance. */
+        void setObjects(const std::vector<ObjectBounds> &bounds, std::vector<DrawElementsIndirectCommand> draws);
+
+        /* Builds the Hi-Z pyramid from a depth texture rendered with the given view-projection */
+        void buildHiZ(const unsigned int depthTexture, const int width, const int height, const glm::mat4 &viewProj);
+
+        /* Dispatches the culling pass, filling the indirect command buffer with visible draws */
+        void cull(const glm::mat4 &viewProj);
+
+        /*  Issues every visible draw. Expects the VAO with the shared vertex/index buffers to be bound.
+            Below GL 4.6 there is no draw count parameter, so every object's command is submitted
+            and the culled ones draw zero instances. */
+        void draw() const;
+
+        /* Reads back the number of visible draws. Stalls the pipeline, debug use only */
+        unsigned int getVisibleCount() const;
+
+        bool occlusionCulling;
+
+    private:
+        Shader cullShader;
+        Shader hiZShader;
+
+        unsigned int maxObjects;
+        unsigned int objectCount;
+
+        /* Compacted commands drawn with the GPU side count, else one command per object */
+        bool indirectCount;
+
+        unsigned int boundsBuffer;
+        unsigned int drawTemplateBuffer;
+        unsigned int drawCommandBuffer;
+        unsigned int drawCountBuffer;
+
+        unsigned int hiZTexture;
+        int hiZWidth, hiZHeight, hiZLevels;
+        glm::mat4 hiZViewProj;
+
+        void createHiZTexture(const int width, const int height);
+};
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef COMPONENTS
+#define COMPONENTS
+
+#include <glm/glm.hpp>
+#include <cstdint>
+
+/* Components must stay trivially copyable, chunks move them with memcpy */
+
+/* World space position, Euler rotation (degrees) and scale */
+struct Transform
+{
+    glm::vec3 position;
+    glm::vec3 rotation;
+    glm::vec3 scale;
+};
+
+/* Node in the TransformHierarchy that owns the entity's world matrix */
+struct SceneNode
+{
+    uint32_t node;
+};
+
+/* Vertex array and the range of vertices to draw from it, a range of its element buffer when indexed */
+struct MeshRef
+{
+    unsigned int VAO;
+    unsigned int firstVertex;
+    unsigned int vertexCount;
+    bool indexed;
+};
+
+/* Shader program and texture maps used to shade a mesh */
+struct MaterialRef
+{
+    unsigned int shaderProgramID;
+    unsigned int diffuseMapID;
+    unsigned int specularMapID;
+    float shine;
+};
+
+/* Local space axis aligned bounding box */
+struct Bounds
+{
+    glm::vec3 center;
+    glm::vec3 extents;
+};
+
+/* Point light emitted from the entity's Transform position */
+struct PointLight
+{
+    glm::vec3 ambient;
+    glm::vec3 diffuse;
+    glm::vec3 specular;
+
+    float attConstant;
+    float attLinear;
+    float attQuadratic;
+};
+
+#endif
@@ -0,0 +1,230 @@
+#include "ecs.h"
+
+/* ------------------------------- ComponentRegistry ------------------------------- */
+const ComponentInfo &ComponentRegistry::info(const ComponentID componentID)
+{
+    return components()[componentID];
+}
+
+ComponentID ComponentRegistry::registerComponent(const size_t size, const size_t alignment)
+{
+    std::vector<ComponentInfo> &registered = components();
+
+    /* IDs index fixed size masks and arrays, so there's nothing sensible to hand out past the limit */
+    if (registered.size() >= MAX_COMPONENTS)
+    {
+        std::cout << "ERROR: ECS -> Maximum number of component types exceeded. Max = " << MAX_COMPONENTS << std::endl;
+        std::abort();
+    }
+
+    registered.push_back({ size, alignment });
+    return registered.size() - 1;
+}
+
+std::vector<ComponentInfo> &ComponentRegistry::components()
+{
+    static std::vector<ComponentInfo> registered;
+    return registered;
+}
+
+/* ----------------------------------- Archetype ----------------------------------- */
+Archetype::Archetype(const ComponentMask mask)
+    : mask { mask }
+    , chunkCapacity { 0 }
+    , entityCount { 0 }
+{
+    size_t rowSize = sizeof(Entity);
+    size_t alignmentSlack = 0;
+
+    for (ComponentID i = 0; i < MAX_COMPONENTS; ++i)
+    {
+        if (mask & (ComponentMask(1) << i))
+        {
+            componentIDs.push_back(i);
+            rowSize += ComponentRegistry::info(i).size;
+            alignmentSlack += ComponentRegistry::info(i).alignment;
+        }
+    }
+
+    /* Fit as many rows as possible, leaving room to align each column */
+    chunkCapacity = alignmentSlack < CHUNK_SIZE ? (CHUNK_SIZE - alignmentSlack) / rowSize : 0;
+
+    /* Rows are addressed by dividing by the capacity, an archetype that can't hold one is unusable */
+    if (chunkCapacity == 0)
+    {
+        std::cout << "ERROR: ECS -> Archetype row of " << rowSize << " bytes doesn't fit in a " << CHUNK_SIZE << " byte chunk" << std::endl;
+        std::abort();
+    }
+
+    /*  Chunk layout:
+        | Entity[capacity] | pad | ComponentA[capacity] | pad | ComponentB[capacity] | ... */
+    size_t offset = sizeof(Entity) * chunkCapacity;
+    for (ComponentID componentID : componentIDs)
+    {
+        const ComponentInfo &info = ComponentRegistry::info(componentID);
+        offset = (offset + info.alignment - 1) & ~(info.alignment - 1);
+        columnOffsets[componentID] = offset;
+        offset += info.size * chunkCapacity;
+    }
+}
+
+Archetype::~Archetype()
+{
+    for (Chunk &chunk : chunks)
+        std::free(chunk.data);
+}
+
+bool Archetype::hasComponent(const ComponentID componentID) const
+{
+    return mask & (ComponentMask(1) << componentID);
+}
+
+Entity* Archetype::entities(const Chunk &chunk) const
+{
+    return (Entity*)chunk.data;
+}
+
+void* Archetype::column(const Chunk &chunk, const ComponentID componentID) const
+{
+    return chunk.data + columnOffsets[componentID];
+}
+
+void* Archetype::component(const uint32_t row, const ComponentID componentID) const
+{
+    const Chunk &chunk = chunks[row / chunkCapacity];
+    return (unsigned char*)column(chunk, componentID) + ComponentRegistry::info(componentID).size * (row % chunkCapacity);
+}
+
+uint32_t Archetype::pushRow(const Entity entity)
+{
+    /* Only the last chunk can have free rows since removal keeps rows dense */
+    if (chunks.empty() || chunks.back().count == chunkCapacity)
+        chunks.push_back({ (unsigned char*)std::aligned_alloc(CHUNK_ALIGNMENT, CHUNK_SIZE), 0 });
+
+    Chunk &chunk = chunks.back();
+    entities(chunk)[chunk.count++] = entity;
+
+    return entityCount++;
+}
+
+Entity Archetype::swapRemoveRow(const uint32_t row)
+{
+    uint32_t lastRow = entityCount - 1;
+    Entity moved = NullEntity;
+
+    Chunk &chunk = chunks[row / chunkCapacity];
+    Chunk &lastChunk = chunks[lastRow / chunkCapacity];
+    uint32_t chunkRow = row % chunkCapacity;
+    uint32_t lastChunkRow = lastRow % chunkCapacity;
+
+    if (row != lastRow)
+    {
+        for (ComponentID componentID : componentIDs)
+        {
+            size_t size = ComponentRegistry::info(componentID).size;
+            memcpy((unsigned char*)column(chunk, componentID) + size * chunkRow,
+                   (unsigned char*)column(lastChunk, componentID) + size * lastChunkRow, size);
+        }
+
+        moved = entities(lastChunk)[lastChunkRow];
+        entities(chunk)[chunkRow] = moved;
+    }
+
+    --lastChunk.count;
+    --entityCount;
+
+    /* Release the trailing chunk once it's empty */
+    if (lastChunk.count == 0)
+    {
+        std::free(lastChunk.data);
+        chunks.pop_back();
+    }
+
+    return moved;
+}
+
+/* ------------------------------------- World ------------------------------------- */
+World::World() {}
+
+void World::destroyEntity(const Entity entity)
+{
+    if (!isAlive(entity))
+        return;
+
+    EntityRecord &record = records[entity.index];
+    removeRow(record.archetype, record.row);
+
+    /* Bump the generation so outstanding handles to this slot become invalid */
+    record.archetype = NULL;
+    ++record.generation;
+    freeIndices.push_back(entity.index);
+}
+
+bool World::isAlive(const Entity entity) const
+{
+    return entity.index < records.size()
+        && records[entity.index].generation == entity.generation
+        && records[entity.index].archetype != NULL;
+}
+
+size_t World::entityCount() const
+{
+    return records.size() - freeIndices.size();
+}
+
+/* Private */
+Archetype* World::getArchetype(const ComponentMask mask)
+{
+    auto existing = archetypes.find(mask);
+    if (existing != archetypes.end())
+        return existing->second.get();
+
+    Archetype* archetype = new Archetype(mask);
+    archetypes[mask] = std::unique_ptr<Archetype>(archetype);
+
+    return archetype;
+}
+
+Entity World::allocateEntity()
+{
+    if (!freeIndices.empty())
+    {
+        uint32_t index = freeIndices.back();
+        freeIndices.pop_back();
+
+        return { index, records[index].generation };
+    }
+
+    records.push_back({ NULL, 0, 0 });
+    return { (uint32_t)(records.size() - 1), 0 };
+}
+
+void World::removeRow(Archetype* archetype, const uint32_t row)
+{
+    Entity moved = archetype->swapRemoveRow(row);
+
+    /* The archetype's last entity now lives in the removed row */
+    if (moved != NullEntity)
+        records[moved.index].row = row;
+}
+
+void World::moveEntity(const Entity entity, Archetype* destination)
+{
+    EntityRecord &record = records[entity.index];
+    Archetype* source = record.archetype;
+
+    uint32_t destinationRow = destination->pushRow(entity);
+
+    /* Copy every component both archetypes have in common */
+    ComponentMask shared = source->mask & destination->mask;
+    for (ComponentID i = 0; i < MAX_COMPONENTS; ++i)
+    {
+        if (shared & (ComponentMask(1) << i))
+            memcpy(destination->component(destinationRow, i), source->component(record.row, i), ComponentRegistry::info(i).size);
+    }
+
+    removeRow(source, record.row);
+
+    record.archetype = destination;
+    record.row = destinationRow;
+}
@@ -0,0 +1,286 @@
+#ifndef ECS
+#define ECS
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <type_traits>
+#include <iostream>
+
+/*  Archetype based entity-component system.
+
+    Entities sharing the exact same set of components live in the same archetype. Each
+    archetype stores its entities in fixed size chunks, and every chunk stores each
+    component type as its own contiguous column (structure of arrays), so iterating a
+    component touches only the memory of that component.
+
+    Rows are kept dense by swap-removal, which means component pointers are only valid
+    until the next structural change (create, destroy, add or remove component). Entity
+    handles, however, remain valid until the entity is destroyed. */
+
+#define MAX_COMPONENTS  64
+#define CHUNK_SIZE      (16 * 1024)
+#define CHUNK_ALIGNMENT 64
+
+typedef uint32_t ComponentID;
+typedef uint64_t ComponentMask;
+
+/* Stable entity handle. The generation invalidates handles whose slot has been reused */
+struct Entity
+{
+    uint32_t index;
+    uint32_t generation;
+
+    bool operator==(const Entity &other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const Entity &other) const { return !(*this == other); }
+};
+
+const Entity NullEntity = { UINT32_MAX, 0 };
+
+struct ComponentInfo
+{
+    size_t size;
+    size_t alignment;
+};
+
+class ComponentRegistry
+{
+    public:
+        /* Assigns a dense ID to each component type on first use */
+        template<typename T>
+        static ComponentID id()
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "Components are moved between chunks with memcpy");
+            static const ComponentID componentID = registerComponent(sizeof(T), alignof(T));
+            return componentID;
+        }
+
+        static const ComponentInfo &info(const ComponentID componentID);
+
+    private:
+        static ComponentID registerComponent(const size_t size, const size_t alignment);
+        static std::vector<ComponentInfo> &components();
+};
+
+template<typename... Ts>
+ComponentMask componentMask()
+{
+    return (ComponentMask(0) | ... | (ComponentMask(1) << ComponentRegistry::id<Ts>()));
+}
+
+struct Chunk
+{
+    unsigned char* data;
+    uint32_t count;
+};
+
+class Archetype
+{
+    public:
+        ComponentMask mask;
+        uint32_t chunkCapacity;
+        uint32_t entityCount;
+        std::vector<Chunk> chunks;
+
+        /* Constructor / Destructor */
+        Archetype(const ComponentMask mask);
+        ~Archetype();
+
+        Archetype(const Archetype&) = delete;
+        Archetype &operator=(const Archetype&) = delete;
+
+        bool hasComponent(const ComponentID componentID) const;
+
+        /* Column accessors */
+        Entity* entities(const Chunk &chunk) const;
+        void* column(const Chunk &chunk, const ComponentID componentID) const;
+        void* component(const uint32_t row, const ComponentID componentID) const;
+
+        /* Appends an uninitialized row and returns its index */
+        uint32_t pushRow(const Entity entity);
+
+        /*  Removes a row by moving the archetype's last row into its place.
+            Returns the entity that was moved, or NullEntity if none was. */
+        Entity swapRemoveRow(const uint32_t row);
+
+    private:
+        std::vector<ComponentID> componentIDs;
+        size_t columnOffsets[MAX_COMPONENTS];
+};
+
+class World;
+
+/* Iterates all archetypes containing at least the requested components */
+template<typename... Ts>
+class View
+{
+    public:
+        View(std::vector<Archetype*> archetypes) : archetypes { archetypes } {}
+
+        /* Calls func(count, entities, Ts* columns...) for every non-empty chunk */
+        template<typename Func>
+        void forEachChunk(Func func) const
+        {
+            for (Archetype* archetype : archetypes)
+                for (const Chunk &chunk : archetype->chunks)
+                    if (chunk.count > 0)
+                        func(chunk.count, (const Entity*)archetype->entities(chunk), (Ts*)archetype->column(chunk, ComponentRegistry::id<Ts>())...);
+        }
+
+        /* Calls func(Ts&...) for every matching entity */
+        template<typename Func>
+        void each(Func func) const
+        {
+            forEachChunk([&](uint32_t count, const Entity*, Ts*... columns)
+            {
+                for (uint32_t i = 0; i < count; ++i)
+                    func(columns[i]...);
+            });
+        }
+
+        /* Number of entities matched by this view */
+        size_t size() const
+        {
+            size_t count = 0;
+            for (Archetype* archetype : archetypes)
+                count += archetype->entityCount;
+
+            return count;
+        }
+
+        /* Flat list of chunks, used to split work evenly across threads */
+        std::vector<std::pair<Archetype*, const Chunk*>> chunks() const
+        {
+            std::vector<std::pair<Archetype*, const Chunk*>> result;
+            for (Archetype* archetype : archetypes)
+                for (const Chunk &chunk : archetype->chunks)
+                    if (chunk.count > 0)
+                        result.push_back({ archetype, &chunk });
+
+            return result;
+        }
+
+    private:
+        std::vector<Archetype*> archetypes;
+};
+
+class World
+{
+    public:
+        /* Constructor */
+        World();
+
+        /* Entity lifetime */
+        template<typename... Ts>
+        Entity createEntity(const Ts&... components)
+        {
+            Archetype* archetype = getArchetype(componentMask<Ts...>());
+            Entity entity = allocateEntity();
+
+            uint32_t row = archetype->pushRow(entity);
+            (copyComponent(archetype, row, components), ...);
+
+            records[entity.index].archetype = archetype;
+            records[entity.index].row = row;
+
+            return entity;
+        }
+
+        void destroyEntity(const Entity entity);
+        bool isAlive(const Entity entity) const;
+        size_t entityCount() const;
+
+        /* Component access, returns NULL if the entity doesn't have the component */
+        template<typename T>
+        T* getComponent(const Entity entity) const
+        {
+            if (!isAlive(entity))
+                return NULL;
+
+            const EntityRecord &record = records[entity.index];
+            ComponentID componentID = ComponentRegistry::id<T>();
+
+            if (!record.archetype->hasComponent(componentID))
+                return NULL;
+
+            return (T*)record.archetype->component(record.row, componentID);
+        }
+
+        template<typename T>
+        bool hasComponent(const Entity entity) const
+        {
+            return getComponent<T>(entity) != NULL;
+        }
+
+        /* Structural changes, these move the entity to a different archetype */
+        template<typename T>
+        void addComponent(const Entity entity, const T &component)
+        {
+            if (!isAlive(entity))
+                return;
+
+            if (T* existing = getComponent<T>(entity))
+            {
+                *existing = component;
+                return;
+            }
+
+            ComponentMask mask = records[entity.index].archetype->mask | componentMask<T>();
+            moveEntity(entity, getArchetype(mask));
+
+            const EntityRecord &record = records[entity.index];
+            copyComponent(record.archetype, record.row, component);
+        }
+
+        template<typename T>
+        void removeComponent(const Entity entity)
+        {
+            if (!hasComponent<T>(entity))
+                return;
+
+            ComponentMask mask = records[entity.index].archetype->mask & ~componentMask<T>();
+            moveEntity(entity, getArchetype(mask));
+        }
+
+        /* Returns a view over every entity that has all of the given components */
+        template<typename... Ts>
+        View<Ts...> view() const
+        {
+            ComponentMask mask = componentMask<Ts...>();
+            std::vector<Archetype*> matching;
+
+            for (const auto &archetype : archetypes)
+                if ((archetype.second->mask & mask) == mask)
+                    matching.push_back(archetype.second.get());
+
+            return View<Ts...>(matching);
+        }
+
+    private:
+        struct EntityRecord
+        {
+            Archetype* archetype;
+            uint32_t row;
+            uint32_t generation;
+        };
+
+        std::vector<EntityRecord> records;
+        std::vector<uint32_t> freeIndices;
+        std::unordered_map<ComponentMask, std::unique_ptr<Archetype>> archetypes;
+
+        Archetype* getArchetype(const ComponentMask mask);
+        Entity allocateEntity();
+        void removeRow(Archetype* archetype, const uint32_t row);
+        void moveEntity(const Entity entity, Archetype* destination);
+
+        template<typename T>
+        void copyComponent(Archetype* archetype, const uint32_t row, const T &component)
+        {
+            memcpy(archetype->component(row, ComponentRegistry::id<T>()), &component, sizeof(T));
+        }
+};
+
+#endif
@@ -0,0 +1,296 @@
+#include "jobSystem.h"
+
+/* Index of the calling thread's deque, -1 for threads that aren't workers */
+static thread_local int currentWorkerIndex = -1;
+
+/* Pooled jobs per worker, beyond that jobs come from the heap */
+#define JOB_POOL_SIZE 4096
+
+/* ------------------------------- WorkStealingDeque ------------------------------- */
+WorkStealingDeque::WorkStealingDeque()
+    : top { 0 }
+    , bottom { 0 }
+{
+    for (int64_t i = 0; i < capacity; ++i)
+        jobs[i].store(NULL, std::memory_order_relaxed);
+}
+
+bool WorkStealingDeque::push(Job* job)
+{
+    int64_t b = bottom.load(std::memory_order_relaxed);
+    int64_t t = top.load(std::memory_order_acquire);
+
+    if (b - t >= capacity)
+        return false;
+
+    jobs[b & (capacity - 1)].store(job, std::memory_order_relaxed);
+
+    /* Publish the job before making the slot visible to thieves */
+    bottom.store(b + 1, std::memory_order_release);
+    return true;
+}
+
+Job* WorkStealingDeque::pop()
+{
+    int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+    bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top.load(std::memory_order_relaxed);
+
+    if (t > b)
+    {
+        /* Deque was already empty */
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return NULL;
+    }
+
+    Job* job = jobs[b & (capacity - 1)].load(std::memory_order_relaxed);
+
+    if (t == b)
+    {
+        /* Last job, race against thieves for it */
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            job = NULL;
+
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    return job;
+}
+
+Job* WorkStealingDeque::steal()
+{
+    int64_t t = top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = bottom.load(std::memory_order_acquire);
+
+    if (t >= b)
+        return NULL;
+
+    Job* job = jobs[t & (capacity - 1)].load(std::memory_order_relaxed);
+
+    /* Another thief or the owner got there first */
+    if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        return NULL;
+
+    return job;
+}
+
+/* ----------------------------------- JobSystem ----------------------------------- */
+JobSystem::JobSystem(unsigned int threadCount)
+    : pendingJobs { 0 }
+    , running { true }
+{
+    if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+    for (unsigned int i = 0; i < threadCount; ++i)
+    {
+        deques.push_back(new WorkStealingDeque());
+
+        JobPool* pool = new JobPool();
+        pool->jobs.resize(JOB_POOL_SIZE);
+        pool->freeList = NULL;
+        pool->returned = NULL;
+        for (Job &job : pool->jobs)
+        {
+            job.pool = i;
+            job.next = pool->freeList;
+            pool->freeList = &job;
+        }
+        pools.push_back(pool);
+    }
+
+    /* The creating thread is worker 0 */
+    currentWorkerIndex = 0;
+
+    for (unsigned int i = 1; i < threadCount; ++i)
+        workers.push_back(std::thread(&JobSystem::workerLoop, this, i));
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        running = false;
+    }
+    wakeCondition.notify_all();
+
+    for (std::thread &worker : workers)
+        worker.join();
+
+    for (WorkStealingDeque* deque : deques)
+        delete deque;
+
+    for (Job* job : sharedQueue)
+        if (job->heapAllocated)
+            delete job;
+
+    for (JobPool* pool : pools)
+        delete pool;
+
+    currentWorkerIndex = -1;
+}
+
+void JobSystem::run(std::function<void()> task, JobCounter* counter)
+{
+    if (counter)
+        counter->fetch_add(1, std::memory_order_relaxed);
+
+    Job* job = allocateJob();
+    job->task = std::move(task);
+    job->counter = counter;
+
+    pendingJobs.fetch_add(1, std::memory_order_release);
+
+    /* Fall back to the shared queue from foreign threads or when the deque is full */
+    if (currentWorkerIndex < 0 || !deques[currentWorkerIndex]->push(job))
+    {
+        std::lock_guard<std::mutex> lock(sharedQueueMutex);
+        sharedQueue.push_back(job);
+    }
+
+    /* Taking the lock orders this against a worker checking pendingJobs before sleeping */
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    wakeCondition.notify_one();
+}
+
+void JobSystem::wait(const JobCounter &counter)
+{
+    while (counter.load(std::memory_order_acquire) > 0)
+    {
+        Job* job = findJob();
+
+        if (job)
+            execute(job);
+        else
+            std::this_thread::yield();
+    }
+}
+
+unsigned int JobSystem::getThreadCount() const
+{
+    return deques.size();
+}
+
+/* Private */
+void JobSystem::workerLoop(const unsigned int workerIndex)
+{
+    currentWorkerIndex = workerIndex;
+
+    while (running)
+    {
+        Job* job = findJob();
+
+        if (job)
+        {
+            execute(job);
+            continue;
+        }
+
+        /* Sleep until new work is queued */
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wakeCondition.wait(lock, [this]() { return !running || pendingJobs.load(std::memory_order_acquire) > 0; });
+    }
+}
+
+Job* JobSystem::allocateJob()
+{
+    /*  Workers take jobs from their pool. Jobs created by foreign threads, or while every
+        pooled job is still outstanding, are heap allocated and deleted once executed. */
+    if (currentWorkerIndex >= 0)
+    {
+        JobPool* pool = pools[currentWorkerIndex];
+        if (!pool->freeList)
+            pool->freeList = pool->returned.exchange(NULL, std::memory_order_acquire);
+
+        if (Job* job = pool->freeList)
+        {
+            pool->freeList = job->next;
+            job->counter = NULL;
+            job->heapAllocated = false;
+            return job;
+        }
+    }
+
+    Job* job = new Job();
+    job->heapAllocated = true;
+    return job;
+}
+
+void JobSystem::releaseJob(Job* job)
+{
+    if (job->heapAllocated)
+    {
+        delete job;
+        return;
+    }
+
+    JobPool* pool = pools[job->pool];
+    if ((int)job->pool == currentWorkerIndex)
+    {
+        job->next = pool->freeList;
+        pool->freeList = job;
+        return;
+    }
+
+    /* Only the owner takes from the stack, and it takes all of it, so there's no ABA */
+    Job* head = pool->returned.load(std::memory_order_relaxed);
+    do
+        job->next = head;
+    while (!pool->returned.compare_exchange_weak(head, job, std::memory_order_release, std::memory_order_relaxed));
+}
+
+Job* JobSystem::findJob()
+{
+    int self = currentWorkerIndex;
+
+    if (self >= 0)
+    {
+        if (Job* job = deques[self]->pop())
+            return job;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(sharedQueueMutex);
+        if (!sharedQueue.empty())
+        {
+            Job* job = sharedQueue.front();
+            sharedQueue.pop_front();
+            return job;
+        }
+    }
+
+    /* Steal, starting from a different victim on every thread to spread contention */
+    unsigned int dequeCount = deques.size();
+    unsigned int start = self >= 0 ? self + 1 : 0;
+
+    for (unsigned int i = 0; i < dequeCount; ++i)
+    {
+        unsigned int victim = (start + i) % dequeCount;
+        if ((int)victim == self)
+            continue;
+
+        if (Job* job = deques[victim]->steal())
+            return job;
+    }
+
+    return NULL;
+}
+
+void JobSystem::execute(Job* job)
+{
+    pendingJobs.fetch_sub(1, std::memory_order_acq_rel);
+
+    job->task();
+
+    /* Release captured state before the job is reused */
+    JobCounter* counter = job->counter;
+    job->task = nullptr;
+    releaseJob(job);
+
+    if (counter)
+        counter->fetch_sub(1, std::memory_order_release);
+}
@@ -0,0 +1,136 @@
+#ifndef JOB_SYSTEM
+#define JOB_SYSTEM
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <iostream>
+
+/* Number of outstanding jobs a counter is waiting on */
+typedef std::atomic<int> JobCounter;
+
+struct Job
+{
+    std::function<void()> task;
+    JobCounter* counter;
+    bool heapAllocated;
+    uint32_t pool;          /* Worker whose pool the job came from */
+    Job* next;              /* Free list link while unused */
+};
+
+/*  Jobs a worker allocates from. The owner takes from its free list; jobs executed on other
+    threads come back through a lock-free stack the owner drains once its list runs out, so a
+    job is only reused after execute() is done with it. */
+struct JobPool
+{
+    std::vector<Job> jobs;
+    Job* freeList;                  /* Owner only */
+    std::atomic<Job*> returned;     /* Pushed by any thread, taken whole by the owner */
+};
+
+/*  Chase-Lev work-stealing deque with a fixed capacity.
+    The owning thread pushes and pops at the bottom, other threads steal from the top. */
+class WorkStealingDeque
+{
+    public:
+        static const int64_t capacity = 4096;
+
+        /* Constructor */
+        WorkStealingDeque();
+
+        /* Owner only */
+        bool push(Job* job);
+        Job* pop();
+
+        /* Any thread */
+        Job* steal();
+
+    private:
+        alignas(64) std::atomic<int64_t> top;
+        alignas(64) std::atomic<int64_t> bottom;
+        std::atomic<Job*> jobs[capacity];
+};
+
+/*  Task based job system.
+
+    Every worker owns a deque it pushes its own jobs onto, and steals from the other
+    deques when it runs dry. The thread that creates the JobSystem becomes worker 0, it
+    doesn't run a loop but executes jobs while it waits on a counter. Threads that aren't
+    workers (e.g. a render thread) submit through a shared, locked queue. Only a single
+    JobSystem is meant to exist at a time. */
+class JobSystem
+{
+    public:
+        /* Constructor / Destructor, 0 workers picks one per hardware thread */
+        JobSystem(unsigned int threadCount = 0);
+        ~JobSystem();
+
+        JobSystem(const JobSystem&) = delete;
+        JobSystem &operator=(const JobSystem&) = delete;
+
+        /* Queues a task, incrementing the counter (if any) until it completes */
+        void run(std::function<void()> task, JobCounter* counter = NULL);
+
+        /* Executes pending jobs until the counter reaches zero */
+        void wait(const JobCounter &counter);
+
+        /*  Splits [0, count) into batches of at least minBatchSize items and calls
+            func(begin, end) for each of them in parallel, returning once all are done */
+        template<typename Func>
+        void parallelFor(const uint32_t count, const uint32_t minBatchSize, Func func)
+        {
+            if (count == 0)
+                return;
+
+            /* A few batches per thread so stealing can even out uneven work */
+            uint32_t batchSize = std::max(minBatchSize, count / (getThreadCount() * 4) + 1);
+
+            if (batchSize >= count)
+            {
+                func(0u, count);
+                return;
+            }
+
+            JobCounter counter { 0 };
+            for (uint32_t begin = batchSize; begin < count; begin += batchSize)
+            {
+                uint32_t end = std::min(count, begin + batchSize);
+                run([=, &func]() { func(begin, end); }, &counter);
+            }
+
+            /* The calling thread takes the first batch itself */
+            func(0u, std::min(count, batchSize));
+            wait(counter);
+        }
+
+        unsigned int getThreadCount() const;
+
+    private:
+        std::vector<std::thread> workers;
+        std::vector<WorkStealingDeque*> deques;
+        std::vector<JobPool*> pools;
+
+        /* Jobs submitted from threads that aren't workers */
+        std::deque<Job*> sharedQueue;
+        std::mutex sharedQueueMutex;
+
+        /* Parks idle workers */
+        std::atomic<int> pendingJobs;
+        std::mutex sleepMutex;
+        std::condition_variable wakeCondition;
+        std::atomic<bool> running;
+
+        void workerLoop(const unsigned int workerIndex);
+        Job* allocateJob();
+        void releaseJob(Job* job);
+        Job* findJob();
+        void execute(Job* job);
+};
+
+#endif
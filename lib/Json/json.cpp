@@ -0,0 +1,396 @@
+#include "json.h"
+
+/* Deep enough for any real document, shallow enough to never overflow the stack */
+static const int maxDepth = 256;
+
+/* Cursor over the text, the first error stops the parse */
+struct JsonParser
+{
+    const char* begin;
+    const char* cursor;
+    const char* end;
+
+    std::string error;
+
+    bool fail(const char* message)
+    {
+        if (error.empty())
+            error = std::string(message) + " at byte " + std::to_string(cursor - begin);
+        return false;
+    }
+
+    void skipWhitespace()
+    {
+        while (cursor < end && (*cursor == ' ' || *cursor == '\t' || *cursor == '\n' || *cursor == '\r'))
+            ++cursor;
+    }
+
+    bool consume(const char* literal)
+    {
+        size_t length = strlen(literal);
+        if ((size_t)(end - cursor) < length || memcmp(cursor, literal, length) != 0)
+            return false;
+
+        cursor += length;
+        return true;
+    }
+
+    static void appendUtf8(std::string &text, const uint32_t codePoint)
+    {
+        if (codePoint < 0x80)
+            text += (char)codePoint;
+        else if (codePoint < 0x800)
+        {
+            text += (char)(0xC0 | (codePoint >> 6));
+            text += (char)(0x80 | (codePoint & 0x3F));
+        }
+        else if (codePoint < 0x10000)
+        {
+            text += (char)(0xE0 | (codePoint >> 12));
+            text += (char)(0x80 | ((codePoint >> 6) & 0x3F));
+            text += (char)(0x80 | (codePoint & 0x3F));
+        }
+        else
+        {
+            text += (char)(0xF0 | (codePoint >> 18));
+            text += (char)(0x80 | ((codePoint >> 12) & 0x3F));
+            text += (char)(0x80 | ((codePoint >> 6) & 0x3F));
+            text += (char)(0x80 | (codePoint & 0x3F));
+        }
+    }
+
+    bool parseHex4(uint32_t &value)
+    {
+        if (end - cursor < 4)
+            return fail("Truncated \\u escape");
+
+        value = 0;
+        for (int i = 0; i < 4; ++i, ++cursor)
+        {
+            char c = *cursor;
+            uint32_t digit;
+            if (c >= '0' && c <= '9')
+                digit = c - '0';
+            else if (c >= 'a' && c <= 'f')
+                digit = c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F')
+                digit = c - 'A' + 10;
+            else
+                return fail("Invalid \\u escape");
+
+            value = value * 16 + digit;
+        }
+
+        return true;
+    }
+
+    bool parseString(std::string &text)
+    {
+        /* Opening quote */
+        ++cursor;
+
+        while (true)
+        {
+            /* Copy runs without escapes in one go */
+            const char* run = cursor;
+            while (cursor < end && *cursor != '"' && *cursor != '\\' && (unsigned char)*cursor >= 0x20)
+                ++cursor;
+            text.append(run, cursor);
+
+            if (cursor >= end)
+                return fail("Unterminated string");
+
+            if (*cursor == '"')
+            {
+                ++cursor;
+                return true;
+            }
+
+            if (*cursor != '\\')
+                return fail("Control character in string");
+
+            if (++cursor >= end)
+                return fail("Unterminated string");
+
+            char escape = *cursor++;
+            switch (escape)
+            {
+                case '"': text += '"'; break;
+                case '\\': text += '\\'; break;
+                case '/': text += '/'; break;
+                case 'b': text += '\b'; break;
+                case 'f': text += '\f'; break;
+                case 'n': text += '\n'; break;
+                case 'r': text += '\r'; break;
+                case 't': text += '\t'; break;
+
+                case 'u':
+                {
+                    uint32_t codePoint = 0;
+                    if (!parseHex4(codePoint))
+                        return false;
+
+                    /* Characters outside the BMP come as a surrogate pair */
+                    if (codePoint >= 0xD800 && codePoint < 0xDC00)
+                    {
+                        uint32_t low = 0;
+                        if (!consume("\\u") || !parseHex4(low) || low < 0xDC00 || low >= 0xE000)
+                            return fail("Unpaired surrogate");
+
+                        codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                    }
+
+                    appendUtf8(text, codePoint);
+                    break;
+                }
+
+                default:
+                    return fail("Invalid escape");
+            }
+        }
+    }
+
+    bool parseNumber(double &number)
+    {
+        /* Validate the JSON grammar, strtod alone would also accept hex, inf and nan */
+        const char* start = cursor;
+        if (cursor < end && *cursor == '-')
+            ++cursor;
+
+        if (cursor >= end || *cursor < '0' || *cursor > '9')
+            return fail("Invalid number");
+
+        if (*cursor == '0')
+            ++cursor;
+        else
+            while (cursor < end && *cursor >= '0' && *cursor <= '9')
+                ++cursor;
+
+        if (cursor < end && *cursor == '.')
+        {
+            ++cursor;
+            if (cursor >= end || *cursor < '0' || *cursor > '9')
+                return fail("Invalid number");
+            while (cursor < end && *cursor >= '0' && *cursor <= '9')
+                ++cursor;
+        }
+
+        if (cursor < end && (*cursor == 'e' || *cursor == 'E'))
+        {
+            ++cursor;
+            if (cursor < end && (*cursor == '+' || *cursor == '-'))
+                ++cursor;
+            if (cursor >= end || *cursor < '0' || *cursor > '9')
+                return fail("Invalid number");
+            while (cursor < end && *cursor >= '0' && *cursor <= '9')
+                ++cursor;
+        }
+
+        /* The text isn't null terminated, give strtod a terminated copy */
+        char buffer[64];
+        size_t length = cursor - start;
+        if (length >= sizeof(buffer))
+        {
+            std::string copy(start, cursor);
+            number = strtod(copy.c_str(), NULL);
+        }
+        else
+        {
+            memcpy(buffer, start, length);
+            buffer[length] = '\0';
+            number = strtod(buffer, NULL);
+        }
+
+        return true;
+    }
+
+    bool parseValue(JsonValue &value, const int depth)
+    {
+        if (depth > maxDepth)
+            return fail("Nesting too deep");
+
+        skipWhitespace();
+        if (cursor >= end)
+            return fail("Unexpected end of input");
+
+        switch (*cursor)
+        {
+            case '{':
+            {
+                value.type = JsonType::Object;
+                ++cursor;
+                skipWhitespace();
+                if (cursor < end && *cursor == '}')
+                {
+                    ++cursor;
+                    return true;
+                }
+
+                while (true)
+                {
+                    skipWhitespace();
+                    if (cursor >= end || *cursor != '"')
+                        return fail("Expected member name");
+
+                    value.members.emplace_back();
+                    if (!parseString(value.members.back().first))
+                        return false;
+
+                    skipWhitespace();
+                    if (cursor >= end || *cursor != ':')
+                        return fail("Expected ':'");
+                    ++cursor;
+
+                    if (!parseValue(value.members.back().second, depth + 1))
+                        return false;
+
+                    skipWhitespace();
+                    if (cursor < end && *cursor == ',')
+                        ++cursor;
+                    else if (cursor < end && *cursor == '}')
+                    {
+                        ++cursor;
+                        return true;
+                    }
+                    else
+                        return fail("Expected ',' or '}'");
+                }
+            }
+
+            case '[':
+            {
+                value.type = JsonType::Array;
+                ++cursor;
+                skipWhitespace();
+                if (cursor < end && *cursor == ']')
+                {
+                    ++cursor;
+                    return true;
+                }
+
+                while (true)
+                {
+                    value.elements.emplace_back();
+                    if (!parseValue(value.elements.back(), depth + 1))
+                        return false;
+
+                    skipWhitespace();
+                    if (cursor < end && *cursor == ',')
+                        ++cursor;
+                    else if (cursor < end && *cursor == ']')
+                    {
+                        ++cursor;
+                        return true;
+                    }
+                    else
+                        return fail("Expected ',' or ']'");
+                }
+            }
+
+            case '"':
+                value.type = JsonType::String;
+                return parseString(value.string);
+
+            case 't':
+            case 'f':
+                value.type = JsonType::Bool;
+                value.boolean = *cursor == 't';
+                return consume(value.boolean ? "true" : "false") || fail("Invalid literal");
+
+            case 'n':
+                value.type = JsonType::Null;
+                return consume("null") || fail("Invalid literal");
+
+            default:
+                value.type = JsonType::Number;
+                return parseNumber(value.number);
+        }
+    }
+};
+
+/* Constructor */
+JsonValue::JsonValue()
+    : type { JsonType::Null },
+      boolean { false },
+      number { 0.0 }
+{
+}
+
+/* Public */
+bool JsonValue::parse(const char* text, const size_t length, JsonValue &value, std::string &error)
+{
+    JsonParser parser;
+    parser.begin = parser.cursor = text;
+    parser.end = text + length;
+
+    value = JsonValue();
+    if (parser.parseValue(value, 0))
+    {
+        parser.skipWhitespace();
+        if (parser.cursor == parser.end)
+            return true;
+
+        parser.fail("Unexpected data after the document");
+    }
+
+    value = JsonValue();
+    error = parser.error;
+    return false;
+}
+
+bool JsonValue::isNull() const
+{
+    return type == JsonType::Null;
+}
+
+bool JsonValue::has(const char* key) const
+{
+    return !(*this)[key].isNull();
+}
+
+const JsonValue &JsonValue::operator[](const char* key) const
+{
+    if (type == JsonType::Object)
+        for (const std::pair<std::string, JsonValue> &member : members)
+            if (member.first == key)
+                return member.second;
+
+    return null();
+}
+
+const JsonValue &JsonValue::operator[](const size_t index) const
+{
+    return type == JsonType::Array && index < elements.size() ? elements[index] : null();
+}
+
+size_t JsonValue::size() const
+{
+    return type == JsonType::Array ? elements.size() : type == JsonType::Object ? members.size() : 0;
+}
+
+bool JsonValue::getBool(const bool fallback) const
+{
+    return type == JsonType::Bool ? boolean : fallback;
+}
+
+double JsonValue::getNumber(const double fallback) const
+{
+    return type == JsonType::Number ? number : fallback;
+}
+
+int64_t JsonValue::getInt(const int64_t fallback) const
+{
+    return type == JsonType::Number ? (int64_t)number : fallback;
+}
+
+const std::string &JsonValue::getString() const
+{
+    return type == JsonType::String ? string : null().string;
+}
+
+/* Private */
+const JsonValue &JsonValue::null()
+{
+    static const JsonValue value;
+    return value;
+}
@@ -0,0 +1,64 @@
+#ifndef JSON
+#define JSON
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+enum class JsonType
+{
+    Null,
+    Bool,
+    Number,
+    String,
+    Array,
+    Object
+};
+
+/*  Minimal JSON document, enough for asset descriptions like glTF.
+
+    Lookups never fail: a missing member, an out of range element or a value of the
+    wrong type reads as null, and the typed getters return their fallback for it, so
+    optional properties read as e.g. `json["scene"].getInt(0)`. Objects keep their
+    members in file order and are searched linearly, they're expected to be small. */
+class JsonValue
+{
+    public:
+        /* Constructor */
+        JsonValue();
+
+        JsonType type;
+
+        bool boolean;
+        double number;
+        std::string string;
+        std::vector<JsonValue> elements;
+        std::vector<std::pair<std::string, JsonValue>> members;
+
+        /* Parses length bytes of UTF-8 text, false with a message and byte offset in error if it isn't valid JSON */
+        static bool parse(const char* text, const size_t length, JsonValue &value, std::string &error);
+
+        bool isNull() const;
+        bool has(const char* key) const;
+
+        /* Member or element, a null value if there's none */
+        const JsonValue &operator[](const char* key) const;
+        const JsonValue &operator[](const size_t index) const;
+
+        /* Elements of an array or members of an object, 0 otherwise */
+        size_t size() const;
+
+        bool getBool(const bool fallback) const;
+        double getNumber(const double fallback) const;
+        int64_t getInt(const int64_t fallback) const;
+        const std::string &getString() const;
+
+    private:
+        static const JsonValue &null();
+};
+
+#endif
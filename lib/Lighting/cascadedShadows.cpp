@@ -0,0 +1,235 @@
+#include "cascadedShadows.h"
+
+/* Constructor */
+CascadedShadows::CascadedShadows(const int resolution, const uint32_t cascadeCount, const float maxDistance, const float splitLambda)
+    : casterMargin { 20.0f }
+    , resolution { resolution }
+    , cascadeCount { std::min<uint32_t>(cascadeCount, MAX_SHADOW_CASCADES) }
+    , maxDistance { maxDistance }
+    , splitLambda { splitLambda }
+    , shadowMap { 0 }
+    , cascades(std::min<uint32_t>(cascadeCount, MAX_SHADOW_CASCADES))
+{
+    /* Zero cascades turns shadows off, there's no empty texture array to allocate */
+    if (this->cascadeCount == 0)
+        return;
+
+    /* One depth layer per cascade, compared in hardware so a single bilinear tap is a 2x2 PCF */
+    glGenTextures(1, &shadowMap);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, shadowMap);
+    glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_DEPTH_COMPONENT32F, resolution, resolution, this->cascadeCount);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+
+    /* Outside the map counts as lit */
+    float border[] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+    glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, border);
+
+    for (uint32_t c = 0; c < this->cascadeCount; ++c)
+    {
+        Cascade &cascade = cascades[c];
+
+        glGenFramebuffers(1, &cascade.framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, cascade.framebuffer);
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, shadowMap, 0, c);
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "ERROR: CascadedShadows -> Framebuffer for cascade " << c << " is incomplete" << std::endl;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+CascadedShadows::~CascadedShadows()
+{
+    for (Cascade &cascade : cascades)
+        glDeleteFramebuffers(1, &cascade.framebuffer);
+
+    if (shadowMap)
+        glDeleteTextures(1, &shadowMap);
+}
+
+void CascadedShadows::update(const Camera &camera, const float aspectRatio, const glm::vec3 &lightDirection)
+{
+    const float nearPlane = camera.nearPlane;
+    const float farPlane = std::min(camera.farPlane, maxDistance);
+
+    const glm::mat4 inverseView = glm::inverse(camera.getViewMatrix());
+    const float tanHalfFov = tanf(glm::radians(camera.fov) * 0.5f);
+
+    /* Rotation only, translation is folded into the snapped projection below */
+    const glm::vec3 direction = glm::normalize(lightDirection);
+    const glm::vec3 up = fabsf(direction.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+    const glm::mat4 lightView = glm::lookAt(glm::vec3(0.0f), direction, up);
+
+    float splitNear = nearPlane;
+    for (uint32_t c = 0; c < cascadeCount; ++c)
+    {
+        Cascade &cascade = cascades[c];
+
+        /* Blend of logarithmic and uniform splits */
+        float ratio = (float)(c + 1) / (float)cascadeCount;
+        float logSplit = nearPlane * powf(farPlane / nearPlane, ratio);
+        float uniformSplit = nearPlane + (farPlane - nearPlane) * ratio;
+        float splitFar = splitLambda * logSplit + (1.0f - splitLambda) * uniformSplit;
+
+        /* World space corners of this slice of the camera frustum */
+        glm::vec3 corners[8];
+        glm::vec3 center = glm::vec3(0.0f);
+        for (int i = 0; i < 8; ++i)
+        {
+            float depth = (i & 4) ? splitFar : splitNear;
+            float halfHeight = depth * tanHalfFov;
+            float halfWidth = halfHeight * aspectRatio;
+
+            glm::vec4 corner = glm::vec4((i & 1) ? halfWidth : -halfWidth, (i & 2) ? halfHeight : -halfHeight, -depth, 1.0f);
+            corners[i] = glm::vec3(inverseView * corner);
+            center += corners[i];
+        }
+        center /= 8.0f;
+
+        /* Bounding sphere, radius rounded up so float noise doesn't change the projection size */
+        float radius = 0.0f;
+        for (int i = 0; i < 8; ++i)
+            radius = std::max(radius, glm::length(corners[i] - center));
+        radius = ceilf(radius * 16.0f) / 16.0f;
+
+        /* Move the projection in whole texel steps */
+        float texelSize = 2.0f * radius / (float)resolution;
+        glm::vec3 lightCenter = glm::vec3(lightView * glm::vec4(center, 1.0f));
+        lightCenter.x = floorf(lightCenter.x / texelSize) * texelSize;
+        lightCenter.y = floorf(lightCenter.y / texelSize) * texelSize;
+
+        cascade.nearPlane = -lightCenter.z - radius - casterMargin;
+        cascade.farPlane = -lightCenter.z + radius;
+
+        cascade.view = lightView;
+        cascade.proj = glm::ortho(lightCenter.x - radius, lightCenter.x + radius,
+                                  lightCenter.y - radius, lightCenter.y + radius,
+                                  cascade.nearPlane, cascade.farPlane);
+        cascade.viewProj = cascade.proj * cascade.view;
+        cascade.splitDepth = splitFar;
+
+        splitNear = splitFar;
+    }
+}
+
+void CascadedShadows::render(const World &world, const TransformHierarchy &hierarchy, JobSystem &jobSystem,
+                             FrameRingBuffer &ring, CommandList &commands, const uint32_t depthProgram)
+{
+    PROFILE_SCOPE("CascadedShadows::render");
+
+    if (cascadeCount == 0)
+        return;
+
+    /* The ring isn't thread safe, grab every cascade's camera block before going wide */
+    RingAllocation frameBlocks[MAX_SHADOW_CASCADES];
+    for (uint32_t c = 0; c < cascadeCount; ++c)
+    {
+        glm::mat4 frameMatrices[2] = { cascades[c].view, cascades[c].proj };
+        frameBlocks[c] = ring.allocateUniform(sizeof(frameMatrices));
+        if (frameBlocks[c].data)
+            memcpy(frameBlocks[c].data, frameMatrices, sizeof(frameMatrices));
+    }
+
+    jobSystem.parallelFor(cascadeCount, 1, [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t c = begin; c < end; ++c)
+        {
+            PROFILE_SCOPE("Shadow cascade");
+            Cascade &cascade = cascades[c];
+
+            cullEntities(world, hierarchy, Frustum(cascade.viewProj), jobSystem, cascade.visible);
+
+            cascade.queue.reset();
+            cascade.queue.nearPlane = cascade.nearPlane;
+            cascade.queue.farPlane = cascade.farPlane;
+
+            for (const Entity &entity : cascade.visible)
+            {
+                const SceneNode* node = world.getComponent<SceneNode>(entity);
+                const MeshRef* mesh = world.getComponent<MeshRef>(entity);
+
+                if (!mesh)
+                    continue;
+
+                DrawPacket packet;
+                packet.program = depthProgram;
+                packet.vertexArray = mesh->VAO;
+                packet.diffuseMap = 0;
+                packet.specularMap = 0;
+                packet.material = 0;
+                packet.shine = 0.0f;
+                packet.first = mesh->firstVertex;
+                packet.count = mesh->vertexCount;
+                packet.indexed = mesh->indexed;
+                packet.model = hierarchy.getWorldMatrix(node->node);
+                packet.normalMatrix = glm::mat3(1.0f);
+
+                float lightDepth = -(cascade.view * packet.model[3]).z;
+                cascade.queue.submit(packet, RenderPass::Shadow, false, lightDepth);
+            }
+
+            cascade.queue.sort();
+
+            cascade.commands.reset();
+            if (!frameBlocks[c].data)
+                continue;
+
+            cascade.commands.bindFramebuffer(cascade.framebuffer);
+            cascade.commands.setViewport(0, 0, resolution, resolution);
+            cascade.commands.setDepthState(true, true, DepthFunction::Less);
+            cascade.commands.clear(glm::vec4(1.0f), false, true);
+            cascade.commands.bindBufferRange(BufferTarget::Uniform, 0, frameBlocks[c].buffer, frameBlocks[c].offset, frameBlocks[c].size);
+            cascade.queue.record(cascade.commands);
+        }
+    });
+
+    commands.setColorMask(false);
+    for (uint32_t c = 0; c < cascadeCount; ++c)
+        commands.append(cascades[c].commands);
+
+    /* Back to the default target, the caller restores its viewport and FrameData block */
+    commands.setColorMask(true);
+    commands.bindFramebuffer(0);
+}
+
+void CascadedShadows::apply(CommandList &commands, const uint32_t program) const
+{
+    static const char* matrixNames[MAX_SHADOW_CASCADES] = {
+        "lightViewProj[0]", "lightViewProj[1]", "lightViewProj[2]", "lightViewProj[3]"
+    };
+
+    /* Programs are built without SHADOWS then, see getCascadeCount */
+    if (cascadeCount == 0)
+        return;
+
+    glm::vec4 splits = glm::vec4(0.0f);
+    for (uint32_t c = 0; c < cascadeCount; ++c)
+        splits[c] = cascades[c].splitDepth;
+
+    commands.useProgram(program);
+    commands.bindTexture(SHADOW_MAP_UNIT, shadowMap, TextureTarget::Texture2DArray);
+    commands.setUniform("cascadeCount", (int)cascadeCount);
+    commands.setUniform("cascadeSplits", splits);
+    commands.setUniform("shadowTexelSize", 1.0f / (float)resolution);
+
+    for (uint32_t c = 0; c < cascadeCount; ++c)
+        commands.setUniform(matrixNames[c], cascades[c].viewProj);
+}
+
+uint32_t CascadedShadows::getCascadeCount() const
+{
+    return cascadeCount;
+}
+
+uint32_t CascadedShadows::getShadowMap() const
+{
+    return shadowMap;
+}
@@ -0,0 +1,96 @@
+#ifndef CASCADED_SHADOWS
+#define CASCADED_SHADOWS
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#include <iostream>
+
+#include "../Camera/camera.h"
+#include "../ECS/ecs.h"
+#include "../ECS/components.h"
+#include "../Scene/transformHierarchy.h"
+#include "../Culling/frustum.h"
+#include "../Culling/entityCuller.h"
+#include "../Jobs/jobSystem.h"
+#include "../Render/commandList.h"
+#include "../Render/renderQueue.h"
+#include "../Render/frameRingBuffer.h"
+#include "../Profiler/profiler.h"
+
+/* Must match the lightViewProj array size in lighting.frag */
+#define MAX_SHADOW_CASCADES     4
+
+/* Texture unit lighting.frag samples the shadow map array from */
+#define SHADOW_MAP_UNIT         3
+
+/*  Cascaded shadow maps for a directional light.
+
+    The camera frustum is split into cascades along the view direction, each fitted with
+    an orthographic light projection around the cascade's bounding sphere. A sphere keeps
+    the projection size constant as the camera rotates, and snapping its center to whole
+    shadow map texels keeps edges from shimmering as the camera moves.
+
+    Every cascade culls the scene against its own light frustum and records its depth-only
+    draws into its own command list, one job per cascade, so each object is only drawn into
+    the cascades it actually overlaps.
+
+    With a cascade count of 0 no shadow map is created and render and apply record nothing,
+    so programs must be built without SHADOWS. */
+class CascadedShadows
+{
+    public:
+        /* Constructor */
+        CascadedShadows(const int resolution = 2048, const uint32_t cascadeCount = MAX_SHADOW_CASCADES,
+                        const float maxDistance = 50.0f, const float splitLambda = 0.75f);
+        ~CascadedShadows();
+
+        CascadedShadows(const CascadedShadows&) = delete;
+        CascadedShadows &operator=(const CascadedShadows&) = delete;
+
+        /* Fits the cascades to the camera's frustum for the current frame */
+        void update(const Camera &camera, const float aspectRatio, const glm::vec3 &lightDirection);
+
+        /* Culls and records the depth passes of every cascade. depthProgram is a depth-only
+           program reading view and proj from the FrameData block at binding 0 */
+        void render(const World &world, const TransformHierarchy &hierarchy, JobSystem &jobSystem,
+                    FrameRingBuffer &ring, CommandList &commands, const uint32_t depthProgram);
+
+        /* Records the shadow map bind and cascade uniforms for a program sampling the shadows */
+        void apply(CommandList &commands, const uint32_t program) const;
+
+        uint32_t getCascadeCount() const;
+        uint32_t getShadowMap() const;
+
+        /* Distance the light frustums reach back towards the light, so casters outside
+           the camera frustum still land in the map */
+        float casterMargin;
+
+    private:
+        struct Cascade
+        {
+            glm::mat4 view;
+            glm::mat4 proj;
+            glm::mat4 viewProj;
+            float splitDepth;       /* Far end of the cascade along the camera's view direction */
+            float nearPlane, farPlane;
+            uint32_t framebuffer;
+
+            std::vector<Entity> visible;
+            RenderQueue queue;
+            CommandList commands;
+        };
+
+        int resolution;
+        uint32_t cascadeCount;
+        float maxDistance;
+        float splitLambda;
+
+        uint32_t shadowMap;
+        std::vector<Cascade> cascades;
+};
+
+#endif
@@ -0,0 +1,260 @@
+#include "clusteredLighting.h"
+
+/* Bit i set when the sphere (xyz = view space center, w = radius) touches the pack's box i */
+static uint32_t sphereOverlapMask(const ClusterBoundsPack &pack, const glm::vec4 &sphere)
+{
+    uint32_t mask = 0;
+    for (int lane = 0; lane < 4; ++lane)
+    {
+        /* Sphere vs box: distance from the center to the closest point in the box */
+        float dx = std::min(std::max(sphere.x, pack.minX[lane]), pack.maxX[lane]) - sphere.x;
+        float dy = std::min(std::max(sphere.y, pack.minY[lane]), pack.maxY[lane]) - sphere.y;
+        float dz = std::min(std::max(sphere.z, pack.minZ[lane]), pack.maxZ[lane]) - sphere.z;
+
+        if (dx * dx + dy * dy + dz * dz <= sphere.w * sphere.w)
+            mask |= 1u << lane;
+    }
+
+    return mask;
+}
+
+#if defined(BATCH_MATH_X86)
+__attribute__((target("sse4.1")))
+static uint32_t sphereOverlapMaskSSE41(const ClusterBoundsPack &pack, const glm::vec4 &sphere)
+{
+    __m128 centerX = _mm_set1_ps(sphere.x);
+    __m128 centerY = _mm_set1_ps(sphere.y);
+    __m128 centerZ = _mm_set1_ps(sphere.z);
+
+    __m128 dx = _mm_sub_ps(_mm_min_ps(_mm_max_ps(centerX, _mm_loadu_ps(pack.minX)), _mm_loadu_ps(pack.maxX)), centerX);
+    __m128 dy = _mm_sub_ps(_mm_min_ps(_mm_max_ps(centerY, _mm_loadu_ps(pack.minY)), _mm_loadu_ps(pack.maxY)), centerY);
+    __m128 dz = _mm_sub_ps(_mm_min_ps(_mm_max_ps(centerZ, _mm_loadu_ps(pack.minZ)), _mm_loadu_ps(pack.maxZ)), centerZ);
+
+    __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+    return _mm_movemask_ps(_mm_cmple_ps(distance, _mm_set1_ps(sphere.w * sphere.w)));
+}
+#endif
+
+/* Constructor */
+ClusteredLighting::ClusteredLighting(const uint32_t gridX, const uint32_t gridY, const uint32_t gridZ, const uint32_t maxLightsPerCluster)
+    : gridX { gridX }
+    , gridY { gridY }
+    , gridZ { gridZ }
+    , maxLightsPerCluster { maxLightsPerCluster }
+    , nearPlane { 0.1f }
+    , farPlane { 100.0f }
+    , viewportWidth { 1 }
+    , viewportHeight { 1 }
+    , packsPerSlice { (gridX * gridY + 3) / 4 }
+    , clusterRanges(gridX * gridY * gridZ)
+    , clusterLists(gridX * gridY * gridZ)
+    , clusterOverflowed(gridX * gridY * gridZ)
+    , overflowedClusters { 0 }
+    , reportedOverflow { 0 }
+{
+    /* Inverted boxes in the padding lanes, only ever tested, never assigned to */
+    ClusterBoundsPack empty;
+    std::fill_n(empty.minX, 4, INFINITY); std::fill_n(empty.minY, 4, INFINITY); std::fill_n(empty.minZ, 4, INFINITY);
+    std::fill_n(empty.maxX, 4, -INFINITY); std::fill_n(empty.maxY, 4, -INFINITY); std::fill_n(empty.maxZ, 4, -INFINITY);
+
+    clusterBounds.assign(packsPerSlice * gridZ, empty);
+}
+
+void ClusteredLighting::setProjection(const glm::mat4 &proj, const float nearPlane, const float farPlane,
+                                      const int viewportWidth, const int viewportHeight)
+{
+    this->nearPlane = nearPlane;
+    this->farPlane = farPlane;
+    this->viewportWidth = viewportWidth;
+    this->viewportHeight = viewportHeight;
+
+    /* Exponential slicing keeps clusters roughly cube shaped in view space */
+    sliceDepths.resize(gridZ + 1);
+    for (uint32_t z = 0; z <= gridZ; ++z)
+        sliceDepths[z] = nearPlane * powf(farPlane / nearPlane, (float)z / (float)gridZ);
+
+    glm::mat4 inverseProj = glm::inverse(proj);
+
+    for (uint32_t y = 0; y < gridY; ++y)
+    for (uint32_t x = 0; x < gridX; ++x)
+    {
+        /* View space points on the near plane through the tile's corners */
+        glm::vec3 corners[4];
+        for (int c = 0; c < 4; ++c)
+        {
+            float ndcX = -1.0f + 2.0f * (float)(x + (c & 1)) / (float)gridX;
+            float ndcY = -1.0f + 2.0f * (float)(y + (c >> 1)) / (float)gridY;
+
+            glm::vec4 point = inverseProj * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+            corners[c] = glm::vec3(point) / point.w;
+        }
+
+        for (uint32_t z = 0; z < gridZ; ++z)
+        {
+            glm::vec3 boundsMin = glm::vec3(INFINITY);
+            glm::vec3 boundsMax = glm::vec3(-INFINITY);
+
+            /* Slide each corner ray out to the slice's near and far depth */
+            for (int c = 0; c < 4; ++c)
+            {
+                for (int side = 0; side < 2; ++side)
+                {
+                    float depth = sliceDepths[z + side];
+                    glm::vec3 point = corners[c] * (depth / -corners[c].z);
+
+                    boundsMin = glm::min(boundsMin, point);
+                    boundsMax = glm::max(boundsMax, point);
+                }
+            }
+
+            uint32_t tile = clusterIndex(x, y, 0);
+            ClusterBoundsPack &pack = clusterBounds[z * packsPerSlice + tile / 4];
+            pack.minX[tile % 4] = boundsMin.x; pack.minY[tile % 4] = boundsMin.y; pack.minZ[tile % 4] = boundsMin.z;
+            pack.maxX[tile % 4] = boundsMax.x; pack.maxY[tile % 4] = boundsMax.y; pack.maxZ[tile % 4] = boundsMax.z;
+        }
+    }
+}
+
+void ClusteredLighting::assignLights(const std::vector<GpuPointLight> &lights, const glm::mat4 &view, JobSystem &jobSystem)
+{
+    PROFILE_SCOPE("ClusteredLighting::assignLights");
+
+    frameLights = lights;
+
+    /* View space centers, shared by every slice job */
+    std::vector<glm::vec4> viewSpheres(lights.size());
+    for (size_t i = 0; i < lights.size(); ++i)
+    {
+        glm::vec4 center = view * glm::vec4(glm::vec3(lights[i].positionRange), 1.0f);
+        viewSpheres[i] = glm::vec4(glm::vec3(center), lights[i].positionRange.w);
+    }
+
+    /* Picked once per frame, following the level BatchMath runs at */
+    uint32_t (*overlapMask)(const ClusterBoundsPack&, const glm::vec4&) = sphereOverlapMask;
+#if defined(BATCH_MATH_X86)
+    if (BatchMath::getLevel() >= SimdLevel::SSE41)
+        overlapMask = sphereOverlapMaskSSE41;
+#endif
+
+    const uint32_t tileCount = gridX * gridY;
+
+    /* Each depth slice owns its clusters, so jobs never write to the same list */
+    jobSystem.parallelFor(gridZ, 1, [&](uint32_t sliceBegin, uint32_t sliceEnd)
+    {
+        for (uint32_t z = sliceBegin; z < sliceEnd; ++z)
+        {
+            for (uint32_t tile = 0; tile < tileCount; ++tile)
+            {
+                clusterLists[z * tileCount + tile].clear();
+                clusterOverflowed[z * tileCount + tile] = 0;
+            }
+
+            for (uint32_t light = 0; light < viewSpheres.size(); ++light)
+            {
+                const glm::vec4 &sphere = viewSpheres[light];
+                float depth = -sphere.z;
+
+                if (depth + sphere.w < sliceDepths[z] || depth - sphere.w > sliceDepths[z + 1])
+                    continue;
+
+                for (uint32_t packIndex = 0; packIndex < packsPerSlice; ++packIndex)
+                {
+                    uint32_t mask = overlapMask(clusterBounds[z * packsPerSlice + packIndex], sphere);
+
+                    /* An infinite range also reaches the inverted padding boxes, so bound the tile too */
+                    for (uint32_t lane = 0; mask; ++lane, mask >>= 1)
+                    {
+                        uint32_t tile = packIndex * 4 + lane;
+                        if (!(mask & 1) || tile >= tileCount)
+                            continue;
+
+                        uint32_t cluster = z * tileCount + tile;
+                        if (clusterLists[cluster].size() < maxLightsPerCluster)
+                            clusterLists[cluster].push_back(light);
+                        else
+                            clusterOverflowed[cluster] = 1;
+                    }
+                }
+            }
+        }
+    });
+
+    /* Flatten into one index list */
+    lightIndices.clear();
+    overflowedClusters = 0;
+    for (size_t cluster = 0; cluster < clusterLists.size(); ++cluster)
+    {
+        clusterRanges[cluster] = glm::uvec2(lightIndices.size(), clusterLists[cluster].size());
+        lightIndices.insert(lightIndices.end(), clusterLists[cluster].begin(), clusterLists[cluster].end());
+        overflowedClusters += clusterOverflowed[cluster];
+    }
+
+    /* Only new highs are reported, a scene that overflows every frame would flood the log otherwise */
+    if (overflowedClusters > reportedOverflow)
+    {
+        std::cout << "WARNING: ClusteredLighting -> " << overflowedClusters << " clusters dropped lights. Max per cluster = " << maxLightsPerCluster << std::endl;
+        reportedOverflow = overflowedClusters;
+    }
+}
+
+void ClusteredLighting::upload(FrameRingBuffer &ring, CommandList &commands, const uint32_t program) const
+{
+    /* Zero sized ranges can't be bound, always hand out at least one element */
+    uint32_t lightBytes = std::max<size_t>(1, frameLights.size()) * sizeof(GpuPointLight);
+    uint32_t gridBytes = clusterRanges.size() * sizeof(glm::uvec2);
+    uint32_t indexBytes = std::max<size_t>(1, lightIndices.size()) * sizeof(uint32_t);
+
+    RingAllocation lights = ring.allocateStorage(lightBytes);
+    RingAllocation grid = ring.allocateStorage(gridBytes);
+    RingAllocation indices = ring.allocateStorage(indexBytes);
+
+    if (!lights.data || !grid.data || !indices.data)
+        return;
+
+    memcpy(lights.data, frameLights.data(), frameLights.size() * sizeof(GpuPointLight));
+    memcpy(grid.data, clusterRanges.data(), gridBytes);
+    memcpy(indices.data, lightIndices.data(), lightIndices.size() * sizeof(uint32_t));
+
+    commands.bindBufferRange(BufferTarget::ShaderStorage, CLUSTER_LIGHTS_BINDING, lights.buffer, lights.offset, lights.size);
+    commands.bindBufferRange(BufferTarget::ShaderStorage, CLUSTER_GRID_BINDING, grid.buffer, grid.offset, grid.size);
+    commands.bindBufferRange(BufferTarget::ShaderStorage, CLUSTER_INDICES_BINDING, indices.buffer, indices.offset, indices.size);
+
+    commands.useProgram(program);
+    commands.setUniform("clusterGrid", glm::vec4((float)gridX, (float)gridY, (float)gridZ, 0.0f));
+    commands.setUniform("clusterDepth", glm::vec4(nearPlane, farPlane, (float)gridZ / logf(farPlane / nearPlane), 0.0f));
+    commands.setUniform("viewportSize", glm::vec4((float)viewportWidth, (float)viewportHeight, 0.0f, 0.0f));
+}
+
+float ClusteredLighting::computeRange(const PointLight &light, const float threshold)
+{
+    /* Solve 1 / (c + l * d + q * d^2) = threshold for d */
+    float c = light.attConstant - 1.0f / threshold;
+    float l = light.attLinear;
+    float q = light.attQuadratic;
+
+    if (q <= 0.0f)
+        return l > 0.0f ? -c / l : INFINITY;
+
+    return (-l + sqrtf(l * l - 4.0f * q * c)) / (2.0f * q);
+}
+
+uint32_t ClusteredLighting::getClusterCount() const
+{
+    return gridX * gridY * gridZ;
+}
+
+uint32_t ClusteredLighting::getAssignedIndexCount() const
+{
+    return lightIndices.size();
+}
+
+uint32_t ClusteredLighting::getOverflowedClusterCount() const
+{
+    return overflowedClusters;
+}
+
+/* Private */
+uint32_t ClusteredLighting::clusterIndex(const uint32_t x, const uint32_t y, const uint32_t z) const
+{
+    return (z * gridY + y) * gridX + x;
+}
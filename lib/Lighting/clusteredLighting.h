@@ -0,0 +1,102 @@
+#ifndef CLUSTERED_LIGHTING
+#define CLUSTERED_LIGHTING
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <cmath>
+#include <vector>
+
+#include "../ECS/components.h"
+#include "../Jobs/jobSystem.h"
+#include "../Math/batchMath.h"
+#include "../Render/commandList.h"
+#include "../Render/frameRingBuffer.h"
+#include "../Profiler/profiler.h"
+
+/* Storage buffer bindings shared with clustered.frag */
+#define CLUSTER_LIGHTS_BINDING      1
+#define CLUSTER_GRID_BINDING        2
+#define CLUSTER_INDICES_BINDING     3
+
+/* Point light laid out to match the std430 struct in clustered.frag */
+struct GpuPointLight
+{
+    glm::vec4 positionRange;    /* xyz = world position, w = range */
+    glm::vec4 ambient;
+    glm::vec4 diffuse;
+    glm::vec4 specular;
+    glm::vec4 attenuation;      /* x = constant, y = linear, z = quadratic */
+};
+
+/* View space boxes of four neighbouring clusters in a depth slice, one lane each */
+struct ClusterBoundsPack
+{
+    float minX[4], minY[4], minZ[4];
+    float maxX[4], maxY[4], maxZ[4];
+};
+
+/*  Clustered forward shading.
+
+    The view frustum is split into a gridX * gridY * gridZ grid of froxels, tiled in screen
+    space and sliced exponentially in depth. Every frame each light's bounding sphere is
+    tested against the froxels' view space boxes on the job system, one depth slice per
+    job, four clusters per test at BatchMath's SIMD level, producing a compact list of
+    light indices per cluster. The fragment shader then only evaluates the lights of the
+    cluster it falls into.
+
+    Lights past maxLightsPerCluster are dropped from a cluster. The number of clusters
+    that overflowed is kept per frame and a warning is printed whenever it reaches a new high. */
+class ClusteredLighting
+{
+    public:
+        /* Constructor */
+        ClusteredLighting(const uint32_t gridX = 16, const uint32_t gridY = 9, const uint32_t gridZ = 24,
+                          const uint32_t maxLightsPerCluster = 128);
+
+        /* Rebuilds the cluster boxes, call whenever the projection changes */
+        void setProjection(const glm::mat4 &proj, const float nearPlane, const float farPlane,
+                           const int viewportWidth, const int viewportHeight);
+
+        /* Assigns world space lights to clusters for the given view */
+        void assignLights(const std::vector<GpuPointLight> &lights, const glm::mat4 &view, JobSystem &jobSystem);
+
+        /* Writes lights, cluster grid and index list into the ring and records their binds,
+           plus the cluster uniforms for `program` */
+        void upload(FrameRingBuffer &ring, CommandList &commands, const uint32_t program) const;
+
+        /* Distance at which the light's attenuation drops below `threshold` */
+        static float computeRange(const PointLight &light, const float threshold = 5.0f / 256.0f);
+
+        uint32_t getClusterCount() const;
+        uint32_t getAssignedIndexCount() const;
+
+        /* Clusters that dropped lights in the last assignLights */
+        uint32_t getOverflowedClusterCount() const;
+
+    private:
+        uint32_t gridX, gridY, gridZ;
+        uint32_t maxLightsPerCluster;
+        float nearPlane, farPlane;
+        int viewportWidth, viewportHeight;
+
+        /* packsPerSlice packs per depth slice, lanes past the last tile stay empty */
+        uint32_t packsPerSlice;
+        std::vector<ClusterBoundsPack> clusterBounds;
+        std::vector<float> sliceDepths;             /* gridZ + 1 view space depths */
+
+        std::vector<GpuPointLight> frameLights;
+        std::vector<glm::uvec2> clusterRanges;      /* (offset, count) into lightIndices */
+        std::vector<uint32_t> lightIndices;
+
+        /* Per cluster scratch lists, filled by one job per depth slice */
+        std::vector<std::vector<uint32_t>> clusterLists;
+        std::vector<uint8_t> clusterOverflowed;
+
+        uint32_t overflowedClusters;
+        uint32_t reportedOverflow;
+
+        uint32_t clusterIndex(const uint32_t x, const uint32_t y, const uint32_t z) const;
+};
+
+#endif
@@ -0,0 +1,380 @@
+#include "batchMath.h"
+
+/* Reference kernels, plain glm */
+namespace BatchMathScalar
+{
+    static void multiply(const glm::mat4* a, const glm::mat4* b, glm::mat4* out, const size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+            out[i] = a[i] * b[i];
+    }
+
+    static void multiplyBroadcast(const glm::mat4 &a, const glm::mat4* b, glm::mat4* out, const size_t count)
+    {
+        const glm::mat4 left = a;
+        for (size_t i = 0; i < count; ++i)
+            out[i] = left * b[i];
+    }
+
+    static void transformPoints(const glm::mat4 &m, const glm::vec4* in, glm::vec4* out, const size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+            out[i] = m * in[i];
+    }
+
+    static void transformPointsSoA(const glm::mat4 &m, const float* x, const float* y, const float* z,
+                                   float* outX, float* outY, float* outZ, const size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            glm::vec4 p = m * glm::vec4(x[i], y[i], z[i], 1.0f);
+            outX[i] = p.x;
+            outY[i] = p.y;
+            outZ[i] = p.z;
+        }
+    }
+
+    static void transformAABBs(const glm::mat4* matrices, const glm::mat4* const* pointers,
+                               const Bounds* local, Bounds* world, const size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            const glm::mat4 &m = pointers ? *pointers[i] : matrices[i];
+            const Bounds box = local[i];
+
+            world[i].center = glm::vec3(m * glm::vec4(box.center, 1.0f));
+            world[i].extents = glm::abs(glm::vec3(m[0])) * box.extents.x
+                             + glm::abs(glm::vec3(m[1])) * box.extents.y
+                             + glm::abs(glm::vec3(m[2])) * box.extents.z;
+        }
+    }
+
+    static void composeTRS(const glm::vec3* positions, const glm::quat* rotations, const glm::vec3* scales,
+                           glm::mat4* out, const size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            glm::mat4 local = glm::mat4_cast(rotations[i]);
+            local[0] *= scales[i].x;
+            local[1] *= scales[i].y;
+            local[2] *= scales[i].z;
+            local[3] = glm::vec4(positions[i], 1.0f);
+            out[i] = local;
+        }
+    }
+}
+
+#if defined(BATCH_MATH_X86)
+
+/* Applies a target to every function up to the matching pop, GCC and Clang spell it differently */
+#define BATCH_MATH_PRAGMA(x) _Pragma(#x)
+#if defined(__clang__)
+#define BATCH_MATH_TARGET_PUSH(isa) BATCH_MATH_PRAGMA(clang attribute push (__attribute__((target(isa))), apply_to = function))
+#define BATCH_MATH_TARGET_POP BATCH_MATH_PRAGMA(clang attribute pop)
+#else
+#define BATCH_MATH_TARGET_PUSH(isa) BATCH_MATH_PRAGMA(GCC push_options) BATCH_MATH_PRAGMA(GCC target(isa))
+#define BATCH_MATH_TARGET_POP BATCH_MATH_PRAGMA(GCC pop_options)
+#endif
+
+BATCH_MATH_TARGET_PUSH("sse4.1")
+namespace BatchMathSSE41
+{
+    #define BATCH_MATH_FMADD(a, b, c) _mm_add_ps(_mm_mul_ps(a, b), c)
+    #include "batchMathKernels.h"
+    #undef BATCH_MATH_FMADD
+}
+BATCH_MATH_TARGET_POP
+
+BATCH_MATH_TARGET_PUSH("avx2,fma")
+namespace BatchMathAVX2
+{
+    #define BATCH_MATH_FMADD(a, b, c) _mm_fmadd_ps(a, b, c)
+    #include "batchMathKernels.h"
+    #undef BATCH_MATH_FMADD
+
+    /* Two columns per register, each 128-bit lane multiplies one of them */
+    static inline __m256 combineWide(const __m256 v, const __m256 a0, const __m256 a1, const __m256 a2, const __m256 a3)
+    {
+        __m256 result = _mm256_mul_ps(a0, _mm256_permute_ps(v, 0x00));
+        result = _mm256_fmadd_ps(a1, _mm256_permute_ps(v, 0x55), result);
+        result = _mm256_fmadd_ps(a2, _mm256_permute_ps(v, 0xAA), result);
+        return _mm256_fmadd_ps(a3, _mm256_permute_ps(v, 0xFF), result);
+    }
+
+    static void multiplyWide(const glm::mat4* a, const glm::mat4* b, glm::mat4* out, const size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            const float* left = &a[i][0][0];
+            const float* right = &b[i][0][0];
+
+            __m256 a0 = _mm256_broadcast_ps((const __m128*)left), a1 = _mm256_broadcast_ps((const __m128*)(left + 4));
+            __m256 a2 = _mm256_broadcast_ps((const __m128*)(left + 8)), a3 = _mm256_broadcast_ps((const __m128*)(left + 12));
+            __m256 b01 = _mm256_loadu_ps(right), b23 = _mm256_loadu_ps(right + 8);
+
+            float* result = &out[i][0][0];
+            _mm256_storeu_ps(result, combineWide(b01, a0, a1, a2, a3));
+            _mm256_storeu_ps(result + 8, combineWide(b23, a0, a1, a2, a3));
+        }
+    }
+
+    static void multiplyBroadcastWide(const glm::mat4 &a, const glm::mat4* b, glm::mat4* out, const size_t count)
+    {
+        const float* left = &a[0][0];
+        const __m256 a0 = _mm256_broadcast_ps((const __m128*)left), a1 = _mm256_broadcast_ps((const __m128*)(left + 4));
+        const __m256 a2 = _mm256_broadcast_ps((const __m128*)(left + 8)), a3 = _mm256_broadcast_ps((const __m128*)(left + 12));
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const float* right = &b[i][0][0];
+            __m256 b01 = _mm256_loadu_ps(right), b23 = _mm256_loadu_ps(right + 8);
+
+            float* result = &out[i][0][0];
+            _mm256_storeu_ps(result, combineWide(b01, a0, a1, a2, a3));
+            _mm256_storeu_ps(result + 8, combineWide(b23, a0, a1, a2, a3));
+        }
+    }
+
+    static void transformPointsWide(const glm::mat4 &m, const glm::vec4* in, glm::vec4* out, const size_t count)
+    {
+        const float* matrix = &m[0][0];
+        const __m256 m0 = _mm256_broadcast_ps((const __m128*)matrix), m1 = _mm256_broadcast_ps((const __m128*)(matrix + 4));
+        const __m256 m2 = _mm256_broadcast_ps((const __m128*)(matrix + 8)), m3 = _mm256_broadcast_ps((const __m128*)(matrix + 12));
+
+        size_t i = 0;
+        for (; i + 2 <= count; i += 2)
+            _mm256_storeu_ps(&out[i].x, combineWide(_mm256_loadu_ps(&in[i].x), m0, m1, m2, m3));
+
+        transformPoints(m, in + i, out + i, count - i);
+    }
+
+    static void transformPointsSoAWide(const glm::mat4 &m, const float* x, const float* y, const float* z,
+                                       float* outX, float* outY, float* outZ, const size_t count)
+    {
+        __m256 rows[3][4];
+        for (int row = 0; row < 3; ++row)
+            for (int column = 0; column < 4; ++column)
+                rows[row][column] = _mm256_set1_ps(m[column][row]);
+
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            __m256 px = _mm256_loadu_ps(x + i), py = _mm256_loadu_ps(y + i), pz = _mm256_loadu_ps(z + i);
+
+            __m256 results[3];
+            for (int row = 0; row < 3; ++row)
+            {
+                __m256 result = _mm256_fmadd_ps(rows[row][0], px, rows[row][3]);
+                result = _mm256_fmadd_ps(rows[row][1], py, result);
+                results[row] = _mm256_fmadd_ps(rows[row][2], pz, result);
+            }
+
+            _mm256_storeu_ps(outX + i, results[0]);
+            _mm256_storeu_ps(outY + i, results[1]);
+            _mm256_storeu_ps(outZ + i, results[2]);
+        }
+
+        transformPointsSoA(m, x + i, y + i, z + i, outX + i, outY + i, outZ + i, count - i);
+    }
+}
+BATCH_MATH_TARGET_POP
+
+BATCH_MATH_TARGET_PUSH("avx512f")
+namespace BatchMathAVX512
+{
+    /* A whole matrix per register, lane c multiplies column c */
+    static inline __m512 combine(const __m512 v, const __m512 a0, const __m512 a1, const __m512 a2, const __m512 a3)
+    {
+        __m512 result = _mm512_mul_ps(a0, _mm512_permute_ps(v, 0x00));
+        result = _mm512_fmadd_ps(a1, _mm512_permute_ps(v, 0x55), result);
+        result = _mm512_fmadd_ps(a2, _mm512_permute_ps(v, 0xAA), result);
+        return _mm512_fmadd_ps(a3, _mm512_permute_ps(v, 0xFF), result);
+    }
+
+    static void multiply(const glm::mat4* a, const glm::mat4* b, glm::mat4* out, const size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            const float* left = &a[i][0][0];
+
+            __m512 a0 = _mm512_broadcast_f32x4(_mm_loadu_ps(left)), a1 = _mm512_broadcast_f32x4(_mm_loadu_ps(left + 4));
+            __m512 a2 = _mm512_broadcast_f32x4(_mm_loadu_ps(left + 8)), a3 = _mm512_broadcast_f32x4(_mm_loadu_ps(left + 12));
+
+            _mm512_storeu_ps(&out[i][0][0], combine(_mm512_loadu_ps(&b[i][0][0]), a0, a1, a2, a3));
+        }
+    }
+
+    static void multiplyBroadcast(const glm::mat4 &a, const glm::mat4* b, glm::mat4* out, const size_t count)
+    {
+        const float* left = &a[0][0];
+        const __m512 a0 = _mm512_broadcast_f32x4(_mm_loadu_ps(left)), a1 = _mm512_broadcast_f32x4(_mm_loadu_ps(left + 4));
+        const __m512 a2 = _mm512_broadcast_f32x4(_mm_loadu_ps(left + 8)), a3 = _mm512_broadcast_f32x4(_mm_loadu_ps(left + 12));
+
+        for (size_t i = 0; i < count; ++i)
+            _mm512_storeu_ps(&out[i][0][0], combine(_mm512_loadu_ps(&b[i][0][0]), a0, a1, a2, a3));
+    }
+
+    static void transformPoints(const glm::mat4 &m, const glm::vec4* in, glm::vec4* out, const size_t count)
+    {
+        const float* matrix = &m[0][0];
+        const __m512 m0 = _mm512_broadcast_f32x4(_mm_loadu_ps(matrix)), m1 = _mm512_broadcast_f32x4(_mm_loadu_ps(matrix + 4));
+        const __m512 m2 = _mm512_broadcast_f32x4(_mm_loadu_ps(matrix + 8)), m3 = _mm512_broadcast_f32x4(_mm_loadu_ps(matrix + 12));
+
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4)
+            _mm512_storeu_ps(&out[i].x, combine(_mm512_loadu_ps(&in[i].x), m0, m1, m2, m3));
+
+        BatchMathAVX2::transformPointsWide(m, in + i, out + i, count - i);
+    }
+
+    static void transformPointsSoA(const glm::mat4 &m, const float* x, const float* y, const float* z,
+                                   float* outX, float* outY, float* outZ, const size_t count)
+    {
+        __m512 rows[3][4];
+        for (int row = 0; row < 3; ++row)
+            for (int column = 0; column < 4; ++column)
+                rows[row][column] = _mm512_set1_ps(m[column][row]);
+
+        size_t i = 0;
+        for (; i + 16 <= count; i += 16)
+        {
+            __m512 px = _mm512_loadu_ps(x + i), py = _mm512_loadu_ps(y + i), pz = _mm512_loadu_ps(z + i);
+
+            __m512 results[3];
+            for (int row = 0; row < 3; ++row)
+            {
+                __m512 result = _mm512_fmadd_ps(rows[row][0], px, rows[row][3]);
+                result = _mm512_fmadd_ps(rows[row][1], py, result);
+                results[row] = _mm512_fmadd_ps(rows[row][2], pz, result);
+            }
+
+            _mm512_storeu_ps(outX + i, results[0]);
+            _mm512_storeu_ps(outY + i, results[1]);
+            _mm512_storeu_ps(outZ + i, results[2]);
+        }
+
+        BatchMathAVX2::transformPointsSoAWide(m, x + i, y + i, z + i, outX + i, outY + i, outZ + i, count - i);
+    }
+}
+BATCH_MATH_TARGET_POP
+
+#endif
+
+std::atomic<uint32_t> BatchMath::level { (uint32_t)BatchMath::getSupportedLevel() };
+
+SimdLevel BatchMath::getSupportedLevel()
+{
+    static const SimdLevel supported = detectLevel();
+    return supported;
+}
+
+SimdLevel BatchMath::getLevel()
+{
+    return (SimdLevel)level.load(std::memory_order_relaxed);
+}
+
+void BatchMath::setLevel(const SimdLevel requested)
+{
+    level.store((uint32_t)std::min(requested, getSupportedLevel()), std::memory_order_relaxed);
+}
+
+const char* BatchMath::getLevelName(const SimdLevel level)
+{
+    switch (level)
+    {
+        case SimdLevel::SSE41: return "SSE4.1";
+        case SimdLevel::AVX2: return "AVX2";
+        case SimdLevel::AVX512: return "AVX-512";
+        default: return "Scalar";
+    }
+}
+
+void BatchMath::multiply(const glm::mat4* a, const glm::mat4* b, glm::mat4* out, const size_t count)
+{
+    getKernels().multiply(a, b, out, count);
+}
+
+void BatchMath::multiply(const glm::mat4 &a, const glm::mat4* b, glm::mat4* out, const size_t count)
+{
+    getKernels().multiplyBroadcast(a, b, out, count);
+}
+
+void BatchMath::transformPoints(const glm::mat4 &m, const glm::vec4* in, glm::vec4* out, const size_t count)
+{
+    getKernels().transformPoints(m, in, out, count);
+}
+
+void BatchMath::transformPoints(const glm::mat4 &m, const float* x, const float* y, const float* z,
+                                float* outX, float* outY, float* outZ, const size_t count)
+{
+    getKernels().transformPointsSoA(m, x, y, z, outX, outY, outZ, count);
+}
+
+void BatchMath::transformAABBs(const glm::mat4* matrices, const Bounds* local, Bounds* world, const size_t count)
+{
+    getKernels().transformAABBs(matrices, NULL, local, world, count);
+}
+
+void BatchMath::transformAABBs(const glm::mat4* const* matrices, const Bounds* local, Bounds* world, const size_t count)
+{
+    getKernels().transformAABBs(NULL, matrices, local, world, count);
+}
+
+void BatchMath::composeTRS(const glm::vec3* positions, const glm::quat* rotations, const glm::vec3* scales,
+                           glm::mat4* out, const size_t count)
+{
+    getKernels().composeTRS(positions, rotations, scales, out, count);
+}
+
+/* Private */
+const BatchMath::Kernels &BatchMath::getKernels()
+{
+    /* Indexed by SimdLevel */
+    static const Kernels kernels[] = {
+        {
+            BatchMathScalar::multiply, BatchMathScalar::multiplyBroadcast, BatchMathScalar::transformPoints,
+            BatchMathScalar::transformPointsSoA, BatchMathScalar::transformAABBs, BatchMathScalar::composeTRS
+        },
+#if defined(BATCH_MATH_X86)
+        {
+            BatchMathSSE41::multiply, BatchMathSSE41::multiplyBroadcast, BatchMathSSE41::transformPoints,
+            BatchMathSSE41::transformPointsSoA, BatchMathSSE41::transformAABBs, BatchMathSSE41::composeTRS
+        },
+        {
+            BatchMathAVX2::multiplyWide, BatchMathAVX2::multiplyBroadcastWide, BatchMathAVX2::transformPointsWide,
+            BatchMathAVX2::transformPointsSoAWide, BatchMathAVX2::transformAABBs, BatchMathAVX2::composeTRS
+        },
+        {
+            /* One object per register gains nothing from 512 bits, those stay on the AVX2 kernels */
+            BatchMathAVX512::multiply, BatchMathAVX512::multiplyBroadcast, BatchMathAVX512::transformPoints,
+            BatchMathAVX512::transformPointsSoA, BatchMathAVX2::transformAABBs, BatchMathAVX2::composeTRS
+        }
+#endif
+    };
+
+    return kernels[level.load(std::memory_order_relaxed)];
+}
+
+SimdLevel BatchMath::detectLevel()
+{
+    /* The kernels read glm's quaternions as (x, y, z, w), which GLM_FORCE_QUAT_DATA_WXYZ would break */
+    const glm::quat probe(1.0f, 0.0f, 0.0f, 0.0f);
+    float probeData[4];
+    memcpy(probeData, &probe, sizeof(probeData));
+    if (sizeof(glm::quat) != sizeof(probeData) || probeData[3] != 1.0f)
+        return SimdLevel::Scalar;
+
+#if defined(BATCH_MATH_X86)
+    /* Also checks the OS saves the wider registers */
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx512f"))
+        return SimdLevel::AVX512;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        return SimdLevel::AVX2;
+    if (__builtin_cpu_supports("sse4.1"))
+        return SimdLevel::SSE41;
+#endif
+
+    return SimdLevel::Scalar;
+}
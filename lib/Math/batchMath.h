@@ -0,0 +1,97 @@
+#ifndef BATCH_MATH
+#define BATCH_MATH
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "../ECS/components.h"
+
+/* The SIMD kernels need GCC or Clang's per function target attributes and cpu detection */
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define BATCH_MATH_X86
+#include <immintrin.h>
+#endif
+
+enum class SimdLevel : uint32_t
+{
+    Scalar,
+    SSE41,
+    AVX2,       /* Including FMA */
+    AVX512
+};
+
+/*  Math over arrays of transforms, for the per object work that grows with the scene.
+
+    Every function has a kernel per instruction set, compiled with per function target
+    attributes so the rest of the build needs no -m flags, and the best one the CPU
+    supports is picked at startup. Matrices and vectors stay in glm's AoS layout:
+
+    - Matrix products and vec4 transforms broadcast one column's elements against the
+      other matrix's columns, a column per SSE register, two per AVX2 register and a
+      whole matrix per AVX-512 register.
+    - SoA point transforms process 4, 8 or 16 points per instruction.
+    - TRS composition and AABB transforms work on one object per 128-bit register. AVX2
+      adds FMA to them, AVX-512 runs the AVX2 kernels.
+
+    Outputs may alias inputs of the same type (out == b, world == local), every element
+    is read before its result is written. */
+class BatchMath
+{
+    public:
+        /* Best level the CPU and OS support */
+        static SimdLevel getSupportedLevel();
+
+        /* Level the kernels run at, the supported one unless changed. Higher requests are clamped */
+        static SimdLevel getLevel();
+        static void setLevel(const SimdLevel level);
+        static const char* getLevelName(const SimdLevel level);
+
+        /* out[i] = a[i] * b[i] */
+        static void multiply(const glm::mat4* a, const glm::mat4* b, glm::mat4* out, const size_t count);
+
+        /* out[i] = a * b[i], e.g. viewProjection * model for every instance */
+        static void multiply(const glm::mat4 &a, const glm::mat4* b, glm::mat4* out, const size_t count);
+
+        /* out[i] = m * in[i] */
+        static void transformPoints(const glm::mat4 &m, const glm::vec4* in, glm::vec4* out, const size_t count);
+
+        /* SoA points, transformed as (x, y, z, 1) without the projective divide */
+        static void transformPoints(const glm::mat4 &m, const float* x, const float* y, const float* z,
+                                    float* outX, float* outY, float* outZ, const size_t count);
+
+        /* World space boxes enclosing the local boxes transformed by matrices[i] */
+        static void transformAABBs(const glm::mat4* matrices, const Bounds* local, Bounds* world, const size_t count);
+        static void transformAABBs(const glm::mat4* const* matrices, const Bounds* local, Bounds* world, const size_t count);
+
+        /* translate(positions[i]) * mat4_cast(rotations[i]) * scale(scales[i]) */
+        static void composeTRS(const glm::vec3* positions, const glm::quat* rotations, const glm::vec3* scales,
+                               glm::mat4* out, const size_t count);
+
+    private:
+        struct Kernels
+        {
+            void (*multiply)(const glm::mat4* a, const glm::mat4* b, glm::mat4* out, const size_t count);
+            void (*multiplyBroadcast)(const glm::mat4 &a, const glm::mat4* b, glm::mat4* out, const size_t count);
+            void (*transformPoints)(const glm::mat4 &m, const glm::vec4* in, glm::vec4* out, const size_t count);
+            void (*transformPointsSoA)(const glm::mat4 &m, const float* x, const float* y, const float* z,
+                                       float* outX, float* outY, float* outZ, const size_t count);
+
+            /* Reads matrices[i], or *pointers[i] when pointers isn't NULL */
+            void (*transformAABBs)(const glm::mat4* matrices, const glm::mat4* const* pointers,
+                                   const Bounds* local, Bounds* world, const size_t count);
+            void (*composeTRS)(const glm::vec3* positions, const glm::quat* rotations, const glm::vec3* scales,
+                               glm::mat4* out, const size_t count);
+        };
+
+        static std::atomic<uint32_t> level;
+
+        static const Kernels &getKernels();
+        static SimdLevel detectLevel();
+};
+
+#endif
@@ -0,0 +1,188 @@
+/*  128-bit kernels of BatchMath, one object per register.
+
+    Deliberately without an include guard: batchMath.cpp includes this once per
+    instruction set, inside that set's namespace and target pragma, with
+    BATCH_MATH_FMADD(a, b, c) defined as a * b + c for it. */
+
+static inline __m128 splat(const __m128 v, const int lane)
+{
+    switch (lane)
+    {
+        case 0: return _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0));
+        case 1: return _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1));
+        case 2: return _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2));
+        default: return _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3));
+    }
+}
+
+/* a0 * v.x + a1 * v.y + a2 * v.z + a3 * v.w, a matrix times a column */
+static inline __m128 combine(const __m128 v, const __m128 a0, const __m128 a1, const __m128 a2, const __m128 a3)
+{
+    __m128 result = _mm_mul_ps(a0, splat(v, 0));
+    result = BATCH_MATH_FMADD(a1, splat(v, 1), result);
+    result = BATCH_MATH_FMADD(a2, splat(v, 2), result);
+    return BATCH_MATH_FMADD(a3, splat(v, 3), result);
+}
+
+/* (x, y, z, w) from a vec3, without reading past its last float */
+static inline __m128 loadVec3(const float* v, const float w)
+{
+    __m128 xy = _mm_castpd_ps(_mm_load_sd((const double*)v));
+    __m128 zw = _mm_unpacklo_ps(_mm_load_ss(v + 2), _mm_set_ss(w));
+    return _mm_movelh_ps(xy, zw);
+}
+
+static inline void storeVec3(float* v, const __m128 value)
+{
+    _mm_storel_pi((__m64*)v, value);
+    _mm_store_ss(v + 2, _mm_movehl_ps(value, value));
+}
+
+static inline void multiply(const glm::mat4* a, const glm::mat4* b, glm::mat4* out, const size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        const float* left = &a[i][0][0];
+        const float* right = &b[i][0][0];
+
+        __m128 a0 = _mm_loadu_ps(left), a1 = _mm_loadu_ps(left + 4), a2 = _mm_loadu_ps(left + 8), a3 = _mm_loadu_ps(left + 12);
+        __m128 b0 = _mm_loadu_ps(right), b1 = _mm_loadu_ps(right + 4), b2 = _mm_loadu_ps(right + 8), b3 = _mm_loadu_ps(right + 12);
+
+        float* result = &out[i][0][0];
+        _mm_storeu_ps(result, combine(b0, a0, a1, a2, a3));
+        _mm_storeu_ps(result + 4, combine(b1, a0, a1, a2, a3));
+        _mm_storeu_ps(result + 8, combine(b2, a0, a1, a2, a3));
+        _mm_storeu_ps(result + 12, combine(b3, a0, a1, a2, a3));
+    }
+}
+
+static inline void multiplyBroadcast(const glm::mat4 &a, const glm::mat4* b, glm::mat4* out, const size_t count)
+{
+    const float* left = &a[0][0];
+    const __m128 a0 = _mm_loadu_ps(left), a1 = _mm_loadu_ps(left + 4), a2 = _mm_loadu_ps(left + 8), a3 = _mm_loadu_ps(left + 12);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const float* right = &b[i][0][0];
+        __m128 b0 = _mm_loadu_ps(right), b1 = _mm_loadu_ps(right + 4), b2 = _mm_loadu_ps(right + 8), b3 = _mm_loadu_ps(right + 12);
+
+        float* result = &out[i][0][0];
+        _mm_storeu_ps(result, combine(b0, a0, a1, a2, a3));
+        _mm_storeu_ps(result + 4, combine(b1, a0, a1, a2, a3));
+        _mm_storeu_ps(result + 8, combine(b2, a0, a1, a2, a3));
+        _mm_storeu_ps(result + 12, combine(b3, a0, a1, a2, a3));
+    }
+}
+
+static inline void transformPoints(const glm::mat4 &m, const glm::vec4* in, glm::vec4* out, const size_t count)
+{
+    const float* matrix = &m[0][0];
+    const __m128 m0 = _mm_loadu_ps(matrix), m1 = _mm_loadu_ps(matrix + 4), m2 = _mm_loadu_ps(matrix + 8), m3 = _mm_loadu_ps(matrix + 12);
+
+    for (size_t i = 0; i < count; ++i)
+        _mm_storeu_ps(&out[i].x, combine(_mm_loadu_ps(&in[i].x), m0, m1, m2, m3));
+}
+
+static inline void transformPointsSoA(const glm::mat4 &m, const float* x, const float* y, const float* z,
+                               float* outX, float* outY, float* outZ, const size_t count)
+{
+    __m128 rows[3][4];
+    for (int row = 0; row < 3; ++row)
+        for (int column = 0; column < 4; ++column)
+            rows[row][column] = _mm_set1_ps(m[column][row]);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 px = _mm_loadu_ps(x + i), py = _mm_loadu_ps(y + i), pz = _mm_loadu_ps(z + i);
+
+        __m128 results[3];
+        for (int row = 0; row < 3; ++row)
+        {
+            __m128 result = BATCH_MATH_FMADD(rows[row][0], px, rows[row][3]);
+            result = BATCH_MATH_FMADD(rows[row][1], py, result);
+            results[row] = BATCH_MATH_FMADD(rows[row][2], pz, result);
+        }
+
+        _mm_storeu_ps(outX + i, results[0]);
+        _mm_storeu_ps(outY + i, results[1]);
+        _mm_storeu_ps(outZ + i, results[2]);
+    }
+
+    for (; i < count; ++i)
+    {
+        glm::vec4 p = m * glm::vec4(x[i], y[i], z[i], 1.0f);
+        outX[i] = p.x;
+        outY[i] = p.y;
+        outZ[i] = p.z;
+    }
+}
+
+static inline void transformAABBs(const glm::mat4* matrices, const glm::mat4* const* pointers,
+                           const Bounds* local, Bounds* world, const size_t count)
+{
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const float* matrix = pointers ? &(*pointers[i])[0][0] : &matrices[i][0][0];
+        __m128 m0 = _mm_loadu_ps(matrix), m1 = _mm_loadu_ps(matrix + 4), m2 = _mm_loadu_ps(matrix + 8), m3 = _mm_loadu_ps(matrix + 12);
+
+        __m128 center = loadVec3(&local[i].center.x, 1.0f);
+        __m128 extents = loadVec3(&local[i].extents.x, 0.0f);
+
+        /* The box's half axes map to the matrix columns, their absolute sum bounds the new box */
+        __m128 newCenter = combine(center, m0, m1, m2, m3);
+        __m128 newExtents = _mm_mul_ps(_mm_and_ps(m0, absMask), splat(extents, 0));
+        newExtents = BATCH_MATH_FMADD(_mm_and_ps(m1, absMask), splat(extents, 1), newExtents);
+        newExtents = BATCH_MATH_FMADD(_mm_and_ps(m2, absMask), splat(extents, 2), newExtents);
+
+        storeVec3(&world[i].center.x, newCenter);
+        storeVec3(&world[i].extents.x, newExtents);
+    }
+}
+
+/*  Rotation matrix columns from a quaternion (x, y, z, w), as sums of two products so each
+    column is two shuffles and two multiply-adds:
+
+        column 0 = (1, 0, 0) + 2 * (y * (-y,  x, -w) + z * (-z,  w,  x))
+        column 1 = (0, 1, 0) + 2 * (x * ( y, -x,  w) + z * (-w, -z,  y))
+        column 2 = (0, 0, 1) + 2 * (x * ( z, -w, -x) + y * ( w,  z, -y)) */
+static inline void composeTRS(const glm::vec3* positions, const glm::quat* rotations, const glm::vec3* scales,
+                       glm::mat4* out, const size_t count)
+{
+    const __m128 identity0 = _mm_setr_ps(1.0f, 0.0f, 0.0f, 0.0f);
+    const __m128 identity1 = _mm_setr_ps(0.0f, 1.0f, 0.0f, 0.0f);
+    const __m128 identity2 = _mm_setr_ps(0.0f, 0.0f, 1.0f, 0.0f);
+
+    const __m128 signs0a = _mm_setr_ps(-2.0f,  2.0f, -2.0f, 0.0f), signs0b = _mm_setr_ps(-2.0f,  2.0f,  2.0f, 0.0f);
+    const __m128 signs1a = _mm_setr_ps( 2.0f, -2.0f,  2.0f, 0.0f), signs1b = _mm_setr_ps(-2.0f, -2.0f,  2.0f, 0.0f);
+    const __m128 signs2a = _mm_setr_ps( 2.0f, -2.0f, -2.0f, 0.0f), signs2b = _mm_setr_ps( 2.0f,  2.0f, -2.0f, 0.0f);
+    const __m128 one = _mm_set1_ps(1.0f);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        __m128 q = _mm_loadu_ps((const float*)&rotations[i]);
+
+        __m128 yxww = _mm_shuffle_ps(q, q, _MM_SHUFFLE(3, 3, 0, 1));
+        __m128 zwxx = _mm_shuffle_ps(q, q, _MM_SHUFFLE(0, 0, 3, 2));
+        __m128 wzyy = _mm_shuffle_ps(q, q, _MM_SHUFFLE(1, 1, 2, 3));
+        __m128 x = splat(q, 0), y = splat(q, 1), z = splat(q, 2);
+
+        __m128 column0 = BATCH_MATH_FMADD(_mm_mul_ps(y, yxww), signs0a, identity0);
+        column0 = BATCH_MATH_FMADD(_mm_mul_ps(z, zwxx), signs0b, column0);
+        __m128 column1 = BATCH_MATH_FMADD(_mm_mul_ps(x, yxww), signs1a, identity1);
+        column1 = BATCH_MATH_FMADD(_mm_mul_ps(z, wzyy), signs1b, column1);
+        __m128 column2 = BATCH_MATH_FMADD(_mm_mul_ps(x, zwxx), signs2a, identity2);
+        column2 = BATCH_MATH_FMADD(_mm_mul_ps(y, wzyy), signs2b, column2);
+
+        __m128 scale = loadVec3(&scales[i].x, 0.0f);
+        __m128 position = _mm_blend_ps(loadVec3(&positions[i].x, 0.0f), one, 0x8);
+
+        float* result = &out[i][0][0];
+        _mm_storeu_ps(result, _mm_mul_ps(column0, splat(scale, 0)));
+        _mm_storeu_ps(result + 4, _mm_mul_ps(column1, splat(scale, 1)));
+        _mm_storeu_ps(result + 8, _mm_mul_ps(column2, splat(scale, 2)));
+        _mm_storeu_ps(result + 12, position);
+    }
+}
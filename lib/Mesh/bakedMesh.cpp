@@ -0,0 +1,238 @@
+#include "bakedMesh.h"
+
+static uint64_t alignOffset(const uint64_t offset)
+{
+    return (offset + BakedMeshAlignment - 1) / BakedMeshAlignment * BakedMeshAlignment;
+}
+
+static BakedString addString(std::vector<char> &strings, const std::string &string)
+{
+    BakedString baked = { (uint32_t)strings.size(), (uint32_t)string.size() };
+    strings.insert(strings.end(), string.begin(), string.end());
+    return baked;
+}
+
+bool writeBakedMesh(const char* path, const Mesh &mesh)
+{
+    PROFILE_SCOPE("writeBakedMesh");
+
+    std::vector<Meshlet> meshlets = buildMeshlets(mesh);
+
+    std::vector<BakedMaterial> materials;
+    std::vector<char> strings;
+    for (const MeshMaterial &material : mesh.materials)
+    {
+        BakedMaterial baked;
+        baked.ambient = material.ambient;
+        baked.diffuse = material.diffuse;
+        baked.specular = material.specular;
+        baked.shine = material.shine;
+        baked.name = addString(strings, material.name);
+        baked.diffuseMap = addString(strings, material.diffuseMap);
+        baked.specularMap = addString(strings, material.specularMap);
+        materials.push_back(baked);
+    }
+
+    BakedMeshHeader header = {};
+    header.magic = BakedMeshMagic;
+    header.version = BakedMeshVersion;
+    header.byteOrder = BakedMeshByteOrder;
+    header.vertexSize = sizeof(MeshVertex);
+    header.vertexCount = (uint32_t)mesh.vertices.size();
+    header.indexCount = (uint32_t)mesh.indices.size();
+    header.subMeshCount = (uint32_t)mesh.subMeshes.size();
+    header.meshletCount = (uint32_t)meshlets.size();
+    header.materialCount = (uint32_t)materials.size();
+    header.bounds = mesh.bounds;
+
+    const void* sectionData[BakedSectionCount] = {
+        mesh.vertices.data(), mesh.indices.data(), mesh.subMeshes.data(), meshlets.data(), materials.data(), strings.data()
+    };
+    const uint64_t sectionSizes[BakedSectionCount] = {
+        sizeof(MeshVertex) * mesh.vertices.size(), sizeof(uint32_t) * mesh.indices.size(), sizeof(SubMesh) * mesh.subMeshes.size(),
+        sizeof(Meshlet) * meshlets.size(), sizeof(BakedMaterial) * materials.size(), strings.size()
+    };
+
+    uint64_t offset = sizeof(header);
+    for (int s = 0; s < BakedSectionCount; ++s)
+    {
+        header.sections[s].offset = alignOffset(offset);
+        header.sections[s].size = sectionSizes[s];
+        offset = header.sections[s].offset + sectionSizes[s];
+    }
+
+    FILE* file = fopen(path, "wb");
+    if (!file)
+    {
+        std::cout << "ERROR: BakedMesh -> Unable to open " << path << " for writing" << std::endl;
+        return false;
+    }
+
+    static const char padding[BakedMeshAlignment] = {};
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1;
+    offset = sizeof(header);
+    for (int s = 0; s < BakedSectionCount && written; ++s)
+    {
+        size_t paddingSize = (size_t)(header.sections[s].offset - offset);
+        written = fwrite(padding, 1, paddingSize, file) == paddingSize
+               && fwrite(sectionData[s], 1, (size_t)sectionSizes[s], file) == sectionSizes[s];
+        offset = header.sections[s].offset + sectionSizes[s];
+    }
+
+    written = fclose(file) == 0 && written;
+    if (!written)
+        std::cout << "ERROR: BakedMesh -> Failed writing " << path << std::endl;
+
+    return written;
+}
+
+/* Constructor */
+BakedMesh::BakedMesh()
+    : header { NULL }
+{
+}
+
+/* Public */
+bool BakedMesh::open(const char* path)
+{
+    PROFILE_SCOPE("BakedMesh::open");
+
+    close();
+    if (!file.open(path))
+        return false;
+
+    const size_t size = file.size();
+    const BakedMeshHeader* candidate = (const BakedMeshHeader*)file.data();
+
+    if (size < sizeof(BakedMeshHeader) || candidate->magic != BakedMeshMagic)
+    {
+        std::cout << "ERROR: BakedMesh -> " << path << " isn't a baked mesh" << std::endl;
+        close();
+        return false;
+    }
+
+    if (candidate->byteOrder != BakedMeshByteOrder || candidate->version != BakedMeshVersion || candidate->vertexSize != sizeof(MeshVertex))
+    {
+        std::cout << "ERROR: BakedMesh -> " << path << " was baked for another version or platform, bake it again" << std::endl;
+        close();
+        return false;
+    }
+
+    const uint64_t recordSizes[BakedSectionCount] = {
+        sizeof(MeshVertex) * (uint64_t)candidate->vertexCount, sizeof(uint32_t) * (uint64_t)candidate->indexCount,
+        sizeof(SubMesh) * (uint64_t)candidate->subMeshCount, sizeof(Meshlet) * (uint64_t)candidate->meshletCount,
+        sizeof(BakedMaterial) * (uint64_t)candidate->materialCount, candidate->sections[BakedStrings].size
+    };
+
+    for (int s = 0; s < BakedSectionCount; ++s)
+    {
+        const BakedSection &section = candidate->sections[s];
+        if (section.size != recordSizes[s] || section.offset % BakedMeshAlignment != 0 || section.offset > size || section.size > size - section.offset)
+        {
+            std::cout << "ERROR: BakedMesh -> " << path << " is truncated or corrupt" << std::endl;
+            close();
+            return false;
+        }
+    }
+
+    header = candidate;
+
+    /* Ranges are checked here so draws and culling can trust them */
+    bool valid = true;
+    for (uint32_t i = 0; i < header->subMeshCount && valid; ++i)
+    {
+        const SubMesh &subMesh = getSubMeshes()[i];
+        valid = (uint64_t)subMesh.firstIndex + subMesh.indexCount <= header->indexCount
+             && (subMesh.material == NoMaterial || subMesh.material < header->materialCount);
+    }
+
+    for (uint32_t i = 0; i < header->meshletCount && valid; ++i)
+        valid = (uint64_t)getMeshlets()[i].firstIndex + getMeshlets()[i].indexCount <= header->indexCount;
+
+    /* The upload reads the indices anyway, one more pass keeps a corrupt file from reaching the driver */
+    const uint32_t* indices = getIndices();
+    uint32_t largestIndex = 0;
+    for (uint32_t i = 0; i < header->indexCount; ++i)
+        largestIndex = std::max(largestIndex, indices[i]);
+    valid = valid && (header->indexCount == 0 || largestIndex < header->vertexCount);
+
+    if (!valid)
+    {
+        std::cout << "ERROR: BakedMesh -> " << path << " has out of range indices" << std::endl;
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void BakedMesh::close()
+{
+    file.close();
+    header = NULL;
+}
+
+bool BakedMesh::isValid() const
+{
+    return header != NULL;
+}
+
+const BakedMeshHeader &BakedMesh::getHeader() const
+{
+    return *header;
+}
+
+const MeshVertex* BakedMesh::getVertices() const
+{
+    return (const MeshVertex*)getSection(BakedVertices);
+}
+
+const uint32_t* BakedMesh::getIndices() const
+{
+    return (const uint32_t*)getSection(BakedIndices);
+}
+
+const SubMesh* BakedMesh::getSubMeshes() const
+{
+    return (const SubMesh*)getSection(BakedSubMeshes);
+}
+
+const Meshlet* BakedMesh::getMeshlets() const
+{
+    return (const Meshlet*)getSection(BakedMeshlets);
+}
+
+std::vector<MeshMaterial> BakedMesh::getMaterials() const
+{
+    std::vector<MeshMaterial> materials;
+
+    const BakedMaterial* baked = (const BakedMaterial*)getSection(BakedMaterials);
+    for (uint32_t i = 0; i < header->materialCount; ++i)
+    {
+        MeshMaterial material = makeDefaultMaterial(getString(baked[i].name));
+        material.ambient = baked[i].ambient;
+        material.diffuse = baked[i].diffuse;
+        material.specular = baked[i].specular;
+        material.shine = baked[i].shine;
+        material.diffuseMap = getString(baked[i].diffuseMap);
+        material.specularMap = getString(baked[i].specularMap);
+        materials.push_back(material);
+    }
+
+    return materials;
+}
+
+/* Private */
+const char* BakedMesh::getSection(const BakedMeshSection section) const
+{
+    return file.data() + header->sections[section].offset;
+}
+
+std::string BakedMesh::getString(const BakedString &string) const
+{
+    const BakedSection &strings = header->sections[BakedStrings];
+    if ((uint64_t)string.offset + string.length > strings.size)
+        return std::string();
+
+    return std::string(getSection(BakedStrings) + string.offset, string.length);
+}
@@ -0,0 +1,128 @@
+#ifndef BAKED_MESH
+#define BAKED_MESH
+
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <iostream>
+
+#include "mesh.h"
+#include "../Platform/mappedFile.h"
+#include "../Profiler/profiler.h"
+
+/*  Engine native mesh file (.bmesh), written once by the mesh baker and loaded without parsing.
+
+    Layout, little endian throughout:
+        BakedMeshHeader
+        sections, each starting on a BakedMeshAlignment boundary, in BakedMeshSection order:
+            vertices    MeshVertex[vertexCount]
+            indices     uint32_t[indexCount]
+            subMeshes   SubMesh[subMeshCount]
+            meshlets    Meshlet[meshletCount]
+            materials   BakedMaterial[materialCount]
+            strings     char[], referenced by BakedString
+
+    The records are the runtime structs themselves, so a loaded file is used in place:
+    arrays point into the mapping and the vertex and index sections go to uploadMesh
+    without a copy. The header stores sizeof(MeshVertex) and the version so a file
+    baked with a different layout is rejected instead of misread. */
+const uint32_t BakedMeshMagic = 0x48534D42;        /* "BMSH" */
+const uint32_t BakedMeshVersion = 1;
+const uint32_t BakedMeshByteOrder = 0x01020304;     /* Reads back differently on a big endian machine */
+const uint32_t BakedMeshAlignment = 64;
+
+enum BakedMeshSection
+{
+    BakedVertices,
+    BakedIndices,
+    BakedSubMeshes,
+    BakedMeshlets,
+    BakedMaterials,
+    BakedStrings,
+    BakedSectionCount
+};
+
+struct BakedSection
+{
+    uint64_t offset;    /* From the start of the file */
+    uint64_t size;
+};
+
+struct BakedMeshHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t vertexSize;
+
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t subMeshCount;
+    uint32_t meshletCount;
+    uint32_t materialCount;
+    uint32_t reserved;
+
+    Bounds bounds;
+    BakedSection sections[BakedSectionCount];
+};
+
+/* Range of the string section */
+struct BakedString
+{
+    uint32_t offset;
+    uint32_t length;
+};
+
+/* MeshMaterial without the runtime texture IDs */
+struct BakedMaterial
+{
+    glm::vec3 ambient;
+    glm::vec3 diffuse;
+    glm::vec3 specular;
+    float shine;
+
+    BakedString name;
+    BakedString diffuseMap;
+    BakedString specularMap;
+};
+
+/* Bakes the mesh, building its meshlets. Map paths are stored as the loader resolved them */
+bool writeBakedMesh(const char* path, const Mesh &mesh);
+
+/*  Memory mapped .bmesh. open() checks the header and every section's bounds once,
+    afterwards the accessors are plain pointers into the file. Pages are only read as
+    they're touched, and the OS shares them between processes mapping the same file. */
+class BakedMesh
+{
+    public:
+        /* Constructor */
+        BakedMesh();
+
+        /* Closes the current file first, false if the new one isn't a valid baked mesh */
+        bool open(const char* path);
+        void close();
+
+        bool isValid() const;
+        const BakedMeshHeader &getHeader() const;
+
+        const MeshVertex* getVertices() const;
+        const uint32_t* getIndices() const;
+        const SubMesh* getSubMeshes() const;
+        const Meshlet* getMeshlets() const;
+
+        /* Copies out the materials, texture IDs 0 */
+        std::vector<MeshMaterial> getMaterials() const;
+
+    private:
+        MappedFile file;
+        const BakedMeshHeader* header;
+
+        const char* getSection(const BakedMeshSection section) const;
+        std::string getString(const BakedString &string) const;
+};
+
+#endif
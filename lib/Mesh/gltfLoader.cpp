@@ -0,0 +1,937 @@
+#include "gltfLoader.h"
+
+static const uint32_t glbMagic = 0x46546C67;       /* "glTF" */
+static const uint32_t glbJsonChunk = 0x4E4F534A;   /* "JSON" */
+static const uint32_t glbBinaryChunk = 0x004E4942; /* "BIN\0" */
+
+/* glTF is little endian like every platform the engine runs on, memcpy only avoids unaligned reads */
+static uint32_t readUint32(const char* data)
+{
+    uint32_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+static size_t componentSize(const GLenum componentType)
+{
+    switch (componentType)
+    {
+        case GL_BYTE:
+        case GL_UNSIGNED_BYTE:
+            return 1;
+        case GL_SHORT:
+        case GL_UNSIGNED_SHORT:
+            return 2;
+        case GL_UNSIGNED_INT:
+        case GL_FLOAT:
+            return 4;
+        default:
+            return 0;
+    }
+}
+
+static int componentCount(const std::string &type)
+{
+    if (type == "SCALAR")
+        return 1;
+    if (type == "VEC2")
+        return 2;
+    if (type == "VEC3")
+        return 3;
+    if (type == "VEC4")
+        return 4;
+    return 0;
+}
+
+static glm::vec3 readVec3(const JsonValue &value, const glm::vec3 &fallback)
+{
+    if (value.size() < 3)
+        return fallback;
+
+    return glm::vec3(value[(size_t)0].getNumber(fallback.x), value[1].getNumber(fallback.y), value[2].getNumber(fallback.z));
+}
+
+/* One element of a float, or normalized integer, accessor */
+static void readElement(const unsigned char* element, const GLenum componentType, const bool normalized, const int components, float* values)
+{
+    for (int c = 0; c < components; ++c)
+    {
+        switch (componentType)
+        {
+            case GL_FLOAT:
+                memcpy(&values[c], element + c * 4, sizeof(float));
+                break;
+            case GL_UNSIGNED_BYTE:
+                values[c] = element[c] / (normalized ? 255.0f : 1.0f);
+                break;
+            case GL_UNSIGNED_SHORT:
+            {
+                uint16_t value;
+                memcpy(&value, element + c * 2, sizeof(value));
+                values[c] = value / (normalized ? 65535.0f : 1.0f);
+                break;
+            }
+            default:
+                values[c] = 0.0f;
+        }
+    }
+}
+
+static uint32_t readIndex(const unsigned char* element, const GLenum componentType)
+{
+    if (componentType == GL_UNSIGNED_BYTE)
+        return *element;
+
+    if (componentType == GL_UNSIGNED_SHORT)
+    {
+        uint16_t value;
+        memcpy(&value, element, sizeof(value));
+        return value;
+    }
+
+    uint32_t value;
+    memcpy(&value, element, sizeof(value));
+    return value;
+}
+
+static glm::mat4 nodeTransform(const JsonValue &node)
+{
+    const JsonValue &matrix = node["matrix"];
+    if (matrix.size() == 16)
+    {
+        glm::mat4 transform;
+        for (int i = 0; i < 16; ++i)
+            transform[i / 4][i % 4] = (float)matrix[i].getNumber(i % 5 == 0 ? 1.0 : 0.0);
+        return transform;
+    }
+
+    glm::vec3 translation = readVec3(node["translation"], glm::vec3(0.0f));
+    glm::vec3 scale = readVec3(node["scale"], glm::vec3(1.0f));
+
+    /* Stored as x, y, z, w */
+    const JsonValue &rotation = node["rotation"];
+    glm::quat orientation(1.0f, 0.0f, 0.0f, 0.0f);
+    if (rotation.size() == 4)
+        orientation = glm::quat((float)rotation[3].getNumber(1.0), (float)rotation[(size_t)0].getNumber(0.0),
+                                (float)rotation[1].getNumber(0.0), (float)rotation[2].getNumber(0.0));
+
+    glm::mat4 transform = glm::mat4_cast(orientation);
+    transform[0] *= scale.x;
+    transform[1] *= scale.y;
+    transform[2] *= scale.z;
+    transform[3] = glm::vec4(translation, 1.0f);
+    return transform;
+}
+
+void deleteGltfModel(GltfModel &model)
+{
+    if (!model.vertexArrays.empty())
+        glDeleteVertexArrays((GLsizei)model.vertexArrays.size(), model.vertexArrays.data());
+    if (!model.buffers.empty())
+        glDeleteBuffers((GLsizei)model.buffers.size(), model.buffers.data());
+    if (!model.textures.empty())
+        glDeleteTextures((GLsizei)model.textures.size(), model.textures.data());
+
+    model = GltfModel();
+}
+
+/* Constructor */
+GltfLoader::GltfLoader(JobSystem &jobSystem)
+    : jobSystem { jobSystem }
+{
+}
+
+/* Public */
+bool GltfLoader::load(const char* path, GltfModel &model, Texture &textures)
+{
+    PROFILE_SCOPE("GltfLoader::load");
+
+    model = GltfModel();
+
+    Document document;
+    if (!readDocument(path, document) || !resolveBuffers(document))
+        return false;
+
+    const JsonValue &json = document.json;
+    const JsonValue &materials = json["materials"];
+    const JsonValue &images = json["images"];
+
+    /* Only base color maps have a place in the lighting shader, decode just the images they use */
+    std::vector<int64_t> materialImages(materials.size(), -1);
+    std::vector<uint8_t> imageUsed(images.size(), 0);
+    for (size_t m = 0; m < materials.size(); ++m)
+    {
+        int64_t texture = materials[m]["pbrMetallicRoughness"]["baseColorTexture"]["index"].getInt(-1);
+        int64_t image = texture < 0 ? -1 : json["textures"][(size_t)texture]["source"].getInt(-1);
+        if (image >= 0 && (size_t)image < images.size())
+        {
+            materialImages[m] = image;
+            imageUsed[image] = 1;
+        }
+    }
+
+    /*  glTF puts the first row of an image at v = 0, where GL already samples it, so images
+        load unflipped. stb's flip flag is global, it's restored once the decodes are done. */
+    stbi_set_flip_vertically_on_load(false);
+
+    std::vector<DecodedImage> decodedImages(images.size(), DecodedImage { NULL, 0, 0, 0 });
+    JobCounter imageCounter { 0 };
+    for (size_t i = 0; i < images.size(); ++i)
+        if (imageUsed[i])
+            jobSystem.run([&, i]() { decodedImages[i] = decodeImage(document, images[i]); }, &imageCounter);
+
+    /* Buffers upload while the images decode */
+    bool valid = true;
+    std::vector<unsigned int> viewBuffers(json["bufferViews"].size(), 0);
+    std::vector<uint32_t> meshFirstPrimitives;
+    {
+        PROFILE_SCOPE("GltfLoader upload");
+
+        const JsonValue &meshes = json["meshes"];
+        for (size_t m = 0; m < meshes.size() && valid; ++m)
+        {
+            meshFirstPrimitives.push_back((uint32_t)model.primitives.size());
+
+            const JsonValue &primitives = meshes[m]["primitives"];
+            for (size_t p = 0; p < primitives.size() && valid; ++p)
+                valid = loadPrimitive(document, primitives[p], viewBuffers, model);
+        }
+        meshFirstPrimitives.push_back((uint32_t)model.primitives.size());
+    }
+
+    jobSystem.wait(imageCounter);
+    stbi_set_flip_vertically_on_load(true);
+
+    std::vector<unsigned int> imageTextures(images.size(), 0);
+    for (size_t i = 0; i < images.size(); ++i)
+    {
+        if (!imageUsed[i])
+            continue;
+
+        if (!valid)
+        {
+            stbi_image_free(decodedImages[i].data);
+            continue;
+        }
+
+        /* Only names the image in error messages */
+        std::string uri = images[i]["uri"].getString();
+        std::string name = !uri.empty() && uri.compare(0, 5, "data:") != 0 ? document.directory + decodeURI(uri)
+                         : path + std::string(" image ") + std::to_string(i);
+
+        imageTextures[i] = textures.upload(name.c_str(), decodedImages[i]);
+        model.textures.push_back(imageTextures[i]);
+    }
+
+    if (!valid)
+    {
+        deleteGltfModel(model);
+        return false;
+    }
+
+    for (size_t m = 0; m < materials.size(); ++m)
+    {
+        MeshMaterial material = makeMaterial(document, m);
+        if (materialImages[m] >= 0)
+            material.diffuseMapID = imageTextures[(size_t)materialImages[m]];
+
+        model.materials.push_back(material);
+    }
+
+    for (GltfPrimitive &primitive : model.primitives)
+        if (primitive.material != NoMaterial && primitive.material >= model.materials.size())
+            primitive.material = NoMaterial;
+
+    collectInstances(document, meshFirstPrimitives, model);
+
+    return true;
+}
+
+bool GltfLoader::loadMesh(const char* path, Mesh &mesh)
+{
+    PROFILE_SCOPE("GltfLoader::loadMesh");
+
+    mesh = Mesh();
+
+    Document document;
+    if (!readDocument(path, document) || !resolveBuffers(document))
+        return false;
+
+    const JsonValue &materials = document.json["materials"];
+    for (size_t m = 0; m < materials.size(); ++m)
+        mesh.materials.push_back(makeMaterial(document, m));
+
+    /* Number the primitives like load() does so the scene walk can be shared */
+    const JsonValue &meshes = document.json["meshes"];
+    std::vector<const JsonValue*> primitives;
+    std::vector<uint32_t> meshFirstPrimitives;
+    for (size_t m = 0; m < meshes.size(); ++m)
+    {
+        meshFirstPrimitives.push_back((uint32_t)primitives.size());
+        for (size_t p = 0; p < meshes[m]["primitives"].size(); ++p)
+            primitives.push_back(&meshes[m]["primitives"][p]);
+    }
+    meshFirstPrimitives.push_back((uint32_t)primitives.size());
+
+    GltfModel scene;
+    collectInstances(document, meshFirstPrimitives, scene);
+
+    for (const GltfInstance &instance : scene.instances)
+    {
+        if (!appendPrimitive(document, *primitives[instance.primitive], instance.transform, mesh))
+        {
+            mesh = Mesh();
+            return false;
+        }
+    }
+
+    generateMissingNormals(mesh);
+    mesh.bounds = computeBounds(mesh.vertices);
+
+    return true;
+}
+
+/* Private */
+bool GltfLoader::readDocument(const char* path, Document &document) const
+{
+    document.path = path;
+    size_t separator = document.path.find_last_of("/\\");
+    document.directory = separator == std::string::npos ? std::string() : document.path.substr(0, separator + 1);
+
+    if (!document.file.open(path))
+        return false;
+
+    const char* data = document.file.data();
+    const size_t size = document.file.size();
+
+    const char* jsonText = data;
+    size_t jsonLength = size;
+    document.binaryChunk = BufferData { NULL, 0 };
+
+    /* GLB: 12 byte header, then a JSON chunk and an optional binary chunk, each with an 8 byte header */
+    if (size >= 12 && readUint32(data) == glbMagic)
+    {
+        uint32_t version = readUint32(data + 4);
+        size_t length = std::min<size_t>(readUint32(data + 8), size);
+        if (version != 2)
+        {
+            std::cout << "ERROR: GltfLoader -> Unsupported GLB version " << version << " in " << path << std::endl;
+            return false;
+        }
+
+        if (length < 20 || readUint32(data + 16) != glbJsonChunk || 20 + (size_t)readUint32(data + 12) > length)
+        {
+            std::cout << "ERROR: GltfLoader -> Missing or truncated JSON chunk in " << path << std::endl;
+            return false;
+        }
+
+        jsonText = data + 20;
+        jsonLength = readUint32(data + 12);
+
+        size_t offset = 20 + ((jsonLength + 3) & ~(size_t)3);
+        if (offset + 8 <= length && readUint32(data + offset + 4) == glbBinaryChunk)
+        {
+            size_t binaryLength = std::min<size_t>(readUint32(data + offset), length - offset - 8);
+            document.binaryChunk = BufferData { (const unsigned char*)data + offset + 8, binaryLength };
+        }
+    }
+
+    std::string error;
+    if (!JsonValue::parse(jsonText, jsonLength, document.json, error))
+    {
+        std::cout << "ERROR: GltfLoader -> Invalid JSON in " << path << ": " << error << std::endl;
+        return false;
+    }
+
+    const std::string &version = document.json["asset"]["version"].getString();
+    if (version.compare(0, 2, "2.") != 0)
+    {
+        std::cout << "ERROR: GltfLoader -> Unsupported glTF version '" << version << "' in " << path << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool GltfLoader::resolveBuffers(Document &document) const
+{
+    const JsonValue &buffers = document.json["buffers"];
+    for (size_t i = 0; i < buffers.size(); ++i)
+    {
+        const std::string &uri = buffers[i]["uri"].getString();
+        size_t byteLength = (size_t)std::max<int64_t>(buffers[i]["byteLength"].getInt(0), 0);
+
+        BufferData buffer = { NULL, 0 };
+        if (uri.empty())
+        {
+            /* Only the first buffer of a GLB may live in its binary chunk */
+            if (i == 0)
+                buffer = document.binaryChunk;
+        }
+
+        else if (uri.compare(0, 5, "data:") == 0)
+        {
+            size_t dataStart = uri.find(";base64,");
+            std::vector<unsigned char> data;
+            if (dataStart == std::string::npos || !decodeBase64(uri.substr(dataStart + 8), data))
+            {
+                std::cout << "ERROR: GltfLoader -> Buffer " << i << " has an unsupported data URI in " << document.path << std::endl;
+                return false;
+            }
+
+            document.decodedURIs.push_back(std::move(data));
+            buffer = BufferData { document.decodedURIs.back().data(), document.decodedURIs.back().size() };
+        }
+
+        else
+        {
+            std::unique_ptr<MappedFile> file(new MappedFile());
+            if (!file->open((document.directory + decodeURI(uri)).c_str()))
+                return false;
+
+            file->adviseSequential();
+            buffer = BufferData { (const unsigned char*)file->data(), file->size() };
+            document.bufferFiles.push_back(std::move(file));
+        }
+
+        if (!buffer.data || buffer.size < byteLength)
+        {
+            std::cout << "ERROR: GltfLoader -> Buffer " << i << " is missing or shorter than its byteLength in " << document.path << std::endl;
+            return false;
+        }
+
+        buffer.size = byteLength;
+        document.buffers.push_back(buffer);
+    }
+
+    return true;
+}
+
+bool GltfLoader::getBufferView(const Document &document, const uint32_t index, BufferData &view, size_t &stride) const
+{
+    const JsonValue &json = document.json["bufferViews"][index];
+    int64_t buffer = json["buffer"].getInt(-1);
+    int64_t byteOffset = json["byteOffset"].getInt(0);
+    int64_t byteLength = json["byteLength"].getInt(-1);
+
+    if (buffer < 0 || (size_t)buffer >= document.buffers.size() || byteOffset < 0 || byteLength < 0
+        || (uint64_t)(byteOffset + byteLength) > document.buffers[buffer].size)
+    {
+        std::cout << "ERROR: GltfLoader -> Buffer view " << index << " is out of range in " << document.path << std::endl;
+        return false;
+    }
+
+    view = BufferData { document.buffers[buffer].data + byteOffset, (size_t)byteLength };
+    stride = (size_t)std::max<int64_t>(json["byteStride"].getInt(0), 0);
+    return true;
+}
+
+bool GltfLoader::getAccessor(const Document &document, const uint32_t index, Accessor &accessor) const
+{
+    const JsonValue &json = document.json["accessors"][index];
+    if (json.isNull() || !json.has("bufferView"))
+    {
+        std::cout << "ERROR: GltfLoader -> Accessor " << index << " is missing or has no buffer view in " << document.path << std::endl;
+        return false;
+    }
+
+    if (json.has("sparse"))
+        std::cout << "WARNING: GltfLoader -> Ignoring the sparse values of accessor " << index << " in " << document.path << std::endl;
+
+    accessor.bufferView = (uint32_t)json["bufferView"].getInt(0);
+    accessor.byteOffset = (size_t)std::max<int64_t>(json["byteOffset"].getInt(0), 0);
+    accessor.count = (uint32_t)std::max<int64_t>(json["count"].getInt(0), 0);
+    accessor.componentType = (GLenum)json["componentType"].getInt(0);
+    accessor.components = componentCount(json["type"].getString());
+    accessor.normalized = json["normalized"].getBool(false);
+
+    size_t elementSize = componentSize(accessor.componentType) * accessor.components;
+    if (elementSize == 0)
+    {
+        std::cout << "ERROR: GltfLoader -> Accessor " << index << " has an unsupported type in " << document.path << std::endl;
+        return false;
+    }
+
+    BufferData view;
+    size_t stride;
+    if (!getBufferView(document, accessor.bufferView, view, stride))
+        return false;
+
+    /* The last element has to end inside the view */
+    size_t step = stride ? stride : elementSize;
+    if (accessor.count > 0 && accessor.byteOffset + step * (accessor.count - 1) + elementSize > view.size)
+    {
+        std::cout << "ERROR: GltfLoader -> Accessor " << index << " reads past its buffer view in " << document.path << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+unsigned int GltfLoader::getViewBuffer(const Document &document, const uint32_t index, std::vector<unsigned int> &viewBuffers, GltfModel &model) const
+{
+    if (viewBuffers[index])
+        return viewBuffers[index];
+
+    BufferData view;
+    size_t stride;
+    getBufferView(document, index, view, stride);
+
+    /* Straight from the mapping, the driver's copy is the only one. The array buffer binding isn't vertex array state */
+    unsigned int buffer;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glBufferData(GL_ARRAY_BUFFER, view.size, view.data, GL_STATIC_DRAW);
+
+    model.buffers.push_back(buffer);
+    viewBuffers[index] = buffer;
+    return buffer;
+}
+
+DecodedImage GltfLoader::decodeImage(const Document &document, const JsonValue &image) const
+{
+    const std::string &uri = image["uri"].getString();
+    if (uri.compare(0, 5, "data:") == 0)
+    {
+        std::vector<unsigned char> data;
+        size_t dataStart = uri.find(";base64,");
+        if (dataStart != std::string::npos && decodeBase64(uri.substr(dataStart + 8), data))
+            return Texture::decode(data.data(), data.size());
+    }
+
+    else if (!uri.empty())
+        return Texture::decode((document.directory + decodeURI(uri)).c_str());
+
+    else if (image.has("bufferView"))
+    {
+        BufferData view;
+        size_t stride;
+        if (getBufferView(document, (uint32_t)image["bufferView"].getInt(0), view, stride))
+            return Texture::decode(view.data, view.size);
+    }
+
+    return DecodedImage { NULL, 0, 0, 0 };
+}
+
+bool GltfLoader::loadPrimitive(const Document &document, const JsonValue &primitive, std::vector<unsigned int> &viewBuffers, GltfModel &model) const
+{
+    if (primitive["mode"].getInt(4) != 4)
+    {
+        std::cout << "WARNING: GltfLoader -> Skipping a primitive that isn't a triangle list in " << document.path << std::endl;
+        return true;
+    }
+
+    const JsonValue &attributes = primitive["attributes"];
+    if (!attributes.has("POSITION"))
+    {
+        std::cout << "WARNING: GltfLoader -> Skipping a primitive without positions in " << document.path << std::endl;
+        return true;
+    }
+
+    /* Validate everything first so a failure leaves no half built vertex array behind */
+    struct Semantic
+    {
+        const char* name;
+        GLuint location;
+        int components;
+    };
+    const Semantic semantics[] = { { "POSITION", 0, 3 }, { "NORMAL", 1, 3 }, { "TEXCOORD_0", 2, 2 } };
+
+    Accessor accessors[3];
+    bool present[3];
+    for (int s = 0; s < 3; ++s)
+    {
+        present[s] = attributes.has(semantics[s].name);
+        if (!present[s])
+            continue;
+
+        if (!getAccessor(document, (uint32_t)attributes[semantics[s].name].getInt(0), accessors[s]))
+            return false;
+
+        if (accessors[s].components != semantics[s].components)
+        {
+            std::cout << "ERROR: GltfLoader -> " << semantics[s].name << " has the wrong number of components in " << document.path << std::endl;
+            return false;
+        }
+    }
+
+    if (!present[1])
+        std::cout << "WARNING: GltfLoader -> A primitive has no normals and won't be lit correctly in " << document.path << std::endl;
+
+    Accessor indices;
+    bool indexed = primitive.has("indices");
+    if (indexed)
+    {
+        if (!getAccessor(document, (uint32_t)primitive["indices"].getInt(0), indices))
+            return false;
+
+        if (indices.components != 1 || (indices.componentType != GL_UNSIGNED_BYTE && indices.componentType != GL_UNSIGNED_SHORT
+                                        && indices.componentType != GL_UNSIGNED_INT))
+        {
+            std::cout << "ERROR: GltfLoader -> Indices must be unsigned scalars in " << document.path << std::endl;
+            return false;
+        }
+    }
+
+    /* The vertex array only records buffer bindings, the buffers themselves are uploaded before it's bound */
+    unsigned int attributeBuffers[3] = { 0, 0, 0 };
+    for (int s = 0; s < 3; ++s)
+        if (present[s])
+            attributeBuffers[s] = getViewBuffer(document, accessors[s].bufferView, viewBuffers, model);
+
+    unsigned int indexBuffer = 0;
+    uint32_t firstIndex = 0;
+    if (indexed)
+    {
+        if (indices.componentType == GL_UNSIGNED_INT)
+        {
+            indexBuffer = getViewBuffer(document, indices.bufferView, viewBuffers, model);
+            firstIndex = (uint32_t)(indices.byteOffset / sizeof(uint32_t));
+        }
+
+        else
+        {
+            /* Draws always use 32 bit indices, narrower ones are the one thing that gets copied */
+            BufferData view;
+            size_t stride;
+            getBufferView(document, indices.bufferView, view, stride);
+
+            size_t size = componentSize(indices.componentType);
+            size_t step = stride ? stride : size;
+            const unsigned char* source = view.data + indices.byteOffset;
+
+            std::vector<uint32_t> widened(indices.count);
+            for (uint32_t i = 0; i < indices.count; ++i, source += step)
+            {
+                if (size == 1)
+                    widened[i] = *source;
+                else
+                {
+                    uint16_t value;
+                    memcpy(&value, source, sizeof(value));
+                    widened[i] = value;
+                }
+            }
+
+            glGenBuffers(1, &indexBuffer);
+            glBindBuffer(GL_ARRAY_BUFFER, indexBuffer);
+            glBufferData(GL_ARRAY_BUFFER, sizeof(uint32_t) * widened.size(), widened.data(), GL_STATIC_DRAW);
+            model.buffers.push_back(indexBuffer);
+        }
+    }
+
+    unsigned int vertexArray;
+    glGenVertexArrays(1, &vertexArray);
+    glBindVertexArray(vertexArray);
+    model.vertexArrays.push_back(vertexArray);
+
+    for (int s = 0; s < 3; ++s)
+    {
+        if (!present[s])
+            continue;
+
+        BufferData view;
+        size_t stride;
+        getBufferView(document, accessors[s].bufferView, view, stride);
+
+        glBindBuffer(GL_ARRAY_BUFFER, attributeBuffers[s]);
+        glVertexAttribPointer(semantics[s].location, accessors[s].components, accessors[s].componentType,
+                              accessors[s].normalized ? GL_TRUE : GL_FALSE, (GLsizei)stride, (void*)accessors[s].byteOffset);
+        glEnableVertexAttribArray(semantics[s].location);
+    }
+
+    if (indexed)
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+
+    glBindVertexArray(0);
+
+    GltfPrimitive result;
+    result.mesh = indexed ? MeshRef { vertexArray, firstIndex, indices.count, true }
+                          : MeshRef { vertexArray, 0, accessors[0].count, false };
+
+    int64_t material = primitive["material"].getInt(-1);
+    result.material = material < 0 ? NoMaterial : (uint32_t)material;
+
+    /* POSITION accessors are required to carry their bounds */
+    const JsonValue &positionAccessor = document.json["accessors"][(size_t)attributes["POSITION"].getInt(0)];
+    glm::vec3 minimum = readVec3(positionAccessor["min"], glm::vec3(0.0f));
+    glm::vec3 maximum = readVec3(positionAccessor["max"], glm::vec3(0.0f));
+    result.bounds = Bounds { (minimum + maximum) * 0.5f, (maximum - minimum) * 0.5f };
+
+    model.primitives.push_back(result);
+    return true;
+}
+
+bool GltfLoader::appendPrimitive(const Document &document, const JsonValue &primitive, const glm::mat4 &transform, Mesh &mesh) const
+{
+    const JsonValue &attributes = primitive["attributes"];
+    if (primitive["mode"].getInt(4) != 4 || !attributes.has("POSITION"))
+    {
+        std::cout << "WARNING: GltfLoader -> Skipping a primitive that isn't a triangle list with positions in " << document.path << std::endl;
+        return true;
+    }
+
+    const char* names[3] = { "POSITION", "NORMAL", "TEXCOORD_0" };
+    const int components[3] = { 3, 3, 2 };
+
+    Accessor accessors[3];
+    const unsigned char* data[3] = { NULL, NULL, NULL };
+    size_t steps[3] = { 0, 0, 0 };
+    for (int s = 0; s < 3; ++s)
+    {
+        if (!attributes.has(names[s]))
+            continue;
+
+        if (!getAccessor(document, (uint32_t)attributes[names[s]].getInt(0), accessors[s]))
+            return false;
+
+        if (accessors[s].components != components[s] || (s < 2 && accessors[s].componentType != GL_FLOAT))
+        {
+            std::cout << "ERROR: GltfLoader -> " << names[s] << " has an unsupported layout in " << document.path << std::endl;
+            return false;
+        }
+
+        BufferData view;
+        size_t stride;
+        getBufferView(document, accessors[s].bufferView, view, stride);
+        data[s] = view.data + accessors[s].byteOffset;
+        steps[s] = stride ? stride : componentSize(accessors[s].componentType) * components[s];
+    }
+
+    /* Normals go through the inverse transpose, and mirroring transforms flip the winding */
+    glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(transform)));
+    bool mirrored = glm::determinant(glm::mat3(transform)) < 0.0f;
+
+    uint32_t baseVertex = (uint32_t)mesh.vertices.size();
+    uint32_t vertexCount = accessors[0].count;
+    for (uint32_t i = 0; i < vertexCount; ++i)
+    {
+        float values[3] = { 0.0f, 0.0f, 0.0f };
+        MeshVertex vertex;
+
+        readElement(data[0] + i * steps[0], GL_FLOAT, false, 3, values);
+        vertex.position = glm::vec3(transform * glm::vec4(values[0], values[1], values[2], 1.0f));
+
+        /* Zero normals are generated once the whole mesh is in */
+        vertex.normal = glm::vec3(0.0f);
+        if (data[1])
+        {
+            readElement(data[1] + i * steps[1], GL_FLOAT, false, 3, values);
+            glm::vec3 normal = normalMatrix * glm::vec3(values[0], values[1], values[2]);
+            float length = glm::length(normal);
+            vertex.normal = length > 0.0f ? normal / length : glm::vec3(0.0f);
+        }
+
+        vertex.texCoords = glm::vec2(0.0f);
+        if (data[2])
+        {
+            readElement(data[2] + i * steps[2], accessors[2].componentType, accessors[2].normalized, 2, values);
+            vertex.texCoords = glm::vec2(values[0], values[1]);
+        }
+
+        mesh.vertices.push_back(vertex);
+    }
+
+    SubMesh subMesh;
+    subMesh.firstIndex = (uint32_t)mesh.indices.size();
+
+    if (primitive.has("indices"))
+    {
+        Accessor indices;
+        if (!getAccessor(document, (uint32_t)primitive["indices"].getInt(0), indices))
+            return false;
+
+        if (indices.components != 1 || (indices.componentType != GL_UNSIGNED_BYTE && indices.componentType != GL_UNSIGNED_SHORT
+                                        && indices.componentType != GL_UNSIGNED_INT))
+        {
+            std::cout << "ERROR: GltfLoader -> Indices must be unsigned scalars in " << document.path << std::endl;
+            return false;
+        }
+
+        BufferData view;
+        size_t stride;
+        getBufferView(document, indices.bufferView, view, stride);
+        size_t step = stride ? stride : componentSize(indices.componentType);
+
+        for (uint32_t i = 0; i + 2 < indices.count; i += 3)
+        {
+            uint32_t triangle[3];
+            for (uint32_t corner = 0; corner < 3; ++corner)
+            {
+                triangle[corner] = readIndex(view.data + indices.byteOffset + (i + corner) * step, indices.componentType);
+                if (triangle[corner] >= vertexCount)
+                {
+                    std::cout << "ERROR: GltfLoader -> Index out of range in " << document.path << std::endl;
+                    return false;
+                }
+            }
+
+            if (mirrored)
+                std::swap(triangle[1], triangle[2]);
+
+            for (uint32_t corner = 0; corner < 3; ++corner)
+                mesh.indices.push_back(baseVertex + triangle[corner]);
+        }
+    }
+
+    else
+    {
+        for (uint32_t i = 0; i + 2 < vertexCount; i += 3)
+        {
+            mesh.indices.push_back(baseVertex + i);
+            mesh.indices.push_back(baseVertex + (mirrored ? i + 2 : i + 1));
+            mesh.indices.push_back(baseVertex + (mirrored ? i + 1 : i + 2));
+        }
+    }
+
+    int64_t material = primitive["material"].getInt(-1);
+    subMesh.material = material < 0 || (size_t)material >= mesh.materials.size() ? NoMaterial : (uint32_t)material;
+    subMesh.indexCount = (uint32_t)mesh.indices.size() - subMesh.firstIndex;
+
+    /* Instances of the same material draw as one range */
+    if (!mesh.subMeshes.empty() && mesh.subMeshes.back().material == subMesh.material)
+        mesh.subMeshes.back().indexCount += subMesh.indexCount;
+    else if (subMesh.indexCount > 0)
+        mesh.subMeshes.push_back(subMesh);
+
+    return true;
+}
+
+MeshMaterial GltfLoader::makeMaterial(const Document &document, const size_t index) const
+{
+    const JsonValue &material = document.json["materials"][index];
+    const JsonValue &pbr = material["pbrMetallicRoughness"];
+
+    MeshMaterial meshMaterial = makeDefaultMaterial(material["name"].getString());
+    meshMaterial.diffuse = readVec3(pbr["baseColorFactor"], glm::vec3(1.0f));
+    meshMaterial.ambient = meshMaterial.diffuse * 0.2f;
+
+    /* Blinn-Phong exponent with about the highlight size of the GGX roughness */
+    float roughness = glm::clamp((float)pbr["roughnessFactor"].getNumber(1.0), 0.05f, 1.0f);
+    float alpha = roughness * roughness;
+    meshMaterial.shine = glm::clamp(2.0f / (alpha * alpha) - 2.0f, 1.0f, 256.0f);
+
+    /* Only images in their own file have a path, embedded ones are left to the caller */
+    int64_t texture = pbr["baseColorTexture"]["index"].getInt(-1);
+    int64_t image = texture < 0 ? -1 : document.json["textures"][(size_t)texture]["source"].getInt(-1);
+    const std::string &uri = document.json["images"][(size_t)image]["uri"].getString();
+    if (!uri.empty() && uri.compare(0, 5, "data:") != 0)
+        meshMaterial.diffuseMap = document.directory + decodeURI(uri);
+
+    return meshMaterial;
+}
+
+void GltfLoader::collectInstances(const Document &document, const std::vector<uint32_t> &meshFirstPrimitives, GltfModel &model) const
+{
+    const JsonValue &nodes = document.json["nodes"];
+    const JsonValue &scenes = document.json["scenes"];
+
+    std::vector<size_t> roots;
+    if (scenes.size() > 0)
+    {
+        const JsonValue &sceneNodes = scenes[(size_t)document.json["scene"].getInt(0)]["nodes"];
+        for (size_t i = 0; i < sceneNodes.size(); ++i)
+            roots.push_back((size_t)sceneNodes[i].getInt(-1));
+    }
+
+    /* Without scenes every node that isn't a child is a root */
+    else
+    {
+        std::vector<uint8_t> isChild(nodes.size(), 0);
+        for (size_t n = 0; n < nodes.size(); ++n)
+            for (size_t c = 0; c < nodes[n]["children"].size(); ++c)
+                if ((size_t)nodes[n]["children"][c].getInt(-1) < nodes.size())
+                    isChild[(size_t)nodes[n]["children"][c].getInt(-1)] = 1;
+
+        for (size_t n = 0; n < nodes.size(); ++n)
+            if (!isChild[n])
+                roots.push_back(n);
+    }
+
+    struct PendingNode
+    {
+        size_t node;
+        glm::mat4 parentTransform;
+        size_t depth;
+    };
+
+    std::vector<PendingNode> pending;
+    for (size_t root : roots)
+        pending.push_back(PendingNode { root, glm::mat4(1.0f), 0 });
+
+    while (!pending.empty())
+    {
+        PendingNode current = pending.back();
+        pending.pop_back();
+
+        /* Deeper than the node count means the hierarchy has a cycle */
+        if (current.node >= nodes.size() || current.depth > nodes.size())
+            continue;
+
+        const JsonValue &node = nodes[current.node];
+        glm::mat4 transform = current.parentTransform * nodeTransform(node);
+
+        int64_t mesh = node["mesh"].getInt(-1);
+        if (mesh >= 0 && (size_t)mesh + 1 < meshFirstPrimitives.size())
+            for (uint32_t p = meshFirstPrimitives[mesh]; p < meshFirstPrimitives[mesh + 1]; ++p)
+                model.instances.push_back(GltfInstance { p, transform });
+
+        const JsonValue &children = node["children"];
+        for (size_t c = 0; c < children.size(); ++c)
+            pending.push_back(PendingNode { (size_t)children[c].getInt(-1), transform, current.depth + 1 });
+    }
+}
+
+bool GltfLoader::decodeBase64(const std::string &text, std::vector<unsigned char> &data)
+{
+    data.clear();
+    data.reserve(text.size() / 4 * 3);
+
+    uint32_t bits = 0;
+    int bitCount = 0;
+    for (char c : text)
+    {
+        uint32_t value;
+        if (c >= 'A' && c <= 'Z')
+            value = c - 'A';
+        else if (c >= 'a' && c <= 'z')
+            value = c - 'a' + 26;
+        else if (c >= '0' && c <= '9')
+            value = c - '0' + 52;
+        else if (c == '+')
+            value = 62;
+        else if (c == '/')
+            value = 63;
+        else if (c == '=')
+            break;
+        else
+            return false;
+
+        bits = (bits << 6) | value;
+        bitCount += 6;
+        if (bitCount >= 8)
+        {
+            bitCount -= 8;
+            data.push_back((unsigned char)(bits >> bitCount));
+        }
+    }
+
+    return true;
+}
+
+std::string GltfLoader::decodeURI(const std::string &uri)
+{
+    std::string decoded;
+    for (size_t i = 0; i < uri.size(); ++i)
+    {
+        if (uri[i] == '%' && i + 2 < uri.size() && isxdigit((unsigned char)uri[i + 1]) && isxdigit((unsigned char)uri[i + 2]))
+        {
+            decoded += (char)strtol(uri.substr(i + 1, 2).c_str(), NULL, 16);
+            i += 2;
+        }
+        else
+            decoded += uri[i];
+    }
+
+    return decoded;
+}
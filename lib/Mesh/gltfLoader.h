@@ -0,0 +1,135 @@
+#ifndef GLTF_LOADER
+#define GLTF_LOADER
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+#include <iostream>
+
+#include "mesh.h"
+#include "../Json/json.h"
+#include "../Platform/mappedFile.h"
+#include "../Texture/texture.h"
+#include "../Jobs/jobSystem.h"
+#include "../Profiler/profiler.h"
+
+/* One drawable glTF primitive, with its own vertex array */
+struct GltfPrimitive
+{
+    MeshRef mesh;
+    uint32_t material;      /* Into GltfModel::materials, NoMaterial for glTF's default material */
+    Bounds bounds;          /* Local space, from the POSITION accessor's min and max */
+};
+
+/* A primitive placed in the scene by a node */
+struct GltfInstance
+{
+    uint32_t primitive;
+    glm::mat4 transform;
+};
+
+/* Everything a glTF file uploaded, the GL objects are owned by the model */
+struct GltfModel
+{
+    std::vector<GltfPrimitive> primitives;
+    std::vector<GltfInstance> instances;
+    std::vector<MeshMaterial> materials;
+
+    std::vector<unsigned int> buffers;
+    std::vector<unsigned int> vertexArrays;
+    std::vector<unsigned int> textures;
+};
+
+void deleteGltfModel(GltfModel &model);
+
+/*  glTF 2.0 loader for .gltf (with external, embedded or data URI buffers) and .glb files.
+
+    Files are memory mapped and every buffer view a primitive reads is handed to
+    glBufferData straight from the mapping, so vertex data is never copied on the CPU.
+    Vertex arrays are built from the accessor descriptions (POSITION, NORMAL and
+    TEXCOORD_0 at lighting.vert's locations 0, 1 and 2). Only index accessors narrower
+    than 32 bits are widened, since draws always use GL_UNSIGNED_INT indices.
+
+    Base color images are decoded on the job system while the buffers upload on the
+    calling thread, then turned into textures through Texture. The default scene's node
+    hierarchy is flattened into instances with their world transforms.
+
+    Triangle primitives only; sparse accessors, skins, morph targets and animations are
+    ignored. Must be called on the GL context's thread. */
+class GltfLoader
+{
+    public:
+        /* Constructor */
+        GltfLoader(JobSystem &jobSystem);
+
+        /* Replaces model with the file's contents, false (leaving model empty) on error */
+        bool load(const char* path, GltfModel &model, Texture &textures);
+
+        /*  Flattens the default scene into one Mesh on the CPU, in world space with a sub mesh
+            per primitive, for tools like the mesh baker. Doesn't need a GL context; embedded
+            images are dropped since materials only carry map paths. */
+        bool loadMesh(const char* path, Mesh &mesh);
+
+    private:
+        struct BufferData
+        {
+            const unsigned char* data;
+            size_t size;
+        };
+
+        struct Accessor
+        {
+            uint32_t bufferView;
+            size_t byteOffset;
+            uint32_t count;
+            GLenum componentType;
+            int components;
+            bool normalized;
+        };
+
+        /* The parsed file and the memory its buffers live in */
+        struct Document
+        {
+            std::string path;
+            std::string directory;
+            JsonValue json;
+
+            MappedFile file;
+            BufferData binaryChunk;
+            std::vector<std::unique_ptr<MappedFile>> bufferFiles;
+            std::vector<std::vector<unsigned char>> decodedURIs;
+            std::vector<BufferData> buffers;
+        };
+
+        JobSystem &jobSystem;
+
+        bool readDocument(const char* path, Document &document) const;
+        bool resolveBuffers(Document &document) const;
+
+        bool getBufferView(const Document &document, const uint32_t index, BufferData &view, size_t &stride) const;
+        bool getAccessor(const Document &document, const uint32_t index, Accessor &accessor) const;
+
+        /* GL buffer holding a buffer view, uploaded on first use */
+        unsigned int getViewBuffer(const Document &document, const uint32_t index, std::vector<unsigned int> &viewBuffers, GltfModel &model) const;
+
+        /* Runs on a worker, reads the image from its file, data URI or buffer view */
+        DecodedImage decodeImage(const Document &document, const JsonValue &image) const;
+
+        bool loadPrimitive(const Document &document, const JsonValue &primitive, std::vector<unsigned int> &viewBuffers, GltfModel &model) const;
+        bool appendPrimitive(const Document &document, const JsonValue &primitive, const glm::mat4 &transform, Mesh &mesh) const;
+
+        /* Everything but the texture IDs, the base color map's path if it's in its own file */
+        MeshMaterial makeMaterial(const Document &document, const size_t index) const;
+        void collectInstances(const Document &document, const std::vector<uint32_t> &meshFirstPrimitives, GltfModel &model) const;
+
+        static bool decodeBase64(const std::string &text, std::vector<unsigned char> &data);
+        static std::string decodeURI(const std::string &uri);
+};
+
+#endif
@@ -0,0 +1,138 @@
+#include "mesh.h"
+
+MeshMaterial makeDefaultMaterial(const std::string &name)
+{
+    MeshMaterial material;
+    material.name = name;
+    material.ambient = glm::vec3(0.2f);
+    material.diffuse = glm::vec3(0.8f);
+    material.specular = glm::vec3(0.0f);
+    material.shine = 32.0f;
+    material.diffuseMapID = 0;
+    material.specularMapID = 0;
+
+    return material;
+}
+
+void generateMissingNormals(Mesh &mesh)
+{
+    /*  Vertices split only by their texture coordinates, or duplicated on a loader's chunk
+        seams, share a position. Normals are accumulated per position so they shade alike. */
+    std::vector<uint32_t> missing;
+    for (uint32_t i = 0; i < mesh.vertices.size(); ++i)
+        if (mesh.vertices[i].normal == glm::vec3(0.0f))
+            missing.push_back(i);
+
+    if (missing.empty())
+        return;
+
+    std::sort(missing.begin(), missing.end(), [&](const uint32_t a, const uint32_t b)
+    {
+        return memcmp(&mesh.vertices[a].position, &mesh.vertices[b].position, sizeof(glm::vec3)) < 0;
+    });
+
+    const uint32_t NoGroup = UINT32_MAX;
+    std::vector<uint32_t> groups(mesh.vertices.size(), NoGroup);
+    uint32_t groupCount = 0;
+    for (size_t i = 0; i < missing.size(); ++i)
+    {
+        bool samePosition = i > 0 && memcmp(&mesh.vertices[missing[i]].position, &mesh.vertices[missing[i - 1]].position, sizeof(glm::vec3)) == 0;
+        groups[missing[i]] = samePosition ? groupCount - 1 : groupCount++;
+    }
+
+    /* The unnormalized cross product is twice the triangle's area, so bigger faces weigh more */
+    std::vector<glm::vec3> groupNormals(groupCount, glm::vec3(0.0f));
+    for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+    {
+        uint32_t a = mesh.indices[i], b = mesh.indices[i + 1], c = mesh.indices[i + 2];
+        if (groups[a] == NoGroup && groups[b] == NoGroup && groups[c] == NoGroup)
+            continue;
+
+        glm::vec3 faceNormal = glm::cross(mesh.vertices[b].position - mesh.vertices[a].position,
+                                          mesh.vertices[c].position - mesh.vertices[a].position);
+
+        for (uint32_t vertex : { a, b, c })
+            if (groups[vertex] != NoGroup)
+                groupNormals[groups[vertex]] += faceNormal;
+    }
+
+    for (uint32_t vertex : missing)
+    {
+        glm::vec3 normal = groupNormals[groups[vertex]];
+        float length = glm::length(normal);
+        mesh.vertices[vertex].normal = length > 0.0f ? normal / length : glm::vec3(0.0f, 1.0f, 0.0f);
+    }
+}
+
+Bounds computeBounds(const std::vector<MeshVertex> &vertices)
+{
+    if (vertices.empty())
+        return Bounds { glm::vec3(0.0f), glm::vec3(0.0f) };
+
+    glm::vec3 minimum = vertices[0].position, maximum = vertices[0].position;
+    for (const MeshVertex &vertex : vertices)
+    {
+        minimum = glm::min(minimum, vertex.position);
+        maximum = glm::max(maximum, vertex.position);
+    }
+
+    return Bounds { (minimum + maximum) * 0.5f, (maximum - minimum) * 0.5f };
+}
+
+std::vector<Meshlet> buildMeshlets(const Mesh &mesh)
+{
+    std::vector<Meshlet> meshlets;
+
+    uint32_t meshletVertices[MeshletMaxVertices];
+    uint32_t vertexCount = 0;
+    glm::vec3 minimum(0.0f), maximum(0.0f);
+
+    auto finishMeshlet = [&]()
+    {
+        if (!meshlets.empty())
+            meshlets.back().bounds = Bounds { (minimum + maximum) * 0.5f, (maximum - minimum) * 0.5f };
+    };
+
+    for (const SubMesh &subMesh : mesh.subMeshes)
+    {
+        /* Meshlets never span two sub meshes, they'd draw with one material */
+        bool first = true;
+        for (uint32_t i = subMesh.firstIndex; i + 2 < subMesh.firstIndex + subMesh.indexCount; i += 3)
+        {
+            const uint32_t* triangle = &mesh.indices[i];
+
+            uint32_t newVertices = 0;
+            for (uint32_t corner = 0; corner < 3; ++corner)
+            {
+                bool known = std::find(meshletVertices, meshletVertices + vertexCount, triangle[corner]) != meshletVertices + vertexCount;
+                for (uint32_t previous = 0; previous < corner; ++previous)
+                    known = known || triangle[previous] == triangle[corner];
+                newVertices += known ? 0 : 1;
+            }
+
+            if (first || vertexCount + newVertices > MeshletMaxVertices || meshlets.back().indexCount >= MeshletMaxTriangles * 3)
+            {
+                finishMeshlet();
+                meshlets.push_back(Meshlet { i, 0, Bounds { glm::vec3(0.0f), glm::vec3(0.0f) } });
+
+                vertexCount = 0;
+                minimum = maximum = mesh.vertices[triangle[0]].position;
+                first = false;
+            }
+
+            for (uint32_t corner = 0; corner < 3; ++corner)
+            {
+                if (std::find(meshletVertices, meshletVertices + vertexCount, triangle[corner]) == meshletVertices + vertexCount)
+                    meshletVertices[vertexCount++] = triangle[corner];
+
+                minimum = glm::min(minimum, mesh.vertices[triangle[corner]].position);
+                maximum = glm::max(maximum, mesh.vertices[triangle[corner]].position);
+            }
+
+            meshlets.back().indexCount += 3;
+        }
+    }
+
+    finishMeshlet();
+    return meshlets;
+}
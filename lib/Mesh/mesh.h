@@ -0,0 +1,84 @@
+#ifndef MESH
+#define MESH
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "../ECS/components.h"
+
+/* Interleaved like the demos' vertex arrays: position, normal, texture coordinates */
+struct MeshVertex
+{
+    glm::vec3 position;
+    glm::vec3 normal;
+    glm::vec2 texCoords;
+};
+
+/*  Phong parameters and texture maps of a material as the asset describes them. Map
+    paths are usable as given (already joined with the asset's directory), empty if the
+    material has none. The IDs stay 0 until the maps are loaded into textures. */
+struct MeshMaterial
+{
+    std::string name;
+
+    glm::vec3 ambient;
+    glm::vec3 diffuse;
+    glm::vec3 specular;
+    float shine;
+
+    std::string diffuseMap;
+    std::string specularMap;
+
+    unsigned int diffuseMapID;
+    unsigned int specularMapID;
+};
+
+const uint32_t NoMaterial = UINT32_MAX;
+
+/* Range of indices drawn with one material */
+struct SubMesh
+{
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    uint32_t material;      /* Into Mesh::materials, NoMaterial if the faces have none */
+};
+
+/*  Small cluster of a sub mesh's triangles: a contiguous index range touching at most
+    MeshletMaxVertices vertices, with bounds tight enough to cull it on its own */
+struct Meshlet
+{
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    Bounds bounds;
+};
+
+const uint32_t MeshletMaxVertices = 64;
+const uint32_t MeshletMaxTriangles = 124;
+
+/* Indexed triangle list on the CPU, as produced by the mesh loaders */
+struct Mesh
+{
+    std::vector<MeshVertex> vertices;
+    std::vector<uint32_t> indices;
+    std::vector<SubMesh> subMeshes;
+    std::vector<MeshMaterial> materials;
+
+    Bounds bounds;
+};
+
+/* Material with the defaults used for anything the asset leaves out */
+MeshMaterial makeDefaultMaterial(const std::string &name);
+
+/* Smooth, area weighted normals for every vertex whose normal is zero, shared by vertices at the same position */
+void generateMissingNormals(Mesh &mesh);
+
+Bounds computeBounds(const std::vector<MeshVertex> &vertices);
+
+/* Splits every sub mesh into meshlets in index order, so the indices need no reordering */
+std::vector<Meshlet> buildMeshlets(const Mesh &mesh);
+
+#endif
@@ -0,0 +1,78 @@
+#include "meshBuffers.h"
+
+MeshBuffers uploadMesh(const Mesh &mesh)
+{
+    return uploadMesh(mesh.vertices.data(), mesh.vertices.size(), mesh.indices.data(), mesh.indices.size());
+}
+
+MeshBuffers uploadMesh(const MeshVertex* vertices, const size_t vertexCount, const uint32_t* indices, const size_t indexCount)
+{
+    MeshBuffers buffers;
+    buffers.indexCount = (uint32_t)indexCount;
+
+    glGenVertexArrays(1, &buffers.VAO);
+    glGenBuffers(1, &buffers.VBO);
+    glGenBuffers(1, &buffers.EBO);
+
+    glBindVertexArray(buffers.VAO);
+
+    glBindBuffer(GL_ARRAY_BUFFER, buffers.VBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(MeshVertex) * vertexCount, vertices, GL_STATIC_DRAW);
+
+    /* The element buffer binding is part of the vertex array state */
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers.EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(uint32_t) * indexCount, indices, GL_STATIC_DRAW);
+
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), (void*)offsetof(MeshVertex, position));
+    glEnableVertexAttribArray(0);
+
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), (void*)offsetof(MeshVertex, normal));
+    glEnableVertexAttribArray(1);
+
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), (void*)offsetof(MeshVertex, texCoords));
+    glEnableVertexAttribArray(2);
+
+    glBindVertexArray(0);
+
+    return buffers;
+}
+
+void deleteMeshBuffers(MeshBuffers &buffers)
+{
+    glDeleteVertexArrays(1, &buffers.VAO);
+    glDeleteBuffers(1, &buffers.VBO);
+    glDeleteBuffers(1, &buffers.EBO);
+
+    buffers.VAO = buffers.VBO = buffers.EBO = 0;
+    buffers.indexCount = 0;
+}
+
+MeshRef makeMeshRef(const MeshBuffers &buffers, const SubMesh &subMesh)
+{
+    return MeshRef { buffers.VAO, subMesh.firstIndex, subMesh.indexCount, true };
+}
+
+void loadMaterialMaps(std::vector<MeshMaterial> &materials, Texture &textures, JobSystem &jobSystem)
+{
+    /* Materials commonly share maps, decode each file only once */
+    std::vector<const char*> paths;
+    std::unordered_map<std::string, size_t> pathIndices;
+
+    for (const MeshMaterial &material : materials)
+        for (const std::string *map : { &material.diffuseMap, &material.specularMap })
+            if (!map->empty() && pathIndices.emplace(*map, paths.size()).second)
+                paths.push_back(map->c_str());
+
+    if (paths.empty())
+        return;
+
+    std::vector<unsigned int> textureIDs = textures.loadBatch(paths, jobSystem);
+
+    for (MeshMaterial &material : materials)
+    {
+        if (!material.diffuseMap.empty())
+            material.diffuseMapID = textureIDs[pathIndices[material.diffuseMap]];
+        if (!material.specularMap.empty())
+            material.specularMapID = textureIDs[pathIndices[material.specularMap]];
+    }
+}
@@ -0,0 +1,39 @@
+#ifndef MESH_BUFFERS
+#define MESH_BUFFERS
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "mesh.h"
+#include "../Texture/texture.h"
+#include "../Jobs/jobSystem.h"
+
+/* Vertex array of an uploaded Mesh, with the buffers it owns */
+struct MeshBuffers
+{
+    unsigned int VAO;
+    unsigned int VBO;
+    unsigned int EBO;
+    uint32_t indexCount;
+};
+
+/*  Uploads the vertices and indices into a new vertex array with the attribute layout of
+    lighting.vert: 0 position, 1 normal, 2 texture coordinates. Needs the GL context. */
+MeshBuffers uploadMesh(const Mesh &mesh);
+
+/* Same from arrays anywhere in memory, e.g. straight out of a mapped baked mesh */
+MeshBuffers uploadMesh(const MeshVertex* vertices, const size_t vertexCount, const uint32_t* indices, const size_t indexCount);
+void deleteMeshBuffers(MeshBuffers &buffers);
+
+/* Indexed MeshRef drawing one sub mesh out of the uploaded buffers */
+MeshRef makeMeshRef(const MeshBuffers &buffers, const SubMesh &subMesh);
+
+/*  Decodes every map the materials reference on the job system, each distinct file once,
+    and fills in the texture IDs. Materials without a map keep ID 0. */
+void loadMaterialMaps(std::vector<MeshMaterial> &materials, Texture &textures, JobSystem &jobSystem);
+
+#endif
@@ -0,0 +1,677 @@
+#include "objLoader.h"
+
+/* Exactly representable powers of ten, larger exponents fall back to pow */
+static const double powersOfTen[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static bool isDigit(const char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+static bool isSpace(const char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static void skipSpaces(const char* &cursor, const char* end)
+{
+    while (cursor < end && isSpace(*cursor))
+        ++cursor;
+}
+
+/* True if the line continues with keyword followed by whitespace, moving past both */
+static bool matchKeyword(const char* &cursor, const char* end, const char* keyword)
+{
+    size_t length = strlen(keyword);
+    if ((size_t)(end - cursor) <= length || memcmp(cursor, keyword, length) != 0 || !isSpace(cursor[length]))
+        return false;
+
+    cursor += length;
+    skipSpaces(cursor, end);
+    return true;
+}
+
+/*  Decimal float with optional sign, fraction and exponent. The first 19 significant
+    digits are accumulated exactly in an integer and scaled once, which is far more
+    precision than a float keeps, and doesn't depend on the locale like strtof. */
+static bool parseFloat(const char* &cursor, const char* end, float &value)
+{
+    skipSpaces(cursor, end);
+
+    const char* c = cursor;
+    bool negative = false;
+    if (c < end && (*c == '-' || *c == '+'))
+        negative = *c++ == '-';
+
+    uint64_t mantissa = 0;
+    int digits = 0, exponent = 0;
+    bool hasDigits = false;
+
+    for (; c < end && isDigit(*c); ++c, hasDigits = true)
+    {
+        if (digits < 19)
+        {
+            mantissa = mantissa * 10 + (*c - '0');
+            digits += mantissa != 0;
+        }
+        else
+            ++exponent;
+    }
+
+    if (c < end && *c == '.')
+    {
+        for (++c; c < end && isDigit(*c); ++c, hasDigits = true)
+        {
+            if (digits < 19)
+            {
+                mantissa = mantissa * 10 + (*c - '0');
+                digits += mantissa != 0;
+                --exponent;
+            }
+        }
+    }
+
+    if (!hasDigits)
+        return false;
+
+    if (c < end && (*c == 'e' || *c == 'E'))
+    {
+        const char* e = c + 1;
+        bool negativeExponent = false;
+        if (e < end && (*e == '-' || *e == '+'))
+            negativeExponent = *e++ == '-';
+
+        if (e < end && isDigit(*e))
+        {
+            int explicitExponent = 0;
+            for (; e < end && isDigit(*e); ++e)
+                explicitExponent = std::min(explicitExponent * 10 + (*e - '0'), 100000);
+
+            exponent += negativeExponent ? -explicitExponent : explicitExponent;
+            c = e;
+        }
+    }
+
+    double result = (double)mantissa;
+    if (mantissa != 0 && exponent != 0)
+    {
+        if (exponent > 0 && exponent <= 22)
+            result *= powersOfTen[exponent];
+        else if (exponent < 0 && exponent >= -22)
+            result /= powersOfTen[-exponent];
+        else
+            result *= std::pow(10.0, (double)exponent);
+    }
+
+    value = (float)(negative ? -result : result);
+    cursor = c;
+    return true;
+}
+
+static bool parseInteger(const char* &cursor, const char* end, int64_t &value)
+{
+    const char* c = cursor;
+    bool negative = false;
+    if (c < end && (*c == '-' || *c == '+'))
+        negative = *c++ == '-';
+
+    if (c >= end || !isDigit(*c))
+        return false;
+
+    int64_t result = 0;
+    for (; c < end && isDigit(*c); ++c)
+        result = std::min<int64_t>(result * 10 + (*c - '0'), INT32_MAX);
+
+    value = negative ? -result : result;
+    cursor = c;
+    return true;
+}
+
+/* Rest of the line without surrounding whitespace */
+static std::string restOfLine(const char* cursor, const char* end)
+{
+    skipSpaces(cursor, end);
+    while (end > cursor && isSpace(end[-1]))
+        --end;
+
+    return std::string(cursor, end);
+}
+
+/* Next whitespace separated token of the line, empty at its end */
+static std::string nextToken(const char* &cursor, const char* end)
+{
+    skipSpaces(cursor, end);
+    const char* begin = cursor;
+    while (cursor < end && !isSpace(*cursor))
+        ++cursor;
+
+    return std::string(begin, cursor);
+}
+
+static std::string joinPath(const std::string &directory, const std::string &path)
+{
+    bool isAbsolute = (!path.empty() && (path[0] == '/' || path[0] == '\\')) || (path.size() > 1 && path[1] == ':');
+    return isAbsolute ? path : directory + path;
+}
+
+/* Constructor */
+ObjLoader::ObjLoader(JobSystem &jobSystem)
+    : chunkSize { 1 << 20 },
+      jobSystem { jobSystem }
+{
+}
+
+/* Public */
+bool ObjLoader::load(const char* path, Mesh &mesh)
+{
+    PROFILE_SCOPE("ObjLoader::load");
+
+    mesh = Mesh();
+
+    MappedFile file(path);
+    if (!file.isValid())
+        return false;
+
+    file.adviseSequential();
+
+    std::vector<Chunk> chunks = splitIntoChunks(file.data(), file.size());
+
+    {
+        PROFILE_SCOPE("ObjLoader parse");
+        jobSystem.parallelFor(chunks.size(), 1, [&](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t c = begin; c < end; ++c)
+                parseChunk(chunks[c]);
+        });
+    }
+
+    for (const Chunk &chunk : chunks)
+    {
+        if (chunk.error)
+        {
+            std::cout << "ERROR: ObjLoader -> Malformed statement at byte " << (chunk.error - file.data()) << " of " << path << std::endl;
+            return false;
+        }
+    }
+
+    /* Where each chunk's attributes start once all of them are concatenated */
+    std::vector<uint32_t> positionBases(chunks.size()), texCoordBases(chunks.size()), normalBases(chunks.size());
+    size_t positionCount = 0, texCoordCount = 0, normalCount = 0;
+    for (size_t c = 0; c < chunks.size(); ++c)
+    {
+        positionBases[c] = (uint32_t)positionCount;
+        texCoordBases[c] = (uint32_t)texCoordCount;
+        normalBases[c] = (uint32_t)normalCount;
+
+        positionCount += chunks[c].positions.size();
+        texCoordCount += chunks[c].texCoords.size();
+        normalCount += chunks[c].normals.size();
+    }
+
+    if (positionCount > INT32_MAX || texCoordCount > INT32_MAX || normalCount > INT32_MAX)
+    {
+        std::cout << "ERROR: ObjLoader -> Too many vertex attributes in " << path << std::endl;
+        return false;
+    }
+
+    std::vector<glm::vec3> positions(positionCount), normals(normalCount);
+    std::vector<glm::vec2> texCoords(texCoordCount);
+    std::vector<uint8_t> validIndices(chunks.size());
+
+    {
+        PROFILE_SCOPE("ObjLoader weld");
+        jobSystem.parallelFor(chunks.size(), 1, [&](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t c = begin; c < end; ++c)
+            {
+                Chunk &chunk = chunks[c];
+                std::copy(chunk.positions.begin(), chunk.positions.end(), positions.begin() + positionBases[c]);
+                std::copy(chunk.texCoords.begin(), chunk.texCoords.end(), texCoords.begin() + texCoordBases[c]);
+                std::copy(chunk.normals.begin(), chunk.normals.end(), normals.begin() + normalBases[c]);
+
+                std::vector<glm::vec3>().swap(chunk.positions);
+                std::vector<glm::vec2>().swap(chunk.texCoords);
+                std::vector<glm::vec3>().swap(chunk.normals);
+
+                validIndices[c] = resolveIndices(chunk, positionBases[c], texCoordBases[c], normalBases[c],
+                                                 (uint32_t)positionCount, (uint32_t)texCoordCount, (uint32_t)normalCount);
+            }
+        });
+
+        for (uint8_t valid : validIndices)
+        {
+            if (!valid)
+            {
+                std::cout << "ERROR: ObjLoader -> Face references a vertex attribute that doesn't exist in " << path << std::endl;
+                return false;
+            }
+        }
+
+        /* Welding reads attributes written by other chunks, so it waits for every copy above */
+        jobSystem.parallelFor(chunks.size(), 1, [&](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t c = begin; c < end; ++c)
+                weldChunk(chunks[c], positions, texCoords, normals);
+        });
+    }
+
+    std::vector<size_t> vertexBases(chunks.size()), indexBases(chunks.size());
+    size_t vertexCount = 0, indexCount = 0;
+    bool missingNormals = false;
+    for (size_t c = 0; c < chunks.size(); ++c)
+    {
+        vertexBases[c] = vertexCount;
+        indexBases[c] = indexCount;
+        vertexCount += chunks[c].vertices.size();
+        indexCount += chunks[c].indices.size();
+        missingNormals = missingNormals || chunks[c].missingNormals;
+    }
+
+    if (vertexCount > UINT32_MAX || indexCount > UINT32_MAX)
+    {
+        std::cout << "ERROR: ObjLoader -> Too many vertices for 32 bit indices in " << path << std::endl;
+        return false;
+    }
+
+    mesh.vertices.resize(vertexCount);
+    mesh.indices.resize(indexCount);
+
+    jobSystem.parallelFor(chunks.size(), 1, [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t c = begin; c < end; ++c)
+        {
+            const Chunk &chunk = chunks[c];
+            std::copy(chunk.vertices.begin(), chunk.vertices.end(), mesh.vertices.begin() + vertexBases[c]);
+
+            uint32_t vertexBase = (uint32_t)vertexBases[c];
+            uint32_t* indices = mesh.indices.data() + indexBases[c];
+            for (size_t i = 0; i < chunk.indices.size(); ++i)
+                indices[i] = chunk.indices[i] + vertexBase;
+        }
+    });
+
+    /* Materials, from every library in the order they're referenced */
+    std::string pathString = path;
+    size_t separator = pathString.find_last_of("/\\");
+    std::string directory = separator == std::string::npos ? std::string() : pathString.substr(0, separator + 1);
+
+    std::vector<std::string> loadedLibraries;
+    for (const Chunk &chunk : chunks)
+    {
+        for (const std::string &library : chunk.materialLibraries)
+        {
+            if (std::find(loadedLibraries.begin(), loadedLibraries.end(), library) != loadedLibraries.end())
+                continue;
+
+            loadedLibraries.push_back(library);
+            if (!loadMaterialLibrary(joinPath(directory, library), directory, mesh.materials))
+                std::cout << "WARNING: ObjLoader -> Unable to load material library " << library << " of " << path << std::endl;
+        }
+    }
+
+    std::unordered_map<std::string, uint32_t> materialIndices;
+    for (uint32_t m = 0; m < mesh.materials.size(); ++m)
+        materialIndices.emplace(mesh.materials[m].name, m);
+
+    /* Sub meshes, split wherever the material changes */
+    uint32_t currentMaterial = NoMaterial;
+    size_t runStart = 0;
+
+    auto closeRun = [&](const size_t runEnd)
+    {
+        if (runEnd == runStart)
+            return;
+
+        if (!mesh.subMeshes.empty() && mesh.subMeshes.back().material == currentMaterial)
+            mesh.subMeshes.back().indexCount += (uint32_t)(runEnd - runStart);
+        else
+            mesh.subMeshes.push_back(SubMesh { (uint32_t)runStart, (uint32_t)(runEnd - runStart), currentMaterial });
+
+        runStart = runEnd;
+    };
+
+    for (size_t c = 0; c < chunks.size(); ++c)
+    {
+        for (const MaterialSwitch &materialSwitch : chunks[c].materialSwitches)
+        {
+            closeRun(indexBases[c] + (size_t)materialSwitch.firstTriangle * 3);
+
+            auto material = materialIndices.find(materialSwitch.name);
+            if (material == materialIndices.end())
+            {
+                std::cout << "WARNING: ObjLoader -> Undefined material " << materialSwitch.name << " in " << path << std::endl;
+                material = materialIndices.emplace(materialSwitch.name, (uint32_t)mesh.materials.size()).first;
+                mesh.materials.push_back(makeDefaultMaterial(materialSwitch.name));
+            }
+
+            currentMaterial = material->second;
+        }
+    }
+    closeRun(indexCount);
+
+    if (missingNormals)
+        generateMissingNormals(mesh);
+
+    mesh.bounds = computeBounds(mesh.vertices);
+
+    return true;
+}
+
+/* Private */
+std::vector<ObjLoader::Chunk> ObjLoader::splitIntoChunks(const char* data, const size_t size) const
+{
+    std::vector<Chunk> chunks;
+
+    const char* end = data + size;
+    const char* begin = data;
+    while (begin < end)
+    {
+        /* Extend each chunk to the end of the line it would cut */
+        const char* chunkEnd = (size_t)(end - begin) > chunkSize ? begin + std::max<size_t>(chunkSize, 1) : end;
+        if (chunkEnd < end)
+        {
+            const char* lineEnd = (const char*)memchr(chunkEnd, '\n', end - chunkEnd);
+            chunkEnd = lineEnd ? lineEnd + 1 : end;
+        }
+
+        Chunk chunk;
+        chunk.begin = begin;
+        chunk.end = chunkEnd;
+        chunk.error = NULL;
+        chunk.missingNormals = false;
+        chunks.push_back(std::move(chunk));
+
+        begin = chunkEnd;
+    }
+
+    return chunks;
+}
+
+void ObjLoader::parseChunk(Chunk &chunk)
+{
+    std::vector<Corner> polygon;
+    std::vector<uint8_t> relative;
+
+    const char* cursor = chunk.begin;
+    while (cursor < chunk.end && !chunk.error)
+    {
+        const char* lineStart = cursor;
+        const char* lineEnd = (const char*)memchr(cursor, '\n', chunk.end - cursor);
+        if (!lineEnd)
+            lineEnd = chunk.end;
+
+        cursor = lineStart;
+        skipSpaces(cursor, lineEnd);
+
+        bool valid = true;
+        if (matchKeyword(cursor, lineEnd, "v"))
+        {
+            glm::vec3 position;
+            valid = parseFloat(cursor, lineEnd, position.x) && parseFloat(cursor, lineEnd, position.y) && parseFloat(cursor, lineEnd, position.z);
+            chunk.positions.push_back(position);
+        }
+
+        else if (matchKeyword(cursor, lineEnd, "vt"))
+        {
+            glm::vec2 texCoord(0.0f);
+            valid = parseFloat(cursor, lineEnd, texCoord.x);
+            parseFloat(cursor, lineEnd, texCoord.y);
+            chunk.texCoords.push_back(texCoord);
+        }
+
+        else if (matchKeyword(cursor, lineEnd, "vn"))
+        {
+            glm::vec3 normal;
+            valid = parseFloat(cursor, lineEnd, normal.x) && parseFloat(cursor, lineEnd, normal.y) && parseFloat(cursor, lineEnd, normal.z);
+            chunk.normals.push_back(normal);
+        }
+
+        else if (matchKeyword(cursor, lineEnd, "f"))
+        {
+            polygon.clear();
+            uint32_t firstIndex = (uint32_t)chunk.corners.size() * 3;
+
+            /*  v, v/vt, v//vn or v/vt/vn. Relative indices count back from the attributes seen
+                so far, which within a chunk are only those of the chunk itself */
+            while (valid && cursor < lineEnd)
+            {
+                int64_t values[3] = { 0, 0, 0 };
+                valid = parseInteger(cursor, lineEnd, values[0]);
+                if (valid && cursor < lineEnd && *cursor == '/')
+                {
+                    ++cursor;
+                    if (cursor < lineEnd && *cursor != '/')
+                        valid = parseInteger(cursor, lineEnd, values[1]);
+                    if (valid && cursor < lineEnd && *cursor == '/')
+                    {
+                        ++cursor;
+                        valid = parseInteger(cursor, lineEnd, values[2]);
+                    }
+                }
+
+                const size_t counts[3] = { chunk.positions.size(), chunk.texCoords.size(), chunk.normals.size() };
+                int32_t indices[3];
+                for (int attribute = 0; attribute < 3 && valid; ++attribute)
+                {
+                    int64_t value = values[attribute];
+                    if (value > 0)
+                        indices[attribute] = (int32_t)(value - 1);
+                    else if (value < 0)
+                    {
+                        indices[attribute] = (int32_t)((int64_t)counts[attribute] + value);
+                        chunk.relativeIndices.push_back(firstIndex + (uint32_t)polygon.size() * 3 + attribute);
+                    }
+                    else
+                    {
+                        indices[attribute] = MissingIndex;
+                        valid = attribute > 0;
+                    }
+                }
+
+                if (valid)
+                    polygon.push_back(Corner { indices[0], indices[1], indices[2] });
+
+                skipSpaces(cursor, lineEnd);
+            }
+
+            valid = valid && polygon.size() >= 3;
+
+            /* Fan triangulation. Relative entries were recorded against the polygon's corner order, so remap them */
+            if (valid)
+            {
+                size_t relativeStart = chunk.relativeIndices.size();
+                while (relativeStart > 0 && chunk.relativeIndices[relativeStart - 1] >= firstIndex)
+                    --relativeStart;
+
+                bool hasRelative = relativeStart < chunk.relativeIndices.size();
+                if (hasRelative)
+                {
+                    relative.assign(polygon.size() * 3, 0);
+                    for (size_t r = relativeStart; r < chunk.relativeIndices.size(); ++r)
+                        relative[chunk.relativeIndices[r] - firstIndex] = 1;
+                    chunk.relativeIndices.resize(relativeStart);
+                }
+
+                for (size_t i = 1; i + 1 < polygon.size(); ++i)
+                {
+                    for (size_t corner : { (size_t)0, i, i + 1 })
+                    {
+                        if (hasRelative)
+                        {
+                            uint32_t slot = (uint32_t)chunk.corners.size() * 3;
+                            for (int attribute = 0; attribute < 3; ++attribute)
+                                if (relative[corner * 3 + attribute])
+                                    chunk.relativeIndices.push_back(slot + attribute);
+                        }
+
+                        chunk.corners.push_back(polygon[corner]);
+                    }
+                }
+            }
+        }
+
+        else if (matchKeyword(cursor, lineEnd, "usemtl"))
+        {
+            chunk.materialSwitches.push_back(MaterialSwitch { (uint32_t)(chunk.corners.size() / 3), restOfLine(cursor, lineEnd) });
+        }
+
+        else if (matchKeyword(cursor, lineEnd, "mtllib"))
+        {
+            for (std::string library = nextToken(cursor, lineEnd); !library.empty(); library = nextToken(cursor, lineEnd))
+                chunk.materialLibraries.push_back(library);
+        }
+
+        if (!valid)
+            chunk.error = lineStart;
+
+        cursor = lineEnd + 1;
+    }
+}
+
+bool ObjLoader::resolveIndices(Chunk &chunk, const uint32_t positionBase, const uint32_t texCoordBase, const uint32_t normalBase,
+                               const uint32_t positionCount, const uint32_t texCoordCount, const uint32_t normalCount)
+{
+    const int32_t bases[3] = { (int32_t)positionBase, (int32_t)texCoordBase, (int32_t)normalBase };
+
+    int32_t* indices = (int32_t*)chunk.corners.data();
+    for (uint32_t slot : chunk.relativeIndices)
+        indices[slot] += bases[slot % 3];
+    std::vector<uint32_t>().swap(chunk.relativeIndices);
+
+    for (const Corner &corner : chunk.corners)
+    {
+        if (corner.position < 0 || (uint32_t)corner.position >= positionCount)
+            return false;
+        if (corner.texCoord != MissingIndex && (corner.texCoord < 0 || (uint32_t)corner.texCoord >= texCoordCount))
+            return false;
+        if (corner.normal != MissingIndex && (corner.normal < 0 || (uint32_t)corner.normal >= normalCount))
+            return false;
+    }
+
+    return true;
+}
+
+void ObjLoader::weldChunk(Chunk &chunk, const std::vector<glm::vec3> &positions,
+                          const std::vector<glm::vec2> &texCoords, const std::vector<glm::vec3> &normals)
+{
+    /* Open addressing with linear probing, slots hold the vertex index + 1 and 0 when empty */
+    size_t capacity = 16;
+    while (capacity < chunk.corners.size() * 2)
+        capacity *= 2;
+
+    std::vector<uint32_t> slots(capacity, 0);
+    std::vector<Corner> keys;
+    const size_t mask = capacity - 1;
+
+    chunk.indices.reserve(chunk.corners.size());
+
+    for (const Corner &corner : chunk.corners)
+    {
+        uint32_t hash = (uint32_t)corner.position * 0x9E3779B1u ^ (uint32_t)corner.texCoord * 0x85EBCA77u ^ (uint32_t)corner.normal * 0xC2B2AE3Du;
+        hash ^= hash >> 15;
+
+        size_t slot = hash & mask;
+        while (slots[slot])
+        {
+            const Corner &key = keys[slots[slot] - 1];
+            if (key.position == corner.position && key.texCoord == corner.texCoord && key.normal == corner.normal)
+                break;
+
+            slot = (slot + 1) & mask;
+        }
+
+        if (!slots[slot])
+        {
+            MeshVertex vertex;
+            vertex.position = positions[corner.position];
+            vertex.texCoords = corner.texCoord == MissingIndex ? glm::vec2(0.0f) : texCoords[corner.texCoord];
+            vertex.normal = corner.normal == MissingIndex ? glm::vec3(0.0f) : normals[corner.normal];
+            chunk.missingNormals = chunk.missingNormals || corner.normal == MissingIndex;
+
+            keys.push_back(corner);
+            chunk.vertices.push_back(vertex);
+            slots[slot] = (uint32_t)keys.size();
+        }
+
+        chunk.indices.push_back(slots[slot] - 1);
+    }
+
+    std::vector<Corner>().swap(chunk.corners);
+}
+
+bool ObjLoader::loadMaterialLibrary(const std::string &path, const std::string &directory, std::vector<MeshMaterial> &materials)
+{
+    MappedFile file;
+    if (!file.open(path.c_str()))
+        return false;
+
+    MeshMaterial* material = NULL;
+
+    const char* cursor = file.data();
+    const char* end = file.data() + file.size();
+    while (cursor < end)
+    {
+        const char* lineEnd = (const char*)memchr(cursor, '\n', end - cursor);
+        if (!lineEnd)
+            lineEnd = end;
+
+        skipSpaces(cursor, lineEnd);
+
+        if (matchKeyword(cursor, lineEnd, "newmtl"))
+        {
+            materials.push_back(makeDefaultMaterial(restOfLine(cursor, lineEnd)));
+            material = &materials.back();
+        }
+
+        /* Statements before the first newmtl have no material to apply to */
+        else if (material)
+        {
+            glm::vec3* color = NULL;
+            std::string* map = NULL;
+
+            if (matchKeyword(cursor, lineEnd, "Ka"))
+                color = &material->ambient;
+            else if (matchKeyword(cursor, lineEnd, "Kd"))
+                color = &material->diffuse;
+            else if (matchKeyword(cursor, lineEnd, "Ks"))
+                color = &material->specular;
+            else if (matchKeyword(cursor, lineEnd, "Ns"))
+                parseFloat(cursor, lineEnd, material->shine);
+            else if (matchKeyword(cursor, lineEnd, "map_Kd"))
+                map = &material->diffuseMap;
+            else if (matchKeyword(cursor, lineEnd, "map_Ks"))
+                map = &material->specularMap;
+
+            if (color)
+            {
+                glm::vec3 value;
+                if (parseFloat(cursor, lineEnd, value.x))
+                {
+                    /* A single value means a grey */
+                    value.y = value.z = value.x;
+                    if (parseFloat(cursor, lineEnd, value.y))
+                        parseFloat(cursor, lineEnd, value.z);
+                    *color = value;
+                }
+            }
+
+            /* Options like -bm 0.5 come before the file name, which is the last token */
+            if (map)
+            {
+                std::string fileName;
+                for (std::string token = nextToken(cursor, lineEnd); !token.empty(); token = nextToken(cursor, lineEnd))
+                    fileName = token;
+
+                if (!fileName.empty())
+                    *map = joinPath(directory, fileName);
+            }
+        }
+
+        cursor = lineEnd + 1;
+    }
+
+    return true;
+}
@@ -0,0 +1,104 @@
+#ifndef OBJ_LOADER
+#define OBJ_LOADER
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <iostream>
+
+#include "mesh.h"
+#include "../Platform/mappedFile.h"
+#include "../Jobs/jobSystem.h"
+#include "../Profiler/profiler.h"
+
+/*  Wavefront OBJ loader, including the MTL libraries the file references.
+
+    The file is memory mapped and cut into chunks at line breaks, which are parsed in
+    parallel on the job system with a hand written number parser. Once every chunk's
+    counts are known the attributes are concatenated, then each chunk welds its face
+    corners into unique vertices with its own hash table. Corners are only shared within
+    a chunk, the few vertices on chunk seams are duplicated instead of merged globally,
+    which keeps the whole load parallel. Chunk boundaries depend on chunkSize alone, so
+    the output doesn't change with the number of threads.
+
+    Polygons are triangulated as fans, faces are kept in file order and split into a
+    SubMesh wherever usemtl switches material. Vertices without a normal get smooth
+    generated ones. Supported statements: v, vt, vn, f, usemtl and mtllib, the rest
+    (groups, smoothing groups, lines, points) is ignored. */
+class ObjLoader
+{
+    public:
+        /* Constructor */
+        ObjLoader(JobSystem &jobSystem);
+
+        /* Bytes of the file parsed per job */
+        size_t chunkSize;
+
+        /* Replaces mesh with the file's contents, false (leaving mesh empty) on error */
+        bool load(const char* path, Mesh &mesh);
+
+    private:
+        /* Attribute indices of a face corner, made 0 based. MissingIndex if the corner has none */
+        struct Corner
+        {
+            int32_t position;
+            int32_t texCoord;
+            int32_t normal;
+        };
+
+        static const int32_t MissingIndex = INT32_MIN;
+
+        /* usemtl taking effect from a triangle of the chunk on */
+        struct MaterialSwitch
+        {
+            uint32_t firstTriangle;
+            std::string name;
+        };
+
+        struct Chunk
+        {
+            const char* begin;
+            const char* end;
+
+            std::vector<glm::vec3> positions;
+            std::vector<glm::vec2> texCoords;
+            std::vector<glm::vec3> normals;
+
+            /* Three per triangle */
+            std::vector<Corner> corners;
+
+            /*  Negative (relative) indices are stored relative to the chunk's first attribute
+                until the chunks before it are counted. Entries are corner * 3 + attribute. */
+            std::vector<uint32_t> relativeIndices;
+
+            std::vector<MaterialSwitch> materialSwitches;
+            std::vector<std::string> materialLibraries;
+
+            /* Start of the first malformed line, NULL if none */
+            const char* error;
+
+            /* Filled in by the welding pass */
+            std::vector<MeshVertex> vertices;
+            std::vector<uint32_t> indices;
+            bool missingNormals;
+        };
+
+        JobSystem &jobSystem;
+
+        std::vector<Chunk> splitIntoChunks(const char* data, const size_t size) const;
+        static void parseChunk(Chunk &chunk);
+        static bool resolveIndices(Chunk &chunk, const uint32_t positionBase, const uint32_t texCoordBase, const uint32_t normalBase,
+                                   const uint32_t positionCount, const uint32_t texCoordCount, const uint32_t normalCount);
+        static void weldChunk(Chunk &chunk, const std::vector<glm::vec3> &positions,
+                              const std::vector<glm::vec2> &texCoords, const std::vector<glm::vec3> &normals);
+
+        /* Appends the materials of an MTL file to materials, false if it can't be read */
+        static bool loadMaterialLibrary(const std::string &path, const std::string &directory, std::vector<MeshMaterial> &materials);
+};
+
+#endif
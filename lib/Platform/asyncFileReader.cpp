@@ -0,0 +1,523 @@
+#include "asyncFileReader.h"
+
+/* Constructor / Destructor */
+IOBuffer::IOBuffer()
+    : bytes { nullptr }
+    , length { 0 }
+{
+}
+
+IOBuffer::IOBuffer(const size_t size)
+    : IOBuffer()
+{
+    /* Over allocates and keeps the original pointer right before the aligned block */
+    length = (size + DirectIOAlignment - 1) / DirectIOAlignment * DirectIOAlignment;
+    unsigned char* allocation = (unsigned char*)malloc(length + DirectIOAlignment + sizeof(void*));
+    if (!allocation)
+    {
+        length = 0;
+        return;
+    }
+
+    uintptr_t aligned = ((uintptr_t)allocation + sizeof(void*) + DirectIOAlignment - 1) / DirectIOAlignment * DirectIOAlignment;
+    bytes = (unsigned char*)aligned;
+    memcpy(bytes - sizeof(void*), &allocation, sizeof(void*));
+}
+
+IOBuffer::~IOBuffer()
+{
+    if (!bytes)
+        return;
+
+    void* allocation;
+    memcpy(&allocation, bytes - sizeof(void*), sizeof(void*));
+    free(allocation);
+}
+
+IOBuffer::IOBuffer(IOBuffer &&other)
+    : IOBuffer()
+{
+    *this = std::move(other);
+}
+
+IOBuffer &IOBuffer::operator=(IOBuffer &&other)
+{
+    std::swap(bytes, other.bytes);
+    std::swap(length, other.length);
+    return *this;
+}
+
+/* Public */
+unsigned char* IOBuffer::data() const
+{
+    return bytes;
+}
+
+size_t IOBuffer::size() const
+{
+    return length;
+}
+
+/* Constructor / Destructor */
+AsyncFileReader::AsyncFileReader(JobSystem &jobSystem, const unsigned int queueDepth, const unsigned int fallbackThreads)
+    : jobSystem { jobSystem }
+    , inFlight { 0 }
+    , queueDepth { std::max(queueDepth, 1u) }
+    , running { true }
+{
+#if defined(ASYNC_FILE_IO_URING)
+    ring = -1;
+    submissionRing = completionRing = NULL;
+    submissionEntries = NULL;
+
+    if (setupRing(this->queueDepth))
+    {
+        completionThread = std::thread(&AsyncFileReader::completionLoop, this);
+        return;
+    }
+
+    std::cout << "WARNING: AsyncFileReader -> io_uring isn't available, reading on a thread pool" << std::endl;
+#endif
+
+    for (unsigned int i = 0; i < std::max(fallbackThreads, 1u); ++i)
+        fallbackWorkers.emplace_back(&AsyncFileReader::fallbackLoop, this);
+}
+
+AsyncFileReader::~AsyncFileReader()
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        idleCondition.wait(lock, [this]() { return queue.empty() && inFlight == 0; });
+        running = false;
+    }
+
+    queueCondition.notify_all();
+    for (std::thread &worker : fallbackWorkers)
+        worker.join();
+
+#if defined(ASYNC_FILE_IO_URING)
+    if (completionThread.joinable())
+    {
+        /* A no-op without a read is the completion thread's signal to stop */
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pushEntry(IORING_OP_NOP, NULL);
+            syscall(__NR_io_uring_enter, ring, 1, 0, 0, NULL, 0);
+        }
+        completionThread.join();
+    }
+
+    destroyRing();
+#endif
+
+#if !defined(ASYNC_FILE_POSIX)
+    for (FILE* file : files)
+        if (file)
+            fclose(file);
+#endif
+}
+
+/* Public */
+int AsyncFileReader::openFile(const char* path, const bool direct)
+{
+#if defined(ASYNC_FILE_POSIX)
+    int flags = O_RDONLY;
+#if defined(O_CLOEXEC)
+    flags |= O_CLOEXEC;
+#endif
+
+    int file = -1;
+#if defined(O_DIRECT)
+    if (direct)
+    {
+        file = ::open(path, flags | O_DIRECT);
+        if (file < 0 && errno == EINVAL)
+            std::cout << "WARNING: AsyncFileReader -> " << path << " doesn't support direct I/O, reading it buffered" << std::endl;
+    }
+#endif
+
+    if (file < 0)
+        file = ::open(path, flags);
+
+#if defined(__APPLE__)
+    if (file >= 0 && direct)
+        fcntl(file, F_NOCACHE, 1);
+#endif
+#else
+    std::lock_guard<std::mutex> lock(fileMutex);
+    FILE* stream = fopen(path, "rb");
+    int file = stream ? (int)files.size() : -1;
+    if (stream)
+        files.push_back(stream);
+#endif
+
+    if (file < 0)
+        std::cout << "ERROR: AsyncFileReader -> Unable to open " << path << std::endl;
+
+    return file;
+}
+
+void AsyncFileReader::closeFile(const int file)
+{
+    if (file < 0)
+        return;
+
+#if defined(ASYNC_FILE_POSIX)
+    ::close(file);
+#else
+    std::lock_guard<std::mutex> lock(fileMutex);
+    if ((size_t)file < files.size() && files[file])
+    {
+        fclose(files[file]);
+        files[file] = NULL;
+    }
+#endif
+}
+
+int64_t AsyncFileReader::getFileSize(const int file)
+{
+#if defined(ASYNC_FILE_POSIX)
+    struct stat status;
+    return fstat(file, &status) == 0 ? (int64_t)status.st_size : -1;
+#else
+    std::lock_guard<std::mutex> lock(fileMutex);
+    if (file < 0 || (size_t)file >= files.size() || !files[file] || fseek(files[file], 0, SEEK_END) != 0)
+        return -1;
+
+    return (int64_t)ftell(files[file]);
+#endif
+}
+
+void AsyncFileReader::read(std::vector<FileReadRequest> requests, JobCounter* counter)
+{
+    if (requests.empty())
+        return;
+
+    /* One count per read, handed over to its callback's job when it completes */
+    if (counter)
+        counter->fetch_add((int)requests.size());
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (FileReadRequest &request : requests)
+    {
+        PendingRead* read = new PendingRead();
+        read->request = std::move(request);
+        read->counter = counter;
+        queue.push_back(read);
+    }
+
+#if defined(ASYNC_FILE_IO_URING)
+    if (ring >= 0)
+    {
+        submitQueued();
+        return;
+    }
+#endif
+
+    queueCondition.notify_all();
+}
+
+void AsyncFileReader::readFile(const char* path, std::function<void(const unsigned char* data, const size_t size)> onLoaded, JobCounter* counter)
+{
+    int file = openFile(path);
+    int64_t size = file < 0 ? -1 : getFileSize(file);
+    if (size < 0)
+    {
+        closeFile(file);
+        jobSystem.run([onLoaded]() { onLoaded(NULL, 0); }, counter);
+        return;
+    }
+
+    std::shared_ptr<std::vector<unsigned char>> data = std::make_shared<std::vector<unsigned char>>((size_t)size);
+    FileReadRequest request = { file, 0, (size_t)size, data->data(), [this, file, data, onLoaded](const int64_t result)
+    {
+        closeFile(file);
+
+        /* Not NULL for an empty file, it was read fine */
+        static const unsigned char empty = 0;
+        if (result == (int64_t)data->size())
+            onLoaded(data->empty() ? &empty : data->data(), data->size());
+        else
+            onLoaded(NULL, 0);
+    } };
+
+    read({ request }, counter);
+}
+
+bool AsyncFileReader::isUsingIoUring() const
+{
+#if defined(ASYNC_FILE_IO_URING)
+    return ring >= 0;
+#else
+    return false;
+#endif
+}
+
+/* Private */
+#if defined(ASYNC_FILE_IO_URING)
+bool AsyncFileReader::setupRing(const unsigned int entries)
+{
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    ring = (int)syscall(__NR_io_uring_setup, entries, &params);
+    if (ring < 0)
+        return false;
+
+    submissionRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    completionRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+
+    /* Newer kernels share one mapping between both rings */
+    bool singleMapping = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (singleMapping)
+        submissionRingSize = completionRingSize = std::max(submissionRingSize, completionRingSize);
+
+    void* mapping = mmap(NULL, submissionRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQ_RING);
+    submissionRing = mapping == MAP_FAILED ? NULL : mapping;
+
+    mapping = singleMapping ? submissionRing
+                            : mmap(NULL, completionRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_CQ_RING);
+    completionRing = mapping == MAP_FAILED ? NULL : mapping;
+
+    submissionEntriesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    mapping = mmap(NULL, submissionEntriesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQES);
+    submissionEntries = mapping == MAP_FAILED ? NULL : (struct io_uring_sqe*)mapping;
+
+    if (!submissionRing || !completionRing || !submissionEntries)
+    {
+        destroyRing();
+        return false;
+    }
+
+    char* submission = (char*)submissionRing;
+    submissionHead = (unsigned int*)(submission + params.sq_off.head);
+    submissionTail = (unsigned int*)(submission + params.sq_off.tail);
+    submissionMask = (unsigned int*)(submission + params.sq_off.ring_mask);
+    submissionArray = (unsigned int*)(submission + params.sq_off.array);
+
+    char* completion = (char*)completionRing;
+    completionHead = (unsigned int*)(completion + params.cq_off.head);
+    completionTail = (unsigned int*)(completion + params.cq_off.tail);
+    completionMask = (unsigned int*)(completion + params.cq_off.ring_mask);
+    completionEntries = (struct io_uring_cqe*)(completion + params.cq_off.cqes);
+
+    /* The completion ring is twice as large, so it can't overflow while this many are in flight */
+    queueDepth = params.sq_entries;
+    return true;
+}
+
+void AsyncFileReader::destroyRing()
+{
+    if (submissionEntries)
+        munmap(submissionEntries, submissionEntriesSize);
+    if (completionRing && completionRing != submissionRing)
+        munmap(completionRing, completionRingSize);
+    if (submissionRing)
+        munmap(submissionRing, submissionRingSize);
+    if (ring >= 0)
+        ::close(ring);
+
+    submissionRing = completionRing = NULL;
+    submissionEntries = NULL;
+    ring = -1;
+}
+
+void AsyncFileReader::submitQueued()
+{
+    while (!queue.empty() && inFlight < queueDepth && pushEntry(IORING_OP_READV, queue.front()))
+    {
+        queue.pop_front();
+        ++inFlight;
+    }
+
+    /* Everything the kernel hasn't consumed yet, including entries a busy ring turned away before */
+    unsigned int pending = *submissionTail - __atomic_load_n(submissionHead, __ATOMIC_ACQUIRE);
+    while (pending > 0)
+    {
+        int submitted = (int)syscall(__NR_io_uring_enter, ring, pending, 0, 0, NULL, 0);
+        if (submitted < 0 && errno == EINTR)
+            continue;
+
+        /* EAGAIN and EBUSY leave the entries in the ring, the next completion submits them again */
+        if (submitted < 0 && errno != EAGAIN && errno != EBUSY)
+            std::cout << "ERROR: AsyncFileReader -> io_uring_enter failed: " << strerror(errno) << std::endl;
+        break;
+    }
+}
+
+bool AsyncFileReader::pushEntry(const uint8_t opcode, PendingRead* read)
+{
+    /* Only this side writes the tail, under the mutex */
+    unsigned int tail = *submissionTail;
+    if (tail - __atomic_load_n(submissionHead, __ATOMIC_ACQUIRE) > *submissionMask)
+        return false;
+
+    unsigned int index = tail & *submissionMask;
+    struct io_uring_sqe* entry = &submissionEntries[index];
+    memset(entry, 0, sizeof(*entry));
+    entry->opcode = opcode;
+    entry->fd = -1;
+    entry->user_data = (uint64_t)(uintptr_t)read;
+
+    /* READV rather than READ works on every kernel that has io_uring at all */
+    if (read)
+    {
+        read->vector.iov_base = (char*)read->request.buffer + read->done;
+        read->vector.iov_len = read->request.size - read->done;
+
+        entry->fd = read->request.file;
+        entry->addr = (uint64_t)(uintptr_t)&read->vector;
+        entry->len = 1;
+        entry->off = read->request.offset + read->done;
+    }
+
+    submissionArray[index] = index;
+    __atomic_store_n(submissionTail, tail + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+void AsyncFileReader::completionLoop()
+{
+    std::vector<std::pair<PendingRead*, int>> reaped;
+    std::vector<PendingRead*> resubmit;
+    bool stopping = false;
+
+    while (!stopping)
+    {
+        if (syscall(__NR_io_uring_enter, ring, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0) < 0 && errno != EINTR)
+        {
+            std::cout << "ERROR: AsyncFileReader -> Waiting for completions failed: " << strerror(errno) << std::endl;
+            return;
+        }
+
+        reaped.clear();
+        resubmit.clear();
+
+        unsigned int head = *completionHead;
+        unsigned int tail = __atomic_load_n(completionTail, __ATOMIC_ACQUIRE);
+        for (; head != tail; ++head)
+        {
+            const struct io_uring_cqe &entry = completionEntries[head & *completionMask];
+            reaped.push_back(std::make_pair((PendingRead*)(uintptr_t)entry.user_data, entry.res));
+        }
+        __atomic_store_n(completionHead, head, __ATOMIC_RELEASE);
+
+        if (reaped.empty())
+            continue;
+
+        PROFILE_SCOPE("AsyncFileReader completions");
+
+        unsigned int finished = 0;
+        for (const std::pair<PendingRead*, int> &completion : reaped)
+        {
+            PendingRead* read = completion.first;
+            int result = completion.second;
+            if (!read)
+            {
+                stopping = true;
+                continue;
+            }
+
+            ++finished;
+
+            /* Interrupted and short reads carry on where they stopped, zero bytes means the end of the file */
+            if (result == -EINTR || result == -EAGAIN)
+                resubmit.push_back(read);
+            else if (result > 0 && read->done + result < read->request.size)
+            {
+                read->done += result;
+                resubmit.push_back(read);
+            }
+            else
+                complete(read, result < 0 ? result : (int64_t)(read->done + result));
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        inFlight -= finished;
+        queue.insert(queue.begin(), resubmit.begin(), resubmit.end());
+        submitQueued();
+
+        if (queue.empty() && inFlight == 0)
+            idleCondition.notify_all();
+    }
+}
+#endif
+
+void AsyncFileReader::fallbackLoop()
+{
+    while (true)
+    {
+        PendingRead* read;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            queueCondition.wait(lock, [this]() { return !running || (!queue.empty() && inFlight < queueDepth); });
+            if (queue.empty())
+                return;
+
+            read = queue.front();
+            queue.pop_front();
+            ++inFlight;
+        }
+
+        complete(read, readBlocking(read));
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--inFlight == 0 && queue.empty())
+            idleCondition.notify_all();
+
+        /* A slot opened up for a worker held back by the queue depth */
+        if (!queue.empty())
+            queueCondition.notify_one();
+    }
+}
+
+int64_t AsyncFileReader::readBlocking(PendingRead* read)
+{
+    PROFILE_SCOPE("AsyncFileReader read");
+
+    const FileReadRequest &request = read->request;
+    char* buffer = (char*)request.buffer;
+
+#if defined(ASYNC_FILE_POSIX)
+    while (read->done < request.size)
+    {
+        ssize_t bytes = pread(request.file, buffer + read->done, request.size - read->done, (off_t)(request.offset + read->done));
+        if (bytes < 0 && errno == EINTR)
+            continue;
+        if (bytes < 0)
+            return -errno;
+        if (bytes == 0)
+            break;
+
+        read->done += bytes;
+    }
+#else
+    std::lock_guard<std::mutex> lock(fileMutex);
+    FILE* file = request.file >= 0 && (size_t)request.file < files.size() ? files[request.file] : NULL;
+#if defined(_WIN32)
+    bool positioned = file && _fseeki64(file, (int64_t)request.offset, SEEK_SET) == 0;
+#else
+    bool positioned = file && fseek(file, (long)request.offset, SEEK_SET) == 0;
+#endif
+    if (!positioned)
+        return -EINVAL;
+
+    read->done = fread(buffer, 1, request.size, file);
+    if (ferror(file))
+        return -EIO;
+#endif
+
+    return (int64_t)read->done;
+}
+
+void AsyncFileReader::complete(PendingRead* read, const int64_t result)
+{
+    FileReadCallback callback = std::move(read->request.onComplete);
+    JobCounter* counter = read->counter;
+    delete read;
+
+    /* The job takes over the read's count before it's released */
+    jobSystem.run([callback, result]() { if (callback) callback(result); }, counter);
+    if (counter)
+        counter->fetch_sub(1);
+}
@@ -0,0 +1,186 @@
+#ifndef ASYNC_FILE_READER
+#define ASYNC_FILE_READER
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+#include <iostream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define ASYNC_FILE_POSIX
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+/* Talks to the kernel interface directly, no liburing needed */
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define ASYNC_FILE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+#endif
+
+#include "../Jobs/jobSystem.h"
+#include "../Profiler/profiler.h"
+
+/* Offsets, sizes and buffers of direct reads have to be multiples of this */
+const size_t DirectIOAlignment = 4096;
+
+/* Bytes read (fewer only at the end of the file), or -errno */
+typedef std::function<void(const int64_t result)> FileReadCallback;
+
+struct FileReadRequest
+{
+    int file;                       /* From AsyncFileReader::openFile */
+    uint64_t offset;
+    size_t size;
+    void* buffer;                   /* Owned by the caller, until the callback has run */
+    FileReadCallback onComplete;
+};
+
+/* Heap memory for direct reads, aligned and with the size rounded up to DirectIOAlignment */
+class IOBuffer
+{
+    public:
+        /* Constructor / Destructor */
+        IOBuffer();
+        explicit IOBuffer(const size_t size);
+        ~IOBuffer();
+
+        IOBuffer(const IOBuffer&) = delete;
+        IOBuffer &operator=(const IOBuffer&) = delete;
+        IOBuffer(IOBuffer &&other);
+        IOBuffer &operator=(IOBuffer &&other);
+
+        unsigned char* data() const;
+        size_t size() const;
+
+    private:
+        unsigned char* bytes;
+        size_t length;
+};
+
+/*  Asynchronous file reads that hand their completions to the job system.
+
+    On Linux reads go through an io_uring: every batch passed to read() is submitted with
+    a single system call and one thread reaps completions for all of them, so a handful of
+    threads keep many requests in flight. Elsewhere, or where the kernel refuses to set up
+    a ring (old kernels, seccomp filtered containers), a small pool of threads blocks in
+    pread instead. Either way each request's callback then runs as a job, which is where
+    decompression and decoding belong.
+
+    Requests beyond the queue depth wait in a FIFO until earlier ones complete, on the ring
+    and the thread pool alike, so a pool with more threads than the depth leaves the extra
+    ones idle. Short reads are resumed, so a callback only sees fewer bytes than asked for
+    at the end of the file. */
+class AsyncFileReader
+{
+    public:
+        /* Constructor / Destructor. The destructor waits for every queued read */
+        AsyncFileReader(JobSystem &jobSystem, const unsigned int queueDepth = 64, const unsigned int fallbackThreads = 4);
+        ~AsyncFileReader();
+
+        AsyncFileReader(const AsyncFileReader&) = delete;
+        AsyncFileReader &operator=(const AsyncFileReader&) = delete;
+
+        /*  -1 if the file can't be opened. Direct descriptors bypass the page cache (O_DIRECT),
+            for large pack files read once; filesystems without support get a buffered one */
+        int openFile(const char* path, const bool direct = false);
+        void closeFile(const int file);
+
+        /* -1 on error */
+        int64_t getFileSize(const int file);
+
+        /* Queues the requests as one batch. The counter, if any, stays above zero until every callback has returned */
+        void read(std::vector<FileReadRequest> requests, JobCounter* counter = NULL);
+
+        /* Whole file into memory, onLoaded gets NULL if it can't be read. Runs as a job like read() callbacks */
+        void readFile(const char* path, std::function<void(const unsigned char* data, const size_t size)> onLoaded, JobCounter* counter = NULL);
+
+        bool isUsingIoUring() const;
+
+    private:
+        struct PendingRead
+        {
+            FileReadRequest request;
+            size_t done;
+            JobCounter* counter;
+#if defined(ASYNC_FILE_POSIX)
+            struct iovec vector;
+#endif
+        };
+
+        JobSystem &jobSystem;
+
+        std::mutex mutex;
+        std::condition_variable queueCondition;
+        std::condition_variable idleCondition;
+        std::deque<PendingRead*> queue;
+        unsigned int inFlight;
+        unsigned int queueDepth;        /* Reads in flight at once, rounded up by the kernel for a ring */
+        bool running;
+
+        std::vector<std::thread> fallbackWorkers;
+
+#if defined(ASYNC_FILE_IO_URING)
+        int ring;
+
+        void* submissionRing;
+        void* completionRing;
+        size_t submissionRingSize;
+        size_t completionRingSize;
+        struct io_uring_sqe* submissionEntries;
+        size_t submissionEntriesSize;
+
+        unsigned int* submissionHead;
+        unsigned int* submissionTail;
+        unsigned int* submissionMask;
+        unsigned int* submissionArray;
+        unsigned int* completionHead;
+        unsigned int* completionTail;
+        unsigned int* completionMask;
+        struct io_uring_cqe* completionEntries;
+
+        std::thread completionThread;
+
+        bool setupRing(const unsigned int entries);
+        void destroyRing();
+
+        /* With mutex held: moves queued reads into the ring up to the queue depth */
+        void submitQueued();
+        bool pushEntry(const uint8_t opcode, PendingRead* read);
+        void completionLoop();
+#endif
+
+#if !defined(ASYNC_FILE_POSIX)
+        /* Without descriptors files are stdio streams, read one at a time */
+        std::vector<FILE*> files;
+        std::mutex fileMutex;
+#endif
+
+        void fallbackLoop();
+
+        /* Blocking read of whatever the request has left, result as for callbacks */
+        int64_t readBlocking(PendingRead* read);
+
+        /* Hands the callback to the job system and releases the read */
+        void complete(PendingRead* read, const int64_t result);
+};
+
+#endif
@@ -0,0 +1,240 @@
+#include "headlessContext.h"
+
+/* Constructor */
+HeadlessContext::HeadlessContext(const int width, const int height)
+    : width { width }
+    , height { height }
+    , display { EGL_NO_DISPLAY }
+    , context { EGL_NO_CONTEXT }
+    , surface { EGL_NO_SURFACE }
+    , framebuffer { 0 }
+    , colorTarget { 0 }
+    , depthTarget { 0 }
+    , valid { false }
+{
+    if (!createDisplay() || !createContext())
+        return;
+
+    if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress))
+    {
+        std::cout << "ERROR: HeadlessContext -> Unable to load OpenGL functions" << std::endl;
+        return;
+    }
+
+    valid = createFramebuffer();
+}
+
+HeadlessContext::~HeadlessContext()
+{
+    if (display == EGL_NO_DISPLAY)
+        return;
+
+    if (framebuffer)
+    {
+        glDeleteFramebuffers(1, &framebuffer);
+        glDeleteRenderbuffers(1, &colorTarget);
+        glDeleteRenderbuffers(1, &depthTarget);
+    }
+
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+
+    if (surface != EGL_NO_SURFACE)
+        eglDestroySurface(display, surface);
+    if (context != EGL_NO_CONTEXT)
+        eglDestroyContext(display, context);
+
+    eglTerminate(display);
+}
+
+bool HeadlessContext::isValid() const
+{
+    return valid;
+}
+
+uint32_t HeadlessContext::getFramebuffer() const
+{
+    return framebuffer;
+}
+
+int HeadlessContext::getWidth() const
+{
+    return width;
+}
+
+int HeadlessContext::getHeight() const
+{
+    return height;
+}
+
+std::vector<unsigned char> HeadlessContext::readPixels() const
+{
+    std::vector<unsigned char> pixels(width * height * 4);
+    if (!valid)
+        return pixels;
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+    /* GL returns the bottom row first */
+    size_t rowSize = width * 4;
+    std::vector<unsigned char> row(rowSize);
+    for (int y = 0; y < height / 2; ++y)
+    {
+        unsigned char* top = pixels.data() + y * rowSize;
+        unsigned char* bottom = pixels.data() + (height - 1 - y) * rowSize;
+        memcpy(row.data(), top, rowSize);
+        memcpy(top, bottom, rowSize);
+        memcpy(bottom, row.data(), rowSize);
+    }
+
+    return pixels;
+}
+
+/* Private */
+bool HeadlessContext::createDisplay()
+{
+    /* Client extensions, queried without a display */
+    const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+
+    if (hasExtension(clientExtensions, "EGL_MESA_platform_surfaceless"))
+    {
+        PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+            (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+
+        if (getPlatformDisplay)
+            display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    }
+
+    if (display == EGL_NO_DISPLAY)
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+    EGLint major, minor;
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor))
+    {
+        std::cout << "ERROR: HeadlessContext -> Unable to initialize an EGL display" << std::endl;
+        display = EGL_NO_DISPLAY;
+        return false;
+    }
+
+    if (!eglBindAPI(EGL_OPENGL_API))
+    {
+        std::cout << "ERROR: HeadlessContext -> EGL display doesn't support desktop OpenGL" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool HeadlessContext::createContext()
+{
+    const char* displayExtensions = eglQueryString(display, EGL_EXTENSIONS);
+    bool surfaceless = hasExtension(displayExtensions, "EGL_KHR_surfaceless_context");
+
+    /* The config's surface only matters when falling back to a pbuffer */
+    const EGLint configAttributes[] = {
+        EGL_SURFACE_TYPE, surfaceless ? 0 : EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8,
+        EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE, 8,
+        EGL_NONE
+    };
+
+    EGLConfig config;
+    EGLint configCount = 0;
+    if (!eglChooseConfig(display, configAttributes, &config, 1, &configCount) || configCount == 0)
+    {
+        std::cout << "ERROR: HeadlessContext -> No suitable EGL config" << std::endl;
+        return false;
+    }
+
+    /* Shaders target 4.6, older drivers (e.g. llvmpipe before Mesa 24) stop at 4.5 */
+    const EGLint versions[][2] = { { 4, 6 }, { 4, 5 } };
+    for (const EGLint* version : versions)
+    {
+        const EGLint contextAttributes[] = {
+            EGL_CONTEXT_MAJOR_VERSION, version[0],
+            EGL_CONTEXT_MINOR_VERSION, version[1],
+            EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+            EGL_NONE
+        };
+
+        context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+        if (context != EGL_NO_CONTEXT)
+        {
+            if (version[1] != 6)
+                std::cout << "WARNING: HeadlessContext -> Only OpenGL " << version[0] << "." << version[1]
+                          << " is available" << std::endl;
+            break;
+        }
+    }
+
+    if (context == EGL_NO_CONTEXT)
+    {
+        std::cout << "ERROR: HeadlessContext -> Unable to create an OpenGL 4.5+ core context" << std::endl;
+        return false;
+    }
+
+    if (!surfaceless)
+    {
+        const EGLint surfaceAttributes[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+        surface = eglCreatePbufferSurface(display, config, surfaceAttributes);
+        if (surface == EGL_NO_SURFACE)
+        {
+            std::cout << "ERROR: HeadlessContext -> Unable to create a pbuffer surface" << std::endl;
+            return false;
+        }
+    }
+
+    if (!eglMakeCurrent(display, surface, surface, context))
+    {
+        std::cout << "ERROR: HeadlessContext -> Unable to make the context current" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool HeadlessContext::createFramebuffer()
+{
+    glGenRenderbuffers(1, &colorTarget);
+    glBindRenderbuffer(GL_RENDERBUFFER, colorTarget);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+    glGenRenderbuffers(1, &depthTarget);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthTarget);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorTarget);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthTarget);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cout << "ERROR: HeadlessContext -> Offscreen framebuffer is incomplete" << std::endl;
+        return false;
+    }
+
+    glViewport(0, 0, width, height);
+    return true;
+}
+
+bool HeadlessContext::hasExtension(const char* extensions, const char* name)
+{
+    if (!extensions)
+        return false;
+
+    /* Space separated list, match whole names only */
+    size_t length = strlen(name);
+    for (const char* start = strstr(extensions, name); start; start = strstr(start + 1, name))
+    {
+        bool startsWord = start == extensions || start[-1] == ' ';
+        bool endsWord = start[length] == ' ' || start[length] == '\0';
+        if (startsWord && endsWord)
+            return true;
+    }
+
+    return false;
+}
@@ -0,0 +1,61 @@
+#ifndef HEADLESS_CONTEXT
+#define HEADLESS_CONTEXT
+
+#include <glad/glad.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <iostream>
+
+/*  OpenGL context without a window, for running on machines with no display such as CI
+    runners. Works on any EGL driver, including Mesa's llvmpipe without a GPU.
+
+    The Mesa surfaceless platform is used when available, otherwise the default display.
+    The context is made current without a surface if EGL_KHR_surfaceless_context is
+    supported, else with a 1x1 pbuffer nobody draws to. Frames are rendered into an
+    offscreen framebuffer owned by the context, bind getFramebuffer() instead of 0.
+
+    The constructor makes the context current and loads the GL entry points, the
+    context must then only be used from the creating thread. Link with -lEGL. */
+class HeadlessContext
+{
+    public:
+        /* Constructor / Destructor */
+        HeadlessContext(const int width, const int height);
+        ~HeadlessContext();
+
+        HeadlessContext(const HeadlessContext&) = delete;
+        HeadlessContext &operator=(const HeadlessContext&) = delete;
+
+        bool isValid() const;
+
+        uint32_t getFramebuffer() const;
+        int getWidth() const;
+        int getHeight() const;
+
+        /* Waits for rendering to finish and copies the color target out as RGBA8, top row first */
+        std::vector<unsigned char> readPixels() const;
+
+    private:
+        int width, height;
+
+        EGLDisplay display;
+        EGLContext context;
+        EGLSurface surface;
+
+        uint32_t framebuffer;
+        uint32_t colorTarget;
+        uint32_t depthTarget;
+
+        bool valid;
+
+        bool createDisplay();
+        bool createContext();
+        bool createFramebuffer();
+
+        static bool hasExtension(const char* extensions, const char* name);
+};
+
+#endif
@@ -0,0 +1,149 @@
+#include "mappedFile.h"
+
+/* Constructor / Destructor */
+MappedFile::MappedFile()
+    : bytes { nullptr }
+    , length { 0 }
+    , mapped { false }
+    , valid { false }
+{
+}
+
+MappedFile::MappedFile(const char* path)
+    : MappedFile()
+{
+    open(path);
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+MappedFile::MappedFile(MappedFile &&other)
+    : MappedFile()
+{
+    *this = std::move(other);
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other)
+{
+    if (this == &other)
+        return *this;
+
+    close();
+
+    bytes = other.bytes;
+    length = other.length;
+    mapped = other.mapped;
+    valid = other.valid;
+    buffer.swap(other.buffer);
+
+    other.bytes = nullptr;
+    other.length = 0;
+    other.mapped = false;
+    other.valid = false;
+
+    return *this;
+}
+
+/* Public */
+bool MappedFile::open(const char* path)
+{
+    close();
+
+#if defined(MAPPED_FILE_MMAP)
+    int descriptor = ::open(path, O_RDONLY);
+    if (descriptor < 0)
+    {
+        std::cout << "ERROR: MappedFile -> Unable to open " << path << std::endl;
+        return false;
+    }
+
+    struct stat status;
+    if (fstat(descriptor, &status) != 0)
+    {
+        std::cout << "ERROR: MappedFile -> Unable to query the size of " << path << std::endl;
+        ::close(descriptor);
+        return false;
+    }
+
+    length = (size_t)status.st_size;
+
+    /* Zero length mappings are invalid, an empty file is simply an empty view */
+    if (length > 0)
+    {
+        void* address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if (address == MAP_FAILED)
+        {
+            std::cout << "ERROR: MappedFile -> Unable to map " << path << std::endl;
+            ::close(descriptor);
+            length = 0;
+            return false;
+        }
+
+        bytes = (const char*)address;
+        mapped = true;
+    }
+
+    /* The mapping keeps its own reference to the file */
+    ::close(descriptor);
+#else
+    FILE* file = fopen(path, "rb");
+    if (!file)
+    {
+        std::cout << "ERROR: MappedFile -> Unable to open " << path << std::endl;
+        return false;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long fileSize = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    buffer.resize(fileSize > 0 ? (size_t)fileSize : 0);
+    length = fread(buffer.data(), 1, buffer.size(), file);
+    fclose(file);
+
+    bytes = buffer.data();
+#endif
+
+    valid = true;
+    return true;
+}
+
+void MappedFile::close()
+{
+#if defined(MAPPED_FILE_MMAP)
+    if (mapped)
+        munmap((void*)bytes, length);
+#endif
+
+    bytes = nullptr;
+    length = 0;
+    mapped = false;
+    valid = false;
+    std::vector<char>().swap(buffer);
+}
+
+bool MappedFile::isValid() const
+{
+    return valid;
+}
+
+const char* MappedFile::data() const
+{
+    return bytes;
+}
+
+size_t MappedFile::size() const
+{
+    return length;
+}
+
+void MappedFile::adviseSequential() const
+{
+#if defined(MAPPED_FILE_MMAP)
+    if (mapped)
+        madvise((void*)bytes, length, MADV_SEQUENTIAL);
+#endif
+}
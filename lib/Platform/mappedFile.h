@@ -0,0 +1,58 @@
+#ifndef MAPPED_FILE
+#define MAPPED_FILE
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <utility>
+#include <iostream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define MAPPED_FILE_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#else
+#include <cstdio>
+#endif
+
+/*  Read only view of a whole file. Mapped into memory where mmap is available, so large
+    assets are paged in by the OS as they are touched instead of copied through a read
+    buffer, otherwise read into memory once.
+
+    The view stays valid until the MappedFile is destroyed or moved from. */
+class MappedFile
+{
+    public:
+        /* Constructor / Destructor */
+        MappedFile();
+        MappedFile(const char* path);
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile &operator=(const MappedFile&) = delete;
+        MappedFile(MappedFile &&other);
+        MappedFile &operator=(MappedFile &&other);
+
+        /* Unmaps the current file first, false if the new one can't be opened */
+        bool open(const char* path);
+        void close();
+
+        bool isValid() const;
+        const char* data() const;
+        size_t size() const;
+
+        /* Tells the OS the file will be read front to back, a hint only */
+        void adviseSequential() const;
+
+    private:
+        const char* bytes;
+        size_t length;
+
+        bool mapped;
+        bool valid;
+        std::vector<char> buffer;   /* Holds the contents when mmap isn't used */
+};
+
+#endif
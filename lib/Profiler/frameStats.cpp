@@ -0,0 +1,40 @@
+#include "frameStats.h"
+
+FrameTimeStats computeFrameTimeStats(std::vector<double> frameTimes)
+{
+    FrameTimeStats stats = { 0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+    if (frameTimes.empty())
+        return stats;
+
+    std::sort(frameTimes.begin(), frameTimes.end());
+
+    stats.frames = frameTimes.size();
+    for (double time : frameTimes)
+        stats.total += time;
+
+    /* Nearest rank: the smallest time with at least p% of the frames at or below it. Multiplying
+       before dividing keeps exact ranks like 90% of 10 frames from rounding up past 9 */
+    auto percentile = [&](const double p)
+    {
+        size_t rank = (size_t)ceil(p * frameTimes.size() / 100.0);
+        return frameTimes[std::min(std::max(rank, (size_t)1), frameTimes.size()) - 1];
+    };
+
+    stats.min = frameTimes.front();
+    stats.max = frameTimes.back();
+    stats.mean = stats.total / stats.frames;
+    stats.p50 = percentile(50.0);
+    stats.p90 = percentile(90.0);
+    stats.p95 = percentile(95.0);
+    stats.p99 = percentile(99.0);
+
+    return stats;
+}
+
+void printFrameTimeStats(const char* label, const FrameTimeStats &stats)
+{
+    printf("%s: %u frames in %.1f ms (%.1f fps)\n", label, stats.frames, stats.total,
+           stats.total > 0.0 ? stats.frames * 1000.0 / stats.total : 0.0);
+    printf("    min %.3f  mean %.3f  p50 %.3f  p90 %.3f  p95 %.3f  p99 %.3f  max %.3f ms\n",
+           stats.min, stats.mean, stats.p50, stats.p90, stats.p95, stats.p99, stats.max);
+}
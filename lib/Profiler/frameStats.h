@@ -0,0 +1,24 @@
+#ifndef FRAME_STATS
+#define FRAME_STATS
+
+#include <cstdint>
+#include <cstdio>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+/* Summary of a run's frame times, all in milliseconds */
+struct FrameTimeStats
+{
+    uint32_t frames;
+    double total;
+    double min, mean, max;
+    double p50, p90, p95, p99;
+};
+
+/* Percentiles use the nearest rank, so they are always times that actually occurred */
+FrameTimeStats computeFrameTimeStats(std::vector<double> frameTimes);
+
+void printFrameTimeStats(const char* label, const FrameTimeStats &stats);
+
+#endif
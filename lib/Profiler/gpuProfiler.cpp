@@ -0,0 +1,139 @@
+#include "gpuProfiler.h"
+
+/* Constructor */
+GpuProfiler::GpuProfiler(const uint32_t maxScopesPerFrame, const uint32_t latency)
+    : maxScopesPerFrame { maxScopesPerFrame }
+    , frames(latency + 1)
+    , frameIndex { 0 }
+    , skippedFrames { 0 }
+    , lastFrameTime { 0.0 }
+{
+    queries.resize(frames.size() * maxScopesPerFrame * 2);
+    glGenQueries(queries.size(), queries.data());
+
+    for (Frame &frame : frames)
+    {
+        frame.scopes.reserve(maxScopesPerFrame);
+        frame.usedQueries = 0;
+    }
+}
+
+GpuProfiler::~GpuProfiler()
+{
+    glDeleteQueries(queries.size(), queries.data());
+}
+
+void GpuProfiler::beginFrame()
+{
+    if (!openScopes.empty())
+    {
+        std::cout << "ERROR: GpuProfiler -> " << openScopes.size() << " scope(s) left open at the end of the frame" << std::endl;
+        openScopes.clear();
+    }
+
+    frameIndex = (frameIndex + 1) % frames.size();
+
+    /* This slot was recorded frames.size() frames ago, harvest it before reusing its queries */
+    Frame &frame = frames[frameIndex];
+    uint32_t* frameQueries = queries.data() + frameIndex * maxScopesPerFrame * 2;
+
+    if (frame.usedQueries)
+        resolve(frame, frameQueries);
+
+    frame.scopes.clear();
+    frame.usedQueries = 0;
+}
+
+void GpuProfiler::beginScope(CommandList &commands, const char* name)
+{
+    Frame &frame = frames[frameIndex];
+    if (frame.scopes.size() >= maxScopesPerFrame)
+    {
+        /* Still tracked so the matching endScope stays balanced */
+        openScopes.push_back(UINT32_MAX);
+        return;
+    }
+
+    uint32_t* frameQueries = queries.data() + frameIndex * maxScopesPerFrame * 2;
+
+    Scope scope = { name, frame.usedQueries, frame.usedQueries + 1 };
+    frame.usedQueries += 2;
+
+    commands.writeTimestamp(frameQueries[scope.beginQuery]);
+
+    openScopes.push_back(frame.scopes.size());
+    frame.scopes.push_back(scope);
+}
+
+void GpuProfiler::endScope(CommandList &commands)
+{
+    Frame &frame = frames[frameIndex];
+
+    if (openScopes.empty())
+    {
+        std::cout << "ERROR: GpuProfiler -> endScope without a matching beginScope" << std::endl;
+        return;
+    }
+
+    /* Scopes past the per frame limit were never written */
+    if (openScopes.back() == UINT32_MAX)
+    {
+        openScopes.pop_back();
+        return;
+    }
+
+    uint32_t* frameQueries = queries.data() + frameIndex * maxScopesPerFrame * 2;
+
+    commands.writeTimestamp(frameQueries[frame.scopes[openScopes.back()].endQuery]);
+    openScopes.pop_back();
+}
+
+uint64_t GpuProfiler::getSkippedFrameCount() const
+{
+    return skippedFrames;
+}
+
+double GpuProfiler::getLastFrameTime() const
+{
+    return lastFrameTime;
+}
+
+/* Private */
+void GpuProfiler::resolve(Frame &frame, const uint32_t* frameQueries)
+{
+    /* Nested scopes end out of submission order, so every query has to be checked */
+    for (uint32_t i = 0; i < frame.usedQueries; ++i)
+    {
+        GLint available = 0;
+        glGetQueryObjectiv(frameQueries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+        {
+            ++skippedFrames;
+            return;
+        }
+    }
+
+    /* Map GPU time onto the CPU clock. Both are sampled now, the error is the latency of
+       the glGet call, far below the resolution anyone reads a trace at */
+    GLint64 gpuNow = 0;
+    glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+    int64_t offset = (int64_t)Profiler::now() - gpuNow;
+
+    Profiler &profiler = Profiler::instance();
+    for (const Scope &scope : frame.scopes)
+    {
+        GLuint64 begin = 0, end = 0;
+        glGetQueryObjectui64v(frameQueries[scope.beginQuery], GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(frameQueries[scope.endQuery], GL_QUERY_RESULT, &end);
+
+        profiler.recordExternal(scope.name, begin + offset, end + offset, PROFILER_GPU_THREAD);
+    }
+
+    if (!frame.scopes.empty())
+    {
+        GLuint64 begin = 0, end = 0;
+        glGetQueryObjectui64v(frameQueries[frame.scopes[0].beginQuery], GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(frameQueries[frame.scopes[0].endQuery], GL_QUERY_RESULT, &end);
+        lastFrameTime = (end - begin) / 1000000.0;
+    }
+}
@@ -0,0 +1,66 @@
+#ifndef GPU_PROFILER
+#define GPU_PROFILER
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <vector>
+#include <iostream>
+
+#include "profiler.h"
+#include "../Render/commandList.h"
+
+/*  Times sections of command lists on the GPU with GL_TIMESTAMP queries.
+
+    Every frame uses its own set of queries from a pool `latency + 1` frames deep, results
+    are read back when the slot comes around again so the CPU never waits on the GPU. A frame
+    whose results still aren't available by then is skipped rather than stalled on. Resolved
+    scopes are converted to the CPU profiler's clock and reported on the "GPU" track of the
+    trace. Must only be used on the thread that owns the GL context. */
+class GpuProfiler
+{
+    public:
+        /* Constructor */
+        GpuProfiler(const uint32_t maxScopesPerFrame = 64, const uint32_t latency = 3);
+        ~GpuProfiler();
+
+        /* Reads back the oldest frame and starts recording into its queries, call once per frame */
+        void beginFrame();
+
+        /* Scopes nest and must be closed in the order opened, within the same frame */
+        void beginScope(CommandList &commands, const char* name);
+        void endScope(CommandList &commands);
+
+        /* Frames dropped because the GPU was more than `latency` frames behind */
+        uint64_t getSkippedFrameCount() const;
+
+        /* Duration of the outermost scope of the last resolved frame, in milliseconds */
+        double getLastFrameTime() const;
+
+    private:
+        struct Scope
+        {
+            const char* name;
+            uint32_t beginQuery;
+            uint32_t endQuery;
+        };
+
+        struct Frame
+        {
+            std::vector<Scope> scopes;
+            uint32_t usedQueries;
+        };
+
+        uint32_t maxScopesPerFrame;
+        std::vector<uint32_t> queries;      /* maxScopesPerFrame * 2 per frame */
+        std::vector<Frame> frames;
+        uint32_t frameIndex;
+
+        std::vector<uint32_t> openScopes;
+
+        uint64_t skippedFrames;
+        double lastFrameTime;
+
+        void resolve(Frame &frame, const uint32_t* frameQueries);
+};
+
+#endif
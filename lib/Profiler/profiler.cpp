@@ -0,0 +1,192 @@
+#include "profiler.h"
+
+/* Quotes, backslashes and control characters escaped for a JSON string */
+static std::string escapeJson(const char* text)
+{
+    std::string escaped;
+    for (const char* c = text; *c; ++c)
+    {
+        if (*c == '"' || *c == '\\')
+        {
+            escaped += '\\';
+            escaped += *c;
+        }
+        else if ((unsigned char)*c < 0x20)
+        {
+            char code[8];
+            snprintf(code, sizeof(code), "\\u%04x", (unsigned char)*c);
+            escaped += code;
+        }
+        else
+            escaped += *c;
+    }
+
+    return escaped;
+}
+
+Profiler &Profiler::instance()
+{
+    static Profiler profiler;
+    return profiler;
+}
+
+uint64_t Profiler::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/* Constructor */
+Profiler::Profiler()
+    : maxCapturedEvents { 1024 * 1024 }
+    , capturedDropped { 0 }
+{}
+
+void Profiler::record(const char* name, const uint64_t start, const uint64_t end)
+{
+    ThreadBuffer* buffer = getThreadBuffer();
+
+    uint32_t head = buffer->head.load(std::memory_order_relaxed);
+    if (head - buffer->tail.load(std::memory_order_acquire) >= PROFILER_RING_SIZE)
+    {
+        buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    buffer->events[head & (PROFILER_RING_SIZE - 1)] = { name, start, end, buffer->threadID };
+    buffer->head.store(head + 1, std::memory_order_release);
+}
+
+void Profiler::setThreadName(const std::string &name)
+{
+    ThreadBuffer* buffer = getThreadBuffer();
+
+    std::lock_guard<std::mutex> lock(threadsMutex);
+    buffer->name = name;
+}
+
+void Profiler::recordExternal(const char* name, const uint64_t start, const uint64_t end, const uint32_t threadID)
+{
+    std::lock_guard<std::mutex> lock(threadsMutex);
+    externalEvents.push_back({ name, start, end, threadID });
+}
+
+void Profiler::collect()
+{
+    std::lock_guard<std::mutex> lock(threadsMutex);
+
+    for (const std::unique_ptr<ThreadBuffer> &buffer : threads)
+    {
+        uint32_t tail = buffer->tail.load(std::memory_order_relaxed);
+        uint32_t head = buffer->head.load(std::memory_order_acquire);
+
+        for (; tail != head; ++tail)
+        {
+            if (captured.size() < maxCapturedEvents)
+                captured.push_back(buffer->events[tail & (PROFILER_RING_SIZE - 1)]);
+            else
+                ++capturedDropped;
+        }
+
+        buffer->tail.store(tail, std::memory_order_release);
+    }
+
+    for (const ProfileEvent &event : externalEvents)
+    {
+        if (captured.size() < maxCapturedEvents)
+            captured.push_back(event);
+        else
+            ++capturedDropped;
+    }
+    externalEvents.clear();
+}
+
+bool Profiler::writeChromeTrace(const std::string &path)
+{
+    collect();
+
+    FILE* file = fopen(path.c_str(), "w");
+    if (!file)
+    {
+        std::cout << "ERROR: Profiler -> Unable to open " << path << std::endl;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(threadsMutex);
+
+    /* Timestamps relative to the first event keep the numbers short */
+    uint64_t origin = UINT64_MAX;
+    for (const ProfileEvent &event : captured)
+        origin = std::min(origin, event.start);
+
+    fprintf(file, "{\"traceEvents\":[\n");
+
+    bool first = true;
+    for (const std::unique_ptr<ThreadBuffer> &buffer : threads)
+    {
+        std::string name = buffer->name.empty() ? "Thread " + std::to_string(buffer->threadID) : buffer->name;
+        fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                first ? "" : ",\n", buffer->threadID, escapeJson(name.c_str()).c_str());
+        first = false;
+    }
+
+    fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"GPU\"}}",
+            first ? "" : ",\n", PROFILER_GPU_THREAD);
+
+    /* Complete events, microseconds with nanosecond fractions */
+    for (const ProfileEvent &event : captured)
+    {
+        fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                escapeJson(event.name).c_str(), event.threadID, (event.start - origin) / 1000.0, (event.end - event.start) / 1000.0);
+    }
+
+    fprintf(file, "\n]}\n");
+    fclose(file);
+
+    uint64_t dropped = capturedDropped;
+    for (const std::unique_ptr<ThreadBuffer> &buffer : threads)
+        dropped += buffer->dropped.load(std::memory_order_relaxed);
+
+    std::cout << "Profiler -> Wrote " << captured.size() << " events to " << path;
+    if (dropped)
+        std::cout << " (" << dropped << " dropped)";
+    std::cout << std::endl;
+
+    captured.clear();
+    return true;
+}
+
+size_t Profiler::getCapturedCount() const
+{
+    return captured.size();
+}
+
+uint64_t Profiler::getDroppedCount() const
+{
+    std::lock_guard<std::mutex> lock(threadsMutex);
+
+    uint64_t dropped = capturedDropped;
+    for (const std::unique_ptr<ThreadBuffer> &buffer : threads)
+        dropped += buffer->dropped.load(std::memory_order_relaxed);
+
+    return dropped;
+}
+
+/* Private */
+Profiler::ThreadBuffer* Profiler::getThreadBuffer()
+{
+    /* Buffers are never freed, a thread exiting leaves its last events for collect() */
+    thread_local ThreadBuffer* buffer = NULL;
+    if (buffer)
+        return buffer;
+
+    std::lock_guard<std::mutex> lock(threadsMutex);
+
+    threads.emplace_back(new ThreadBuffer());
+    buffer = threads.back().get();
+    buffer->head = 0;
+    buffer->tail = 0;
+    buffer->dropped = 0;
+    buffer->threadID = threads.size() - 1;
+
+    return buffer;
+}
@@ -0,0 +1,117 @@
+#ifndef PROFILER
+#define PROFILER
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <iostream>
+
+/* Events each thread can hold before the collector drains them, must be a power of two */
+#define PROFILER_RING_SIZE 16384
+
+/* Pseudo thread the GPU scopes are reported on */
+#define PROFILER_GPU_THREAD 0xFFFFFFFFu
+
+/* One finished scope. Names must outlive the profiler, in practice string literals */
+struct ProfileEvent
+{
+    const char* name;
+    uint64_t start;         /* Nanoseconds on the profiler's clock */
+    uint64_t end;
+    uint32_t threadID;
+};
+
+/*  Collects timed scopes from every thread and exports them as a Chrome trace
+    (chrome://tracing or ui.perfetto.dev).
+
+    Each thread writes into its own single producer, single consumer ring, so recording a
+    scope is two clock reads and a release store with no locks or shared cache lines.
+    collect() drains the rings from one thread, events that don't fit because nobody
+    collected in time are dropped and counted. Only registering a thread takes a lock. */
+class Profiler
+{
+    public:
+        static Profiler &instance();
+
+        /* Monotonic clock shared by CPU and (calibrated) GPU events */
+        static uint64_t now();
+
+        /* Recording, any thread */
+        void record(const char* name, const uint64_t start, const uint64_t end);
+        void setThreadName(const std::string &name);
+
+        /* Events from another clock domain, e.g. resolved GPU queries */
+        void recordExternal(const char* name, const uint64_t start, const uint64_t end, const uint32_t threadID);
+
+        /* Moves pending events of every thread into the capture, call once per frame */
+        void collect();
+
+        /* Writes and clears the capture */
+        bool writeChromeTrace(const std::string &path);
+
+        size_t getCapturedCount() const;
+        uint64_t getDroppedCount() const;
+
+        /* Capture stops growing past this, so forgetting to export can't eat all memory */
+        size_t maxCapturedEvents;
+
+    private:
+        struct ThreadBuffer
+        {
+            ProfileEvent events[PROFILER_RING_SIZE];
+            alignas(64) std::atomic<uint32_t> head;     /* Written by the owning thread */
+            alignas(64) std::atomic<uint32_t> tail;     /* Written by collect() */
+            std::atomic<uint64_t> dropped;
+            uint32_t threadID;
+            std::string name;
+        };
+
+        Profiler();
+
+        mutable std::mutex threadsMutex;
+        std::vector<std::unique_ptr<ThreadBuffer>> threads;
+
+        /* GPU and other external events, only touched under threadsMutex */
+        std::vector<ProfileEvent> externalEvents;
+
+        std::vector<ProfileEvent> captured;
+        uint64_t capturedDropped;
+
+        ThreadBuffer* getThreadBuffer();
+};
+
+/* Times the enclosing block on the calling thread */
+class CpuScope
+{
+    public:
+        CpuScope(const char* name)
+            : name { name }
+            , start { Profiler::now() }
+        {}
+
+        ~CpuScope()
+        {
+            Profiler::instance().record(name, start, Profiler::now());
+        }
+
+    private:
+        const char* name;
+        uint64_t start;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#ifndef DISABLE_PROFILER
+#define PROFILE_SCOPE(name) CpuScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#else
+#define PROFILE_SCOPE(name)
+#endif
+
+#endif
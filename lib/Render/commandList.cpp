@@ -0,0 +1,178 @@
+#include "commandList.h"
+
+/* Constructor */
+CommandList::CommandList()
+    : buffer(64 * 1024)
+    , used { 0 }
+{}
+
+void CommandList::reset()
+{
+    used = 0;
+}
+
+bool CommandList::empty() const
+{
+    return used == 0;
+}
+
+size_t CommandList::size() const
+{
+    return used;
+}
+
+/* Recording */
+void CommandList::bindFramebuffer(const uint32_t framebuffer)
+{
+    push<BindFramebufferCommand>(CommandType::BindFramebuffer)->framebuffer = framebuffer;
+}
+
+void CommandList::clear(const glm::vec4 &color, const bool clearColor, const bool clearDepth)
+{
+    ClearCommand* command = push<ClearCommand>(CommandType::Clear);
+    command->color = color;
+    command->clearColor = clearColor;
+    command->clearDepth = clearDepth;
+}
+
+void CommandList::setViewport(const int x, const int y, const int width, const int height)
+{
+    SetViewportCommand* command = push<SetViewportCommand>(CommandType::SetViewport);
+    command->x = x;
+    command->y = y;
+    command->width = width;
+    command->height = height;
+}
+
+void CommandList::setDepthState(const bool test, const bool write, const DepthFunction function)
+{
+    SetDepthStateCommand* command = push<SetDepthStateCommand>(CommandType::SetDepthState);
+    command->test = test;
+    command->write = write;
+    command->function = function;
+}
+
+void CommandList::setColorMask(const bool write)
+{
+    push<SetColorMaskCommand>(CommandType::SetColorMask)->write = write;
+}
+
+void CommandList::useProgram(const uint32_t program)
+{
+    push<UseProgramCommand>(CommandType::UseProgram)->program = program;
+}
+
+void CommandList::setUniform(const char* name, const int value)
+{
+    pushUniform(CommandType::SetUniformInt, name, value);
+}
+
+void CommandList::setUniform(const char* name, const float value)
+{
+    pushUniform(CommandType::SetUniformFloat, name, value);
+}
+
+void CommandList::setUniform(const char* name, const glm::vec3 &value)
+{
+    pushUniform(CommandType::SetUniformVec3, name, value);
+}
+
+void CommandList::setUniform(const char* name, const glm::vec4 &value)
+{
+    pushUniform(CommandType::SetUniformVec4, name, value);
+}
+
+void CommandList::setUniform(const char* name, const glm::mat3 &value)
+{
+    pushUniform(CommandType::SetUniformMat3, name, value);
+}
+
+void CommandList::setUniform(const char* name, const glm::mat4 &value)
+{
+    pushUniform(CommandType::SetUniformMat4, name, value);
+}
+
+void CommandList::bindTexture(const uint32_t unit, const uint32_t texture, const TextureTarget target)
+{
+    BindTextureCommand* command = push<BindTextureCommand>(CommandType::BindTexture);
+    command->unit = unit;
+    command->texture = texture;
+    command->target = target;
+}
+
+void CommandList::bindVertexArray(const uint32_t vertexArray)
+{
+    push<BindVertexArrayCommand>(CommandType::BindVertexArray)->vertexArray = vertexArray;
+}
+
+void CommandList::bindBufferRange(const BufferTarget target, const uint32_t index, const uint32_t buffer, const uint32_t offset, const uint32_t size)
+{
+    BindBufferRangeCommand* command = push<BindBufferRangeCommand>(CommandType::BindBufferRange);
+    command->target = target;
+    command->index = index;
+    command->buffer = buffer;
+    command->offset = offset;
+    command->size = size;
+}
+
+void CommandList::drawArrays(const PrimitiveType primitive, const uint32_t first, const uint32_t count, const uint32_t instanceCount)
+{
+    DrawArraysCommand* command = push<DrawArraysCommand>(CommandType::DrawArrays);
+    command->primitive = primitive;
+    command->first = first;
+    command->count = count;
+    command->instanceCount = instanceCount;
+}
+
+void CommandList::drawElements(const PrimitiveType primitive, const uint32_t count, const uint32_t firstIndex, const int32_t baseVertex, const uint32_t instanceCount)
+{
+    DrawElementsCommand* command = push<DrawElementsCommand>(CommandType::DrawElements);
+    command->primitive = primitive;
+    command->count = count;
+    command->firstIndex = firstIndex;
+    command->baseVertex = baseVertex;
+    command->instanceCount = instanceCount;
+}
+
+void CommandList::writeTimestamp(const uint32_t query)
+{
+    push<WriteTimestampCommand>(CommandType::WriteTimestamp)->query = query;
+}
+
+void CommandList::append(const CommandList &other)
+{
+    if (used + other.used > buffer.size())
+        buffer.resize(std::max(buffer.size() * 2, used + other.used));
+
+    memcpy(buffer.data() + used, other.buffer.data(), other.used);
+    used += other.used;
+}
+
+/* Iteration */
+const CommandHeader* CommandList::begin() const
+{
+    return (const CommandHeader*)buffer.data();
+}
+
+const CommandHeader* CommandList::next(const CommandHeader* command) const
+{
+    return (const CommandHeader*)((const uint8_t*)command + command->size);
+}
+
+const CommandHeader* CommandList::end() const
+{
+    return (const CommandHeader*)(buffer.data() + used);
+}
+
+/* FNV-1a */
+uint32_t CommandList::hashName(const char* name)
+{
+    uint32_t hash = 2166136261u;
+    for (; *name; ++name)
+    {
+        hash ^= (uint8_t)*name;
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
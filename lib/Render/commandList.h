@@ -0,0 +1,172 @@
+#ifndef COMMAND_LIST
+#define COMMAND_LIST
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+
+/*  API agnostic list of rendering commands recorded for one frame.
+
+    Commands are packed back to back into a single byte buffer so recording is a few
+    stores and no allocations once the buffer has grown to its steady state size.
+    Resources are referenced through opaque handles, the backend replaying the list
+    decides what they map to. */
+
+enum class CommandType : uint32_t
+{
+    BindFramebuffer,
+    Clear,
+    SetViewport,
+    SetDepthState,
+    SetColorMask,
+    UseProgram,
+    SetUniformInt,
+    SetUniformFloat,
+    SetUniformVec3,
+    SetUniformVec4,
+    SetUniformMat3,
+    SetUniformMat4,
+    BindTexture,
+    BindVertexArray,
+    BindBufferRange,
+    DrawArrays,
+    DrawElements,
+    WriteTimestamp
+};
+
+enum class PrimitiveType : uint32_t
+{
+    Triangles,
+    Lines,
+    Points
+};
+
+enum class BufferTarget : uint32_t
+{
+    Uniform,
+    ShaderStorage
+};
+
+enum class TextureTarget : uint32_t
+{
+    Texture2D,
+    Texture2DArray
+};
+
+enum class DepthFunction : uint32_t
+{
+    Less,
+    LessEqual,
+    Equal,
+    Always
+};
+
+#define UNIFORM_NAME_LENGTH 48
+
+struct CommandHeader
+{
+    CommandType type;
+    uint32_t size;      /* Size of the command including this header */
+};
+
+struct BindFramebufferCommand { CommandHeader header; uint32_t framebuffer; };
+struct ClearCommand        { CommandHeader header; glm::vec4 color; bool clearColor; bool clearDepth; };
+struct SetViewportCommand  { CommandHeader header; int x, y, width, height; };
+struct SetDepthStateCommand{ CommandHeader header; bool test; bool write; DepthFunction function; };
+struct SetColorMaskCommand { CommandHeader header; bool write; };
+struct UseProgramCommand   { CommandHeader header; uint32_t program; };
+struct BindTextureCommand  { CommandHeader header; uint32_t unit; uint32_t texture; TextureTarget target; };
+struct BindVertexArrayCommand { CommandHeader header; uint32_t vertexArray; };
+struct BindBufferRangeCommand { CommandHeader header; BufferTarget target; uint32_t index, buffer, offset, size; };
+struct DrawArraysCommand   { CommandHeader header; PrimitiveType primitive; uint32_t first, count, instanceCount; };
+struct DrawElementsCommand { CommandHeader header; PrimitiveType primitive; uint32_t count, firstIndex, instanceCount; int32_t baseVertex; };
+struct WriteTimestampCommand { CommandHeader header; uint32_t query; };
+
+/* Uniforms are addressed by name, the hash lets the backend cache resolved locations */
+template<typename T>
+struct SetUniformCommand
+{
+    CommandHeader header;
+    uint32_t nameHash;
+    char name[UNIFORM_NAME_LENGTH];
+    T value;
+};
+
+class CommandList
+{
+    public:
+        /* Constructor */
+        CommandList();
+
+        /* Discards all commands but keeps the allocated storage */
+        void reset();
+        bool empty() const;
+        size_t size() const;
+
+        /* Recording */
+        void bindFramebuffer(const uint32_t framebuffer);
+        void clear(const glm::vec4 &color, const bool clearColor = true, const bool clearDepth = true);
+        void setViewport(const int x, const int y, const int width, const int height);
+        void setDepthState(const bool test, const bool write, const DepthFunction function = DepthFunction::Less);
+        void setColorMask(const bool write);
+        void useProgram(const uint32_t program);
+        void setUniform(const char* name, const int value);
+        void setUniform(const char* name, const float value);
+        void setUniform(const char* name, const glm::vec3 &value);
+        void setUniform(const char* name, const glm::vec4 &value);
+        void setUniform(const char* name, const glm::mat3 &value);
+        void setUniform(const char* name, const glm::mat4 &value);
+        void bindTexture(const uint32_t unit, const uint32_t texture, const TextureTarget target = TextureTarget::Texture2D);
+        void bindVertexArray(const uint32_t vertexArray);
+        void bindBufferRange(const BufferTarget target, const uint32_t index, const uint32_t buffer, const uint32_t offset, const uint32_t size);
+        void drawArrays(const PrimitiveType primitive, const uint32_t first, const uint32_t count, const uint32_t instanceCount = 1);
+        void drawElements(const PrimitiveType primitive, const uint32_t count, const uint32_t firstIndex = 0, const int32_t baseVertex = 0, const uint32_t instanceCount = 1);
+
+        /* Records the GPU time at which all preceding commands have completed into a timer query */
+        void writeTimestamp(const uint32_t query);
+
+        /* Copies all commands of `other` to the end of this list, used to merge lists recorded on other threads */
+        void append(const CommandList &other);
+
+        /* Iteration, used by backends to replay the list */
+        const CommandHeader* begin() const;
+        const CommandHeader* next(const CommandHeader* command) const;
+        const CommandHeader* end() const;
+
+        static uint32_t hashName(const char* name);
+
+    private:
+        std::vector<uint8_t> buffer;
+        size_t used;
+
+        template<typename T>
+        T* push(const CommandType type)
+        {
+            /* Keep every command 8 byte aligned */
+            size_t size = (sizeof(T) + 7) & ~size_t(7);
+
+            if (used + size > buffer.size())
+                buffer.resize(std::max(buffer.size() * 2, used + size));
+
+            T* command = (T*)(buffer.data() + used);
+            command->header.type = type;
+            command->header.size = size;
+            used += size;
+
+            return command;
+        }
+
+        template<typename T>
+        void pushUniform(const CommandType type, const char* name, const T &value)
+        {
+            SetUniformCommand<T>* command = push<SetUniformCommand<T>>(type);
+            command->nameHash = hashName(name);
+            strncpy(command->name, name, UNIFORM_NAME_LENGTH - 1);
+            command->name[UNIFORM_NAME_LENGTH - 1] = '\0';
+            command->value = value;
+        }
+};
+
+#endif
@@ -0,0 +1,134 @@
+#include "frameRingBuffer.h"
+
+/* Constructor */
+FrameRingBuffer::FrameRingBuffer(const uint32_t frameSize, const uint32_t framesInFlight)
+    : frameSize { frameSize }
+    , framesInFlight { framesInFlight }
+    , currentFrame { 0 }
+    , frameOffset { 0 }
+    , fences(framesInFlight, (GLsync)0)
+{
+    GLint alignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    uniformAlignment = alignment;
+
+    alignment = 256;
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    storageAlignment = alignment;
+
+    /* Keep every segment start aligned for uniform and storage buffer binds */
+    uint32_t segmentAlignment = std::max(uniformAlignment, storageAlignment);
+    this->frameSize = (frameSize + segmentAlignment - 1) / segmentAlignment * segmentAlignment;
+
+    /* Immutable storage that stays mapped for the buffer's lifetime. Coherent mapping means
+       writes become visible to the GPU without explicit flushes */
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    GLsizeiptr totalSize = (GLsizeiptr)this->frameSize * framesInFlight;
+
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glBufferStorage(GL_COPY_WRITE_BUFFER, totalSize, NULL, flags);
+    mapping = (uint8_t*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, totalSize, flags);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    if (!mapping)
+        std::cout << "ERROR: FrameRingBuffer -> Unable to map buffer storage" << std::endl;
+}
+
+FrameRingBuffer::~FrameRingBuffer()
+{
+    for (GLsync fence : fences)
+        if (fence)
+            glDeleteSync(fence);
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    glDeleteBuffers(1, &buffer);
+}
+
+void FrameRingBuffer::beginFrame()
+{
+    currentFrame = (currentFrame + 1) % framesInFlight;
+    frameOffset = 0;
+
+    GLsync fence = fences[currentFrame];
+    if (!fence)
+        return;
+
+    /* Only blocks when the CPU is a full ring of frames ahead of the GPU */
+    GLbitfield waitFlags = 0;
+    while (true)
+    {
+        GLenum result = glClientWaitSync(fence, waitFlags, 1000000);
+        if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED)
+            break;
+
+        if (result == GL_WAIT_FAILED)
+        {
+            std::cout << "ERROR: FrameRingBuffer -> Fence wait failed" << std::endl;
+            break;
+        }
+
+        /* Make sure the fence has actually been submitted before waiting any longer */
+        waitFlags = GL_SYNC_FLUSH_COMMANDS_BIT;
+    }
+
+    glDeleteSync(fence);
+    fences[currentFrame] = 0;
+}
+
+void FrameRingBuffer::endFrame()
+{
+    if (fences[currentFrame])
+        glDeleteSync(fences[currentFrame]);
+
+    fences[currentFrame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+RingAllocation FrameRingBuffer::allocate(const uint32_t size, const uint32_t alignment)
+{
+    uint32_t offset = (frameOffset + alignment - 1) / alignment * alignment;
+
+    if (!mapping || offset + size > frameSize)
+    {
+        std::cout << "FrameRingBuffer -> Frame segment exhausted. Size = " << frameSize << std::endl;
+        return { NULL, buffer, 0, 0 };
+    }
+
+    frameOffset = offset + size;
+
+    uint32_t bufferOffset = currentFrame * frameSize + offset;
+    return { mapping + bufferOffset, buffer, bufferOffset, size };
+}
+
+RingAllocation FrameRingBuffer::allocateUniform(const uint32_t size)
+{
+    return allocate(size, uniformAlignment);
+}
+
+RingAllocation FrameRingBuffer::allocateStorage(const uint32_t size)
+{
+    return allocate(size, storageAlignment);
+}
+
+RingAllocation FrameRingBuffer::push(const void* data, const uint32_t size, const uint32_t alignment)
+{
+    RingAllocation allocation = allocate(size, alignment);
+
+    if (allocation.data)
+        memcpy(allocation.data, data, size);
+
+    return allocation;
+}
+
+uint32_t FrameRingBuffer::getBuffer() const
+{
+    return buffer;
+}
+
+uint32_t FrameRingBuffer::getUsedBytes() const
+{
+    return frameOffset;
+}
@@ -0,0 +1,71 @@
+#ifndef FRAME_RING_BUFFER
+#define FRAME_RING_BUFFER
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+
+/* A sub-range of the ring buffer handed out for the current frame */
+struct RingAllocation
+{
+    void* data;             /* Persistently mapped, write-only CPU pointer */
+    uint32_t buffer;
+    uint32_t offset;
+    uint32_t size;
+};
+
+/*  Persistently mapped buffer for data that changes every frame.
+
+    The buffer is split into one segment per frame in flight. Each frame allocates
+    linearly from its segment, writes straight into mapped GPU memory, and fences the
+    segment when the frame is submitted. Before a segment is reused the CPU waits on its
+    fence, so regions the GPU may still be reading are never overwritten. */
+class FrameRingBuffer
+{
+    public:
+        /* Constructor / Destructor */
+        FrameRingBuffer(const uint32_t frameSize, const uint32_t framesInFlight = 3);
+        ~FrameRingBuffer();
+
+        FrameRingBuffer(const FrameRingBuffer&) = delete;
+        FrameRingBuffer &operator=(const FrameRingBuffer&) = delete;
+
+        /* Waits until the next segment is no longer in use by the GPU, then rewinds it */
+        void beginFrame();
+
+        /* Fences the current segment, call after the frame's draws have been issued */
+        void endFrame();
+
+        /* Returns an allocation with data == NULL if the frame's segment is full */
+        RingAllocation allocate(const uint32_t size, const uint32_t alignment);
+
+        /* Allocation aligned for glBindBufferRange(GL_UNIFORM_BUFFER, ...) */
+        RingAllocation allocateUniform(const uint32_t size);
+
+        /* Allocation aligned for glBindBufferRange(GL_SHADER_STORAGE_BUFFER, ...) */
+        RingAllocation allocateStorage(const uint32_t size);
+
+        /* Allocates and copies in one go */
+        RingAllocation push(const void* data, const uint32_t size, const uint32_t alignment);
+
+        uint32_t getBuffer() const;
+        uint32_t getUsedBytes() const;
+
+    private:
+        uint32_t buffer;
+        uint8_t* mapping;
+
+        uint32_t frameSize;
+        uint32_t framesInFlight;
+        uint32_t currentFrame;
+        uint32_t frameOffset;
+
+        uint32_t uniformAlignment;
+        uint32_t storageAlignment;
+        std::vector<GLsync> fences;
+};
+
+#endif
@@ -0,0 +1,112 @@
+#include "gBuffer.h"
+
+/* Constructor */
+GBuffer::GBuffer(const int width, const int height)
+    : framebuffer { 0 }
+    , albedoSpecular { 0 }
+    , normalShine { 0 }
+    , depth { 0 }
+    , width { width }
+    , height { height }
+{
+    glGenFramebuffers(1, &framebuffer);
+    createAttachments();
+}
+
+GBuffer::~GBuffer()
+{
+    destroyAttachments();
+    glDeleteFramebuffers(1, &framebuffer);
+}
+
+void GBuffer::resize(const int width, const int height)
+{
+    if (width == this->width && height == this->height)
+        return;
+
+    this->width = width;
+    this->height = height;
+
+    destroyAttachments();
+    createAttachments();
+}
+
+void GBuffer::beginGeometryPass(CommandList &commands) const
+{
+    commands.bindFramebuffer(framebuffer);
+    commands.setViewport(0, 0, width, height);
+    commands.setDepthState(true, true, DepthFunction::Less);
+
+    /* Zero normals mark background pixels for the lighting pass */
+    commands.clear(glm::vec4(0.0f), true, true);
+}
+
+void GBuffer::bindTextures(CommandList &commands) const
+{
+    commands.bindTexture(GBUFFER_ALBEDO_SPECULAR_UNIT, albedoSpecular);
+    commands.bindTexture(GBUFFER_NORMAL_SHINE_UNIT, normalShine);
+    commands.bindTexture(GBUFFER_DEPTH_UNIT, depth);
+}
+
+void GBuffer::blitDepth(const uint32_t framebuffer) const
+{
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, this->framebuffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+    glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+}
+
+uint32_t GBuffer::getFramebuffer() const
+{
+    return framebuffer;
+}
+
+int GBuffer::getWidth() const
+{
+    return width;
+}
+
+int GBuffer::getHeight() const
+{
+    return height;
+}
+
+/* Private */
+void GBuffer::createAttachments()
+{
+    /* The lighting pass reads texels 1:1, no filtering or mips needed */
+    auto createTexture = [&](GLenum format, GLenum attachment)
+    {
+        unsigned int texture;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexStorage2D(GL_TEXTURE_2D, 1, format, width, height);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, texture, 0);
+
+        return texture;
+    };
+
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+
+    albedoSpecular = createTexture(GL_RGBA8, GL_COLOR_ATTACHMENT0);
+    normalShine = createTexture(GL_RGBA16F, GL_COLOR_ATTACHMENT1);
+    depth = createTexture(GL_DEPTH_COMPONENT32F, GL_DEPTH_ATTACHMENT);
+
+    GLenum drawBuffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+    glDrawBuffers(2, drawBuffers);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "ERROR: GBuffer -> Framebuffer is incomplete" << std::endl;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void GBuffer::destroyAttachments()
+{
+    unsigned int textures[] = { albedoSpecular, normalShine, depth };
+    glDeleteTextures(3, textures);
+}
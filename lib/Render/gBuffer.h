@@ -0,0 +1,58 @@
+#ifndef G_BUFFER
+#define G_BUFFER
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <iostream>
+
+#include "commandList.h"
+
+/* Texture units the lighting pass expects the G-buffer on, see deferred.frag */
+#define GBUFFER_ALBEDO_SPECULAR_UNIT    0
+#define GBUFFER_NORMAL_SHINE_UNIT       1
+#define GBUFFER_DEPTH_UNIT              2
+
+/*  Geometry buffer for deferred shading.
+
+    Attachment 0 (RGBA8)    rgb = diffuse albedo, a = specular intensity
+    Attachment 1 (RGBA16F)  rgb = world space normal, a = shininess
+    Depth (32F)             sampled by the lighting pass to rebuild positions
+
+    Only core formats are used so the same targets work on Mesa's software drivers. */
+class GBuffer
+{
+    public:
+        /* Constructor */
+        GBuffer(const int width, const int height);
+        ~GBuffer();
+
+        GBuffer(const GBuffer&) = delete;
+        GBuffer &operator=(const GBuffer&) = delete;
+
+        /* Recreates the attachments, call when the framebuffer size changes */
+        void resize(const int width, const int height);
+
+        /* Records binding the G-buffer as the render target and clearing it */
+        void beginGeometryPass(CommandList &commands) const;
+
+        /* Records binding the attachments to the GBUFFER_*_UNIT texture units */
+        void bindTextures(CommandList &commands) const;
+
+        /* Copies the scene depth into `framebuffer` so forward passes can depth test against it.
+           Not a command, must run on the GL thread after the geometry pass was executed */
+        void blitDepth(const uint32_t framebuffer) const;
+
+        uint32_t getFramebuffer() const;
+        int getWidth() const;
+        int getHeight() const;
+
+    private:
+        uint32_t framebuffer;
+        uint32_t albedoSpecular, normalShine, depth;
+        int width, height;
+
+        void createAttachments();
+        void destroyAttachments();
+};
+
+#endif
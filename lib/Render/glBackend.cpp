@@ -0,0 +1,220 @@
+#include "glBackend.h"
+
+/* Constructor */
+GLBackend::GLBackend()
+{
+    invalidateState();
+}
+
+RenderStats GLBackend::execute(const CommandList &commands)
+{
+    PROFILE_SCOPE("GLBackend::execute");
+
+    RenderStats stats = { 0, 0, 0, 0 };
+
+    for (const CommandHeader* command = commands.begin(); command != commands.end(); command = commands.next(command))
+    {
+        switch (command->type)
+        {
+            case CommandType::BindFramebuffer:
+            {
+                glBindFramebuffer(GL_FRAMEBUFFER, ((const BindFramebufferCommand*)command)->framebuffer);
+                break;
+            }
+
+            case CommandType::Clear:
+            {
+                const ClearCommand* clear = (const ClearCommand*)command;
+                glClearColor(clear->color.x, clear->color.y, clear->color.z, clear->color.w);
+                glClear((clear->clearColor ? GL_COLOR_BUFFER_BIT : 0) | (clear->clearDepth ? GL_DEPTH_BUFFER_BIT : 0));
+                break;
+            }
+
+            case CommandType::SetViewport:
+            {
+                const SetViewportCommand* viewport = (const SetViewportCommand*)command;
+                glViewport(viewport->x, viewport->y, viewport->width, viewport->height);
+                break;
+            }
+
+            case CommandType::SetDepthState:
+            {
+                const SetDepthStateCommand* depth = (const SetDepthStateCommand*)command;
+                if (depth->test) glEnable(GL_DEPTH_TEST);
+                else glDisable(GL_DEPTH_TEST);
+                glDepthMask(depth->write ? GL_TRUE : GL_FALSE);
+                glDepthFunc(toGL(depth->function));
+                break;
+            }
+
+            case CommandType::SetColorMask:
+            {
+                GLboolean write = ((const SetColorMaskCommand*)command)->write ? GL_TRUE : GL_FALSE;
+                glColorMask(write, write, write, write);
+                break;
+            }
+
+            case CommandType::UseProgram:
+            {
+                uint32_t program = ((const UseProgramCommand*)command)->program;
+                if (program != currentProgram)
+                {
+                    glUseProgram(program);
+                    currentProgram = program;
+                    ++stats.programChanges;
+                }
+                break;
+            }
+
+            case CommandType::SetUniformInt:
+            {
+                const SetUniformCommand<int>* uniform = (const SetUniformCommand<int>*)command;
+                glUniform1i(getUniformLocation(uniform->nameHash, uniform->name), uniform->value);
+                break;
+            }
+
+            case CommandType::SetUniformFloat:
+            {
+                const SetUniformCommand<float>* uniform = (const SetUniformCommand<float>*)command;
+                glUniform1f(getUniformLocation(uniform->nameHash, uniform->name), uniform->value);
+                break;
+            }
+
+            case CommandType::SetUniformVec3:
+            {
+                const SetUniformCommand<glm::vec3>* uniform = (const SetUniformCommand<glm::vec3>*)command;
+                glUniform3fv(getUniformLocation(uniform->nameHash, uniform->name), 1, &uniform->value[0]);
+                break;
+            }
+
+            case CommandType::SetUniformVec4:
+            {
+                const SetUniformCommand<glm::vec4>* uniform = (const SetUniformCommand<glm::vec4>*)command;
+                glUniform4fv(getUniformLocation(uniform->nameHash, uniform->name), 1, &uniform->value[0]);
+                break;
+            }
+
+            case CommandType::SetUniformMat3:
+            {
+                const SetUniformCommand<glm::mat3>* uniform = (const SetUniformCommand<glm::mat3>*)command;
+                glUniformMatrix3fv(getUniformLocation(uniform->nameHash, uniform->name), 1, GL_FALSE, &uniform->value[0][0]);
+                break;
+            }
+
+            case CommandType::SetUniformMat4:
+            {
+                const SetUniformCommand<glm::mat4>* uniform = (const SetUniformCommand<glm::mat4>*)command;
+                glUniformMatrix4fv(getUniformLocation(uniform->nameHash, uniform->name), 1, GL_FALSE, &uniform->value[0][0]);
+                break;
+            }
+
+            case CommandType::BindTexture:
+            {
+                const BindTextureCommand* bind = (const BindTextureCommand*)command;
+                if (bind->unit < 32 && boundTextures[bind->unit] != bind->texture)
+                {
+                    glActiveTexture(GL_TEXTURE0 + bind->unit);
+                    glBindTexture(bind->target == TextureTarget::Texture2DArray ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D, bind->texture);
+                    boundTextures[bind->unit] = bind->texture;
+                    ++stats.textureBinds;
+                }
+                break;
+            }
+
+            case CommandType::BindVertexArray:
+            {
+                uint32_t vertexArray = ((const BindVertexArrayCommand*)command)->vertexArray;
+                if (vertexArray != currentVertexArray)
+                {
+                    glBindVertexArray(vertexArray);
+                    currentVertexArray = vertexArray;
+                    ++stats.vertexArrayBinds;
+                }
+                break;
+            }
+
+            case CommandType::BindBufferRange:
+            {
+                const BindBufferRangeCommand* bind = (const BindBufferRangeCommand*)command;
+                GLenum target = bind->target == BufferTarget::Uniform ? GL_UNIFORM_BUFFER : GL_SHADER_STORAGE_BUFFER;
+                glBindBufferRange(target, bind->index, bind->buffer, bind->offset, bind->size);
+                break;
+            }
+
+            case CommandType::DrawArrays:
+            {
+                const DrawArraysCommand* draw = (const DrawArraysCommand*)command;
+                glDrawArraysInstanced(toGL(draw->primitive), draw->first, draw->count, draw->instanceCount);
+                ++stats.drawCalls;
+                break;
+            }
+
+            case CommandType::DrawElements:
+            {
+                const DrawElementsCommand* draw = (const DrawElementsCommand*)command;
+                glDrawElementsInstancedBaseVertex(toGL(draw->primitive), draw->count, GL_UNSIGNED_INT,
+                                                  (void*)(sizeof(GLuint) * draw->firstIndex), draw->instanceCount, draw->baseVertex);
+                ++stats.drawCalls;
+                break;
+            }
+
+            case CommandType::WriteTimestamp:
+            {
+                glQueryCounter(((const WriteTimestampCommand*)command)->query, GL_TIMESTAMP);
+                break;
+            }
+        }
+    }
+
+    return stats;
+}
+
+void GLBackend::invalidateState()
+{
+    /* Values no real GL object name can have */
+    currentProgram = UINT32_MAX;
+    currentVertexArray = UINT32_MAX;
+    for (int i = 0; i < 32; ++i)
+        boundTextures[i] = UINT32_MAX;
+}
+
+void GLBackend::invalidateUniformLocations()
+{
+    uniformLocations.clear();
+}
+
+/* Private */
+GLint GLBackend::getUniformLocation(const uint32_t nameHash, const char* name)
+{
+    uint64_t key = ((uint64_t)currentProgram << 32) | nameHash;
+
+    auto cached = uniformLocations.find(key);
+    if (cached != uniformLocations.end())
+        return cached->second;
+
+    GLint location = glGetUniformLocation(currentProgram, name);
+    uniformLocations[key] = location;
+
+    return location;
+}
+
+GLenum GLBackend::toGL(const PrimitiveType primitive)
+{
+    switch (primitive)
+    {
+        case PrimitiveType::Lines:  return GL_LINES;
+        case PrimitiveType::Points: return GL_POINTS;
+        default:                    return GL_TRIANGLES;
+    }
+}
+
+GLenum GLBackend::toGL(const DepthFunction function)
+{
+    switch (function)
+    {
+        case DepthFunction::LessEqual:  return GL_LEQUAL;
+        case DepthFunction::Equal:      return GL_EQUAL;
+        case DepthFunction::Always:     return GL_ALWAYS;
+        default:                        return GL_LESS;
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef GL_BACKEND
+#define GL_BACKEND
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <unordered_map>
+
+#include "commandList.h"
+#include "../Profiler/profiler.h"
+
+/* Counters gathered while replaying a command list */
+struct RenderStats
+{
+    uint32_t drawCalls;
+    uint32_t programChanges;
+    uint32_t textureBinds;
+    uint32_t vertexArrayBinds;
+};
+
+/*  Replays command lists through OpenGL. Must only be used on the thread that owns
+    the GL context. Redundant program, texture and vertex array binds are skipped. */
+class GLBackend
+{
+    public:
+        /* Constructor */
+        GLBackend();
+
+        RenderStats execute(const CommandList &commands);
+
+        /* Forget cached bindings, e.g. after GL state was changed outside the backend */
+        void invalidateState();
+
+        /* Forget cached uniform locations, needed once a program has been relinked */
+        void invalidateUniformLocations();
+
+    private:
+        uint32_t currentProgram;
+        uint32_t currentVertexArray;
+        uint32_t boundTextures[32];
+
+        /* (program, uniform name hash) -> location */
+        std::unordered_map<uint64_t, GLint> uniformLocations;
+
+        GLint getUniformLocation(const uint32_t nameHash, const char* name);
+
+        static GLenum toGL(const PrimitiveType primitive);
+        static GLenum toGL(const DepthFunction function);
+};
+
+#endif
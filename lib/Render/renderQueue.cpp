@@ -0,0 +1,258 @@
+#include "renderQueue.h"
+
+/* Key field widths */
+#define PASS_BITS           4
+#define TRANSLUCENT_BITS    1
+#define PROGRAM_BITS        10
+#define MATERIAL_BITS       12
+#define TEXTURE_SET_BITS    12
+#define DEPTH_BITS          24
+
+#define FIELD_MASK(bits)    ((uint64_t(1) << (bits)) - 1)
+#define PASS_SHIFT          (TRANSLUCENT_BITS + PROGRAM_BITS + MATERIAL_BITS + TEXTURE_SET_BITS + DEPTH_BITS)
+
+/* Constructor */
+RenderQueue::RenderQueue(const float nearPlane, const float farPlane)
+    : nearPlane { nearPlane }
+    , farPlane { farPlane }
+    , depthPrepass { false }
+    , depthOnlyProgram { 0 }
+{}
+
+void RenderQueue::reset()
+{
+    packets.clear();
+    items.clear();
+}
+
+size_t RenderQueue::size() const
+{
+    return items.size();
+}
+
+void RenderQueue::submit(const DrawPacket &packet, const RenderPass pass, const bool translucent, const float viewDepth)
+{
+    if (depthPrepass && depthOnlyProgram && pass == RenderPass::Opaque && !translucent)
+    {
+        /* Untextured copy, all depth-only draws share one state bucket and sort front to back */
+        DrawPacket depthPacket = packet;
+        depthPacket.program = depthOnlyProgram;
+        depthPacket.diffuseMap = 0;
+        depthPacket.specularMap = 0;
+        depthPacket.material = 0;
+
+        pushItem(depthPacket, RenderPass::DepthPrepass, false, viewDepth);
+    }
+
+    pushItem(packet, pass, translucent, viewDepth);
+}
+
+void RenderQueue::sort()
+{
+    PROFILE_SCOPE("RenderQueue::sort");
+
+    size_t count = items.size();
+    if (count < 2)
+        return;
+
+    scratch.resize(count);
+
+    /* Bytes that are identical across all keys can't change the order */
+    uint64_t keyOr = 0, keyAnd = ~uint64_t(0);
+    for (const SortItem &item : items)
+    {
+        keyOr |= item.key;
+        keyAnd &= item.key;
+    }
+    uint64_t varyingBits = keyOr ^ keyAnd;
+
+    SortItem* source = items.data();
+    SortItem* destination = scratch.data();
+
+    for (int shift = 0; shift < 64; shift += 8)
+    {
+        if (((varyingBits >> shift) & 0xFF) == 0)
+            continue;
+
+        uint32_t offsets[256] = { 0 };
+        for (size_t i = 0; i < count; ++i)
+            ++offsets[(source[i].key >> shift) & 0xFF];
+
+        uint32_t total = 0;
+        for (int bucket = 0; bucket < 256; ++bucket)
+        {
+            uint32_t bucketCount = offsets[bucket];
+            offsets[bucket] = total;
+            total += bucketCount;
+        }
+
+        /* Stable scatter keeps the order established by the lower bytes */
+        for (size_t i = 0; i < count; ++i)
+            destination[offsets[(source[i].key >> shift) & 0xFF]++] = source[i];
+
+        std::swap(source, destination);
+    }
+
+    if (source != items.data())
+        items.swap(scratch);
+}
+
+void RenderQueue::record(CommandList &commands) const
+{
+    uint32_t program = UINT32_MAX, vertexArray = UINT32_MAX;
+    uint32_t diffuseMap = UINT32_MAX, specularMap = UINT32_MAX, material = UINT32_MAX;
+
+    bool hasPrepass = !items.empty() && (RenderPass)(items.front().key >> PASS_SHIFT) == RenderPass::DepthPrepass;
+    uint32_t pass = UINT32_MAX;
+
+    for (const SortItem &item : items)
+    {
+        const DrawPacket &packet = packets[item.packet];
+
+        uint32_t itemPass = (uint32_t)(item.key >> PASS_SHIFT);
+        if (itemPass != pass)
+        {
+            recordPassState(commands, (RenderPass)itemPass, hasPrepass);
+            pass = itemPass;
+        }
+
+        /* Depth-only passes need no textures or normals */
+        bool depthOnly = itemPass == (uint32_t)RenderPass::DepthPrepass || itemPass == (uint32_t)RenderPass::Shadow;
+
+        if (packet.program != program)
+        {
+            commands.useProgram(packet.program);
+            program = packet.program;
+
+            /* Uniforms belong to the program, a new one needs the material set again */
+            material = UINT32_MAX;
+        }
+
+        if (!depthOnly && packet.material != 0 && packet.material != material)
+        {
+            commands.setUniform("material.shine", packet.shine);
+            material = packet.material;
+        }
+
+        if (!depthOnly && packet.diffuseMap != diffuseMap)
+        {
+            commands.bindTexture(0, packet.diffuseMap);
+            diffuseMap = packet.diffuseMap;
+        }
+
+        if (!depthOnly && packet.specularMap != specularMap)
+        {
+            commands.bindTexture(1, packet.specularMap);
+            specularMap = packet.specularMap;
+        }
+
+        if (packet.vertexArray != vertexArray)
+        {
+            commands.bindVertexArray(packet.vertexArray);
+            vertexArray = packet.vertexArray;
+        }
+
+        commands.setUniform("model", packet.model);
+        if (!depthOnly)
+            commands.setUniform("normalMatrix", packet.normalMatrix);
+
+        if (packet.indexed)
+            commands.drawElements(PrimitiveType::Triangles, packet.count, packet.first);
+        else
+            commands.drawArrays(PrimitiveType::Triangles, packet.first, packet.count);
+    }
+
+    /* Leave depth writes on, glClear respects the depth mask */
+    if (hasPrepass)
+        commands.setDepthState(true, true, DepthFunction::Less);
+}
+
+/* Private */
+void RenderQueue::pushItem(const DrawPacket &packet, const RenderPass pass, const bool translucent, const float viewDepth)
+{
+    uint64_t program = internProgram(packet.program) & FIELD_MASK(PROGRAM_BITS);
+    uint64_t material = packet.material & FIELD_MASK(MATERIAL_BITS);
+    uint64_t textureSet = internTextureSet(packet.diffuseMap, packet.specularMap) & FIELD_MASK(TEXTURE_SET_BITS);
+    uint64_t depth = quantizeDepth(viewDepth);
+
+    uint64_t key = (uint64_t)pass & FIELD_MASK(PASS_BITS);
+    key = (key << TRANSLUCENT_BITS) | (translucent ? 1 : 0);
+
+    if (!translucent)
+    {
+        /* State first, then front to back */
+        key = (key << PROGRAM_BITS) | program;
+        key = (key << MATERIAL_BITS) | material;
+        key = (key << TEXTURE_SET_BITS) | textureSet;
+        key = (key << DEPTH_BITS) | depth;
+    }
+    else
+    {
+        /* Back to front first, blending order matters more than state changes */
+        key = (key << DEPTH_BITS) | (FIELD_MASK(DEPTH_BITS) - depth);
+        key = (key << PROGRAM_BITS) | program;
+        key = (key << MATERIAL_BITS) | material;
+        key = (key << TEXTURE_SET_BITS) | textureSet;
+    }
+
+    items.push_back({ key, (uint32_t)packets.size() });
+    packets.push_back(packet);
+}
+
+void RenderQueue::recordPassState(CommandList &commands, const RenderPass pass, const bool hasPrepass) const
+{
+    /* Without a pre-pass the queue keeps whatever depth state the caller set up */
+    if (!hasPrepass)
+        return;
+
+    if (pass == RenderPass::DepthPrepass)
+    {
+        commands.setColorMask(false);
+        commands.setDepthState(true, true, DepthFunction::Less);
+    }
+    else if (pass == RenderPass::Opaque)
+    {
+        /* Depth is final, only the closest surface passes and nothing needs writing */
+        commands.setColorMask(true);
+        commands.setDepthState(true, false, DepthFunction::Equal);
+    }
+    else
+    {
+        commands.setColorMask(true);
+        commands.setDepthState(true, true, DepthFunction::Less);
+    }
+}
+
+uint32_t RenderQueue::internProgram(const uint32_t program)
+{
+    auto existing = programIDs.find(program);
+    if (existing != programIDs.end())
+        return existing->second;
+
+    uint32_t id = programIDs.size();
+    programIDs[program] = id;
+
+    return id;
+}
+
+uint32_t RenderQueue::internTextureSet(const uint32_t diffuseMap, const uint32_t specularMap)
+{
+    uint64_t textureSet = ((uint64_t)diffuseMap << 32) | specularMap;
+
+    auto existing = textureSetIDs.find(textureSet);
+    if (existing != textureSetIDs.end())
+        return existing->second;
+
+    uint32_t id = textureSetIDs.size();
+    textureSetIDs[textureSet] = id;
+
+    return id;
+}
+
+uint32_t RenderQueue::quantizeDepth(const float viewDepth) const
+{
+    float normalized = (viewDepth - nearPlane) / (farPlane - nearPlane);
+    normalized = normalized < 0.0f ? 0.0f : (normalized > 1.0f ? 1.0f : normalized);
+
+    return (uint32_t)(normalized * (float)FIELD_MASK(DEPTH_BITS));
+}
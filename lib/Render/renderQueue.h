@@ -0,0 +1,97 @@
+#ifndef RENDER_QUEUE
+#define RENDER_QUEUE
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+
+#include "commandList.h"
+#include "../Profiler/profiler.h"
+
+/* Everything needed to issue one draw */
+struct DrawPacket
+{
+    uint32_t program;
+    uint32_t vertexArray;
+    uint32_t diffuseMap;
+    uint32_t specularMap;
+    uint32_t material;          /* Caller defined material index, draws sharing it share uniforms */
+    float shine;                /* material.shine for non-zero materials, 0 keeps the program's own */
+
+    uint32_t first;             /* First vertex, or first index when indexed */
+    uint32_t count;
+    bool indexed;
+
+    glm::mat4 model;
+    glm::mat3 normalMatrix;
+};
+
+enum class RenderPass : uint32_t
+{
+    DepthPrepass,
+    Shadow,
+    Opaque,
+    Translucent,
+    Overlay
+};
+
+/*  Collects draws for a frame and orders them by a 64-bit sort key:
+
+    | pass (4) | translucent (1) | program (10) | material (12) | texture set (12) | depth (24) |
+
+    Opaque draws end up grouped by program, then material, then textures, and within the
+    same state front to back for early-Z. With depthPrepass enabled every opaque draw is
+    also queued in the DepthPrepass pass using depthOnlyProgram, laying down depth with
+    color writes off, and the opaque pass then tests with GL_EQUAL and no depth writes so
+    each pixel is shaded exactly once. Translucent draws swap the depth into the bits
+    below the translucency flag, inverted, so they are drawn back to front regardless of
+    state. Keys are sorted with an LSD radix sort that skips bytes identical in every key. */
+class RenderQueue
+{
+    public:
+        /* Constructor */
+        RenderQueue(const float nearPlane = 0.1f, const float farPlane = 100.0f);
+
+        void reset();
+        size_t size() const;
+
+        /* viewDepth is the draw's distance along the camera's view direction */
+        void submit(const DrawPacket &packet, const RenderPass pass, const bool translucent, const float viewDepth);
+
+        void sort();
+
+        /* Records the sorted draws, only emitting state that differs from the previous draw */
+        void record(CommandList &commands) const;
+
+        float nearPlane, farPlane;
+
+        /* Depth pre-pass, can be toggled between frames. depthOnlyProgram must transform
+           vertices exactly like the opaque programs (see invariant in depth.vert) */
+        bool depthPrepass;
+        uint32_t depthOnlyProgram;
+
+    private:
+        struct SortItem
+        {
+            uint64_t key;
+            uint32_t packet;
+        };
+
+        std::vector<DrawPacket> packets;
+        std::vector<SortItem> items;
+        std::vector<SortItem> scratch;
+
+        /* Map GL names to the compact IDs that fit in the key */
+        std::unordered_map<uint32_t, uint32_t> programIDs;
+        std::unordered_map<uint64_t, uint32_t> textureSetIDs;
+
+        uint32_t internProgram(const uint32_t program);
+        uint32_t internTextureSet(const uint32_t diffuseMap, const uint32_t specularMap);
+        uint32_t quantizeDepth(const float viewDepth) const;
+
+        void pushItem(const DrawPacket &packet, const RenderPass pass, const bool translucent, const float viewDepth);
+        void recordPassState(CommandList &commands, const RenderPass pass, const bool hasPrepass) const;
+};
+
+#endif
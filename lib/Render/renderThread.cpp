@@ -0,0 +1,110 @@
+#include "renderThread.h"
+
+/* Constructor */
+RenderThread::RenderThread(GLFWwindow* window, const unsigned int frameCount)
+    : window { window }
+    , frames(frameCount)
+    , recordingFrame { NULL }
+    , running { true }
+    , lastFrameStats { 0, 0, 0, 0 }
+{
+    for (CommandList &frame : frames)
+        freeFrames.push_back(&frame);
+
+    /* A context can only be current on one thread at a time */
+    glfwMakeContextCurrent(NULL);
+
+    thread = std::thread(&RenderThread::renderLoop, this);
+}
+
+RenderThread::~RenderThread()
+{
+    stop();
+}
+
+CommandList &RenderThread::beginFrame()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    frameFreed.wait(lock, [this]() { return !freeFrames.empty(); });
+
+    recordingFrame = freeFrames.front();
+    freeFrames.pop_front();
+    recordingFrame->reset();
+
+    return *recordingFrame;
+}
+
+void RenderThread::submitFrame()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        submittedFrames.push_back(recordingFrame);
+        recordingFrame = NULL;
+    }
+
+    frameSubmitted.notify_one();
+}
+
+void RenderThread::stop()
+{
+    if (!thread.joinable())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+
+    frameSubmitted.notify_one();
+    thread.join();
+
+    glfwMakeContextCurrent(window);
+}
+
+RenderStats RenderThread::getLastFrameStats() const
+{
+    std::lock_guard<std::mutex> lock(statsMutex);
+    return lastFrameStats;
+}
+
+/* Private */
+void RenderThread::renderLoop()
+{
+    glfwMakeContextCurrent(window);
+
+    GLBackend backend;
+
+    while (true)
+    {
+        CommandList* frame;
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            frameSubmitted.wait(lock, [this]() { return !running || !submittedFrames.empty(); });
+
+            /* Drain everything already submitted before shutting down */
+            if (submittedFrames.empty())
+                break;
+
+            frame = submittedFrames.front();
+            submittedFrames.pop_front();
+        }
+
+        RenderStats stats = backend.execute(*frame);
+        glfwSwapBuffers(window);
+
+        {
+            std::lock_guard<std::mutex> lock(statsMutex);
+            lastFrameStats = stats;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            freeFrames.push_back(frame);
+        }
+
+        frameFreed.notify_one();
+    }
+
+    glfwMakeContextCurrent(NULL);
+}
@@ -0,0 +1,62 @@
+#ifndef RENDER_THREAD
+#define RENDER_THREAD
+
+#include <glad/glad.h>
+#include <glfw3.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include <atomic>
+
+#include "commandList.h"
+#include "glBackend.h"
+
+/*  Owns the window's GL context on a dedicated thread and replays one command list
+    per frame.
+
+    The simulation thread records frame N+1 while the render thread is still submitting
+    frame N. With `frameCount` lists in flight, the simulation can run at most
+    frameCount - 1 frames ahead before beginFrame() blocks. */
+class RenderThread
+{
+    public:
+        /* Constructor / Destructor. The calling thread must currently own the window's context */
+        RenderThread(GLFWwindow* window, const unsigned int frameCount = 2);
+        ~RenderThread();
+
+        RenderThread(const RenderThread&) = delete;
+        RenderThread &operator=(const RenderThread&) = delete;
+
+        /* Simulation side: get an empty list to record into, then hand it over */
+        CommandList &beginFrame();
+        void submitFrame();
+
+        /* Waits for submitted frames to finish, then hands the context back to the caller */
+        void stop();
+
+        /* Stats of the most recently replayed frame */
+        RenderStats getLastFrameStats() const;
+
+    private:
+        GLFWwindow* window;
+        std::thread thread;
+
+        std::vector<CommandList> frames;
+        std::deque<CommandList*> freeFrames;
+        std::deque<CommandList*> submittedFrames;
+        CommandList* recordingFrame;
+
+        std::mutex mutex;
+        std::condition_variable frameFreed;
+        std::condition_variable frameSubmitted;
+        bool running;
+
+        mutable std::mutex statsMutex;
+        RenderStats lastFrameStats;
+
+        void renderLoop();
+};
+
+#endif
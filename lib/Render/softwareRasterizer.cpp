@@ -0,0 +1,717 @@
+#include "softwareRasterizer.h"
+
+/* Triangles outside [-guard * w, guard * w] are clipped, keeping screen coordinates within [-W / 2, 3W / 2] */
+static const float guardBand = 2.0f;
+
+static const int subpixelScale = 1 << SOFTWARE_SUBPIXEL_BITS;
+static const int tilePixels = SOFTWARE_TILE_SIZE * SOFTWARE_TILE_SIZE;
+static const int blocksPerTileSide = SOFTWARE_TILE_SIZE / SOFTWARE_BLOCK_SIZE;
+
+static uint32_t packColor(const glm::vec3 &color)
+{
+    uint32_t r = (uint32_t)(glm::clamp(color.x, 0.0f, 1.0f) * 255.0f + 0.5f);
+    uint32_t g = (uint32_t)(glm::clamp(color.y, 0.0f, 1.0f) * 255.0f + 0.5f);
+    uint32_t b = (uint32_t)(glm::clamp(color.z, 0.0f, 1.0f) * 255.0f + 0.5f);
+
+    return r | (g << 8) | (b << 16) | (255u << 24);
+}
+
+static glm::vec3 unpackColor(const uint32_t color)
+{
+    return glm::vec3((float)(color & 0xFF), (float)((color >> 8) & 0xFF), (float)((color >> 16) & 0xFF)) * (1.0f / 255.0f);
+}
+
+/* Smallest and largest value of a linear function over a block, from its value at the first pixel */
+static void edgeRange(const int64_t origin, const int64_t stepX, const int64_t stepY, const int64_t span, int64_t &minValue, int64_t &maxValue)
+{
+    minValue = origin + std::min<int64_t>(0, stepX * span) + std::min<int64_t>(0, stepY * span);
+    maxValue = origin + std::max<int64_t>(0, stepX * span) + std::max<int64_t>(0, stepY * span);
+}
+
+/* Constructor */
+SoftwareRasterizer::SoftwareRasterizer(const int width, const int height, JobSystem &jobSystem)
+    : clearColor { glm::vec3(0.1f, 0.1f, 0.1f) },
+      cullBackFaces { false },
+      width { std::min(std::max(width, 1), SOFTWARE_MAX_SIZE) },
+      height { std::min(std::max(height, 1), SOFTWARE_MAX_SIZE) },
+      jobSystem { jobSystem },
+      viewProjection { glm::mat4(1.0f) },
+      batchCount { 0 }
+{
+    if (width > SOFTWARE_MAX_SIZE || height > SOFTWARE_MAX_SIZE)
+        std::cout << "WARNING: SoftwareRasterizer -> Framebuffer clamped to " << this->width << "x" << this->height << std::endl;
+
+    tilesX = (this->width + SOFTWARE_TILE_SIZE - 1) / SOFTWARE_TILE_SIZE;
+    tilesY = (this->height + SOFTWARE_TILE_SIZE - 1) / SOFTWARE_TILE_SIZE;
+
+    /* Edge tiles are allocated whole, so tile addressing never needs the framebuffer width */
+    const size_t tileCount = (size_t)tilesX * tilesY;
+    colorBuffer.resize(tileCount * tilePixels);
+    depthBuffer.resize(tileCount * tilePixels);
+    blockMaxDepth.resize(tileCount * blocksPerTileSide * blocksPerTileSide);
+    tileStats.resize(tileCount);
+}
+
+void SoftwareRasterizer::addMesh(const uint32_t vertexArray, const std::vector<SoftwareVertex> &vertices, const std::vector<uint32_t> &indices)
+{
+    Mesh &mesh = meshes[vertexArray];
+    mesh.vertices = vertices;
+    mesh.indices = indices;
+}
+
+void SoftwareRasterizer::addTexture(const uint32_t texture, const int width, const int height, const int channels, const unsigned char* pixels)
+{
+    if (!pixels || width <= 0 || height <= 0 || channels < 1 || channels > 4)
+    {
+        std::cout << "ERROR: SoftwareRasterizer -> Invalid texture " << texture << std::endl;
+        return;
+    }
+
+    Texture &target = textures[texture];
+    target.width = width;
+    target.height = height;
+    target.texels.resize((size_t)width * height);
+
+    /* Expanded to RGBA the way GL expands GL_RED, GL_RG and GL_RGB uploads */
+    for (size_t i = 0; i < target.texels.size(); ++i)
+    {
+        const unsigned char* texel = pixels + i * channels;
+        uint32_t r = texel[0];
+        uint32_t g = channels >= 2 ? texel[1] : 0;
+        uint32_t b = channels >= 3 ? texel[2] : 0;
+        uint32_t a = channels == 4 ? texel[3] : 255;
+
+        target.texels[i] = r | (g << 8) | (b << 16) | (a << 24);
+    }
+}
+
+void SoftwareRasterizer::beginFrame(const glm::mat4 &view, const glm::mat4 &projection, const SoftwareLighting &lighting)
+{
+    viewProjection = projection * view;
+    this->lighting = lighting;
+    draws.clear();
+}
+
+void SoftwareRasterizer::draw(const MeshRef &mesh, const MaterialRef &material, const glm::mat4 &model, const glm::mat3 &normalMatrix)
+{
+    auto meshIterator = meshes.find(mesh.VAO);
+    if (meshIterator == meshes.end())
+    {
+        std::cout << "ERROR: SoftwareRasterizer -> No mesh registered for vertex array " << mesh.VAO << std::endl;
+        return;
+    }
+
+    const Mesh &source = meshIterator->second;
+    const uint32_t available = source.indices.empty() ? source.vertices.size() : source.indices.size();
+    if (mesh.firstVertex >= available)
+        return;
+
+    auto diffuseIterator = textures.find(material.diffuseMapID);
+    auto specularIterator = textures.find(material.specularMapID);
+
+    DrawItem item;
+    item.mesh = &source;
+    item.diffuseMap = diffuseIterator != textures.end() ? &diffuseIterator->second : NULL;
+    item.specularMap = specularIterator != textures.end() ? &specularIterator->second : NULL;
+    item.first = mesh.firstVertex;
+    item.count = std::min(mesh.vertexCount, available - mesh.firstVertex);
+    item.lit = material.diffuseMapID != 0;
+    item.shine = material.shine;
+    item.model = model;
+    item.normalMatrix = normalMatrix;
+
+    draws.push_back(item);
+}
+
+SoftwareRasterStats SoftwareRasterizer::endFrame()
+{
+    PROFILE_SCOPE("SoftwareRasterizer::endFrame");
+
+    const uint32_t tileCount = tilesX * tilesY;
+
+    /* A few batches per thread so stealing can even out draws of different sizes */
+    batchCount = std::min<uint32_t>(draws.size(), jobSystem.getThreadCount() * 4);
+    if (batches.size() < batchCount)
+        batches.resize(batchCount);
+
+    for (uint32_t i = 0; i < batchCount; ++i)
+    {
+        batches[i].firstDraw = (uint64_t)draws.size() * i / batchCount;
+        batches[i].endDraw = (uint64_t)draws.size() * (i + 1) / batchCount;
+    }
+
+    {
+        PROFILE_SCOPE("Software geometry");
+        jobSystem.parallelFor(batchCount, 1, [this](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t i = begin; i < end; ++i)
+                processBatch(batches[i]);
+        });
+    }
+
+    {
+        PROFILE_SCOPE("Software raster");
+        jobSystem.parallelFor(tileCount, 1, [this](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t tile = begin; tile < end; ++tile)
+                rasterizeTile(tile);
+        });
+    }
+
+    SoftwareRasterStats stats = { (uint32_t)draws.size(), 0, 0, 0, 0, 0 };
+    for (uint32_t i = 0; i < batchCount; ++i)
+    {
+        stats.triangles += batches[i].triangleCount;
+        stats.trianglesRasterized += batches[i].triangles.size();
+        for (const std::vector<uint32_t> &bin : batches[i].bins)
+            stats.binnedTriangles += bin.size();
+    }
+
+    for (const TileStats &tile : tileStats)
+    {
+        stats.blocksRejected += tile.blocksRejected;
+        stats.pixelsShaded += tile.pixelsShaded;
+    }
+
+    return stats;
+}
+
+std::vector<unsigned char> SoftwareRasterizer::readPixels() const
+{
+    std::vector<unsigned char> pixels((size_t)width * height * 4);
+
+    for (int row = 0; row < height; ++row)
+    {
+        /* Framebuffer rows are bottom up like GL's */
+        const int y = height - 1 - row;
+        const int tileRow = (y / SOFTWARE_TILE_SIZE) * tilesX;
+        const int rowInTile = (y % SOFTWARE_TILE_SIZE) * SOFTWARE_TILE_SIZE;
+
+        unsigned char* out = &pixels[(size_t)row * width * 4];
+        for (int x = 0; x < width; ++x, out += 4)
+        {
+            const size_t tile = tileRow + x / SOFTWARE_TILE_SIZE;
+            const uint32_t color = colorBuffer[tile * tilePixels + rowInTile + x % SOFTWARE_TILE_SIZE];
+
+            out[0] = color & 0xFF;
+            out[1] = (color >> 8) & 0xFF;
+            out[2] = (color >> 16) & 0xFF;
+            out[3] = (color >> 24) & 0xFF;
+        }
+    }
+
+    return pixels;
+}
+
+int SoftwareRasterizer::getWidth() const
+{
+    return width;
+}
+
+int SoftwareRasterizer::getHeight() const
+{
+    return height;
+}
+
+/* Private */
+void SoftwareRasterizer::processBatch(Batch &batch)
+{
+    const uint32_t tileCount = tilesX * tilesY;
+
+    batch.triangles.clear();
+    batch.bins.resize(tileCount);
+    for (std::vector<uint32_t> &bin : batch.bins)
+        bin.clear();
+    batch.triangleCount = 0;
+
+    /* Near plane and guard band, as dot products with the clip space position */
+    const glm::vec4 clipPlanes[5] = {
+        glm::vec4( 0.0f,  0.0f, 1.0f, 1.0f),
+        glm::vec4( 1.0f,  0.0f, 0.0f, guardBand),
+        glm::vec4(-1.0f,  0.0f, 0.0f, guardBand),
+        glm::vec4( 0.0f,  1.0f, 0.0f, guardBand),
+        glm::vec4( 0.0f, -1.0f, 0.0f, guardBand)
+    };
+
+    /* Every plane can add one vertex to the triangle */
+    ClipVertex polygon[2][8];
+
+    for (uint32_t drawIndex = batch.firstDraw; drawIndex < batch.endDraw; ++drawIndex)
+    {
+        const DrawItem &item = draws[drawIndex];
+        const glm::mat4 modelViewProjection = viewProjection * item.model;
+        const bool indexed = !item.mesh->indices.empty();
+
+        for (uint32_t t = 0; t + 3 <= item.count; t += 3)
+        {
+            ++batch.triangleCount;
+
+            ClipVertex* triangle = polygon[0];
+            uint32_t outsideAll = 0x3F, needsClipping = 0;
+
+            for (int i = 0; i < 3; ++i)
+            {
+                const uint32_t index = indexed ? item.mesh->indices[item.first + t + i] : item.first + t + i;
+                const SoftwareVertex &vertex = item.mesh->vertices[index];
+
+                ClipVertex &out = triangle[i];
+                out.position = modelViewProjection * glm::vec4(vertex.position, 1.0f);
+                out.worldPos = glm::vec3(item.model * glm::vec4(vertex.position, 1.0f));
+                out.normal = item.normalMatrix * vertex.normal;
+                out.texCoords = vertex.texCoords;
+
+                /* Outside the view volume, rejected when all vertices are outside the same plane */
+                const glm::vec4 &p = out.position;
+                uint32_t outside = (p.x < -p.w) | ((p.x > p.w) << 1) | ((p.y < -p.w) << 2) |
+                                   ((p.y > p.w) << 3) | ((p.z < -p.w) << 4) | ((p.z > p.w) << 5);
+                outsideAll &= outside;
+
+                const float guard = guardBand * p.w;
+                needsClipping |= (p.z < -p.w) | (p.x < -guard) | (p.x > guard) | (p.y < -guard) | (p.y > guard);
+            }
+
+            if (outsideAll)
+                continue;
+
+            if (!needsClipping)
+            {
+                setupTriangle(batch, drawIndex, triangle);
+                continue;
+            }
+
+            uint32_t count = 3;
+            int current = 0;
+            for (const glm::vec4 &plane : clipPlanes)
+            {
+                count = clipPolygon(polygon[current], count, polygon[current ^ 1], plane);
+                current ^= 1;
+                if (count < 3)
+                    break;
+            }
+
+            /* Clipped polygons are convex, fan them back into triangles */
+            for (uint32_t i = 1; i + 1 < count; ++i)
+            {
+                ClipVertex fan[3] = { polygon[current][0], polygon[current][i], polygon[current][i + 1] };
+                setupTriangle(batch, drawIndex, fan);
+            }
+        }
+    }
+}
+
+void SoftwareRasterizer::setupTriangle(Batch &batch, const uint32_t drawIndex, const ClipVertex* vertices)
+{
+    float screenX[3], screenY[3], screenZ[3], invW[3];
+    int32_t fixedX[3], fixedY[3];
+
+    /* Back facing triangles are wound the other way round, order[] swaps them to counter-clockwise */
+    int order[3] = { 0, 1, 2 };
+
+    for (int i = 0; i < 3; ++i)
+    {
+        const glm::vec4 &p = vertices[i].position;
+        invW[i] = 1.0f / p.w;
+
+        /* Snapped first, the planes below must agree with the edges on where vertices are */
+        fixedX[i] = (int32_t)std::lround((p.x * invW[i] * 0.5f + 0.5f) * width * subpixelScale);
+        fixedY[i] = (int32_t)std::lround((p.y * invW[i] * 0.5f + 0.5f) * height * subpixelScale);
+
+        screenX[i] = (float)fixedX[i] / subpixelScale;
+        screenY[i] = (float)fixedY[i] / subpixelScale;
+        screenZ[i] = p.z * invW[i] * 0.5f + 0.5f;
+    }
+
+    /* Twice the signed area, negative for back faces */
+    const int64_t area = (int64_t)(fixedX[1] - fixedX[0]) * (fixedY[2] - fixedY[0]) -
+                         (int64_t)(fixedX[2] - fixedX[0]) * (fixedY[1] - fixedY[0]);
+    if (area == 0 || (area < 0 && cullBackFaces))
+        return;
+
+    if (area < 0)
+    {
+        std::swap(order[1], order[2]);
+        std::swap(fixedX[1], fixedX[2]);
+        std::swap(fixedY[1], fixedY[2]);
+        std::swap(screenX[1], screenX[2]);
+        std::swap(screenY[1], screenY[2]);
+        std::swap(screenZ[1], screenZ[2]);
+        std::swap(invW[1], invW[2]);
+    }
+
+    Triangle triangle;
+
+    /* Pixels whose centers (x * 16 + 8) fall within the snapped bounds */
+    const int32_t boundsMinX = std::min(fixedX[0], std::min(fixedX[1], fixedX[2]));
+    const int32_t boundsMaxX = std::max(fixedX[0], std::max(fixedX[1], fixedX[2]));
+    const int32_t boundsMinY = std::min(fixedY[0], std::min(fixedY[1], fixedY[2]));
+    const int32_t boundsMaxY = std::max(fixedY[0], std::max(fixedY[1], fixedY[2]));
+
+    triangle.minX = std::max((boundsMinX + subpixelScale / 2 - 1) >> SOFTWARE_SUBPIXEL_BITS, 0);
+    triangle.maxX = std::min((boundsMaxX - subpixelScale / 2) >> SOFTWARE_SUBPIXEL_BITS, width - 1);
+    triangle.minY = std::max((boundsMinY + subpixelScale / 2 - 1) >> SOFTWARE_SUBPIXEL_BITS, 0);
+    triangle.maxY = std::min((boundsMaxY - subpixelScale / 2) >> SOFTWARE_SUBPIXEL_BITS, height - 1);
+
+    if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+        return;
+
+    for (int i = 0; i < 3; ++i)
+    {
+        const int a = (i + 1) % 3, b = (i + 2) % 3;
+
+        triangle.edgeA[i] = fixedY[a] - fixedY[b];
+        triangle.edgeB[i] = fixedX[b] - fixedX[a];
+        triangle.edgeC[i] = -((int64_t)triangle.edgeA[i] * fixedX[a] + (int64_t)triangle.edgeB[i] * fixedY[a]);
+
+        /* Top-left fill rule, samples exactly on an edge belong to only one of the triangles sharing it */
+        const bool topLeft = triangle.edgeA[i] > 0 || (triangle.edgeA[i] == 0 && triangle.edgeB[i] < 0);
+        if (!topLeft)
+            triangle.edgeC[i] -= 1;
+    }
+
+    /* Attribute planes in pixels, relative to vertex 0 to keep precision */
+    const float dx1 = screenX[1] - screenX[0], dy1 = screenY[1] - screenY[0];
+    const float dx2 = screenX[2] - screenX[0], dy2 = screenY[2] - screenY[0];
+    const float invDeterminant = 1.0f / (dx1 * dy2 - dx2 * dy1);
+
+    auto computePlane = [&](const float v0, const float v1, const float v2) -> Plane
+    {
+        Plane plane;
+        plane.a = ((v1 - v0) * dy2 - (v2 - v0) * dy1) * invDeterminant;
+        plane.b = ((v2 - v0) * dx1 - (v1 - v0) * dx2) * invDeterminant;
+
+        /* Folds in the half pixel offset, so planes are evaluated at integer pixel coordinates */
+        plane.c = v0 + plane.a * (0.5f - screenX[0]) + plane.b * (0.5f - screenY[0]);
+        return plane;
+    };
+
+    triangle.depth = computePlane(screenZ[0], screenZ[1], screenZ[2]);
+    triangle.minZ = std::min(screenZ[0], std::min(screenZ[1], screenZ[2]));
+    triangle.maxZ = std::max(screenZ[0], std::max(screenZ[1], screenZ[2]));
+
+    float values[AttributeCount][3];
+    for (int i = 0; i < 3; ++i)
+    {
+        const ClipVertex &vertex = vertices[order[i]];
+        values[AttrInvW][i] = invW[i];
+        values[AttrU][i] = vertex.texCoords.x * invW[i];
+        values[AttrV][i] = vertex.texCoords.y * invW[i];
+        values[AttrNormalX][i] = vertex.normal.x * invW[i];
+        values[AttrNormalY][i] = vertex.normal.y * invW[i];
+        values[AttrNormalZ][i] = vertex.normal.z * invW[i];
+        values[AttrWorldX][i] = vertex.worldPos.x * invW[i];
+        values[AttrWorldY][i] = vertex.worldPos.y * invW[i];
+        values[AttrWorldZ][i] = vertex.worldPos.z * invW[i];
+    }
+
+    for (int attribute = 0; attribute < AttributeCount; ++attribute)
+        triangle.attributes[attribute] = computePlane(values[attribute][0], values[attribute][1], values[attribute][2]);
+
+    triangle.draw = drawIndex;
+
+    const uint32_t index = batch.triangles.size();
+    batch.triangles.push_back(triangle);
+
+    /* Bin into every tile the bounds touch, skipping tiles entirely outside an edge */
+    const int firstTileX = triangle.minX / SOFTWARE_TILE_SIZE, lastTileX = triangle.maxX / SOFTWARE_TILE_SIZE;
+    const int firstTileY = triangle.minY / SOFTWARE_TILE_SIZE, lastTileY = triangle.maxY / SOFTWARE_TILE_SIZE;
+
+    if (firstTileX == lastTileX && firstTileY == lastTileY)
+    {
+        batch.bins[firstTileY * tilesX + firstTileX].push_back(index);
+        return;
+    }
+
+    for (int tileY = firstTileY; tileY <= lastTileY; ++tileY)
+    {
+        for (int tileX = firstTileX; tileX <= lastTileX; ++tileX)
+        {
+            const int64_t centerX = (int64_t)tileX * SOFTWARE_TILE_SIZE * subpixelScale + subpixelScale / 2;
+            const int64_t centerY = (int64_t)tileY * SOFTWARE_TILE_SIZE * subpixelScale + subpixelScale / 2;
+
+            bool overlaps = true;
+            for (int i = 0; i < 3 && overlaps; ++i)
+            {
+                int64_t minValue, maxValue;
+                edgeRange(triangle.edgeA[i] * centerX + triangle.edgeB[i] * centerY + triangle.edgeC[i],
+                          (int64_t)triangle.edgeA[i] * subpixelScale, (int64_t)triangle.edgeB[i] * subpixelScale,
+                          SOFTWARE_TILE_SIZE - 1, minValue, maxValue);
+                overlaps = maxValue >= 0;
+            }
+
+            if (overlaps)
+                batch.bins[tileY * tilesX + tileX].push_back(index);
+        }
+    }
+}
+
+void SoftwareRasterizer::rasterizeTile(const uint32_t tile)
+{
+    const int tileX = (tile % tilesX) * SOFTWARE_TILE_SIZE;
+    const int tileY = (tile / tilesX) * SOFTWARE_TILE_SIZE;
+
+    /* Cleared here rather than up front, so the tile is still in cache while it's drawn */
+    const uint32_t clearValue = packColor(clearColor);
+    std::fill_n(colorBuffer.begin() + (size_t)tile * tilePixels, tilePixels, clearValue);
+    std::fill_n(depthBuffer.begin() + (size_t)tile * tilePixels, tilePixels, 1.0f);
+    std::fill_n(blockMaxDepth.begin() + (size_t)tile * blocksPerTileSide * blocksPerTileSide, blocksPerTileSide * blocksPerTileSide, 1.0f);
+
+    TileStats &stats = tileStats[tile];
+    stats.blocksRejected = 0;
+    stats.pixelsShaded = 0;
+
+    /* Batches hold consecutive draws, walking them in order keeps submission order */
+    for (uint32_t b = 0; b < batchCount; ++b)
+    {
+        const Batch &batch = batches[b];
+        for (uint32_t index : batch.bins[tile])
+            rasterizeTriangle(batch.triangles[index], tile, tileX, tileY, stats);
+    }
+}
+
+void SoftwareRasterizer::rasterizeTriangle(const Triangle &triangle, const uint32_t tile, const int tileX, const int tileY, TileStats &stats)
+{
+    const int minX = std::max(triangle.minX, tileX), maxX = std::min(triangle.maxX, tileX + SOFTWARE_TILE_SIZE - 1);
+    const int minY = std::max(triangle.minY, tileY), maxY = std::min(triangle.maxY, tileY + SOFTWARE_TILE_SIZE - 1);
+    if (minX > maxX || minY > maxY)
+        return;
+
+    const int span = SOFTWARE_BLOCK_SIZE - 1;
+    uint32_t* tileColor = &colorBuffer[(size_t)tile * tilePixels];
+    float* tileDepth = &depthBuffer[(size_t)tile * tilePixels];
+    float* tileBlockDepth = &blockMaxDepth[(size_t)tile * blocksPerTileSide * blocksPerTileSide];
+
+    const Plane &depth = triangle.depth;
+
+    for (int blockY = minY & ~span; blockY <= maxY; blockY += SOFTWARE_BLOCK_SIZE)
+    {
+        for (int blockX = minX & ~span; blockX <= maxX; blockX += SOFTWARE_BLOCK_SIZE)
+        {
+            /* Classify the block against each edge from its corner pixels */
+            int32_t partialOrigin[3], partialStepX[3], partialStepY[3];
+            int partialCount = 0;
+            bool outside = false;
+
+            for (int i = 0; i < 3; ++i)
+            {
+                const int64_t stepX = (int64_t)triangle.edgeA[i] * subpixelScale;
+                const int64_t stepY = (int64_t)triangle.edgeB[i] * subpixelScale;
+                const int64_t origin = triangle.edgeA[i] * ((int64_t)blockX * subpixelScale + subpixelScale / 2) +
+                                       triangle.edgeB[i] * ((int64_t)blockY * subpixelScale + subpixelScale / 2) + triangle.edgeC[i];
+
+                int64_t minValue, maxValue;
+                edgeRange(origin, stepX, stepY, span, minValue, maxValue);
+
+                if (maxValue < 0)
+                {
+                    outside = true;
+                    break;
+                }
+
+                /* An edge crossing the block is within a block's worth of steps of zero, which fits 32 bits */
+                if (minValue < 0)
+                {
+                    partialOrigin[partialCount] = (int32_t)origin;
+                    partialStepX[partialCount] = (int32_t)stepX;
+                    partialStepY[partialCount] = (int32_t)stepY;
+                    ++partialCount;
+                }
+            }
+
+            if (outside)
+                continue;
+
+            /* Coarse depth, the triangle's nearest point in the block against the farthest depth stored there */
+            const float blockDepthOrigin = depth.a * blockX + depth.b * blockY + depth.c;
+            const float blockMinZ = std::max(triangle.minZ, blockDepthOrigin + std::min(0.0f, depth.a * span) + std::min(0.0f, depth.b * span));
+            const float blockMaxZ = std::min(triangle.maxZ, blockDepthOrigin + std::max(0.0f, depth.a * span) + std::max(0.0f, depth.b * span));
+
+            float &storedMaxDepth = tileBlockDepth[((blockY - tileY) / SOFTWARE_BLOCK_SIZE) * blocksPerTileSide + (blockX - tileX) / SOFTWARE_BLOCK_SIZE];
+            if (blockMinZ >= storedMaxDepth)
+            {
+                ++stats.blocksRejected;
+                continue;
+            }
+
+            /* Pixels of the block inside the triangle's bounds */
+            const int firstRow = std::max(blockY, minY), lastRow = std::min(blockY + span, maxY);
+            const int firstColumn = std::max(blockX, minX) - blockX, lastColumn = std::min(blockX + span, maxX) - blockX;
+            const uint32_t columnMask = ((1u << (lastColumn + 1)) - 1) & ~((1u << firstColumn) - 1);
+
+            for (int y = firstRow; y <= lastRow; ++y)
+            {
+                const int row = y - blockY;
+                float* depthRow = tileDepth + (y - tileY) * SOFTWARE_TILE_SIZE + (blockX - tileX);
+                uint32_t* colorRow = tileColor + (y - tileY) * SOFTWARE_TILE_SIZE + (blockX - tileX);
+
+                for (int half = 0; half < 2; ++half)
+                {
+                    const int firstLane = half * 4;
+                    uint32_t coverage = (columnMask >> firstLane) & 0xF;
+                    if (!coverage)
+                        continue;
+
+                    float z[4];
+                    const float rowDepth = depth.a * (blockX + firstLane) + depth.b * y + depth.c;
+
+#if defined(__SSE2__)
+                    __m128i inside = _mm_set1_epi32(-1);
+                    for (int i = 0; i < partialCount; ++i)
+                    {
+                        const int32_t value = partialOrigin[i] + row * partialStepY[i] + firstLane * partialStepX[i];
+                        const int32_t step = partialStepX[i];
+                        __m128i edge = _mm_add_epi32(_mm_set1_epi32(value), _mm_setr_epi32(0, step, step * 2, step * 3));
+                        inside = _mm_and_si128(inside, _mm_cmpgt_epi32(edge, _mm_set1_epi32(-1)));
+                    }
+
+                    coverage &= _mm_movemask_ps(_mm_castsi128_ps(inside));
+                    if (!coverage)
+                        continue;
+
+                    /* Early depth test, before anything is interpolated or sampled */
+                    __m128 depths = _mm_add_ps(_mm_set1_ps(rowDepth), _mm_setr_ps(0.0f, depth.a, depth.a * 2.0f, depth.a * 3.0f));
+                    coverage &= _mm_movemask_ps(_mm_cmplt_ps(depths, _mm_loadu_ps(depthRow + firstLane)));
+                    _mm_storeu_ps(z, depths);
+#else
+                    for (int lane = 0; lane < 4; ++lane)
+                    {
+                        for (int i = 0; i < partialCount; ++i)
+                        {
+                            const int32_t value = partialOrigin[i] + row * partialStepY[i] + (firstLane + lane) * partialStepX[i];
+                            if (value < 0)
+                                coverage &= ~(1u << lane);
+                        }
+
+                        z[lane] = rowDepth + depth.a * lane;
+                        if (!(z[lane] < depthRow[firstLane + lane]))
+                            coverage &= ~(1u << lane);
+                    }
+#endif
+
+                    while (coverage)
+                    {
+                        const int lane = __builtin_ctz(coverage);
+                        coverage &= coverage - 1;
+
+                        const int column = firstLane + lane;
+                        depthRow[column] = z[lane];
+                        shadePixel(triangle, blockX + column, y, colorRow[column]);
+                        ++stats.pixelsShaded;
+                    }
+                }
+            }
+
+            /* Every pixel of a covered block now holds at most the triangle's farthest depth there */
+            if (partialCount == 0 && columnMask == 0xFF && firstRow == blockY && lastRow == blockY + span)
+                storedMaxDepth = std::min(storedMaxDepth, blockMaxZ);
+        }
+    }
+}
+
+void SoftwareRasterizer::shadePixel(const Triangle &triangle, const int x, const int y, uint32_t &color) const
+{
+    const DrawItem &item = draws[triangle.draw];
+    if (!item.lit)
+    {
+        color = packColor(glm::vec3(1.0f));
+        return;
+    }
+
+    auto evaluate = [&](const int attribute) -> float
+    {
+        const Plane &plane = triangle.attributes[attribute];
+        return plane.a * x + plane.b * y + plane.c;
+    };
+
+    /* Attributes were divided by w, dividing by the interpolated 1/w makes them perspective correct */
+    const float w = 1.0f / evaluate(AttrInvW);
+    const float u = evaluate(AttrU) * w;
+    const float v = evaluate(AttrV) * w;
+    const glm::vec3 normal = glm::normalize(glm::vec3(evaluate(AttrNormalX), evaluate(AttrNormalY), evaluate(AttrNormalZ)));
+    const glm::vec3 fragPos = glm::vec3(evaluate(AttrWorldX), evaluate(AttrWorldY), evaluate(AttrWorldZ)) * w;
+    const glm::vec3 viewDirection = glm::normalize(lighting.cameraPos - fragPos);
+
+    const glm::vec3 diffuseColor = sample(item.diffuseMap, u, v);
+    const glm::vec3 specularColor = sample(item.specularMap, u, v);
+
+    /* Same terms as lighting.frag's applyDirectedLight and applyPointLight */
+    auto applyLight = [&](const glm::vec3 &lightDirection, const glm::vec3 &ambient, const glm::vec3 &diffuse, const glm::vec3 &specular) -> glm::vec3
+    {
+        const float diffuseValue = std::max(glm::dot(normal, lightDirection), 0.0f);
+        const glm::vec3 reflectDirection = normal * (2.0f * glm::dot(normal, lightDirection)) - lightDirection;
+        const float specularValue = std::pow(std::max(glm::dot(viewDirection, reflectDirection), 0.0f), item.shine);
+
+        return ambient * diffuseColor + diffuse * diffuseValue * diffuseColor + specular * specularValue * specularColor;
+    };
+
+    glm::vec3 result = applyLight(glm::normalize(-lighting.dirDirection), lighting.dirAmbient, lighting.dirDiffuse, lighting.dirSpecular);
+
+    for (const SoftwarePointLight &pointLight : lighting.pointLights)
+    {
+        const PointLight &light = pointLight.light;
+        const glm::vec3 toLight = pointLight.position - fragPos;
+        const float distance = glm::length(toLight);
+        const float attenuation = 1.0f / (light.attConstant + light.attLinear * distance + light.attQuadratic * distance * distance);
+
+        result += applyLight(toLight / distance, light.ambient, light.diffuse, light.specular) * attenuation;
+    }
+
+    color = packColor(result);
+}
+
+uint32_t SoftwareRasterizer::clipPolygon(const ClipVertex* input, const uint32_t count, ClipVertex* output, const glm::vec4 &plane)
+{
+    uint32_t outputCount = 0;
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const ClipVertex &current = input[i];
+        const ClipVertex &next = input[(i + 1) % count];
+
+        const float currentDistance = glm::dot(current.position, plane);
+        const float nextDistance = glm::dot(next.position, plane);
+
+        if (currentDistance >= 0.0f)
+            output[outputCount++] = current;
+
+        /* Edge crosses the plane, emit the intersection */
+        if ((currentDistance >= 0.0f) != (nextDistance >= 0.0f))
+            output[outputCount++] = lerp(current, next, currentDistance / (currentDistance - nextDistance));
+    }
+
+    return outputCount;
+}
+
+SoftwareRasterizer::ClipVertex SoftwareRasterizer::lerp(const ClipVertex &a, const ClipVertex &b, const float t)
+{
+    ClipVertex result;
+    result.position = a.position + (b.position - a.position) * t;
+    result.worldPos = a.worldPos + (b.worldPos - a.worldPos) * t;
+    result.normal = a.normal + (b.normal - a.normal) * t;
+    result.texCoords = a.texCoords + (b.texCoords - a.texCoords) * t;
+
+    return result;
+}
+
+glm::vec3 SoftwareRasterizer::sample(const Texture* texture, const float u, const float v)
+{
+    /* Untextured lit materials shade as if their maps were white */
+    if (!texture)
+        return glm::vec3(1.0f);
+
+    const float x = u * texture->width - 0.5f;
+    const float y = v * texture->height - 0.5f;
+    const float floorX = std::floor(x), floorY = std::floor(y);
+    const float fractionX = x - floorX, fractionY = y - floorY;
+
+    /* GL_REPEAT */
+    int x0 = (int)floorX % texture->width, y0 = (int)floorY % texture->height;
+    if (x0 < 0) x0 += texture->width;
+    if (y0 < 0) y0 += texture->height;
+    const int x1 = (x0 + 1) % texture->width, y1 = (y0 + 1) % texture->height;
+
+    const uint32_t* texels = texture->texels.data();
+    const glm::vec3 bottom = glm::mix(unpackColor(texels[y0 * texture->width + x0]), unpackColor(texels[y0 * texture->width + x1]), fractionX);
+    const glm::vec3 top = glm::mix(unpackColor(texels[y1 * texture->width + x0]), unpackColor(texels[y1 * texture->width + x1]), fractionX);
+
+    return glm::mix(bottom, top, fractionY);
+}
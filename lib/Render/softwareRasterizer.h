@@ -0,0 +1,235 @@
+#ifndef SOFTWARE_RASTERIZER
+#define SOFTWARE_RASTERIZER
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <iostream>
+
+#include "../ECS/components.h"
+#include "../Jobs/jobSystem.h"
+#include "../Profiler/profiler.h"
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+/* Screen tiles are the unit of work of the raster stage, blocks the unit of coverage and Hi-Z tests */
+#define SOFTWARE_TILE_SIZE 64
+#define SOFTWARE_BLOCK_SIZE 8
+
+/* Vertices are snapped to 1/16th of a pixel */
+#define SOFTWARE_SUBPIXEL_BITS 4
+
+/* Largest framebuffer side, keeps the fixed point edge functions of guard band clipped triangles in range */
+#define SOFTWARE_MAX_SIZE 4096
+
+/* Same layout as the demos' interleaved vertex buffers */
+struct SoftwareVertex
+{
+    glm::vec3 position;
+    glm::vec3 normal;
+    glm::vec2 texCoords;
+};
+
+/* Point light as lighting.frag's pointLights[] receives it */
+struct SoftwarePointLight
+{
+    glm::vec3 position;
+    PointLight light;
+};
+
+/* Uniforms of the lit programs, mirrors what the demos upload to lighting.frag */
+struct SoftwareLighting
+{
+    glm::vec3 cameraPos;
+
+    glm::vec3 dirDirection;
+    glm::vec3 dirAmbient;
+    glm::vec3 dirDiffuse;
+    glm::vec3 dirSpecular;
+
+    std::vector<SoftwarePointLight> pointLights;
+};
+
+/* Counters gathered while rendering a frame */
+struct SoftwareRasterStats
+{
+    uint32_t draws;
+    uint32_t triangles;             /* Submitted */
+    uint32_t trianglesRasterized;   /* Left after clipping, culling and setup */
+    uint64_t binnedTriangles;       /* Triangle and tile pairs */
+    uint64_t blocksRejected;        /* Blocks skipped by the coarse depth test */
+    uint64_t pixelsShaded;
+};
+
+/*  CPU renderer for machines without a usable GPU and for headless testing.
+
+    Draws take the same MeshRef and MaterialRef components the GL path uses. Meshes and
+    textures are registered once under their GL names, so a scene built for the GL
+    renderer can be drawn by both. Materials with a diffuse map are shaded like
+    lighting.frag (directional and point lights, no shadows or spotlight), the rest
+    flat white like lamp.frag.
+
+    endFrame() runs two parallel stages on the job system:
+
+    - Geometry: draws are split into contiguous batches, each transforms and clips its
+      triangles (near plane and a guard band), optionally culls back faces, sets up fixed point
+      edge functions and attribute planes, and bins the triangles into the tiles they
+      overlap. Every batch keeps its own bins, so no locks are needed.
+    - Raster: every tile walks the batches' bins in submission order, which keeps the
+      result deterministic. Triangles are traversed in 8x8 blocks, blocks outside an
+      edge are skipped and edges a block lies fully inside of aren't evaluated. A
+      coarse depth per block rejects occluded blocks outright, the rest evaluate edges
+      and test depth four pixels at a time with SSE before any pixel is shaded.
+
+    Attributes are interpolated perspective correct, textures sampled bilinearly with
+    repeat wrapping. Depth testing is GL_LESS and front faces are counter-clockwise. */
+class SoftwareRasterizer
+{
+    public:
+        /* Constructor */
+        SoftwareRasterizer(const int width, const int height, JobSystem &jobSystem);
+
+        /* Resources, keyed by the GL names the components carry */
+        void addMesh(const uint32_t vertexArray, const std::vector<SoftwareVertex> &vertices, const std::vector<uint32_t> &indices = std::vector<uint32_t>());
+        void addTexture(const uint32_t texture, const int width, const int height, const int channels, const unsigned char* pixels);
+
+        void beginFrame(const glm::mat4 &view, const glm::mat4 &projection, const SoftwareLighting &lighting);
+
+        /* Indexed meshes draw indices [firstVertex, firstVertex + vertexCount) */
+        void draw(const MeshRef &mesh, const MaterialRef &material, const glm::mat4 &model, const glm::mat3 &normalMatrix);
+
+        SoftwareRasterStats endFrame();
+
+        /* RGBA8 color buffer, top row first like PNGWriter expects */
+        std::vector<unsigned char> readPixels() const;
+
+        int getWidth() const;
+        int getHeight() const;
+
+        glm::vec3 clearColor;
+
+        /* Off by default like GL_CULL_FACE, the demos' cube isn't consistently wound */
+        bool cullBackFaces;
+
+    private:
+        struct Mesh
+        {
+            std::vector<SoftwareVertex> vertices;
+            std::vector<uint32_t> indices;
+        };
+
+        /* RGBA8, bottom row first like GL textures */
+        struct Texture
+        {
+            int width, height;
+            std::vector<uint32_t> texels;
+        };
+
+        struct DrawItem
+        {
+            const Mesh* mesh;
+            const Texture* diffuseMap;
+            const Texture* specularMap;
+            uint32_t first, count;
+            bool lit;
+            float shine;
+            glm::mat4 model;
+            glm::mat3 normalMatrix;
+        };
+
+        /* Clip space vertex with its attributes, interpolated linearly while clipping */
+        struct ClipVertex
+        {
+            glm::vec4 position;
+            glm::vec3 worldPos;
+            glm::vec3 normal;
+            glm::vec2 texCoords;
+        };
+
+        /* Attribute planes, each divided by w so they are affine in screen space */
+        enum Attribute
+        {
+            AttrInvW,
+            AttrU, AttrV,
+            AttrNormalX, AttrNormalY, AttrNormalZ,
+            AttrWorldX, AttrWorldY, AttrWorldZ,
+            AttributeCount
+        };
+
+        /* Value at pixel (x, y) is a * x + b * y + c, sampled at the pixel center */
+        struct Plane
+        {
+            float a, b, c;
+        };
+
+        struct Triangle
+        {
+            /* Edge i is opposite vertex i, in 1/16th pixels. Inside is E(p) = A * x + B * y + C >= 0 */
+            int32_t edgeA[3], edgeB[3];
+            int64_t edgeC[3];
+
+            int minX, minY, maxX, maxY;     /* Pixel bounding box, clamped to the framebuffer */
+            float minZ, maxZ;
+
+            Plane depth;
+            Plane attributes[AttributeCount];
+
+            uint32_t draw;
+        };
+
+        /* Contiguous range of draws, set up and binned by one job */
+        struct Batch
+        {
+            uint32_t firstDraw, endDraw;
+            std::vector<Triangle> triangles;
+            std::vector<std::vector<uint32_t>> bins;    /* Triangle indices per tile */
+
+            uint32_t triangleCount;
+        };
+
+        struct TileStats
+        {
+            uint64_t blocksRejected;
+            uint64_t pixelsShaded;
+        };
+
+        int width, height;
+        int tilesX, tilesY;
+        JobSystem &jobSystem;
+
+        glm::mat4 viewProjection;
+        SoftwareLighting lighting;
+
+        std::unordered_map<uint32_t, Mesh> meshes;
+        std::unordered_map<uint32_t, Texture> textures;
+
+        std::vector<DrawItem> draws;
+        std::vector<Batch> batches;
+        uint32_t batchCount;
+        std::vector<TileStats> tileStats;
+
+        /* Tile major, each tile's pixels are contiguous rows of SOFTWARE_TILE_SIZE */
+        std::vector<uint32_t> colorBuffer;
+        std::vector<float> depthBuffer;
+
+        /* Upper bound of the depth in every block, for coarse rejection */
+        std::vector<float> blockMaxDepth;
+
+        void processBatch(Batch &batch);
+        void setupTriangle(Batch &batch, const uint32_t drawIndex, const ClipVertex* vertices);
+        void rasterizeTile(const uint32_t tile);
+        void rasterizeTriangle(const Triangle &triangle, const uint32_t tile, const int tileX, const int tileY, TileStats &stats);
+        void shadePixel(const Triangle &triangle, const int x, const int y, uint32_t &color) const;
+
+        static uint32_t clipPolygon(const ClipVertex* input, const uint32_t count, ClipVertex* output, const glm::vec4 &plane);
+        static ClipVertex lerp(const ClipVertex &a, const ClipVertex &b, const float t);
+        static glm::vec3 sample(const Texture* texture, const float u, const float v);
+};
+
+#endif
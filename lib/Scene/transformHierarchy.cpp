@@ -0,0 +1,355 @@
+#include "transformHierarchy.h"
+
+/* Constructor */
+TransformHierarchy::TransformHierarchy()
+    : jobSystem { NULL }
+    , minNodesPerBatch { 1024 }
+    , needsSort { false }
+    , dirtyCount { 0 }
+{}
+
+NodeHandle TransformHierarchy::createNode(const NodeHandle parent, const glm::vec3 &position, const glm::quat &rotation, const glm::vec3 &scale)
+{
+    uint32_t slot = positions.size();
+    uint32_t parentSlot = parent == InvalidNode ? UINT32_MAX : handleToSlot[parent];
+
+    parentSlots.push_back(parentSlot);
+    depths.push_back(parent == InvalidNode ? 0 : depths[parentSlot] + 1);
+    positions.push_back(position);
+    rotations.push_back(rotation);
+    scales.push_back(scale);
+    worldMatrices.push_back(glm::mat4(1.0f));
+    normalMatrices.push_back(glm::mat3(1.0f));
+    uniformScale.push_back(1);
+    dirty.push_back(1);
+    ++dirtyCount;
+
+    NodeHandle handle = handleToSlot.size();
+    handleToSlot.push_back(slot);
+    slotToHandle.push_back(handle);
+
+    /* Slots are re-sorted by depth on the next update */
+    needsSort = true;
+
+    return handle;
+}
+
+void TransformHierarchy::setPosition(const NodeHandle node, const glm::vec3 &position)
+{
+    uint32_t slot = handleToSlot[node];
+    positions[slot] = position;
+    markDirty(slot);
+}
+
+void TransformHierarchy::setRotation(const NodeHandle node, const glm::quat &rotation)
+{
+    uint32_t slot = handleToSlot[node];
+    rotations[slot] = rotation;
+    markDirty(slot);
+}
+
+void TransformHierarchy::setRotation(const NodeHandle node, const glm::vec3 &eulerDegrees)
+{
+    setRotation(node, glm::quat(glm::radians(eulerDegrees)));
+}
+
+void TransformHierarchy::setScale(const NodeHandle node, const glm::vec3 &scale)
+{
+    uint32_t slot = handleToSlot[node];
+    scales[slot] = scale;
+    markDirty(slot);
+}
+
+const glm::vec3 &TransformHierarchy::getPosition(const NodeHandle node) const
+{
+    return positions[handleToSlot[node]];
+}
+
+const glm::quat &TransformHierarchy::getRotation(const NodeHandle node) const
+{
+    return rotations[handleToSlot[node]];
+}
+
+const glm::vec3 &TransformHierarchy::getScale(const NodeHandle node) const
+{
+    return scales[handleToSlot[node]];
+}
+
+const glm::mat4 &TransformHierarchy::getWorldMatrix(const NodeHandle node) const
+{
+    return worldMatrices[handleToSlot[node]];
+}
+
+const glm::mat3 &TransformHierarchy::getNormalMatrix(const NodeHandle node) const
+{
+    return normalMatrices[handleToSlot[node]];
+}
+
+bool TransformHierarchy::hasUniformScale(const NodeHandle node) const
+{
+    return uniformScale[handleToSlot[node]];
+}
+
+NodeHandle TransformHierarchy::getParent(const NodeHandle node) const
+{
+    uint32_t parentSlot = parentSlots[handleToSlot[node]];
+    return parentSlot == UINT32_MAX ? InvalidNode : slotToHandle[parentSlot];
+}
+
+size_t TransformHierarchy::size() const
+{
+    return positions.size();
+}
+
+void TransformHierarchy::update()
+{
+    /* Static scenes cost nothing once their matrices are computed */
+    if (dirtyCount == 0)
+        return;
+
+    PROFILE_SCOPE("TransformHierarchy::update");
+
+    if (needsSort)
+        sortByDepth();
+
+    /* Levels are processed in order, nodes within a level only read their parent's results */
+    for (size_t level = 0; level + 1 < levelOffsets.size(); ++level)
+    {
+        uint32_t begin = levelOffsets[level];
+        uint32_t end = levelOffsets[level + 1];
+        uint32_t levelSize = end - begin;
+
+        if (!jobSystem || levelSize < minNodesPerBatch * 2)
+        {
+            updateRange(begin, end);
+            continue;
+        }
+
+        jobSystem->parallelFor(levelSize, minNodesPerBatch, [&](uint32_t batchBegin, uint32_t batchEnd)
+        {
+            updateRange(begin + batchBegin, begin + batchEnd);
+        });
+    }
+
+    std::fill(dirty.begin(), dirty.end(), 0);
+    dirtyCount = 0;
+}
+
+/* Private */
+void TransformHierarchy::markDirty(const uint32_t slot)
+{
+    if (!dirty[slot])
+    {
+        dirty[slot] = 1;
+        ++dirtyCount;
+    }
+}
+
+void TransformHierarchy::sortByDepth()
+{
+    size_t nodeCount = positions.size();
+
+    uint32_t maxDepth = 0;
+    for (uint32_t depth : depths)
+        maxDepth = std::max(maxDepth, depth);
+
+    /* Counting sort, stable so siblings keep their creation order */
+    levelOffsets.assign(maxDepth + 2, 0);
+    for (uint32_t depth : depths)
+        ++levelOffsets[depth + 1];
+    for (size_t level = 1; level < levelOffsets.size(); ++level)
+        levelOffsets[level] += levelOffsets[level - 1];
+
+    std::vector<uint32_t> newSlots(nodeCount);
+    std::vector<uint32_t> cursor(levelOffsets.begin(), levelOffsets.end() - 1);
+    for (size_t slot = 0; slot < nodeCount; ++slot)
+        newSlots[slot] = cursor[depths[slot]]++;
+
+    std::vector<uint32_t> sortedParents(nodeCount), sortedDepths(nodeCount);
+    std::vector<glm::vec3> sortedPositions(nodeCount), sortedScales(nodeCount);
+    std::vector<glm::quat> sortedRotations(nodeCount);
+    std::vector<glm::mat4> sortedWorldMatrices(nodeCount);
+    std::vector<glm::mat3> sortedNormalMatrices(nodeCount);
+    std::vector<uint8_t> sortedUniformScale(nodeCount);
+    std::vector<uint8_t> sortedDirty(nodeCount);
+    std::vector<NodeHandle> sortedHandles(nodeCount);
+
+    for (size_t slot = 0; slot < nodeCount; ++slot)
+    {
+        uint32_t newSlot = newSlots[slot];
+        sortedParents[newSlot] = parentSlots[slot] == UINT32_MAX ? UINT32_MAX : newSlots[parentSlots[slot]];
+        sortedDepths[newSlot] = depths[slot];
+        sortedPositions[newSlot] = positions[slot];
+        sortedRotations[newSlot] = rotations[slot];
+        sortedScales[newSlot] = scales[slot];
+        sortedWorldMatrices[newSlot] = worldMatrices[slot];
+        sortedNormalMatrices[newSlot] = normalMatrices[slot];
+        sortedUniformScale[newSlot] = uniformScale[slot];
+        sortedDirty[newSlot] = dirty[slot];
+        sortedHandles[newSlot] = slotToHandle[slot];
+        handleToSlot[slotToHandle[slot]] = newSlot;
+    }
+
+    parentSlots.swap(sortedParents);
+    depths.swap(sortedDepths);
+    positions.swap(sortedPositions);
+    rotations.swap(sortedRotations);
+    scales.swap(sortedScales);
+    worldMatrices.swap(sortedWorldMatrices);
+    normalMatrices.swap(sortedNormalMatrices);
+    uniformScale.swap(sortedUniformScale);
+    dirty.swap(sortedDirty);
+    slotToHandle.swap(sortedHandles);
+
+    needsSort = false;
+}
+
+void TransformHierarchy::updateRange(const uint32_t begin, const uint32_t end)
+{
+    /* Non-uniformly scaled nodes are gathered and their normal matrices computed in batches */
+    const size_t batchSize = 64;
+    uint32_t pendingSlots[batchSize];
+    size_t pendingCount = 0;
+
+    uint32_t slot = begin;
+    while (slot < end)
+    {
+        /* Gather the run of consecutive nodes that changed, or whose parent did */
+        uint32_t runEnd = slot;
+        while (runEnd < end && (dirty[runEnd] || (parentSlots[runEnd] != UINT32_MAX && dirty[parentSlots[runEnd]])))
+        {
+            /* Flag the node so its own children pick up the change on the next level */
+            dirty[runEnd] = 1;
+            ++runEnd;
+        }
+
+        if (runEnd == slot)
+        {
+            ++slot;
+            continue;
+        }
+
+        /* Local T * R * S for the whole run, then the parent's world matrix applied to each span of siblings */
+        BatchMath::composeTRS(&positions[slot], &rotations[slot], &scales[slot], &worldMatrices[slot], runEnd - slot);
+
+        for (uint32_t spanBegin = slot; spanBegin < runEnd;)
+        {
+            uint32_t parentSlot = parentSlots[spanBegin];
+            uint32_t spanEnd = spanBegin + 1;
+            while (spanEnd < runEnd && parentSlots[spanEnd] == parentSlot)
+                ++spanEnd;
+
+            if (parentSlot != UINT32_MAX)
+                BatchMath::multiply(worldMatrices[parentSlot], &worldMatrices[spanBegin], &worldMatrices[spanBegin], spanEnd - spanBegin);
+
+            spanBegin = spanEnd;
+        }
+
+        for (; slot < runEnd; ++slot)
+        {
+            uint32_t parentSlot = parentSlots[slot];
+
+            /*  Rotation and uniform scale leave normals pointing the right way, they only change
+                their length which the fragment shader normalizes anyway */
+            bool isUniform = scales[slot].x == scales[slot].y && scales[slot].y == scales[slot].z;
+            uniformScale[slot] = isUniform && (parentSlot == UINT32_MAX || uniformScale[parentSlot]);
+
+            if (uniformScale[slot])
+            {
+                normalMatrices[slot] = glm::mat3(worldMatrices[slot]);
+                continue;
+            }
+
+            pendingSlots[pendingCount++] = slot;
+            if (pendingCount == batchSize)
+            {
+                computeNormalMatrices(pendingSlots, pendingCount);
+                pendingCount = 0;
+            }
+        }
+    }
+
+    computeNormalMatrices(pendingSlots, pendingCount);
+}
+
+/*  The normal matrix transpose(inverse(M)) equals cofactor(M) / det(M). Normals are
+    renormalized in the shader, so only the sign of the determinant is kept, which makes
+    this three cross products per matrix instead of a full inverse. */
+void TransformHierarchy::computeNormalMatrices(const uint32_t* slots, const size_t count)
+{
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    /* Four matrices at a time, transposed so each register holds one element of all four */
+    for (; i + 4 <= count; i += 4)
+    {
+        const float* m0 = &worldMatrices[slots[i]][0][0];
+        const float* m1 = &worldMatrices[slots[i + 1]][0][0];
+        const float* m2 = &worldMatrices[slots[i + 2]][0][0];
+        const float* m3 = &worldMatrices[slots[i + 3]][0][0];
+
+        __m128 column[3][4];
+        for (int c = 0; c < 3; ++c)
+        {
+            column[c][0] = _mm_loadu_ps(m0 + c * 4);
+            column[c][1] = _mm_loadu_ps(m1 + c * 4);
+            column[c][2] = _mm_loadu_ps(m2 + c * 4);
+            column[c][3] = _mm_loadu_ps(m3 + c * 4);
+            _MM_TRANSPOSE4_PS(column[c][0], column[c][1], column[c][2], column[c][3]);
+        }
+
+        /* column[c][0..2] now hold the x, y and z of column c for all four matrices */
+        __m128 x0 = column[0][0], y0 = column[0][1], z0 = column[0][2];
+        __m128 x1 = column[1][0], y1 = column[1][1], z1 = column[1][2];
+        __m128 x2 = column[2][0], y2 = column[2][1], z2 = column[2][2];
+
+        __m128 cofactor[9] = {
+            /* cross(c1, c2) */
+            _mm_sub_ps(_mm_mul_ps(y1, z2), _mm_mul_ps(z1, y2)),
+            _mm_sub_ps(_mm_mul_ps(z1, x2), _mm_mul_ps(x1, z2)),
+            _mm_sub_ps(_mm_mul_ps(x1, y2), _mm_mul_ps(y1, x2)),
+            /* cross(c2, c0) */
+            _mm_sub_ps(_mm_mul_ps(y2, z0), _mm_mul_ps(z2, y0)),
+            _mm_sub_ps(_mm_mul_ps(z2, x0), _mm_mul_ps(x2, z0)),
+            _mm_sub_ps(_mm_mul_ps(x2, y0), _mm_mul_ps(y2, x0)),
+            /* cross(c0, c1) */
+            _mm_sub_ps(_mm_mul_ps(y0, z1), _mm_mul_ps(z0, y1)),
+            _mm_sub_ps(_mm_mul_ps(z0, x1), _mm_mul_ps(x0, z1)),
+            _mm_sub_ps(_mm_mul_ps(x0, y1), _mm_mul_ps(y0, x1))
+        };
+
+        /* Flip mirrored matrices so normals keep facing outwards */
+        __m128 determinant = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x0, cofactor[0]), _mm_mul_ps(y0, cofactor[1])), _mm_mul_ps(z0, cofactor[2]));
+        __m128 sign = _mm_and_ps(determinant, _mm_set1_ps(-0.0f));
+
+        alignas(16) float result[9][4];
+        for (int e = 0; e < 9; ++e)
+            _mm_store_ps(result[e], _mm_xor_ps(cofactor[e], sign));
+
+        for (int lane = 0; lane < 4; ++lane)
+        {
+            float* normal = &normalMatrices[slots[i + lane]][0][0];
+            for (int e = 0; e < 9; ++e)
+                normal[e] = result[e][lane];
+        }
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        const glm::mat4 &world = worldMatrices[slots[i]];
+        glm::vec3 c0 = glm::vec3(world[0]), c1 = glm::vec3(world[1]), c2 = glm::vec3(world[2]);
+
+        glm::mat3 &normal = normalMatrices[slots[i]];
+        normal[0] = glm::cross(c1, c2);
+        normal[1] = glm::cross(c2, c0);
+        normal[2] = glm::cross(c0, c1);
+
+        if (glm::dot(c0, normal[0]) < 0.0f)
+        {
+            normal[0] = -normal[0];
+            normal[1] = -normal[1];
+            normal[2] = -normal[2];
+        }
+    }
+}
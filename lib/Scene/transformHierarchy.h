@@ -0,0 +1,95 @@
+#ifndef TRANSFORM_HIERARCHY
+#define TRANSFORM_HIERARCHY
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+
+#include "../Jobs/jobSystem.h"
+#include "../Profiler/profiler.h"
+#include "../Math/batchMath.h"
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+typedef uint32_t NodeHandle;
+const NodeHandle InvalidNode = UINT32_MAX;
+
+/*  Scene graph of local TRS transforms.
+
+    Nodes are stored in flat arrays sorted by depth, so every parent precedes its children
+    and the world matrices can be computed in a single forward pass. Only nodes whose local
+    transform changed, and their descendants, have their world matrix recomputed. Nodes on
+    the same depth level don't depend on each other, which lets large levels be split
+    across threads.
+
+    Alongside each world matrix a normal matrix is kept so shaders don't have to invert
+    the model matrix per vertex. Subtrees with uniform scale simply reuse the upper 3x3
+    of the world matrix, everything else is batched through SSE. */
+class TransformHierarchy
+{
+    public:
+        /* Constructor */
+        TransformHierarchy();
+
+        /* Creates a node, parents must be created before their children */
+        NodeHandle createNode(const NodeHandle parent = InvalidNode,
+                              const glm::vec3 &position = glm::vec3(0.0f),
+                              const glm::quat &rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f),
+                              const glm::vec3 &scale = glm::vec3(1.0f));
+
+        /* Local transform setters, these mark the node's subtree as dirty */
+        void setPosition(const NodeHandle node, const glm::vec3 &position);
+        void setRotation(const NodeHandle node, const glm::quat &rotation);
+        void setRotation(const NodeHandle node, const glm::vec3 &eulerDegrees);
+        void setScale(const NodeHandle node, const glm::vec3 &scale);
+
+        /* Getters */
+        const glm::vec3 &getPosition(const NodeHandle node) const;
+        const glm::quat &getRotation(const NodeHandle node) const;
+        const glm::vec3 &getScale(const NodeHandle node) const;
+        const glm::mat4 &getWorldMatrix(const NodeHandle node) const;
+        const glm::mat3 &getNormalMatrix(const NodeHandle node) const;
+        bool hasUniformScale(const NodeHandle node) const;
+        NodeHandle getParent(const NodeHandle node) const;
+        size_t size() const;
+
+        /* Recomputes the world matrices of all dirty subtrees */
+        void update();
+
+        /* Optional, depth levels larger than minNodesPerBatch are split into jobs */
+        JobSystem* jobSystem;
+        unsigned int minNodesPerBatch;
+
+    private:
+        /* Depth sorted node data, indexed by slot */
+        std::vector<uint32_t> parentSlots;
+        std::vector<glm::vec3> positions;
+        std::vector<glm::quat> rotations;
+        std::vector<glm::vec3> scales;
+        std::vector<glm::mat4> worldMatrices;
+        std::vector<glm::mat3> normalMatrices;
+        std::vector<uint8_t> uniformScale;
+        std::vector<uint8_t> dirty;
+
+        /* First slot of every depth level, plus a terminating entry */
+        std::vector<uint32_t> levelOffsets;
+
+        /* Handles stay stable while slots move when the arrays are re-sorted */
+        std::vector<uint32_t> handleToSlot;
+        std::vector<NodeHandle> slotToHandle;
+        std::vector<uint32_t> depths;
+
+        bool needsSort;
+        size_t dirtyCount;
+
+        void markDirty(const uint32_t slot);
+        void sortByDepth();
+        void updateRange(const uint32_t begin, const uint32_t end);
+        void computeNormalMatrices(const uint32_t* slots, const size_t count);
+};
+
+#endif
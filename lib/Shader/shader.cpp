@@ -1,88 +1,31 @@
 #include "shader.h"
 
-Shader::Shader(const GLchar* vertexPath, const GLchar* fragmentPath)
-{
-    std::string vertexShaderCode;
-    std::string fragmentShaderCode;
-    const char* vShaderCString;
-    const char* fShaderCString;
-
-    std::ifstream vShaderFile;
-    std::ifstream fShaderFile;
-
-    try
-    {
-        vShaderFile.open(vertexPath);
-        fShaderFile.open(fragmentPath);
-        std::stringstream vStream, fStream;
-
-        /* Read file buffer contents into streams */
-        vStream << vShaderFile.rdbuf();
-        fStream << fShaderFile.rdbuf();
-
-        vShaderFile.close();
-        fShaderFile.close();
-
-        /* Store stream contents in string format */
-        vertexShaderCode = vStream.str();
-        fragmentShaderCode = fStream.str();
-
-        /* Convert to C strings for glShaderSource compatibility */
-        vShaderCString = vertexShaderCode.c_str();
-        fShaderCString = fragmentShaderCode.c_str();
-    }
-    catch (std::ifstream::failure e)
-    {
-        std::cout << "ERROR: Shader -> Unable to load file(s) " << std::endl;
-    }
-
-    unsigned int vertexShader, fragmentShader;
-    int success;
-    char infoLog[512];
-
-    /* Compile vertex shader */
-    vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vShaderCString, NULL);
-    glCompileShader(vertexShader);
+Shader::Shader()
+    : shaderProgramID { 0 }
+{}
 
-    /* Report compilation errors, if any */
-    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-    if(!success)
-    {
-        glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
-        std::cout << "ERROR: Shader -> Vertex shader compilation failed\n" << infoLog << std::endl;
-    }
+Shader::Shader(const GLchar* vertexPath, const GLchar* fragmentPath, const ShaderDefines &defines)
+{
+    /* Resolve #includes and inject the permutation's defines */
+    std::string vertexShaderCode = ShaderPreprocessor::process(vertexPath, defines);
+    std::string fragmentShaderCode = ShaderPreprocessor::process(fragmentPath, defines);
 
-    /* Compile fragment shader */
-    fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fShaderCString, NULL);
-    glCompileShader(fragmentShader);
+    std::string log;
+    shaderProgramID = compileProgram(vertexShaderCode, fragmentShaderCode, log);
 
-    /* Report compilation errors, if any */
-    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
-    if(!success)
-    {
-        glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
-        std::cout << "ERROR: Shader -> Fragment shader compilation failed\n" << infoLog << std::endl;
-    }
+    if (!shaderProgramID)
+        std::cout << "ERROR: Shader -> " << log << std::endl;
+}
 
-    /* Create and link shader program */
-    shaderProgramID = glCreateProgram();
-    glAttachShader(shaderProgramID, vertexShader);
-    glAttachShader(shaderProgramID, fragmentShader);    
-    glLinkProgram(shaderProgramID);
+Shader::Shader(const GLchar* computePath)
+{
+    std::string computeShaderCode = ShaderPreprocessor::process(computePath, ShaderDefines());
 
-    /* Report linking errors, if any */
-    glGetProgramiv(shaderProgramID, GL_LINK_STATUS, &success);
-    if (!success)
-    {
-        glGetProgramInfoLog(shaderProgramID, 512, NULL, infoLog);
-        std::cout << "ERROR: Shader -> Program linking failed\n" << infoLog << std::endl;
-    }
+    std::string log;
+    shaderProgramID = compileComputeProgram(computeShaderCode, log);
 
-    /* Remove shaders after linking */
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+    if (!shaderProgramID)
+        std::cout << "ERROR: Shader -> " << log << std::endl;
 }
 
 void Shader::use()
@@ -100,6 +43,11 @@ void Shader::setInt(const std::string &name, int value) const
     glUniform1i(glGetUniformLocation(shaderProgramID, name.c_str()), value);
 }
 
+void Shader::setUInt(const std::string &name, unsigned int value) const
+{
+    glUniform1ui(glGetUniformLocation(shaderProgramID, name.c_str()), value);
+}
+
 void Shader::setFloat(const std::string &name, float value) const
 {
     glUniform1f(glGetUniformLocation(shaderProgramID, name.c_str()), value);
@@ -110,7 +58,183 @@ void Shader::setVec3(const std::string &name, glm::vec3 vec) const
     glUniform3fv(glGetUniformLocation(shaderProgramID, name.c_str()), 1, &vec[0]);
 }
 
+void Shader::setVec4(const std::string &name, glm::vec4 vec) const
+{
+    glUniform4fv(glGetUniformLocation(shaderProgramID, name.c_str()), 1, &vec[0]);
+}
+
+void Shader::setMat3(const std::string &name, glm::mat3 mat) const
+{
+    glUniformMatrix3fv(glGetUniformLocation(shaderProgramID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+}
+
 void Shader::setMat4(const std::string &name, glm::mat4 mat) const
 {
     glUniformMatrix4fv(glGetUniformLocation(shaderProgramID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
-}
\ No newline at end of file
+}
+
+unsigned int Shader::compileProgram(const std::string &vertexSource, const std::string &fragmentSource, std::string &log)
+{
+    if (vertexSource.empty() || fragmentSource.empty())
+    {
+        log = "Unable to load file(s)";
+        return 0;
+    }
+
+    unsigned int stages[2];
+
+    /* Compile vertex shader */
+    stages[0] = compileStage(GL_VERTEX_SHADER, vertexSource, log);
+    if (!stages[0])
+    {
+        log = "Vertex shader compilation failed\n" + log;
+        return 0;
+    }
+
+    /* Compile fragment shader */
+    stages[1] = compileStage(GL_FRAGMENT_SHADER, fragmentSource, log);
+    if (!stages[1])
+    {
+        glDeleteShader(stages[0]);
+        log = "Fragment shader compilation failed\n" + log;
+        return 0;
+    }
+
+    return linkProgram(stages, 2, log);
+}
+
+unsigned int Shader::compileComputeProgram(const std::string &computeSource, std::string &log)
+{
+    if (computeSource.empty())
+    {
+        log = "Unable to load file";
+        return 0;
+    }
+
+    /* Compute programs consist of a single stage */
+    unsigned int stage = compileStage(GL_COMPUTE_SHADER, computeSource, log);
+    if (!stage)
+    {
+        log = "Compute shader compilation failed\n" + log;
+        return 0;
+    }
+
+    return linkProgram(&stage, 1, log);
+}
+
+bool Shader::rebuildProgram(const unsigned int program, const std::string &vertexSource, const std::string &fragmentSource, std::string &log)
+{
+    if (vertexSource.empty() || fragmentSource.empty())
+    {
+        log = "Unable to load file(s)";
+        return false;
+    }
+
+    unsigned int stages[2];
+
+    stages[0] = compileStage(GL_VERTEX_SHADER, vertexSource, log);
+    if (!stages[0])
+    {
+        log = "Vertex shader compilation failed\n" + log;
+        return false;
+    }
+
+    stages[1] = compileStage(GL_FRAGMENT_SHADER, fragmentSource, log);
+    if (!stages[1])
+    {
+        glDeleteShader(stages[0]);
+        log = "Fragment shader compilation failed\n" + log;
+        return false;
+    }
+
+    /* Link into a scratch program first, a failed link would throw away the working executable */
+    unsigned int scratch = glCreateProgram();
+    glAttachShader(scratch, stages[0]);
+    glAttachShader(scratch, stages[1]);
+    glLinkProgram(scratch);
+
+    int success;
+    glGetProgramiv(scratch, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        char infoLog[1024];
+        glGetProgramInfoLog(scratch, sizeof(infoLog), NULL, infoLog);
+        log = std::string("Program linking failed\n") + infoLog;
+
+        glDeleteProgram(scratch);
+        glDeleteShader(stages[0]);
+        glDeleteShader(stages[1]);
+        return false;
+    }
+
+    glDeleteProgram(scratch);
+
+    /* Known to link, swap the stages of the real program */
+    unsigned int attached[8];
+    int attachedCount = 0;
+    glGetAttachedShaders(program, 8, &attachedCount, attached);
+    for (int i = 0; i < attachedCount; ++i)
+        glDetachShader(program, attached[i]);
+
+    glAttachShader(program, stages[0]);
+    glAttachShader(program, stages[1]);
+    glLinkProgram(program);
+
+    glDeleteShader(stages[0]);
+    glDeleteShader(stages[1]);
+
+    return true;
+}
+
+/* Private */
+unsigned int Shader::compileStage(const GLenum type, const std::string &source, std::string &log)
+{
+    const char* sourceCString = source.c_str();
+
+    unsigned int shader = glCreateShader(type);
+    glShaderSource(shader, 1, &sourceCString, NULL);
+    glCompileShader(shader);
+
+    /* Report compilation errors, if any */
+    int success;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        char infoLog[1024];
+        glGetShaderInfoLog(shader, sizeof(infoLog), NULL, infoLog);
+        log = infoLog;
+
+        glDeleteShader(shader);
+        return 0;
+    }
+
+    return shader;
+}
+
+unsigned int Shader::linkProgram(const unsigned int* stages, const int stageCount, std::string &log)
+{
+    unsigned int program = glCreateProgram();
+    for (int i = 0; i < stageCount; ++i)
+        glAttachShader(program, stages[i]);
+
+    glLinkProgram(program);
+
+    /* Remove shaders after linking */
+    for (int i = 0; i < stageCount; ++i)
+        glDeleteShader(stages[i]);
+
+    /* Report linking errors, if any */
+    int success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        char infoLog[1024];
+        glGetProgramInfoLog(program, sizeof(infoLog), NULL, infoLog);
+        log = std::string("Program linking failed\n") + infoLog;
+
+        glDeleteProgram(program);
+        return 0;
+    }
+
+    return program;
+}
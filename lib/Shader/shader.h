@@ -8,13 +8,17 @@
 #include <sstream>
 #include <glm/glm.hpp>
 
+#include "shaderPreprocessor.h"
+
 class Shader
 {
     public:
         unsigned int shaderProgramID;
 
         /* Constructor */
-        Shader(const GLchar* vertexPath, const GLchar* fragmentPath);
+        Shader();
+        Shader(const GLchar* vertexPath, const GLchar* fragmentPath, const ShaderDefines &defines = ShaderDefines());
+        Shader(const GLchar* computePath);
 
         /* Activator method */
         void use();
@@ -22,9 +26,24 @@ class Shader
         /* Utility methods */
         void setBool(const std::string &name, bool value) const;
         void setInt(const std::string &name, int value) const;
+        void setUInt(const std::string &name, unsigned int value) const;
         void setFloat(const std::string &name, float value) const;
         void setVec3(const std::string &name, glm::vec3 vec) const;
+        void setVec4(const std::string &name, glm::vec4 vec) const;
+        void setMat3(const std::string &name, glm::mat3 mat) const;
         void setMat4(const std::string &name, glm::mat4 mat) const;
+
+        /* Build programs from preprocessed sources. Return 0 and describe the failure in `log` */
+        static unsigned int compileProgram(const std::string &vertexSource, const std::string &fragmentSource, std::string &log);
+        static unsigned int compileComputeProgram(const std::string &computeSource, std::string &log);
+
+        /* Replaces the executable of an existing program, keeping its ID valid for everyone holding it.
+           The new sources are test linked first, on failure `program` is left untouched */
+        static bool rebuildProgram(const unsigned int program, const std::string &vertexSource, const std::string &fragmentSource, std::string &log);
+
+    private:
+        static unsigned int compileStage(const GLenum type, const std::string &source, std::string &log);
+        static unsigned int linkProgram(const unsigned int* stages, const int stageCount, std::string &log);
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,268 @@
+#include "shaderCache.h"
+
+/* Constructor */
+ShaderCache::ShaderCache()
+{}
+
+ShaderCache::~ShaderCache()
+{
+    clear();
+}
+
+Shader ShaderCache::get(const std::string &vertexPath, const std::string &fragmentPath, const ShaderDefines &defines)
+{
+    Shader shader;
+
+    uint64_t key = permutationKey(vertexPath, fragmentPath, defines);
+    auto permutation = permutations.find(key);
+    if (permutation != permutations.end())
+    {
+        shader.shaderProgramID = permutation->second.program;
+        return shader;
+    }
+
+    std::vector<std::string> vertexFiles, fragmentFiles;
+    std::string vertexSource = ShaderPreprocessor::process(vertexPath, defines, &vertexFiles);
+    std::string fragmentSource = ShaderPreprocessor::process(fragmentPath, defines, &fragmentFiles);
+
+    /* Different define sets can still produce the same program, e.g. unused defines */
+    uint64_t sourceHash = ShaderPreprocessor::hash(fragmentSource, ShaderPreprocessor::hash(vertexSource));
+    auto program = programs.find(sourceHash);
+    if (program != programs.end())
+    {
+        permutations[key] = { program->second, vertexPath, fragmentPath, defines };
+        sources[program->second].permutationKeys.push_back(key);
+        shader.shaderProgramID = program->second;
+        return shader;
+    }
+
+    std::string log;
+    shader.shaderProgramID = Shader::compileProgram(vertexSource, fragmentSource, log);
+
+    if (!shader.shaderProgramID)
+    {
+        std::cout << "ERROR: ShaderCache -> " << vertexPath << " + " << fragmentPath << "\n" << log << std::endl;
+        return shader;
+    }
+
+    programs[sourceHash] = shader.shaderProgramID;
+    permutations[key] = { shader.shaderProgramID, vertexPath, fragmentPath, defines };
+
+    ProgramSource &source = sources[shader.shaderProgramID];
+    source.permutationKeys.push_back(key);
+    source.files = vertexFiles;
+    source.files.insert(source.files.end(), fragmentFiles.begin(), fragmentFiles.end());
+    source.sourceHash = sourceHash;
+
+    watchFiles(source.files);
+
+    return shader;
+}
+
+size_t ShaderCache::getPermutationCount() const
+{
+    return permutations.size();
+}
+
+size_t ShaderCache::getProgramCount() const
+{
+    return sources.size();
+}
+
+void ShaderCache::clear()
+{
+    /* Sources holds every program exactly once, the hash table may not after a split */
+    for (const auto &source : sources)
+        glDeleteProgram(source.first);
+
+    programs.clear();
+    permutations.clear();
+    sources.clear();
+}
+
+void ShaderCache::enableHotReload()
+{
+    if (watcher)
+        return;
+
+    watcher.reset(new ShaderWatcher());
+
+    for (const auto &source : sources)
+        watchFiles(source.second.files);
+}
+
+int ShaderCache::update()
+{
+    if (!watcher)
+        return 0;
+
+    std::vector<std::string> modified = watcher->poll();
+    if (modified.empty())
+        return 0;
+
+    /* Collected first, splitting adds to sources while rebuilding */
+    std::vector<uint32_t> affected;
+    for (const auto &source : sources)
+    {
+        for (const std::string &file : modified)
+        {
+            if (std::find(source.second.files.begin(), source.second.files.end(), file) != source.second.files.end())
+            {
+                affected.push_back(source.first);
+                break;
+            }
+        }
+    }
+
+    int rebuilt = 0;
+    for (uint32_t program : affected)
+        rebuilt += rebuild(program);
+
+    return rebuilt;
+}
+
+/* Private */
+int ShaderCache::rebuild(const uint32_t program)
+{
+    /* Permutations grouped by the source they preprocess to now */
+    struct Build
+    {
+        std::string vertexSource, fragmentSource;
+        std::vector<std::string> files;
+        std::vector<uint64_t> keys;
+        uint64_t sourceHash;
+    };
+
+    std::vector<Build> builds;
+    for (uint64_t key : sources[program].permutationKeys)
+    {
+        const Permutation &permutation = permutations[key];
+
+        std::vector<std::string> vertexFiles, fragmentFiles;
+        std::string vertexSource = ShaderPreprocessor::process(permutation.vertexPath, permutation.defines, &vertexFiles);
+        std::string fragmentSource = ShaderPreprocessor::process(permutation.fragmentPath, permutation.defines, &fragmentFiles);
+        uint64_t sourceHash = ShaderPreprocessor::hash(fragmentSource, ShaderPreprocessor::hash(vertexSource));
+
+        auto build = std::find_if(builds.begin(), builds.end(), [&](const Build &build) { return build.sourceHash == sourceHash; });
+        if (build != builds.end())
+        {
+            build->keys.push_back(key);
+            continue;
+        }
+
+        builds.push_back({ vertexSource, fragmentSource, vertexFiles, { key }, sourceHash });
+        builds.back().files.insert(builds.back().files.end(), fragmentFiles.begin(), fragmentFiles.end());
+    }
+
+    /* The first permutation keeps the program, as the one that created it */
+    const Permutation &first = permutations[builds[0].keys[0]];
+
+    std::string log;
+    if (!Shader::rebuildProgram(program, builds[0].vertexSource, builds[0].fragmentSource, log))
+    {
+        std::cout << "ERROR: ShaderCache -> Reloading " << first.vertexPath << " + " << first.fragmentPath
+                  << " failed, keeping the previous program\n" << log << std::endl;
+        return 0;
+    }
+
+    std::cout << "ShaderCache -> Reloaded " << first.vertexPath << " + " << first.fragmentPath << std::endl;
+
+    /* The source hash moved, keep the dedup table pointing at the right program */
+    ProgramSource &source = sources[program];
+    auto previous = programs.find(source.sourceHash);
+    if (previous != programs.end() && previous->second == program)
+        programs.erase(previous);
+
+    source.sourceHash = builds[0].sourceHash;
+    programs[source.sourceHash] = program;
+
+    /* Edits may have added or removed includes */
+    source.permutationKeys = builds[0].keys;
+    source.files = builds[0].files;
+    watchFiles(source.files);
+
+    notifyReload(program);
+    int rebuilt = 1;
+
+    /* Permutations whose defines no longer produce the same source as the first one */
+    for (size_t i = 1; i < builds.size(); ++i)
+    {
+        const Build &build = builds[i];
+        const Permutation &permutation = permutations[build.keys[0]];
+
+        auto existing = programs.find(build.sourceHash);
+        if (existing != programs.end())
+        {
+            movePermutations(build.keys, existing->second);
+            notifyReload(existing->second);
+            continue;
+        }
+
+        uint32_t split = Shader::compileProgram(build.vertexSource, build.fragmentSource, log);
+        if (!split)
+        {
+            std::cout << "ERROR: ShaderCache -> Splitting " << permutation.vertexPath << " + " << permutation.fragmentPath
+                      << " off failed, it keeps sharing the reloaded program\n" << log << std::endl;
+            source.permutationKeys.insert(source.permutationKeys.end(), build.keys.begin(), build.keys.end());
+            continue;
+        }
+
+        std::cout << "ShaderCache -> Split " << build.keys.size() << " permutation(s) of " << permutation.vertexPath << " + "
+                  << permutation.fragmentPath << " off into their own program" << std::endl;
+
+        programs[build.sourceHash] = split;
+        sources[split].sourceHash = build.sourceHash;
+        sources[split].files = build.files;
+        movePermutations(build.keys, split);
+        watchFiles(build.files);
+
+        notifyReload(split);
+        ++rebuilt;
+    }
+
+    return rebuilt;
+}
+
+void ShaderCache::movePermutations(const std::vector<uint64_t> &keys, const uint32_t program)
+{
+    ProgramSource &source = sources[program];
+    for (uint64_t key : keys)
+    {
+        permutations[key].program = program;
+        source.permutationKeys.push_back(key);
+    }
+}
+
+void ShaderCache::watchFiles(const std::vector<std::string> &files)
+{
+    if (!watcher)
+        return;
+
+    for (const std::string &file : files)
+        watcher->watch(file);
+}
+
+void ShaderCache::notifyReload(const uint32_t program)
+{
+    if (!onReload)
+        return;
+
+    Shader shader;
+    shader.shaderProgramID = program;
+    onReload(shader);
+}
+
+uint64_t ShaderCache::permutationKey(const std::string &vertexPath, const std::string &fragmentPath, const ShaderDefines &defines)
+{
+    /* Define order doesn't change the result, sort so it doesn't change the key either */
+    ShaderDefines sortedDefines = defines;
+    std::sort(sortedDefines.begin(), sortedDefines.end());
+
+    uint64_t key = ShaderPreprocessor::hash(vertexPath);
+    key = ShaderPreprocessor::hash("|" + fragmentPath, key);
+
+    for (const std::pair<std::string, std::string> &define : sortedDefines)
+        key = ShaderPreprocessor::hash("|" + define.first + "=" + define.second, key);
+
+    return key;
+}
@@ -0,0 +1,104 @@
+#ifndef SHADER_CACHE
+#define SHADER_CACHE
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <iostream>
+
+#include "shader.h"
+#include "shaderPreprocessor.h"
+#include "shaderWatcher.h"
+
+/*  Compiles and owns shader program permutations.
+
+    A permutation is a vertex/fragment pair plus a set of defines. Lookups hash the paths
+    and the sorted defines, so asking for a known permutation costs one map lookup and no
+    file access. New permutations are preprocessed and the final sources hashed as well,
+    permutations whose defines end up producing identical source share a single program.
+
+    Features toggled this way are resolved at compile time, keeping the branches out of
+    the fragment shader entirely.
+
+    With hot reload enabled, update() rebuilds every program depending on a file that
+    changed on disk. Programs are rebuilt in place so IDs held by materials and draw
+    packets stay valid, and a rebuild that fails to compile or link keeps the previous
+    program running and prints the error log. Every permutation sharing a program is
+    preprocessed again, and when an edit makes their sources differ the program is split:
+    the first permutation keeps the program and the others move to a new or matching one,
+    which onReload is called for as well. Holders of a moved permutation's old ID have to
+    look it up again with get(). */
+class ShaderCache
+{
+    public:
+        /* Constructor */
+        ShaderCache();
+        ~ShaderCache();
+
+        ShaderCache(const ShaderCache&) = delete;
+        ShaderCache &operator=(const ShaderCache&) = delete;
+
+        /* Returns the program for the permutation, compiling it on first use.
+           A failed build returns a Shader with shaderProgramID 0 */
+        Shader get(const std::string &vertexPath, const std::string &fragmentPath, const ShaderDefines &defines = ShaderDefines());
+
+        size_t getPermutationCount() const;
+        size_t getProgramCount() const;
+
+        /* Deletes every program, previously returned Shaders become invalid */
+        void clear();
+
+        /* Starts watching the files of every program, including ones built later */
+        void enableHotReload();
+
+        /* Rebuilds programs whose files changed since the last call, without blocking when
+           nothing did. Must run on the GL thread. Returns the number of programs swapped */
+        int update();
+
+        /* Called for every rebuilt or split off program, whose uniforms are back at their defaults */
+        std::function<void(const Shader&)> onReload;
+
+    private:
+        /* What a permutation is built from, kept to rebuild it */
+        struct Permutation
+        {
+            uint32_t program;
+            std::string vertexPath, fragmentPath;
+            ShaderDefines defines;
+        };
+
+        /* Permutation key -> program */
+        std::unordered_map<uint64_t, Permutation> permutations;
+
+        /* Hash of the preprocessed vertex and fragment source -> program, for sharing only */
+        std::unordered_map<uint64_t, uint32_t> programs;
+
+        /* Every program the cache owns, with the permutations sharing it and the files they read */
+        struct ProgramSource
+        {
+            std::vector<uint64_t> permutationKeys;
+            std::vector<std::string> files;
+            uint64_t sourceHash;
+        };
+
+        std::unordered_map<uint32_t, ProgramSource> sources;
+        std::unique_ptr<ShaderWatcher> watcher;
+
+        /* Returns the number of programs rebuilt or split off */
+        int rebuild(const uint32_t program);
+
+        /* Points the permutations at another program, adding them to its source */
+        void movePermutations(const std::vector<uint64_t> &keys, const uint32_t program);
+
+        void watchFiles(const std::vector<std::string> &files);
+        void notifyReload(const uint32_t program);
+
+        static uint64_t permutationKey(const std::string &vertexPath, const std::string &fragmentPath, const ShaderDefines &defines);
+};
+
+#endif
@@ -0,0 +1,124 @@
+#include "shaderPreprocessor.h"
+
+/* Guards against include cycles the once-only rule can't catch, e.g. a file including itself via a different path */
+#define MAX_INCLUDE_DEPTH 16
+
+std::string ShaderPreprocessor::versionOverride;
+
+std::string ShaderPreprocessor::process(const std::string &path, const ShaderDefines &defines, std::vector<std::string>* files)
+{
+    std::vector<std::string> includedFiles;
+    std::string body;
+
+    if (!expand(path, includedFiles, body, 0))
+        return std::string();
+
+    if (files)
+        *files = includedFiles;
+
+    /* #version has to stay the first statement, defines go right after it */
+    std::string header;
+    size_t versionStart = body.find("#version");
+    if (versionStart != std::string::npos)
+    {
+        size_t versionEnd = body.find('\n', versionStart);
+        versionEnd = versionEnd == std::string::npos ? body.size() : versionEnd + 1;
+
+        header = versionOverride.empty() ? body.substr(0, versionEnd) : body.substr(0, versionStart) + versionOverride + "\n";
+        body.erase(0, versionEnd);
+    }
+
+    for (const std::pair<std::string, std::string> &define : defines)
+        header += "#define " + define.first + (define.second.empty() ? "" : " " + define.second) + "\n";
+
+    return header + body;
+}
+
+uint64_t ShaderPreprocessor::hash(const std::string &text, uint64_t seed)
+{
+    uint64_t hash = seed;
+    for (char character : text)
+    {
+        hash ^= (uint8_t)character;
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
+
+/* Private */
+bool ShaderPreprocessor::expand(const std::string &path, std::vector<std::string> &files, std::string &output, const int depth)
+{
+    if (depth > MAX_INCLUDE_DEPTH)
+    {
+        std::cout << "ERROR: ShaderPreprocessor -> Include depth exceeded in " << path << std::endl;
+        return false;
+    }
+
+    for (const std::string &file : files)
+        if (file == path)
+            return true;
+
+    std::ifstream file(path);
+    if (!file.is_open())
+    {
+        std::cout << "ERROR: ShaderPreprocessor -> Unable to open file " << path << std::endl;
+        return false;
+    }
+
+    const int fileIndex = files.size();
+    files.push_back(path);
+
+    std::string line;
+    int lineNumber = 0;
+    bool seenVersion = false;
+
+    while (std::getline(file, line))
+    {
+        ++lineNumber;
+
+        size_t start = line.find_first_not_of(" \t");
+        if (start != std::string::npos && line.compare(start, 8, "#include") == 0)
+        {
+            size_t open = line.find('"', start);
+            size_t close = open == std::string::npos ? open : line.find('"', open + 1);
+
+            if (close == std::string::npos)
+            {
+                std::cout << "ERROR: ShaderPreprocessor -> Malformed #include in " << path << ":" << lineNumber << std::endl;
+                return false;
+            }
+
+            std::string includePath = directoryOf(path) + line.substr(open + 1, close - open - 1);
+
+            output += "#line 1 " + std::to_string(files.size()) + "\n";
+            if (!expand(includePath, files, output, depth + 1))
+                return false;
+
+            output += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(fileIndex) + "\n";
+            continue;
+        }
+
+        /* Included files must not redeclare the version */
+        if (start != std::string::npos && line.compare(start, 8, "#version") == 0)
+        {
+            if (depth > 0 || seenVersion)
+                continue;
+
+            seenVersion = true;
+            output += line + "\n";
+            output += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(fileIndex) + "\n";
+            continue;
+        }
+
+        output += line + "\n";
+    }
+
+    return true;
+}
+
+std::string ShaderPreprocessor::directoryOf(const std::string &path)
+{
+    size_t slash = path.find_last_of('/');
+    return slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+}
@@ -0,0 +1,39 @@
+#ifndef SHADER_PREPROCESSOR
+#define SHADER_PREPROCESSOR
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <utility>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+
+/* Ordered (name, value) pairs injected as #defines, an empty value defines the bare name */
+typedef std::vector<std::pair<std::string, std::string>> ShaderDefines;
+
+/*  Resolves #include "file" directives relative to the including file and injects defines
+    right after #version. Every file is included at most once. #line directives are
+    emitted so compile errors report "<file index>(<line>)", where the file index points
+    into the `files` list handed back from process(). */
+class ShaderPreprocessor
+{
+    public:
+        /* Returns the final source, or an empty string if any file could not be read.
+           `files` receives every file the result depends on, the root file first */
+        static std::string process(const std::string &path, const ShaderDefines &defines,
+                                   std::vector<std::string>* files = NULL);
+
+        /* 64-bit FNV-1a */
+        static uint64_t hash(const std::string &text, uint64_t seed = 14695981039346656037ull);
+
+        /* Replaces every shader's #version line when not empty, e.g. "#version 450 core" to run
+           the 4.6 shaders on drivers that stop at 4.5 and don't rely on anything newer */
+        static std::string versionOverride;
+
+    private:
+        static bool expand(const std::string &path, std::vector<std::string> &files, std::string &output, const int depth);
+        static std::string directoryOf(const std::string &path);
+};
+
+#endif
@@ -0,0 +1,85 @@
+#include "shaderWatcher.h"
+
+/* Constructor */
+ShaderWatcher::ShaderWatcher()
+    : inotifyFD { -1 }
+{
+#ifdef __linux__
+    inotifyFD = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFD < 0)
+        std::cout << "ERROR: ShaderWatcher -> inotify_init1 failed, hot reload disabled" << std::endl;
+#endif
+}
+
+ShaderWatcher::~ShaderWatcher()
+{
+#ifdef __linux__
+    if (inotifyFD >= 0)
+        close(inotifyFD);
+#endif
+}
+
+void ShaderWatcher::watch(const std::string &path)
+{
+    if (inotifyFD < 0 || !files.insert(path).second)
+        return;
+
+#ifdef __linux__
+    size_t slash = path.find_last_of('/');
+    std::string directory = slash == std::string::npos ? "./" : path.substr(0, slash + 1);
+
+    if (!watchedDirectories.insert(directory).second)
+        return;
+
+    int watchDescriptor = inotify_add_watch(inotifyFD, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+    if (watchDescriptor < 0)
+    {
+        std::cout << "ERROR: ShaderWatcher -> Unable to watch " << directory << std::endl;
+        return;
+    }
+
+    directories[watchDescriptor] = directory;
+#endif
+}
+
+std::vector<std::string> ShaderWatcher::poll()
+{
+    std::vector<std::string> modified;
+
+#ifdef __linux__
+    if (inotifyFD < 0)
+        return modified;
+
+    std::unordered_set<std::string> seen;
+    alignas(inotify_event) char buffer[4096];
+
+    while (true)
+    {
+        ssize_t length = read(inotifyFD, buffer, sizeof(buffer));
+        if (length <= 0)
+            break;
+
+        for (char* cursor = buffer; cursor < buffer + length; cursor += sizeof(inotify_event) + ((inotify_event*)cursor)->len)
+        {
+            const inotify_event* event = (const inotify_event*)cursor;
+
+            auto directory = directories.find(event->wd);
+            if (directory == directories.end() || event->len == 0)
+                continue;
+
+            /* Paths are compared as they were passed to watch(), "./" stands for no directory */
+            std::string path = directory->second == "./" ? std::string(event->name) : directory->second + event->name;
+
+            if (files.count(path) && seen.insert(path).second)
+                modified.push_back(path);
+        }
+    }
+#endif
+
+    return modified;
+}
+
+bool ShaderWatcher::isActive() const
+{
+    return inotifyFD >= 0;
+}
@@ -0,0 +1,49 @@
+#ifndef SHADER_WATCHER
+#define SHADER_WATCHER
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <iostream>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#endif
+
+/*  Reports modified shader files using inotify.
+
+    Directories are watched rather than files, editors commonly save by writing a new file
+    and renaming it over the old one, which would silently end a watch on the file itself.
+    poll() never blocks so it can run once per frame. On platforms without inotify the
+    watcher stays inactive and poll() returns nothing. */
+class ShaderWatcher
+{
+    public:
+        /* Constructor */
+        ShaderWatcher();
+        ~ShaderWatcher();
+
+        ShaderWatcher(const ShaderWatcher&) = delete;
+        ShaderWatcher &operator=(const ShaderWatcher&) = delete;
+
+        void watch(const std::string &path);
+
+        /* Watched files modified since the last call, each reported once */
+        std::vector<std::string> poll();
+
+        bool isActive() const;
+
+    private:
+        int inotifyFD;
+
+        /* Watch descriptor -> directory, with trailing slash */
+        std::unordered_map<int, std::string> directories;
+        std::unordered_set<std::string> watchedDirectories;
+        std::unordered_set<std::string> files;
+};
+
+#endif
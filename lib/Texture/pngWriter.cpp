@@ -0,0 +1,133 @@
+#include "pngWriter.h"
+
+bool PNGWriter::write(const char* path, const int width, const int height, const int channels, const unsigned char* pixels)
+{
+    static const uint8_t colorTypes[5] = { 0, 0, 4, 2, 6 };
+
+    if (width <= 0 || height <= 0 || channels < 1 || channels > 4)
+    {
+        std::cout << "ERROR: PNGWriter -> Unsupported image layout" << std::endl;
+        return false;
+    }
+
+    FILE* file = fopen(path, "wb");
+    if (!file)
+    {
+        std::cout << "ERROR: PNGWriter -> Unable to open " << path << std::endl;
+        return false;
+    }
+
+    static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    fwrite(signature, 1, sizeof(signature), file);
+
+    /* Header: size, 8 bits per channel, color type, deflate, adaptive filtering, no interlace */
+    std::vector<uint8_t> header;
+    pushBigEndian(header, width);
+    pushBigEndian(header, height);
+    header.insert(header.end(), { 8, colorTypes[channels], 0, 0, 0 });
+    writeChunk(file, "IHDR", header);
+
+    /* Each row is prefixed with its filter type, 0 = none */
+    size_t rowSize = (size_t)width * channels;
+    std::vector<uint8_t> raw;
+    raw.reserve((rowSize + 1) * height);
+    for (int y = 0; y < height; ++y)
+    {
+        raw.push_back(0);
+        raw.insert(raw.end(), pixels + y * rowSize, pixels + (y + 1) * rowSize);
+    }
+
+    /* zlib stream made of stored deflate blocks, each at most 65535 bytes */
+    std::vector<uint8_t> data;
+    data.reserve(raw.size() + raw.size() / 65535 * 5 + 16);
+    data.push_back(0x78);
+    data.push_back(0x01);
+
+    size_t offset = 0;
+    do
+    {
+        size_t blockSize = std::min<size_t>(raw.size() - offset, 65535);
+        bool last = offset + blockSize == raw.size();
+
+        data.push_back(last ? 1 : 0);
+        data.push_back(blockSize & 0xFF);
+        data.push_back(blockSize >> 8);
+        data.push_back(~blockSize & 0xFF);
+        data.push_back((~blockSize >> 8) & 0xFF);
+        data.insert(data.end(), raw.begin() + offset, raw.begin() + offset + blockSize);
+
+        offset += blockSize;
+    }
+    while (offset < raw.size());
+
+    /* Adler-32 of the uncompressed data closes the zlib stream */
+    uint32_t a = 1, b = 0;
+    for (size_t i = 0; i < raw.size(); ++i)
+    {
+        a = (a + raw[i]) % 65521;
+        b = (b + a) % 65521;
+    }
+    pushBigEndian(data, (b << 16) | a);
+
+    writeChunk(file, "IDAT", data);
+    writeChunk(file, "IEND", std::vector<uint8_t>());
+
+    bool success = !ferror(file);
+    fclose(file);
+
+    if (!success)
+        std::cout << "ERROR: PNGWriter -> Failed writing " << path << std::endl;
+
+    return success;
+}
+
+/* Private */
+uint32_t PNGWriter::crc32(const uint8_t* data, const size_t size, uint32_t crc)
+{
+    /* Built once, function local statics are initialized thread safely */
+    static const std::vector<uint32_t> table = []()
+    {
+        std::vector<uint32_t> entries(256);
+        for (uint32_t n = 0; n < 256; ++n)
+        {
+            uint32_t c = n;
+            for (int k = 0; k < 8; ++k)
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            entries[n] = c;
+        }
+        return entries;
+    }();
+
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i)
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+
+    return ~crc;
+}
+
+void PNGWriter::writeChunk(FILE* file, const char type[4], const std::vector<uint8_t> &data)
+{
+    std::vector<uint8_t> length;
+    pushBigEndian(length, data.size());
+    fwrite(length.data(), 1, 4, file);
+
+    /* The checksum covers the type and the data, not the length */
+    fwrite(type, 1, 4, file);
+    if (!data.empty())
+        fwrite(data.data(), 1, data.size(), file);
+
+    uint32_t crc = crc32((const uint8_t*)type, 4);
+    crc = crc32(data.data(), data.size(), crc);
+
+    std::vector<uint8_t> checksum;
+    pushBigEndian(checksum, crc);
+    fwrite(checksum.data(), 1, 4, file);
+}
+
+void PNGWriter::pushBigEndian(std::vector<uint8_t> &out, const uint32_t value)
+{
+    out.push_back(value >> 24);
+    out.push_back((value >> 16) & 0xFF);
+    out.push_back((value >> 8) & 0xFF);
+    out.push_back(value & 0xFF);
+}
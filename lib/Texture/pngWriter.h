@@ -0,0 +1,26 @@
+#ifndef PNG_WRITER
+#define PNG_WRITER
+
+#include <cstdint>
+#include <cstdio>
+#include <algorithm>
+#include <vector>
+#include <iostream>
+
+/*  Minimal PNG encoder for screenshots and test output.
+
+    Pixels are stored with deflate's uncompressed blocks and no row filters, so files are
+    roughly the size of the raw image but encoding is a straight copy plus checksums.
+    Accepts 8-bit gray, gray + alpha, RGB or RGBA rows, top row first. */
+class PNGWriter
+{
+    public:
+        static bool write(const char* path, const int width, const int height, const int channels, const unsigned char* pixels);
+
+    private:
+        static uint32_t crc32(const uint8_t* data, const size_t size, uint32_t crc = 0);
+        static void writeChunk(FILE* file, const char type[4], const std::vector<uint8_t> &data);
+        static void pushBigEndian(std::vector<uint8_t> &out, const uint32_t value);
+};
+
+#endif
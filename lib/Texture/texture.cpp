@@ -3,7 +3,50 @@
 /* Public */
 Texture::Texture() {}
 
-unsigned int Texture::load(const char* path, int width, int height)
+unsigned int Texture::load(const char* path)
+{
+    stbi_set_flip_vertically_on_load(true);
+    DecodedImage image = decode(path);
+
+    return upload(path, image);
+}
+
+std::vector<unsigned int> Texture::loadBatch(const std::vector<const char*> &paths, JobSystem &jobSystem)
+{
+    /* stb's flip flag is global, so set it once before any decode job starts */
+    stbi_set_flip_vertically_on_load(true);
+
+    std::vector<DecodedImage> images(paths.size());
+    jobSystem.parallelFor(paths.size(), 1, [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t i = begin; i < end; ++i)
+            images[i] = decode(paths[i]);
+    });
+
+    std::vector<unsigned int> textures;
+    for (size_t i = 0; i < paths.size(); ++i)
+        textures.push_back(upload(paths[i], images[i]));
+
+    return textures;
+}
+
+DecodedImage Texture::decode(const char* path)
+{
+    DecodedImage image;
+    image.data = stbi_load(path, &image.width, &image.height, &image.channels, 0);
+
+    return image;
+}
+
+DecodedImage Texture::decode(const unsigned char* data, const size_t size)
+{
+    DecodedImage image;
+    image.data = stbi_load_from_memory(data, (int)size, &image.width, &image.height, &image.channels, 0);
+
+    return image;
+}
+
+unsigned int Texture::upload(const char* path, DecodedImage &image)
 {
     unsigned int texture;
     glGenTextures(1, &texture);
@@ -29,15 +72,21 @@ unsigned int Texture::load(const char* path, int width, int height)
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-    /* Load and generate the texture */
-    int nrChannels;
-    stbi_set_flip_vertically_on_load(true);
-    unsigned char* data = stbi_load(path, &width, &height, &nrChannels, 0);
-
-    if (data)
+    /* Generate the texture from the decoded pixels */
+    if (image.data)
     {
-        int colorMode = getColorModeFromFileExt(path);
-        glTexImage2D(GL_TEXTURE_2D, 0, colorMode, width, height, 0, colorMode, GL_UNSIGNED_BYTE, data);
+        /* Images keep the channels they were stored with, grey ones are read back as grey */
+        int colorMode = getColorModeFromChannels(image.channels);
+        if (image.channels <= 2)
+        {
+            GLint swizzle[4] = { GL_RED, GL_RED, GL_RED, image.channels == 2 ? GL_GREEN : GL_ONE };
+            glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+        }
+
+        /* Rows are tightly packed, which only matches GL's default 4 byte alignment for some widths */
+        glPixelStorei(GL_UNPACK_ALIGNMENT, (image.width * image.channels) % 4 == 0 ? 4 : 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, colorMode, image.width, image.height, 0, colorMode, GL_UNSIGNED_BYTE, image.data);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
         glGenerateMipmap(GL_TEXTURE_2D);
     }
 
@@ -47,16 +96,20 @@ unsigned int Texture::load(const char* path, int width, int height)
     }
 
     /* Free image memory */
-    stbi_image_free(data);
+    stbi_image_free(image.data);
+    image.data = NULL;
 
     return texture;
 }
 
 /* Private */
-int Texture::getColorModeFromFileExt(const char* path)
+int Texture::getColorModeFromChannels(const int channels)
 {
-    const char* extension = path + (strlen(path) - 3);
-    int colorMode = strcmp(extension, "png") == 0 ? GL_RGBA : GL_RGB;
-
-    return colorMode;
+    switch (channels)
+    {
+        case 1:  return GL_RED;
+        case 2:  return GL_RG;
+        case 3:  return GL_RGB;
+        default: return GL_RGBA;
+    }
 }
\ No newline at end of file
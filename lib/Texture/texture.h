@@ -4,17 +4,36 @@
 #include <glad/glad.h>
 // #include <glfw3.h>
 #include <iostream>
+#include <vector>
 #include "stb_image.cpp"
+#include "../Jobs/jobSystem.h"
+
+/* CPU side pixels of a decoded image file */
+struct DecodedImage
+{
+    unsigned char* data;
+    int width, height, channels;
+};
 
 class Texture
 {
     public:
         Texture();
-        unsigned int load(const char* path, int width, int height);
+        unsigned int load(const char* path);
+
+        /* Decodes every file on the job system, then uploads them in order on the calling thread */
+        std::vector<unsigned int> loadBatch(const std::vector<const char*> &paths, JobSystem &jobSystem);
+
+        /* Decoding is thread safe, uploading needs the GL context's thread */
+        static DecodedImage decode(const char* path);
+
+        /* Same for an encoded file already in memory, e.g. an image embedded in a glTF binary */
+        static DecodedImage decode(const unsigned char* data, const size_t size);
+        unsigned int upload(const char* path, DecodedImage &image);
     private:
         int currentTexUnits = 0;
         int maxTexUnits = 32;
-        int getColorModeFromFileExt(const char* path);
+        int getColorModeFromChannels(const int channels);
 };
 
 #endif
\ No newline at end of file
@@ -5,11 +5,22 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include <iostream>
+#include <cstring>
+#include <cstdlib>
 
 /* B defined classes */
+#include "lib/Jobs/jobSystem.cpp"
+#include "lib/Profiler/profiler.cpp"
+#include "lib/Shader/shaderPreprocessor.cpp"
 #include "lib/Shader/shader.cpp"
 #include "lib/Texture/texture.cpp"
 #include "lib/Camera/camera.cpp"
+#include "lib/Render/commandList.cpp"
+#include "lib/Render/glBackend.cpp"
+#include "lib/Render/renderThread.cpp"
+#include "lib/Platform/headlessContext.cpp"
+#include "lib/Texture/pngWriter.cpp"
+#include "lib/Profiler/frameStats.cpp"
 
 const unsigned int width = 800, height = 600;
 Camera camera;
@@ -21,10 +32,38 @@ float lastFrameMouseX = width  / 2;
 float lastFrameMouseY = height / 2;
 bool isFirstMouseMovement = true;
 
+/* Current framebuffer size, applied by the render thread at the start of each frame */
+int framebufferWidth = width, framebufferHeight = height;
+
+/* World space cube positions */
+glm::vec3 cubePositions[] = {
+    glm::vec3( 0.0f,  0.0f,  0.0f),
+    glm::vec3( 2.0f,  5.0f, -15.0f),
+    glm::vec3(-1.5f, -2.2f, -2.5f),
+    glm::vec3(-3.8f, -2.0f, -12.3f),
+    glm::vec3( 2.4f, -0.4f, -3.5f),
+    glm::vec3(-1.7f,  3.0f, -7.5f),
+    glm::vec3( 1.3f, -2.0f, -2.5f),
+    glm::vec3( 1.5f,  2.0f, -2.5f),
+    glm::vec3( 1.5f,  0.2f, -1.5f),
+    glm::vec3(-1.3f,  1.0f, -1.5f)
+};
+
+/* Command line switches for running without a window, e.g. on CI */
+struct HeadlessOptions
+{
+    bool enabled;
+    int frames;
+    int width, height;
+    const char* screenshotPath;     /* PNG of the final frame, NULL to skip */
+};
+
 /* Define window resize callback to adjust viewport */
+/* Runs on the main thread, which doesn't own the GL context while rendering */
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
-    glViewport(0, 0, width, height);
+    framebufferWidth = width;
+    framebufferHeight = height;
 }
 
 /* Keyboard event handler */
@@ -156,7 +195,7 @@ void defineRectangle()
     glEnableVertexAttribArray(2);
 }
 
-void defineCube()
+unsigned int defineCube()
 {
     float vertices[] = {
         -0.5f, -0.5f, -0.5f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f,
@@ -223,28 +262,168 @@ void defineCube()
     /* Texture Co-ordinate attribute */
     glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 8, (void*)(sizeof(float) * 6));
     glEnableVertexAttribArray(2);
+
+    return VAO;
 }
 
 /* Compute the multiplication of the Model - View - Projection matrices */
-glm::mat4 getMVPMatrix(glm::vec3 startPos)
+glm::mat4 getMVPMatrix(glm::vec3 startPos, const float time, const float aspectRatio)
 {
     glm::mat4 model, view, proj;
     model = view = proj = glm::mat4(1.0f);
 
     /* Position model and rotate around X axis */
     model = glm::translate(model, startPos);
-    model = glm::rotate(model, (float)glfwGetTime() * glm::radians(-55.0f), glm::vec3(1.0f, 1.0f, 0.0f));
+    model = glm::rotate(model, time * glm::radians(-55.0f), glm::vec3(1.0f, 1.0f, 0.0f));
 
     view = camera.getViewMatrix();
 
     /* Apply perspective transformation */
-    proj = glm::perspective(glm::radians(45.0f), (float)(width / height), 0.1f, 100.0f);
+    proj = glm::perspective(glm::radians(45.0f), aspectRatio, 0.1f, 100.0f);
 
     return proj * view * model;
 }
 
-int main(void)
+/* Records the whole scene, shared by the windowed and headless loops */
+void recordScene(CommandList &commands, const uint32_t program, const uint32_t cubeVAO, const float time,
+                 const int viewportWidth, const int viewportHeight)
+{
+    /* Depth state is part of the recording, so headless frames match the window */
+    commands.setDepthState(true, true, DepthFunction::Less);
+
+    /* Clear screen color */
+    commands.setViewport(0, 0, viewportWidth, viewportHeight);
+    commands.clear(glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
+
+    commands.useProgram(program);
+    commands.bindVertexArray(cubeVAO);
+
+    const float aspectRatio = (float)viewportWidth / (float)std::max(viewportHeight, 1);
+    for (int i = 0; i < 10; ++i)
+    {
+        /* Pass Model View Projection matrix into vertex shader */
+        commands.setUniform("mvp", getMVPMatrix(cubePositions[i], time, aspectRatio));
+        commands.drawArrays(PrimitiveType::Triangles, 0, 36);
+    }
+}
+
+/* Fixed camera path for headless runs, one slow orbit around the cubes over the whole run */
+void placeCameraOnPath(const float t)
+{
+    const glm::vec3 center(0.0f, 0.0f, -6.0f);
+    const float angle = t * glm::radians(360.0f);
+
+    camera.pos = center + glm::vec3(glm::sin(angle) * 10.0f, 2.0f * glm::sin(angle * 2.0f), glm::cos(angle) * 10.0f);
+    camera.front = glm::normalize(center - camera.pos);
+}
+
+/* --headless [--frames N] [--size WxH] [--screenshot out.png] */
+HeadlessOptions parseArguments(int argc, char** argv)
+{
+    HeadlessOptions options = { false, 300, (int)width, (int)height, NULL };
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "--headless"))
+            options.enabled = true;
+        else if (!strcmp(argv[i], "--frames") && i + 1 < argc)
+            options.frames = std::max(atoi(argv[++i]), 1);
+        else if (!strcmp(argv[i], "--size") && i + 1 < argc)
+        {
+            if (sscanf(argv[++i], "%dx%d", &options.width, &options.height) != 2 || options.width <= 0 || options.height <= 0)
+            {
+                std::cout << "ERROR: Main -> Invalid --size, expected WIDTHxHEIGHT" << std::endl;
+                options.width = width;
+                options.height = height;
+            }
+        }
+        else if (!strcmp(argv[i], "--screenshot") && i + 1 < argc)
+            options.screenshotPath = argv[++i];
+        else
+            std::cout << "WARNING: Main -> Ignoring unknown argument " << argv[i] << std::endl;
+    }
+
+    return options;
+}
+
+/* Renders a fixed number of frames offscreen and reports how long they took */
+int runHeadless(const HeadlessOptions &options)
+{
+    HeadlessContext context(options.width, options.height);
+    if (!context.isValid())
+        return -1;
+
+    /* The shaders only need 4.5 features, let them build on software rasterizers stuck at 4.5 */
+    GLint majorVersion = 0, minorVersion = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &majorVersion);
+    glGetIntegerv(GL_MINOR_VERSION, &minorVersion);
+    if (majorVersion * 10 + minorVersion < 46)
+        ShaderPreprocessor::versionOverride = "#version 450 core";
+
+    unsigned int cubeVAO = defineCube();
+
+    JobSystem jobSystem;
+
+    Texture myTextures;
+    myTextures.loadBatch({ "assets/Textures/wood_container.jpg", "assets/Textures/awesome_face.png" }, jobSystem);
+
+    Shader myShaders("shaders/v.vert", "shaders/f.frag");
+    if (!myShaders.shaderProgramID)
+        return -1;
+
+    myShaders.use();
+    myShaders.setInt("texture0", 0);
+    myShaders.setInt("texture1", 1);
+
+    CommandList commands;
+    GLBackend backend;
+
+    /* CPU time covers recording and submission, frame time also waits for the GPU to finish */
+    std::vector<double> cpuTimes, frameTimes;
+    cpuTimes.reserve(options.frames);
+    frameTimes.reserve(options.frames);
+
+    for (int frame = 0; frame < options.frames; ++frame)
+    {
+        /* Time advances by a fixed step so every run renders the exact same frames */
+        const float time = frame / 60.0f;
+        placeCameraOnPath((float)frame / options.frames);
+
+        uint64_t frameStart = Profiler::now();
+
+        commands.reset();
+        commands.bindFramebuffer(context.getFramebuffer());
+        recordScene(commands, myShaders.shaderProgramID, cubeVAO, time, options.width, options.height);
+        backend.execute(commands);
+
+        uint64_t submitted = Profiler::now();
+        glFinish();
+        uint64_t frameEnd = Profiler::now();
+
+        cpuTimes.push_back((submitted - frameStart) / 1000000.0);
+        frameTimes.push_back((frameEnd - frameStart) / 1000000.0);
+    }
+
+    std::cout << "Headless run at " << options.width << "x" << options.height << " on " << glGetString(GL_RENDERER) << std::endl;
+    printFrameTimeStats("CPU", computeFrameTimeStats(cpuTimes));
+    printFrameTimeStats("Frame", computeFrameTimeStats(frameTimes));
+
+    if (options.screenshotPath)
+    {
+        std::vector<unsigned char> pixels = context.readPixels();
+        if (!PNGWriter::write(options.screenshotPath, options.width, options.height, 4, pixels.data()))
+            return -1;
+    }
+
+    return 0;
+}
+
+int main(int argc, char** argv)
 {
+    HeadlessOptions options = parseArguments(argc, argv);
+    if (options.enabled)
+        return runHeadless(options);
+
     GLFWwindow* window;
 
     /* Initialize the library */
@@ -277,25 +456,14 @@ int main(void)
     glEnable(GL_DEPTH_TEST);
 
     /* Define the cube and load its vertices into buffers */
-    defineCube();
-
-    /* World space cube positions */
-    glm::vec3 cubePositions[] = {
-        glm::vec3( 0.0f,  0.0f,  0.0f),
-        glm::vec3( 2.0f,  5.0f, -15.0f),
-        glm::vec3(-1.5f, -2.2f, -2.5f),
-        glm::vec3(-3.8f, -2.0f, -12.3f),
-        glm::vec3( 2.4f, -0.4f, -3.5f),
-        glm::vec3(-1.7f,  3.0f, -7.5f),
-        glm::vec3( 1.3f, -2.0f, -2.5f),
-        glm::vec3( 1.5f,  2.0f, -2.5f),
-        glm::vec3( 1.5f,  0.2f, -1.5f),
-        glm::vec3(-1.3f,  1.0f, -1.5f)
-    };
+    unsigned int cubeVAO = defineCube();
+
+    /* Worker threads, the main thread joins in whenever it waits on jobs */
+    JobSystem jobSystem;
 
+    /* Decode both images in parallel, upload binds them to texture units 0 and 1 */
     Texture myTextures;
-    myTextures.load("assets/Textures/wood_container.jpg", 512, 512);
-    myTextures.load("assets/Textures/awesome_face.png", 512, 512);
+    myTextures.loadBatch({ "assets/Textures/wood_container.jpg", "assets/Textures/awesome_face.png" }, jobSystem);
 
     /* Compile and load shaders */
     Shader myShaders("shaders/v.vert", "shaders/f.frag");
@@ -305,34 +473,29 @@ int main(void)
     myShaders.setInt("texture0", 0);
     myShaders.setInt("texture1", 1);
 
+    /* Hand the GL context over to the render thread, from here on the main thread
+       only records command lists while the previous frame is being submitted */
+    RenderThread renderThread(window, 2);
+
     /* Loop until the user closes the window */
     while (!glfwWindowShouldClose(window))
     {
         /* Listen for keyboard events */
         handleKeyboardEvents(window);
 
-        /* Clear screen color */
-        glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        for (int i = 0; i < 10; ++i)
-        {
-            glm::mat4 mvpMatrix = getMVPMatrix(cubePositions[i]);
-
-            /* Pass Model View Projection matrix into vertex shader */
-            int mvpUniformLoc = glGetUniformLocation(myShaders.shaderProgramID, "mvp");
-            glUniformMatrix4fv(mvpUniformLoc, 1, GL_FALSE, glm::value_ptr(mvpMatrix));
+        CommandList &commands = renderThread.beginFrame();
 
-            glDrawArrays(GL_TRIANGLES, 0, 36);
-        }
+        recordScene(commands, myShaders.shaderProgramID, cubeVAO, glfwGetTime(), framebufferWidth, framebufferHeight);
 
-        /* Swap front and back buffers */
-        glfwSwapBuffers(window);
+        /* Render thread replays the list and swaps front and back buffers */
+        renderThread.submitFrame();
 
         /* Poll for and process events */
         glfwPollEvents();
     }
 
+    renderThread.stop();
+
     glfwTerminate();
     return 0;
 }
\ No newline at end of file
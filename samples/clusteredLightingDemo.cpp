@@ -0,0 +1,351 @@
+#include <glad/glad.h>
+#include <glfw3.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <iostream>
+
+#include "../lib/Jobs/jobSystem.cpp"
+#include "../lib/Profiler/profiler.cpp"
+#include "../lib/Shader/shaderPreprocessor.cpp"
+#include "../lib/Shader/shader.cpp"
+#include "../lib/Texture/texture.cpp"
+#include "../lib/Camera/camera.cpp"
+#include "../lib/ECS/ecs.cpp"
+#include "../lib/ECS/components.h"
+#include "../lib/Math/batchMath.cpp"
+#include "../lib/Scene/transformHierarchy.cpp"
+#include "../lib/Culling/frustum.cpp"
+#include "../lib/Culling/entityCuller.cpp"
+#include "../lib/Render/commandList.cpp"
+#include "../lib/Render/glBackend.cpp"
+#include "../lib/Render/renderQueue.cpp"
+#include "../lib/Render/frameRingBuffer.cpp"
+#include "../lib/Lighting/clusteredLighting.cpp"
+
+#include <random>
+
+/* Lights scattered over the cube field, far more than lighting.frag's fixed array allows */
+#define POINT_LIGHTS 512
+
+/* Cube field dimensions, FIELD_SIZE^2 cubes in total */
+const int FIELD_SIZE = 32;
+const float FIELD_SPACING = 2.0f;
+const unsigned int width = 800, height = 600;
+Camera camera;
+
+float frameDeltaTime = 0.0f;
+float lastFrameTimestamp = 0.0f;
+
+float lastFrameMouseX = width  / 2;
+float lastFrameMouseY = height / 2;
+bool isFirstMouseMovement = true;
+
+unsigned int VAO, lightVAO;
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+    glViewport(0, 0, width, height);
+}
+
+void handleKeyboardEvents(GLFWwindow *window)
+{
+    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+        glfwSetWindowShouldClose(window, true);
+
+    float currentFrameTimestamp = glfwGetTime();
+    frameDeltaTime = currentFrameTimestamp - lastFrameTimestamp;
+    lastFrameTimestamp = currentFrameTimestamp;
+
+    float cameraSpeed = 4.0f * frameDeltaTime;
+    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+        camera.moveForward(cameraSpeed);
+    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+        camera.moveBackward(cameraSpeed);
+    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+        camera.moveLeft(cameraSpeed);
+    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+        camera.moveRight(cameraSpeed);
+}
+
+void mouse_movement_callback(GLFWwindow *window, double xPos, double yPos)
+{
+    if (isFirstMouseMovement)
+    {
+        lastFrameMouseX = xPos;
+        lastFrameMouseY = yPos;
+        isFirstMouseMovement = false;
+    }
+
+   float xOffset = xPos - lastFrameMouseX;
+   float yOffset = lastFrameMouseY - yPos;
+
+   lastFrameMouseX = xPos;
+   lastFrameMouseY = yPos;
+
+   camera.processMouseMovement(xOffset, yOffset);
+}
+
+void defineCube()
+{
+    float vertices[] = {
+        /* Vertex Position */ /* Normal Vector */ /* Texture Co-ordinates */
+        -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f, 0.0f,
+        0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f, 0.0f,
+        0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f, 1.0f,
+        0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f, 1.0f,
+        -0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f, 1.0f,
+        -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f, 0.0f,
+
+        -0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   0.0f, 0.0f,
+        0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   1.0f, 0.0f,
+        0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   1.0f, 1.0f,
+        0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   1.0f, 1.0f,
+        -0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   0.0f, 1.0f,
+        -0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   0.0f, 0.0f,
+
+        -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
+        -0.5f,  0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  1.0f, 1.0f,
+        -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
+        -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
+        -0.5f, -0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  0.0f, 0.0f,
+        -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
+
+        0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
+        0.5f,  0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f,
+        0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
+        0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
+        0.5f, -0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  0.0f, 0.0f,
+        0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
+
+        -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f, 1.0f,
+        0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  1.0f, 1.0f,
+        0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f, 0.0f,
+        0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f, 0.0f,
+        -0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  0.0f, 0.0f,
+        -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f, 1.0f,
+
+        -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f, 1.0f,
+        0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  1.0f, 1.0f,
+        0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f, 0.0f,
+        0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f, 0.0f,
+        -0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  0.0f, 0.0f,
+        -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f, 1.0f
+    };
+
+    unsigned int VBO;
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+
+    glBindVertexArray(VAO);
+
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 8, (void*)0);
+    glEnableVertexAttribArray(0);
+
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 8, (void*)(sizeof(float) * 3));
+    glEnableVertexAttribArray(1);
+
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 8, (void*)(sizeof(float) * 6));
+    glEnableVertexAttribArray(2);
+
+    glGenVertexArrays(1, &lightVAO);
+    glBindVertexArray(lightVAO);
+
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 8, (void*)0);
+    glEnableVertexAttribArray(0);
+}
+
+
+int main(void)
+{
+    GLFWwindow* window;
+
+    if (!glfwInit())
+        return -1;
+
+    window = glfwCreateWindow(width, height, "Clustered Lighting", NULL, NULL);
+    if (!window)
+    {
+        glfwTerminate();
+        return -1;
+    }
+
+    glfwMakeContextCurrent(window);
+
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+
+    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+    glfwSetCursorPosCallback(window, mouse_movement_callback);
+
+    gladLoadGL();
+
+    glEnable(GL_DEPTH_TEST);
+
+    defineCube();
+
+    JobSystem jobSystem;
+
+    Texture materialMaps;
+    std::vector<unsigned int> materialMapIDs = materialMaps.loadBatch({
+        "assets/Textures/diffuse_wood_container.png",
+        "assets/Textures/specular_wood_container.png"
+    }, jobSystem);
+
+    Shader clusteredShader("shaders/lighting.vert", "shaders/clustered.frag");
+    clusteredShader.use();
+    clusteredShader.setInt("material.diffuse", 0);
+    clusteredShader.setInt("material.specular", 1);
+    clusteredShader.setFloat("material.shine", 0.4f * 128.0f);
+
+    clusteredShader.setVec3("dirLight.direction", glm::vec3(-0.2f, -1.0f, -0.3f));
+    clusteredShader.setVec3("dirLight.ambient", glm::vec3(0.02f, 0.02f, 0.02f));
+    clusteredShader.setVec3("dirLight.diffuse", glm::vec3(0.05f, 0.05f, 0.05f));
+    clusteredShader.setVec3("dirLight.specular", glm::vec3(0.1f, 0.1f, 0.1f));
+
+    Shader lampShader("shaders/lamp.vert", "shaders/lamp.frag");
+
+    World world;
+    TransformHierarchy hierarchy;
+    hierarchy.jobSystem = &jobSystem;
+
+    const MeshRef cubeMesh = { VAO, 0, 36, false };
+    const MaterialRef woodMaterial = { clusteredShader.shaderProgramID, materialMapIDs[0], materialMapIDs[1], 0.4f * 128.0f };
+    const Bounds cubeBounds = { glm::vec3(0.0f), glm::vec3(0.5f) };
+
+    const float fieldExtent = FIELD_SIZE * FIELD_SPACING;
+    const glm::vec3 fieldOrigin = glm::vec3(-fieldExtent * 0.5f, -2.0f, 0.0f);
+
+    for (int x = 0; x < FIELD_SIZE; ++x)
+    for (int z = 0; z < FIELD_SIZE; ++z)
+    {
+        glm::vec3 position = fieldOrigin + glm::vec3(x, 0.0f, -z) * FIELD_SPACING;
+
+        SceneNode node = { hierarchy.createNode(InvalidNode, position) };
+        world.createEntity(Transform { position, glm::vec3(0.0f), glm::vec3(1.0f) }, node, cubeMesh, woodMaterial, cubeBounds);
+    }
+
+    // Coloured lamps with short ranges so each cluster only sees a handful of them
+    const MeshRef lampMesh = { lightVAO, 0, 36, false };
+    const MaterialRef lampMaterial = { lampShader.shaderProgramID, 0, 0, 0.0f };
+
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    for (int i = 0; i < POINT_LIGHTS; ++i)
+    {
+        glm::vec3 position = fieldOrigin + glm::vec3(unit(random) * fieldExtent, 0.5f + unit(random) * 1.5f, -unit(random) * fieldExtent);
+        glm::vec3 color = glm::vec3(unit(random), unit(random), unit(random));
+
+        const PointLight light = { color * 0.02f, color, glm::vec3(1.0f), 1.0f, 0.35f, 0.44f };
+
+        SceneNode node = { hierarchy.createNode(InvalidNode, position, glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(0.1f)) };
+        world.createEntity(Transform { position, glm::vec3(0.0f), glm::vec3(0.1f) }, node, lampMesh, lampMaterial, cubeBounds, light);
+    }
+
+    const float aspectRatio = (float)width / (float)height;
+    const glm::mat4 proj = camera.getProjectionMatrix(aspectRatio);
+
+    ClusteredLighting clusteredLighting;
+    clusteredLighting.setProjection(proj, camera.nearPlane, camera.farPlane, width, height);
+
+    std::vector<Entity> visibleEntities;
+    std::vector<GpuPointLight> frameLights;
+    frameLights.reserve(POINT_LIGHTS);
+
+    RenderQueue renderQueue(camera.nearPlane, camera.farPlane);
+    CommandList commands;
+    GLBackend backend;
+    FrameRingBuffer frameData(2 * 1024 * 1024);
+
+    while (!glfwWindowShouldClose(window))
+    {
+        handleKeyboardEvents(window);
+
+        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        glm::mat4 view = camera.getViewMatrix();
+
+        clusteredShader.use();
+        clusteredShader.setVec3("cameraPos", camera.pos);
+
+        frameData.beginFrame();
+        glm::mat4 frameMatrices[2] = { view, proj };
+        RingAllocation frameUniforms = frameData.allocateUniform(sizeof(frameMatrices));
+        memcpy(frameUniforms.data, frameMatrices, sizeof(frameMatrices));
+
+        // Bob the lamps up and down so cluster assignment changes every frame
+        float time = glfwGetTime();
+        frameLights.clear();
+        world.view<Transform, SceneNode, PointLight>().each([&](Transform &transform, SceneNode &node, PointLight &light)
+        {
+            glm::vec3 position = transform.position + glm::vec3(0.0f, sinf(time + transform.position.x), 0.0f);
+            hierarchy.setPosition(node.node, position);
+
+            GpuPointLight gpuLight;
+            gpuLight.positionRange = glm::vec4(position, ClusteredLighting::computeRange(light));
+            gpuLight.ambient = glm::vec4(light.ambient, 0.0f);
+            gpuLight.diffuse = glm::vec4(light.diffuse, 0.0f);
+            gpuLight.specular = glm::vec4(light.specular, 0.0f);
+            gpuLight.attenuation = glm::vec4(light.attConstant, light.attLinear, light.attQuadratic, 0.0f);
+            frameLights.push_back(gpuLight);
+        });
+
+        hierarchy.update();
+
+        clusteredLighting.assignLights(frameLights, view, jobSystem);
+
+        cullEntities(world, hierarchy, Frustum(proj * view), jobSystem, visibleEntities);
+
+        renderQueue.reset();
+        for (const Entity &entity : visibleEntities)
+        {
+            const SceneNode* node = world.getComponent<SceneNode>(entity);
+            const MeshRef* mesh = world.getComponent<MeshRef>(entity);
+            const MaterialRef* material = world.getComponent<MaterialRef>(entity);
+
+            if (!mesh || !material)
+                continue;
+
+            DrawPacket packet;
+            packet.program = material->shaderProgramID;
+            packet.vertexArray = mesh->VAO;
+            packet.diffuseMap = material->diffuseMapID;
+            packet.specularMap = material->specularMapID;
+            packet.material = 0;
+            packet.shine = 0.0f;
+            packet.first = mesh->firstVertex;
+            packet.count = mesh->vertexCount;
+            packet.indexed = mesh->indexed;
+            packet.model = hierarchy.getWorldMatrix(node->node);
+            packet.normalMatrix = hierarchy.getNormalMatrix(node->node);
+
+            float viewDepth = glm::dot(glm::vec3(packet.model[3]) - camera.pos, camera.front);
+            renderQueue.submit(packet, RenderPass::Opaque, false, viewDepth);
+        }
+
+        renderQueue.sort();
+
+        commands.reset();
+        commands.bindBufferRange(BufferTarget::Uniform, 0, frameUniforms.buffer, frameUniforms.offset, frameUniforms.size);
+        clusteredLighting.upload(frameData, commands, clusteredShader.shaderProgramID);
+        renderQueue.record(commands);
+
+        backend.invalidateState();
+        backend.execute(commands);
+
+        frameData.endFrame();
+
+        glfwSwapBuffers(window);
+
+        glfwPollEvents();
+    }
+
+    glfwTerminate();
+    return 0;
+}
@@ -0,0 +1,480 @@
+#include <glad/glad.h>
+#include <glfw3.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <memory>
+
+#include "../lib/Jobs/jobSystem.cpp"
+#include "../lib/Profiler/profiler.cpp"
+#include "../lib/Shader/shaderPreprocessor.cpp"
+#include "../lib/Shader/shader.cpp"
+#include "../lib/Texture/texture.cpp"
+#include "../lib/Camera/camera.cpp"
+#include "../lib/ECS/ecs.cpp"
+#include "../lib/ECS/components.h"
+#include "../lib/Math/batchMath.cpp"
+#include "../lib/Scene/transformHierarchy.cpp"
+#include "../lib/Culling/frustum.cpp"
+#include "../lib/Culling/entityCuller.cpp"
+#include "../lib/Render/commandList.cpp"
+#include "../lib/Render/glBackend.cpp"
+#include "../lib/Render/renderQueue.cpp"
+#include "../lib/Render/frameRingBuffer.cpp"
+#include "../lib/Render/gBuffer.cpp"
+#include "../lib/Lighting/clusteredLighting.cpp"
+#include "../lib/Platform/headlessContext.cpp"
+#include "../lib/Texture/pngWriter.cpp"
+#include "../lib/Profiler/frameStats.cpp"
+
+#include <random>
+
+/* Lights scattered over the cube field, shaded once per pixel in the lighting pass */
+#define POINT_LIGHTS 512
+
+/* Cube field dimensions, FIELD_SIZE^2 cubes in total */
+const int FIELD_SIZE = 32;
+const float FIELD_SPACING = 2.0f;
+const unsigned int width = 800, height = 600;
+Camera camera;
+
+float frameDeltaTime = 0.0f;
+float lastFrameTimestamp = 0.0f;
+
+float lastFrameMouseX = width  / 2;
+float lastFrameMouseY = height / 2;
+bool isFirstMouseMovement = true;
+
+unsigned int VAO, lightVAO;
+
+/* Command line switches for running without a window, e.g. on CI */
+struct HeadlessOptions
+{
+    bool enabled;
+    int frames;
+    int width, height;
+    const char* screenshotPath;     /* PNG of the final frame, NULL to skip */
+};
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+    glViewport(0, 0, width, height);
+}
+
+void handleKeyboardEvents(GLFWwindow *window)
+{
+    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+        glfwSetWindowShouldClose(window, true);
+
+    float currentFrameTimestamp = glfwGetTime();
+    frameDeltaTime = currentFrameTimestamp - lastFrameTimestamp;
+    lastFrameTimestamp = currentFrameTimestamp;
+
+    float cameraSpeed = 4.0f * frameDeltaTime;
+    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+        camera.moveForward(cameraSpeed);
+    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+        camera.moveBackward(cameraSpeed);
+    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+        camera.moveLeft(cameraSpeed);
+    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+        camera.moveRight(cameraSpeed);
+}
+
+void mouse_movement_callback(GLFWwindow *window, double xPos, double yPos)
+{
+    if (isFirstMouseMovement)
+    {
+        lastFrameMouseX = xPos;
+        lastFrameMouseY = yPos;
+        isFirstMouseMovement = false;
+    }
+
+   float xOffset = xPos - lastFrameMouseX;
+   float yOffset = lastFrameMouseY - yPos;
+
+   lastFrameMouseX = xPos;
+   lastFrameMouseY = yPos;
+
+   camera.processMouseMovement(xOffset, yOffset);
+}
+
+/* --headless [--frames N] [--size WxH] [--screenshot out.png] */
+HeadlessOptions parseArguments(int argc, char** argv)
+{
+    HeadlessOptions options = { false, 300, (int)width, (int)height, NULL };
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "--headless"))
+            options.enabled = true;
+        else if (!strcmp(argv[i], "--frames") && i + 1 < argc)
+            options.frames = std::max(atoi(argv[++i]), 1);
+        else if (!strcmp(argv[i], "--size") && i + 1 < argc)
+        {
+            if (sscanf(argv[++i], "%dx%d", &options.width, &options.height) != 2 || options.width <= 0 || options.height <= 0)
+            {
+                std::cout << "ERROR: DeferredDemo -> Invalid --size, expected WIDTHxHEIGHT" << std::endl;
+                options.width = width;
+                options.height = height;
+            }
+        }
+        else if (!strcmp(argv[i], "--screenshot") && i + 1 < argc)
+            options.screenshotPath = argv[++i];
+        else
+            std::cout << "WARNING: DeferredDemo -> Ignoring unknown argument " << argv[i] << std::endl;
+    }
+
+    return options;
+}
+
+void defineCube()
+{
+    float vertices[] = {
+        /* Vertex Position */ /* Normal Vector */ /* Texture Co-ordinates */
+        -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f, 0.0f,
+        0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f, 0.0f,
+        0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f, 1.0f,
+        0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f, 1.0f,
+        -0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f, 1.0f,
+        -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f, 0.0f,
+
+        -0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   0.0f, 0.0f,
+        0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   1.0f, 0.0f,
+        0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   1.0f, 1.0f,
+        0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   1.0f, 1.0f,
+        -0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   0.0f, 1.0f,
+        -0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   0.0f, 0.0f,
+
+        -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
+        -0.5f,  0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  1.0f, 1.0f,
+        -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
+        -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
+        -0.5f, -0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  0.0f, 0.0f,
+        -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
+
+        0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
+        0.5f,  0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f,
+        0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
+        0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
+        0.5f, -0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  0.0f, 0.0f,
+        0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
+
+        -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f, 1.0f,
+        0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  1.0f, 1.0f,
+        0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f, 0.0f,
+        0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f, 0.0f,
+        -0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  0.0f, 0.0f,
+        -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f, 1.0f,
+
+        -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f, 1.0f,
+        0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  1.0f, 1.0f,
+        0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f, 0.0f,
+        0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f, 0.0f,
+        -0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  0.0f, 0.0f,
+        -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f, 1.0f
+    };
+
+    unsigned int VBO;
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+
+    glBindVertexArray(VAO);
+
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 8, (void*)0);
+    glEnableVertexAttribArray(0);
+
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 8, (void*)(sizeof(float) * 3));
+    glEnableVertexAttribArray(1);
+
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 8, (void*)(sizeof(float) * 6));
+    glEnableVertexAttribArray(2);
+
+    glGenVertexArrays(1, &lightVAO);
+    glBindVertexArray(lightVAO);
+
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 8, (void*)0);
+    glEnableVertexAttribArray(0);
+}
+
+
+int main(int argc, char** argv)
+{
+    HeadlessOptions options = parseArguments(argc, argv);
+
+    // Headless runs render into the context's offscreen framebuffer instead of a window
+    GLFWwindow* window = NULL;
+    std::unique_ptr<HeadlessContext> headless;
+    const int frameWidth = options.enabled ? options.width : width;
+    const int frameHeight = options.enabled ? options.height : height;
+
+    if (options.enabled)
+    {
+        headless.reset(new HeadlessContext(frameWidth, frameHeight));
+        if (!headless->isValid())
+            return -1;
+
+        // The shaders only need 4.5 features, let them build on software rasterizers stuck at 4.5
+        GLint majorVersion = 0, minorVersion = 0;
+        glGetIntegerv(GL_MAJOR_VERSION, &majorVersion);
+        glGetIntegerv(GL_MINOR_VERSION, &minorVersion);
+        if (majorVersion * 10 + minorVersion < 46)
+            ShaderPreprocessor::versionOverride = "#version 450 core";
+    }
+    else
+    {
+        if (!glfwInit())
+            return -1;
+
+        window = glfwCreateWindow(width, height, "Deferred Shading", NULL, NULL);
+        if (!window)
+        {
+            glfwTerminate();
+            return -1;
+        }
+
+        glfwMakeContextCurrent(window);
+
+        glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+
+        glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+        glfwSetCursorPosCallback(window, mouse_movement_callback);
+
+        gladLoadGL();
+    }
+
+    const uint32_t outputFramebuffer = headless ? headless->getFramebuffer() : 0;
+
+    glEnable(GL_DEPTH_TEST);
+
+    defineCube();
+
+    JobSystem jobSystem;
+
+    Texture materialMaps;
+    std::vector<unsigned int> materialMapIDs = materialMaps.loadBatch({
+        "assets/Textures/diffuse_wood_container.png",
+        "assets/Textures/specular_wood_container.png"
+    }, jobSystem);
+
+    // Geometry pass writes surface attributes only
+    Shader geometryShader("shaders/lighting.vert", "shaders/gbuffer.frag");
+    geometryShader.use();
+    geometryShader.setInt("material.diffuse", 0);
+    geometryShader.setInt("material.specular", 1);
+    geometryShader.setFloat("material.shine", 0.4f * 128.0f);
+
+    // Lighting pass shades every pixel once from the G-buffer
+    Shader deferredShader("shaders/fullscreen.vert", "shaders/deferred.frag");
+    deferredShader.use();
+    deferredShader.setVec3("dirLight.direction", glm::vec3(-0.2f, -1.0f, -0.3f));
+    deferredShader.setVec3("dirLight.ambient", glm::vec3(0.02f, 0.02f, 0.02f));
+    deferredShader.setVec3("dirLight.diffuse", glm::vec3(0.05f, 0.05f, 0.05f));
+    deferredShader.setVec3("dirLight.specular", glm::vec3(0.1f, 0.1f, 0.1f));
+
+    Shader lampShader("shaders/lamp.vert", "shaders/lamp.frag");
+
+    World world;
+    TransformHierarchy hierarchy;
+    hierarchy.jobSystem = &jobSystem;
+
+    const MeshRef cubeMesh = { VAO, 0, 36, false };
+    const MaterialRef woodMaterial = { geometryShader.shaderProgramID, materialMapIDs[0], materialMapIDs[1], 0.4f * 128.0f };
+    const Bounds cubeBounds = { glm::vec3(0.0f), glm::vec3(0.5f) };
+
+    const float fieldExtent = FIELD_SIZE * FIELD_SPACING;
+    const glm::vec3 fieldOrigin = glm::vec3(-fieldExtent * 0.5f, -2.0f, 0.0f);
+
+    for (int x = 0; x < FIELD_SIZE; ++x)
+    for (int z = 0; z < FIELD_SIZE; ++z)
+    {
+        glm::vec3 position = fieldOrigin + glm::vec3(x, 0.0f, -z) * FIELD_SPACING;
+
+        SceneNode node = { hierarchy.createNode(InvalidNode, position) };
+        world.createEntity(Transform { position, glm::vec3(0.0f), glm::vec3(1.0f) }, node, cubeMesh, woodMaterial, cubeBounds);
+    }
+
+    // Coloured lamps with short ranges so each cluster only sees a handful of them
+    const MeshRef lampMesh = { lightVAO, 0, 36, false };
+    const MaterialRef lampMaterial = { lampShader.shaderProgramID, 0, 0, 0.0f };
+
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    for (int i = 0; i < POINT_LIGHTS; ++i)
+    {
+        glm::vec3 position = fieldOrigin + glm::vec3(unit(random) * fieldExtent, 0.5f + unit(random) * 1.5f, -unit(random) * fieldExtent);
+        glm::vec3 color = glm::vec3(unit(random), unit(random), unit(random));
+
+        const PointLight light = { color * 0.02f, color, glm::vec3(1.0f), 1.0f, 0.35f, 0.44f };
+
+        SceneNode node = { hierarchy.createNode(InvalidNode, position, glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(0.1f)) };
+        world.createEntity(Transform { position, glm::vec3(0.0f), glm::vec3(0.1f) }, node, lampMesh, lampMaterial, cubeBounds, light);
+    }
+
+    const float aspectRatio = (float)frameWidth / (float)frameHeight;
+    const glm::mat4 proj = camera.getProjectionMatrix(aspectRatio);
+
+    ClusteredLighting clusteredLighting;
+    clusteredLighting.setProjection(proj, camera.nearPlane, camera.farPlane, frameWidth, frameHeight);
+
+    GBuffer gBuffer(frameWidth, frameHeight);
+
+    // Core profile needs a bound vertex array even when the vertex shader reads no attributes
+    unsigned int fullscreenVAO;
+    glGenVertexArrays(1, &fullscreenVAO);
+
+    std::vector<Entity> visibleEntities;
+    std::vector<GpuPointLight> frameLights;
+    frameLights.reserve(POINT_LIGHTS);
+
+    // Lit geometry goes through the G-buffer, unlit lamps are drawn forward on top
+    RenderQueue geometryQueue(camera.nearPlane, camera.farPlane);
+    RenderQueue forwardQueue(camera.nearPlane, camera.farPlane);
+    CommandList commands, forwardCommands;
+    GLBackend backend;
+    FrameRingBuffer frameData(2 * 1024 * 1024);
+
+    std::vector<double> frameTimes;
+
+    for (int frame = 0; headless ? frame < options.frames : !glfwWindowShouldClose(window); ++frame)
+    {
+        uint64_t frameStart = Profiler::now();
+
+        if (window)
+            handleKeyboardEvents(window);
+
+        glm::mat4 view = camera.getViewMatrix();
+
+        deferredShader.use();
+        deferredShader.setVec3("cameraPos", camera.pos);
+
+        frameData.beginFrame();
+        glm::mat4 frameMatrices[2] = { view, proj };
+        RingAllocation frameUniforms = frameData.allocateUniform(sizeof(frameMatrices));
+        memcpy(frameUniforms.data, frameMatrices, sizeof(frameMatrices));
+
+        // Bob the lamps up and down so cluster assignment changes every frame, in fixed steps when headless
+        float time = headless ? frame / 60.0f : glfwGetTime();
+        frameLights.clear();
+        world.view<Transform, SceneNode, PointLight>().each([&](Transform &transform, SceneNode &node, PointLight &light)
+        {
+            glm::vec3 position = transform.position + glm::vec3(0.0f, sinf(time + transform.position.x), 0.0f);
+            hierarchy.setPosition(node.node, position);
+
+            GpuPointLight gpuLight;
+            gpuLight.positionRange = glm::vec4(position, ClusteredLighting::computeRange(light));
+            gpuLight.ambient = glm::vec4(light.ambient, 0.0f);
+            gpuLight.diffuse = glm::vec4(light.diffuse, 0.0f);
+            gpuLight.specular = glm::vec4(light.specular, 0.0f);
+            gpuLight.attenuation = glm::vec4(light.attConstant, light.attLinear, light.attQuadratic, 0.0f);
+            frameLights.push_back(gpuLight);
+        });
+
+        hierarchy.update();
+
+        clusteredLighting.assignLights(frameLights, view, jobSystem);
+
+        cullEntities(world, hierarchy, Frustum(proj * view), jobSystem, visibleEntities);
+
+        geometryQueue.reset();
+        forwardQueue.reset();
+        for (const Entity &entity : visibleEntities)
+        {
+            const SceneNode* node = world.getComponent<SceneNode>(entity);
+            const MeshRef* mesh = world.getComponent<MeshRef>(entity);
+            const MaterialRef* material = world.getComponent<MaterialRef>(entity);
+
+            if (!mesh || !material)
+                continue;
+
+            DrawPacket packet;
+            packet.program = material->shaderProgramID;
+            packet.vertexArray = mesh->VAO;
+            packet.diffuseMap = material->diffuseMapID;
+            packet.specularMap = material->specularMapID;
+            packet.material = 0;
+            packet.shine = 0.0f;
+            packet.first = mesh->firstVertex;
+            packet.count = mesh->vertexCount;
+            packet.indexed = mesh->indexed;
+            packet.model = hierarchy.getWorldMatrix(node->node);
+            packet.normalMatrix = hierarchy.getNormalMatrix(node->node);
+
+            float viewDepth = glm::dot(glm::vec3(packet.model[3]) - camera.pos, camera.front);
+            RenderQueue &queue = world.hasComponent<PointLight>(entity) ? forwardQueue : geometryQueue;
+            queue.submit(packet, RenderPass::Opaque, false, viewDepth);
+        }
+
+        geometryQueue.sort();
+        forwardQueue.sort();
+
+        commands.reset();
+        commands.bindBufferRange(BufferTarget::Uniform, 0, frameUniforms.buffer, frameUniforms.offset, frameUniforms.size);
+
+        // Geometry pass
+        gBuffer.beginGeometryPass(commands);
+        geometryQueue.record(commands);
+
+        // Lighting pass, one full screen triangle reading the G-buffer and the cluster lists
+        commands.bindFramebuffer(outputFramebuffer);
+        commands.setViewport(0, 0, frameWidth, frameHeight);
+        commands.setDepthState(false, false);
+        commands.clear(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+
+        clusteredLighting.upload(frameData, commands, deferredShader.shaderProgramID);
+        commands.setUniform("inverseViewProj", glm::inverse(proj * view));
+        gBuffer.bindTextures(commands);
+        commands.bindVertexArray(fullscreenVAO);
+        commands.drawArrays(PrimitiveType::Triangles, 0, 3);
+
+        backend.invalidateState();
+        backend.execute(commands);
+
+        // Lamps depth test against the scene rendered into the G-buffer
+        gBuffer.blitDepth(outputFramebuffer);
+
+        forwardCommands.reset();
+        forwardCommands.setDepthState(true, true);
+        forwardQueue.record(forwardCommands);
+        backend.execute(forwardCommands);
+
+        frameData.endFrame();
+
+        if (window)
+        {
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+            continue;
+        }
+
+        glFinish();
+        frameTimes.push_back((Profiler::now() - frameStart) / 1000000.0);
+    }
+
+    if (!headless)
+    {
+        glfwTerminate();
+        return 0;
+    }
+
+    std::cout << "Headless run at " << frameWidth << "x" << frameHeight << " on " << glGetString(GL_RENDERER) << std::endl;
+    printFrameTimeStats("Frame", computeFrameTimeStats(frameTimes));
+
+    if (options.screenshotPath)
+    {
+        std::vector<unsigned char> pixels = headless->readPixels();
+        if (!PNGWriter::write(options.screenshotPath, frameWidth, frameHeight, 4, pixels.data()))
+            return -1;
+    }
+
+    return 0;
+}
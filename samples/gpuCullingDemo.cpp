@@ -0,0 +1,354 @@
+#include <glad/glad.h>
+#include <glfw3.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <iostream>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+#include <memory>
+
+#include "../lib/Jobs/jobSystem.cpp"
+#include "../lib/Profiler/profiler.cpp"
+#include "../lib/Shader/shaderPreprocessor.cpp"
+#include "../lib/Shader/shader.cpp"
+#include "../lib/Texture/texture.cpp"
+#include "../lib/Camera/camera.cpp"
+#include "../lib/Culling/frustum.cpp"
+#include "../lib/Culling/gpuCuller.cpp"
+#include "../lib/Platform/headlessContext.cpp"
+#include "../lib/Texture/pngWriter.cpp"
+#include "../lib/Profiler/frameStats.cpp"
+
+const unsigned int width = 800, height = 600;
+Camera camera;
+
+float frameDeltaTime = 0.0f;
+float lastFrameTimestamp = 0.0f;
+
+float lastFrameMouseX = width  / 2;
+float lastFrameMouseY = height / 2;
+bool isFirstMouseMovement = true;
+
+/* Cube grid dimensions, GRID_SIZE^3 objects in total */
+const int GRID_SIZE = 24;
+const float GRID_SPACING = 3.0f;
+
+/* Command line switches for running without a window, e.g. on CI */
+struct HeadlessOptions
+{
+    bool enabled;
+    int frames;
+    int width, height;
+    const char* screenshotPath;     /* PNG of the final frame, NULL to skip */
+};
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+    glViewport(0, 0, width, height);
+}
+
+void handleKeyboardEvents(GLFWwindow *window, GpuCuller &culler)
+{
+    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+        glfwSetWindowShouldClose(window, true);
+
+    float currentFrameTimestamp = glfwGetTime();
+    frameDeltaTime = currentFrameTimestamp - lastFrameTimestamp;
+    lastFrameTimestamp = currentFrameTimestamp;
+
+    float cameraSpeed = 8.0f * frameDeltaTime;
+    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+        camera.moveForward(cameraSpeed);
+    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+        camera.moveBackward(cameraSpeed);
+    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+        camera.moveLeft(cameraSpeed);
+    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+        camera.moveRight(cameraSpeed);
+
+    /* Hold O to enable Hi-Z occlusion culling on top of frustum culling */
+    culler.occlusionCulling = glfwGetKey(window, GLFW_KEY_O) == GLFW_PRESS;
+}
+
+void mouse_movement_callback(GLFWwindow *window, double xPos, double yPos)
+{
+    if (isFirstMouseMovement)
+    {
+        lastFrameMouseX = xPos;
+        lastFrameMouseY = yPos;
+        isFirstMouseMovement = false;
+    }
+
+   float xOffset = xPos - lastFrameMouseX;
+   float yOffset = lastFrameMouseY - yPos;
+
+   lastFrameMouseX = xPos;
+   lastFrameMouseY = yPos;
+
+   camera.processMouseMovement(xOffset, yOffset);
+}
+
+/* --headless [--frames N] [--size WxH] [--screenshot out.png] */
+HeadlessOptions parseArguments(int argc, char** argv)
+{
+    HeadlessOptions options = { false, 300, (int)width, (int)height, NULL };
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "--headless"))
+            options.enabled = true;
+        else if (!strcmp(argv[i], "--frames") && i + 1 < argc)
+            options.frames = std::max(atoi(argv[++i]), 1);
+        else if (!strcmp(argv[i], "--size") && i + 1 < argc)
+        {
+            if (sscanf(argv[++i], "%dx%d", &options.width, &options.height) != 2 || options.width <= 0 || options.height <= 0)
+            {
+                std::cout << "ERROR: GpuCullingDemo -> Invalid --size, expected WIDTHxHEIGHT" << std::endl;
+                options.width = width;
+                options.height = height;
+            }
+        }
+        else if (!strcmp(argv[i], "--screenshot") && i + 1 < argc)
+            options.screenshotPath = argv[++i];
+        else
+            std::cout << "WARNING: GpuCullingDemo -> Ignoring unknown argument " << argv[i] << std::endl;
+    }
+
+    return options;
+}
+
+/* Indexed cube, multi-draw indirect requires an element buffer */
+unsigned int defineIndexedCube()
+{
+    float vertices[] = {
+        /* Positions */          /* Colors */         /* Texture Co-ords */
+        -0.5f, -0.5f, -0.5f,     1.0f, 1.0f, 1.0f,    0.0f, 0.0f,
+         0.5f, -0.5f, -0.5f,     1.0f, 1.0f, 1.0f,    1.0f, 0.0f,
+         0.5f,  0.5f, -0.5f,     1.0f, 1.0f, 1.0f,    1.0f, 1.0f,
+        -0.5f,  0.5f, -0.5f,     1.0f, 1.0f, 1.0f,    0.0f, 1.0f,
+
+        -0.5f, -0.5f,  0.5f,     1.0f, 1.0f, 1.0f,    0.0f, 0.0f,
+         0.5f, -0.5f,  0.5f,     1.0f, 1.0f, 1.0f,    1.0f, 0.0f,
+         0.5f,  0.5f,  0.5f,     1.0f, 1.0f, 1.0f,    1.0f, 1.0f,
+        -0.5f,  0.5f,  0.5f,     1.0f, 1.0f, 1.0f,    0.0f, 1.0f
+    };
+
+    unsigned int indices[] = {
+        0, 2, 1,  2, 0, 3,      /* Back */
+        4, 5, 6,  6, 7, 4,      /* Front */
+        7, 3, 0,  0, 4, 7,      /* Left */
+        6, 1, 2,  1, 6, 5,      /* Right */
+        0, 1, 5,  5, 4, 0,      /* Bottom */
+        3, 6, 2,  6, 3, 7       /* Top */
+    };
+
+    unsigned int VAO, VBO, EBO;
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    glGenBuffers(1, &EBO);
+    glBindVertexArray(VAO);
+
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 8, (void*)0);
+    glEnableVertexAttribArray(0);
+
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 8, (void*)(sizeof(float) * 3));
+    glEnableVertexAttribArray(1);
+
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 8, (void*)(sizeof(float) * 6));
+    glEnableVertexAttribArray(2);
+
+    return VAO;
+}
+
+int main(int argc, char** argv)
+{
+    HeadlessOptions options = parseArguments(argc, argv);
+
+    // Headless runs render into the context's offscreen framebuffer instead of a window
+    GLFWwindow* window = NULL;
+    std::unique_ptr<HeadlessContext> headless;
+    const int frameWidth = options.enabled ? options.width : width;
+    const int frameHeight = options.enabled ? options.height : height;
+
+    if (options.enabled)
+    {
+        headless.reset(new HeadlessContext(frameWidth, frameHeight));
+        if (!headless->isValid())
+            return -1;
+
+        // Without 4.6 the culler falls back to uncompacted draws and culled.vert to ARB_shader_draw_parameters
+        GLint majorVersion = 0, minorVersion = 0;
+        glGetIntegerv(GL_MAJOR_VERSION, &majorVersion);
+        glGetIntegerv(GL_MINOR_VERSION, &minorVersion);
+        if (majorVersion * 10 + minorVersion < 46)
+            ShaderPreprocessor::versionOverride = "#version 450 core";
+    }
+    else
+    {
+        if (!glfwInit())
+            return -1;
+
+        window = glfwCreateWindow(width, height, "GPU Culling", NULL, NULL);
+        if (!window)
+        {
+            glfwTerminate();
+            return -1;
+        }
+
+        glfwMakeContextCurrent(window);
+
+        glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+
+        glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+        glfwSetCursorPosCallback(window, mouse_movement_callback);
+
+        gladLoadGL();
+    }
+
+    const uint32_t outputFramebuffer = headless ? headless->getFramebuffer() : 0;
+
+    glEnable(GL_DEPTH_TEST);
+
+    unsigned int cubeVAO = defineIndexedCube();
+
+    /* Lay out the cube grid and its per-object data */
+    std::vector<glm::mat4> models;
+    std::vector<ObjectBounds> bounds;
+    std::vector<DrawElementsIndirectCommand> draws;
+
+    for (int x = 0; x < GRID_SIZE; ++x)
+    for (int y = 0; y < GRID_SIZE; ++y)
+    for (int z = 0; z < GRID_SIZE; ++z)
+    {
+        glm::vec3 position = glm::vec3(x, y, -z) * GRID_SPACING - glm::vec3(GRID_SIZE * GRID_SPACING * 0.5f, GRID_SIZE * GRID_SPACING * 0.5f, 0.0f);
+
+        models.push_back(glm::translate(glm::mat4(1.0f), position));
+        bounds.push_back({ glm::vec4(position, glm::length(glm::vec3(0.5f))), glm::vec4(0.5f, 0.5f, 0.5f, 0.0f) });
+        draws.push_back({ 36, 1, 0, 0, 0 });
+    }
+
+    /* Model matrices indexed with gl_BaseInstance in culled.vert */
+    unsigned int modelBuffer;
+    glGenBuffers(1, &modelBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, modelBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(glm::mat4) * models.size(), models.data(), GL_STATIC_DRAW);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, modelBuffer);
+
+    GpuCuller culler(bounds.size());
+    culler.setObjects(bounds, draws);
+
+    /* Offscreen target so last frame's depth can be read back into the Hi-Z pyramid */
+    unsigned int sceneFBO, colorTexture, depthTexture;
+    glGenFramebuffers(1, &sceneFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, sceneFBO);
+
+    glGenTextures(1, &colorTexture);
+    glBindTexture(GL_TEXTURE_2D, colorTexture);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, frameWidth, frameHeight);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
+
+    glGenTextures(1, &depthTexture);
+    glBindTexture(GL_TEXTURE_2D, depthTexture);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT32F, frameWidth, frameHeight);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "ERROR: Framebuffer -> Scene framebuffer is incomplete" << std::endl;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    Texture myTextures;
+    unsigned int woodTexture = myTextures.load("assets/Textures/wood_container.jpg");
+    unsigned int faceTexture = myTextures.load("assets/Textures/awesome_face.png");
+
+    Shader cubeShader("shaders/culled.vert", "shaders/f.frag");
+    cubeShader.use();
+    cubeShader.setInt("texture0", 0);
+    cubeShader.setInt("texture1", 1);
+
+    const float aspectRatio = (float)frameWidth / (float)frameHeight;
+
+    // Nobody holds O without a keyboard, so headless runs exercise the Hi-Z path from the second frame on
+    culler.occlusionCulling = headless != NULL;
+
+    glViewport(0, 0, frameWidth, frameHeight);
+
+    std::vector<double> frameTimes;
+
+    for (int frame = 0; headless ? frame < options.frames : !glfwWindowShouldClose(window); ++frame)
+    {
+        uint64_t frameStart = Profiler::now();
+
+        if (window)
+            handleKeyboardEvents(window, culler);
+
+        glm::mat4 viewProj = camera.getProjectionMatrix(aspectRatio) * camera.getViewMatrix();
+
+        /* Cull against this frame's frustum and last frame's Hi-Z */
+        culler.cull(viewProj);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, sceneFBO);
+        glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        cubeShader.use();
+        cubeShader.setMat4("viewProj", viewProj);
+
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, woodTexture);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, faceTexture);
+
+        glBindVertexArray(cubeVAO);
+        culler.draw();
+
+        /* Depth of this frame becomes the occluder set for the next one */
+        glBindFramebuffer(GL_FRAMEBUFFER, outputFramebuffer);
+        culler.buildHiZ(depthTexture, frameWidth, frameHeight, viewProj);
+
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, sceneFBO);
+        glBlitFramebuffer(0, 0, frameWidth, frameHeight, 0, 0, frameWidth, frameHeight, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, outputFramebuffer);
+
+        if (window)
+        {
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+            continue;
+        }
+
+        glFinish();
+        frameTimes.push_back((Profiler::now() - frameStart) / 1000000.0);
+    }
+
+    if (!headless)
+    {
+        glfwTerminate();
+        return 0;
+    }
+
+    std::cout << "Headless run at " << frameWidth << "x" << frameHeight << " on " << glGetString(GL_RENDERER) << std::endl;
+    std::cout << "Visible objects: " << culler.getVisibleCount() << " / " << bounds.size() << std::endl;
+    printFrameTimeStats("Frame", computeFrameTimeStats(frameTimes));
+
+    if (options.screenshotPath)
+    {
+        std::vector<unsigned char> pixels = headless->readPixels();
+        if (!PNGWriter::write(options.screenshotPath, frameWidth, frameHeight, 4, pixels.data()))
+            return -1;
+    }
+
+    return 0;
+}
@@ -4,11 +4,43 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <cfloat>
+#include <fstream>
 #include <iostream>
 
+#include "../lib/Jobs/jobSystem.cpp"
+#include "../lib/Profiler/profiler.cpp"
+#include "../lib/Shader/shaderPreprocessor.cpp"
 #include "../lib/Shader/shader.cpp"
+#include "../lib/Shader/shaderWatcher.cpp"
+#include "../lib/Shader/shaderCache.cpp"
 #include "../lib/Texture/texture.cpp"
 #include "../lib/Camera/camera.cpp"
+#include "../lib/ECS/ecs.cpp"
+#include "../lib/ECS/components.h"
+#include "../lib/Math/batchMath.cpp"
+#include "../lib/Scene/transformHierarchy.cpp"
+#include "../lib/Culling/frustum.cpp"
+#include "../lib/Culling/entityCuller.cpp"
+#include "../lib/Render/commandList.cpp"
+#include "../lib/Render/glBackend.cpp"
+#include "../lib/Render/renderQueue.cpp"
+#include "../lib/Render/frameRingBuffer.cpp"
+#include "../lib/Lighting/cascadedShadows.cpp"
+#include "../lib/Profiler/gpuProfiler.cpp"
+#include "../lib/Platform/mappedFile.cpp"
+#include "../lib/Platform/asyncFileReader.cpp"
+#include "../lib/Json/json.cpp"
+#include "../lib/Mesh/mesh.cpp"
+#include "../lib/Mesh/objLoader.cpp"
+#include "../lib/Mesh/meshBuffers.cpp"
+#include "../lib/Mesh/gltfLoader.cpp"
+#include "../lib/Mesh/bakedMesh.cpp"
+#include "../lib/Assets/assetPack.cpp"
+#include "../lib/Assets/assetTextures.cpp"
+
+// Must match the size of the pointLights array in lighting.frag
+#define POINT_LIGHTS 4
 
 const unsigned int width = 800, height = 600;
 Camera camera;
@@ -20,11 +52,26 @@ float lastFrameMouseX = width  / 2;
 float lastFrameMouseY = height / 2;
 bool isFirstMouseMovement = true;
 
+// Depth pre-pass is on unless P is held, to compare the two
+bool depthPrepass = true;
+
+// Camera spotlight, switches to the SPOT_LIGHT permutation of lighting.frag while F is held
+bool spotLight = false;
+
+// Pressing T writes everything profiled so far to trace.json
+bool writeTrace = false;
+bool traceKeyHeld = false;
+
 unsigned int VAO, lightVAO;
 
+// Restored after the shadow passes render into their own targets
+int framebufferWidth = width, framebufferHeight = height;
+
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
     glViewport(0, 0, width, height);
+    framebufferWidth = width;
+    framebufferHeight = height;
 }
 
 void handleKeyboardEvents(GLFWwindow *window)
@@ -45,6 +92,13 @@ void handleKeyboardEvents(GLFWwindow *window)
         camera.moveLeft(cameraSpeed);
     if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
         camera.moveRight(cameraSpeed);
+
+    depthPrepass = glfwGetKey(window, GLFW_KEY_P) != GLFW_PRESS;
+    spotLight = glfwGetKey(window, GLFW_KEY_F) == GLFW_PRESS;
+
+    bool traceKey = glfwGetKey(window, GLFW_KEY_T) == GLFW_PRESS;
+    writeTrace = traceKey && !traceKeyHeld;
+    traceKeyHeld = traceKey;
 }
 
 void mouse_movement_callback(GLFWwindow *window, double xPos, double yPos)
@@ -152,7 +206,8 @@ glm::mat4 getMVPMatrix(glm::vec3 startPos)
     return proj * view * model;
 }
 
-int main(void)
+// lightingDemo [model.obj | model.gltf | model.glb | model.bmesh]
+int main(int argc, char** argv)
 {
     GLFWwindow* window;
 
@@ -180,31 +235,210 @@ int main(void)
 
     defineCube();
 
-    Shader lightingShader("shaders/lighting.vert", "shaders/lighting.frag");
-    lightingShader.use();
-    // Light source properties
-    lightingShader.setVec3("light.ambient", glm::vec3(0.2f, 0.2f, 0.2f));
-    lightingShader.setVec3("light.diffuse", glm::vec3(0.5f, 0.5f, 0.5f));
-    lightingShader.setVec3("light.specular", glm::vec3(1.0f, 1.0f, 1.0f));
+    CascadedShadows shadows;
+
+    // Permutations of lighting.frag, compiled once and looked up by their defines
+    ShaderCache shaderCache;
+    ShaderDefines lightingDefines = { { "POINT_LIGHTS", std::to_string(POINT_LIGHTS) } };
+    if (shadows.getCascadeCount() > 0)
+        lightingDefines.push_back({ "SHADOWS", "" });
 
-    // Light attenuation parameters
-    lightingShader.setFloat("light.attConstant", 1.0f);
-    lightingShader.setFloat("light.attLinear", 0.07f);
-    lightingShader.setFloat("light.attQuadratic", 0.017f);
+    ShaderDefines spotLightDefines = lightingDefines;
+    spotLightDefines.push_back({ "SPOT_LIGHT", "" });
 
-    // Material light reflection properties
-    lightingShader.setVec3("material.specular", glm::vec3(0.628281f, 0.555802f, 0.366065f));
-    lightingShader.setFloat("material.shine", 0.4f * 128.0f);
+    Shader lightingShaders[2] = {
+        shaderCache.get("shaders/lighting.vert", "shaders/lighting.frag", lightingDefines),
+        shaderCache.get("shaders/lighting.vert", "shaders/lighting.frag", spotLightDefines)
+    };
+
+    JobSystem jobSystem;
+    AsyncFileReader fileReader(jobSystem);
+
+    // Maps come out of assets/assets.pack once it's been built with assetPacker, loose files otherwise
+    AssetPack assetPack;
+    if (std::ifstream("assets/assets.pack").good())
+        assetPack.open("assets/assets.pack");
+
+    // Read diffuse and specular maps in one batch, decoding each as it arrives
+    Texture materialMaps;
+    std::vector<unsigned int> materialMapIDs = loadTextureBatch({
+        "assets/Textures/diffuse_wood_container.png",
+        "assets/Textures/specular_wood_container.png"
+    }, assetPack, materialMaps, fileReader, jobSystem);
+
+    const unsigned int diffuseMapID = materialMapIDs[0];
+    const unsigned int specularMapID = materialMapIDs[1];
+
+    Shader lampShader = shaderCache.get("shaders/lamp.vert", "shaders/lamp.frag");
+
+    // Trivial shader laying down depth before the lighting pass
+    Shader depthShader = shaderCache.get("shaders/depth.vert", "shaders/depth.frag");
+
+    // Scene entities and the hierarchy holding their world matrices
+    World world;
+    TransformHierarchy hierarchy;
+    hierarchy.jobSystem = &jobSystem;
+
+    glm::vec3 cubePositions[] = {
+        glm::vec3( 0.0f,  0.0f,  0.0f),
+        glm::vec3( 2.0f,  5.0f, -15.0f),
+        glm::vec3(-1.5f, -2.2f, -2.5f),
+        glm::vec3(-3.8f, -2.0f, -12.3f),
+        glm::vec3( 2.4f, -0.4f, -3.5f),
+        glm::vec3(-1.7f,  3.0f, -7.5f),
+        glm::vec3( 1.3f, -2.0f, -2.5f),
+        glm::vec3( 1.5f,  2.0f, -2.5f),
+        glm::vec3( 1.5f,  0.2f, -1.5f),
+        glm::vec3(-1.3f,  1.0f, -1.5f)
+    };
 
-    // Load diffuse map texture
-    Texture diffuseMap;
-    const unsigned int diffuseMapID = diffuseMap.load("assets/Textures/diffuse_wood_container.png", 500, 500);
-    lightingShader.setInt("material.diffuse", 0);
+    const MeshRef cubeMesh = { VAO, 0, 36, false };
+    const MaterialRef woodMaterial = { lightingShaders[0].shaderProgramID, diffuseMapID, specularMapID, 0.4f * 128.0f };
+    const Bounds cubeBounds = { glm::vec3(0.0f), glm::vec3(0.5f) };
 
-    // Load specular map texture
-    Texture specularMap;
-    const unsigned int specularMapID = specularMap.load("assets/Textures/specular_wood_container.png", 500, 500);
-    lightingShader.setInt("material.specular", 1);
+    for (const glm::vec3 &position : cubePositions)
+    {
+        SceneNode node = { hierarchy.createNode(InvalidNode, position) };
+        world.createEntity(Transform { position, glm::vec3(0.0f), glm::vec3(1.0f) }, node, cubeMesh, woodMaterial, cubeBounds);
+    }
+
+    // A model given on the command line is drawn behind the cubes, fit into a 4 unit box
+    const glm::vec3 modelCenter = glm::vec3(0.0f, 0.0f, -6.0f);
+    const std::string modelPath = argc > 1 ? argv[1] : "";
+    const bool isGltf = modelPath.size() > 5 && (modelPath.compare(modelPath.size() - 5, 5, ".gltf") == 0
+                                                 || modelPath.compare(modelPath.size() - 4, 4, ".glb") == 0);
+
+    // 1x1 maps of a material's Kd / Ks, shared by every material with the same colour
+    std::unordered_map<uint32_t, unsigned int> colorMapIDs;
+    auto getColorMap = [&](const glm::vec3 &color)
+    {
+        unsigned char rgb[3];
+        for (int i = 0; i < 3; ++i)
+            rgb[i] = (unsigned char)(glm::clamp(color[i], 0.0f, 1.0f) * 255.0f + 0.5f);
+
+        unsigned int &mapID = colorMapIDs[(rgb[0] << 16) | (rgb[1] << 8) | rgb[2]];
+        if (!mapID)
+        {
+            DecodedImage pixel = { (unsigned char*)malloc(3), 1, 1, 3 };
+            memcpy(pixel.data, rgb, 3);
+            mapID = materialMaps.upload("material colour", pixel);
+        }
+        return mapID;
+    };
+
+    // Maps a material lacks come from its colours, models without materials use the wood ones
+    auto makeModelMaterial = [&](const MeshMaterial* material)
+    {
+        if (!material)
+            return MaterialRef { lightingShaders[0].shaderProgramID, diffuseMapID, specularMapID, 32.0f };
+
+        return MaterialRef {
+            lightingShaders[0].shaderProgramID,
+            material->diffuseMapID ? material->diffuseMapID : getColorMap(material->diffuse),
+            material->specularMapID ? material->specularMapID : getColorMap(material->specular),
+            material->shine
+        };
+    };
+
+    GltfModel gltfModel;
+    if (isGltf)
+    {
+        GltfLoader gltfLoader(jobSystem);
+        if (gltfLoader.load(argv[1], gltfModel, materialMaps) && !gltfModel.instances.empty())
+        {
+            // Bounds of every instance in model space
+            glm::vec3 minimum(FLT_MAX), maximum(-FLT_MAX);
+            for (const GltfInstance &instance : gltfModel.instances)
+            {
+                const Bounds &bounds = gltfModel.primitives[instance.primitive].bounds;
+                glm::vec3 center = glm::vec3(instance.transform * glm::vec4(bounds.center, 1.0f));
+                glm::vec3 extents = glm::abs(glm::mat3(instance.transform)[0]) * bounds.extents.x
+                                  + glm::abs(glm::mat3(instance.transform)[1]) * bounds.extents.y
+                                  + glm::abs(glm::mat3(instance.transform)[2]) * bounds.extents.z;
+                minimum = glm::min(minimum, center - extents);
+                maximum = glm::max(maximum, center + extents);
+            }
+
+            glm::vec3 extents = (maximum - minimum) * 0.5f;
+            float largestExtent = std::max(extents.x, std::max(extents.y, extents.z));
+            float scale = largestExtent > 0.0f ? 2.0f / largestExtent : 1.0f;
+            glm::vec3 position = modelCenter - (minimum + maximum) * 0.5f * scale;
+            NodeHandle root = hierarchy.createNode(InvalidNode, position, glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(scale));
+
+            // One entity per instance, the node transforms are decomposed back into the hierarchy's TRS
+            for (const GltfInstance &instance : gltfModel.instances)
+            {
+                const GltfPrimitive &primitive = gltfModel.primitives[instance.primitive];
+                glm::mat3 basis = glm::mat3(instance.transform);
+                glm::vec3 instanceScale = glm::vec3(glm::length(basis[0]), glm::length(basis[1]), glm::length(basis[2]));
+                glm::quat rotation = glm::quat_cast(glm::mat3(basis[0] / instanceScale.x, basis[1] / instanceScale.y, basis[2] / instanceScale.z));
+                glm::vec3 instancePosition = glm::vec3(instance.transform[3]);
+
+                SceneNode node = { hierarchy.createNode(root, instancePosition, rotation, instanceScale) };
+                const MeshMaterial* material = primitive.material == NoMaterial ? NULL : &gltfModel.materials[primitive.material];
+                world.createEntity(Transform { instancePosition, glm::eulerAngles(rotation), instanceScale }, node, primitive.mesh,
+                                   makeModelMaterial(material), primitive.bounds);
+            }
+
+            std::cout << "Loaded " << argv[1] << ": " << gltfModel.primitives.size() << " primitives, " << gltfModel.instances.size()
+                      << " instances, " << gltfModel.materials.size() << " materials" << std::endl;
+        }
+    }
+
+    // OBJ and baked meshes share one vertex array, with an entity per material
+    else if (argc > 1)
+    {
+        auto addMeshEntities = [&](const MeshBuffers &buffers, const SubMesh* subMeshes, const uint32_t subMeshCount,
+                                   const std::vector<MeshMaterial> &materials, const Bounds &bounds)
+        {
+            glm::vec3 extents = bounds.extents;
+            float largestExtent = std::max(extents.x, std::max(extents.y, extents.z));
+            float scale = largestExtent > 0.0f ? 2.0f / largestExtent : 1.0f;
+            glm::vec3 position = modelCenter - bounds.center * scale;
+
+            for (uint32_t i = 0; i < subMeshCount; ++i)
+            {
+                const MeshMaterial* material = subMeshes[i].material == NoMaterial ? NULL : &materials[subMeshes[i].material];
+
+                SceneNode node = { hierarchy.createNode(InvalidNode, position, glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(scale)) };
+                world.createEntity(Transform { position, glm::vec3(0.0f), glm::vec3(scale) }, node, makeMeshRef(buffers, subMeshes[i]),
+                                   makeModelMaterial(material), bounds);
+            }
+        };
+
+        // Baked meshes upload straight from the mapped file
+        if (modelPath.size() > 6 && modelPath.compare(modelPath.size() - 6, 6, ".bmesh") == 0)
+        {
+            BakedMesh bakedMesh;
+            if (bakedMesh.open(argv[1]))
+            {
+                const BakedMeshHeader &header = bakedMesh.getHeader();
+                std::vector<MeshMaterial> materials = bakedMesh.getMaterials();
+                loadMaterialMaps(materials, materialMaps, jobSystem);
+
+                MeshBuffers modelBuffers = uploadMesh(bakedMesh.getVertices(), header.vertexCount, bakedMesh.getIndices(), header.indexCount);
+                addMeshEntities(modelBuffers, bakedMesh.getSubMeshes(), header.subMeshCount, materials, header.bounds);
+
+                std::cout << "Loaded " << argv[1] << ": " << header.vertexCount << " vertices, " << header.indexCount / 3
+                          << " triangles, " << header.meshletCount << " meshlets, " << header.materialCount << " materials" << std::endl;
+            }
+        }
+
+        else
+        {
+            ObjLoader objLoader(jobSystem);
+            Mesh model;
+            if (objLoader.load(argv[1], model))
+            {
+                loadMaterialMaps(model.materials, materialMaps, jobSystem);
+                MeshBuffers modelBuffers = uploadMesh(model);
+                addMeshEntities(modelBuffers, model.subMeshes.data(), (uint32_t)model.subMeshes.size(), model.materials, model.bounds);
+
+                std::cout << "Loaded " << argv[1] << ": " << model.vertices.size() << " vertices, " << model.indices.size() / 3
+                          << " triangles, " << model.materials.size() << " materials" << std::endl;
+            }
+        }
+    }
 
     glm::vec3 pointLightPositions[] = {
         glm::vec3( 0.7f,  0.2f,  2.0f),
@@ -213,74 +447,123 @@ int main(void)
         glm::vec3( 0.0f,  0.0f, -3.0f)
     };
 
-    // Individual point light definitions
-    lightingShader.setVec3("pointLights[0].position", pointLightPositions[0]);
-    lightingShader.setVec3("pointLights[0].ambient", glm::vec3(0.05f, 0.05f, 0.05f));
-    lightingShader.setVec3("pointLights[0].diffuse", glm::vec3(0.8f, 0.8f, 0.8f));
-    lightingShader.setVec3("pointLights[0].specular", glm::vec3(1.0f, 1.0f, 1.0f));
-    lightingShader.setFloat("pointLights[0].attConstant", 1.0f);
-    lightingShader.setFloat("pointLights[0].attLinear", 0.09);
-    lightingShader.setFloat("pointLights[0].attQuadratic", 0.032);
-
-    lightingShader.setVec3("pointLights[1].position", pointLightPositions[1]);
-    lightingShader.setVec3("pointLights[1].ambient", glm::vec3(0.05f, 0.05f, 0.05f));
-    lightingShader.setVec3("pointLights[1].diffuse", glm::vec3(0.8f, 0.8f, 0.8f));
-    lightingShader.setVec3("pointLights[1].specular", glm::vec3(1.0f, 1.0f, 1.0f));
-    lightingShader.setFloat("pointLights[1].attConstant", 1.0f);
-    lightingShader.setFloat("pointLights[1].attLinear", 0.09);
-    lightingShader.setFloat("pointLights[1].attQuadratic", 0.032);
-
-    lightingShader.setVec3("pointLights[2].position", pointLightPositions[2]);
-    lightingShader.setVec3("pointLights[2].ambient", glm::vec3(0.05f, 0.05f, 0.05f));
-    lightingShader.setVec3("pointLights[2].diffuse",glm::vec3( 0.8f, 0.8f, 0.8f));
-    lightingShader.setVec3("pointLights[2].specular", glm::vec3(1.0f, 1.0f, 1.0f));
-    lightingShader.setFloat("pointLights[2].attConstant", 1.0f);
-    lightingShader.setFloat("pointLights[2].attLinear", 0.09);
-    lightingShader.setFloat("pointLights[2].attQuadratic", 0.032);
-
-    lightingShader.setVec3("pointLights[3].position", pointLightPositions[3]);
-    lightingShader.setVec3("pointLights[3].ambient", glm::vec3(0.05f, 0.05f, 0.05f));
-    lightingShader.setVec3("pointLights[3].diffuse", glm::vec3(0.8f, 0.8f, 0.8f));
-    lightingShader.setVec3("pointLights[3].specular", glm::vec3(1.0f, 1.0f, 1.0f));
-    lightingShader.setFloat("pointLights[3].attConstant", 1.0f);
-    lightingShader.setFloat("pointLights[3].attLinear", 0.09);
-    lightingShader.setFloat("pointLights[3].attQuadratic", 0.032);
-
-    lightingShader.setVec3("dirLight.direction", glm::vec3(-0.2f, -1.0f, -0.3f));
-    lightingShader.setVec3("dirLight.ambient", glm::vec3(0.05f, 0.05f, 0.05f));
-    lightingShader.setVec3("dirLight.diffuse", glm::vec3(0.4f, 0.4f, 0.4f));
-    lightingShader.setVec3("dirLight.specular", glm::vec3(0.5f, 0.5f, 0.5f));
-
-    Shader lampShader("shaders/lamp.vert", "shaders/lamp.frag");
+    const MeshRef lampMesh = { lightVAO, 0, 36, false };
+    const MaterialRef lampMaterial = { lampShader.shaderProgramID, 0, 0, 0.0f };
+    const PointLight lampLight = {
+        glm::vec3(0.05f, 0.05f, 0.05f), glm::vec3(0.8f, 0.8f, 0.8f), glm::vec3(1.0f, 1.0f, 1.0f),
+        1.0f, 0.09f, 0.032f
+    };
+
+    for (const glm::vec3 &position : pointLightPositions)
+    {
+        SceneNode node = { hierarchy.createNode(InvalidNode, position, glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(0.2f)) };
+        world.createEntity(Transform { position, glm::vec3(0.0f), glm::vec3(0.2f) }, node, lampMesh, lampMaterial, cubeBounds, lampLight);
+    }
+
+    const glm::vec3 dirLightDirection = glm::vec3(-0.2f, -1.0f, -0.3f);
+
+    // Uniforms that never change, applied again whenever hot reload relinks a program
+    auto applyStaticUniforms = [&](Shader lightingShader)
+    {
+        lightingShader.use();
+        // Light source properties
+        lightingShader.setVec3("light.ambient", glm::vec3(0.2f, 0.2f, 0.2f));
+        lightingShader.setVec3("light.diffuse", glm::vec3(0.5f, 0.5f, 0.5f));
+        lightingShader.setVec3("light.specular", glm::vec3(1.0f, 1.0f, 1.0f));
+
+        // Light attenuation parameters
+        lightingShader.setFloat("light.attConstant", 1.0f);
+        lightingShader.setFloat("light.attLinear", 0.07f);
+        lightingShader.setFloat("light.attQuadratic", 0.017f);
+
+        // Material maps, shine is set per draw by the render queue
+        lightingShader.setInt("material.diffuse", 0);
+        lightingShader.setInt("material.specular", 1);
+
+        // Individual point light definitions
+        int lightIndex = 0;
+        world.view<Transform, PointLight>().each([&](Transform &transform, PointLight &pointLight)
+        {
+            if (lightIndex >= POINT_LIGHTS)
+                return;
+
+            std::string name = "pointLights[" + std::to_string(lightIndex++) + "]";
+            lightingShader.setVec3(name + ".position", transform.position);
+            lightingShader.setVec3(name + ".ambient", pointLight.ambient);
+            lightingShader.setVec3(name + ".diffuse", pointLight.diffuse);
+            lightingShader.setVec3(name + ".specular", pointLight.specular);
+            lightingShader.setFloat(name + ".attConstant", pointLight.attConstant);
+            lightingShader.setFloat(name + ".attLinear", pointLight.attLinear);
+            lightingShader.setFloat(name + ".attQuadratic", pointLight.attQuadratic);
+        });
+
+        lightingShader.setVec3("dirLight.direction", dirLightDirection);
+        lightingShader.setVec3("dirLight.ambient", glm::vec3(0.05f, 0.05f, 0.05f));
+        lightingShader.setVec3("dirLight.diffuse", glm::vec3(0.4f, 0.4f, 0.4f));
+        lightingShader.setVec3("dirLight.specular", glm::vec3(0.5f, 0.5f, 0.5f));
+    };
+
+    for (const Shader &lightingShader : lightingShaders)
+        applyStaticUniforms(lightingShader);
+
+    std::vector<Entity> visibleEntities;
+
+    RenderQueue renderQueue(camera.nearPlane, camera.farPlane);
+
+    // Draws with the same shine share a material, so the queue only sets it when it changes
+    std::unordered_map<float, uint32_t> materialIDs;
+    auto getMaterialID = [&](const float shine)
+    {
+        uint32_t &materialID = materialIDs[shine];
+        if (!materialID)
+            materialID = (uint32_t)materialIDs.size();
+        return materialID;
+    };
+    renderQueue.depthOnlyProgram = depthShader.shaderProgramID;
+    CommandList commands;
+    GLBackend backend;
+    FrameRingBuffer frameData(64 * 1024);
+
+    // Saved shader edits are picked up while running, relinked programs lose their uniforms
+    shaderCache.onReload = [&](const Shader &shader)
+    {
+        // An edit can split the two permutations apart, so look them up again
+        lightingShaders[0] = shaderCache.get("shaders/lighting.vert", "shaders/lighting.frag", lightingDefines);
+        lightingShaders[1] = shaderCache.get("shaders/lighting.vert", "shaders/lighting.frag", spotLightDefines);
+
+        for (const Shader &lightingShader : lightingShaders)
+            if (lightingShader.shaderProgramID == shader.shaderProgramID)
+                applyStaticUniforms(shader);
+
+        backend.invalidateUniformLocations();
+    };
+    shaderCache.enableHotReload();
+
+    // CPU scopes are recorded by the instrumented modules, GPU ones are read back a few frames late
+    Profiler::instance().setThreadName("Main");
+    GpuProfiler gpuProfiler;
 
     while (!glfwWindowShouldClose(window))
     {
+        PROFILE_SCOPE("Frame");
+        gpuProfiler.beginFrame();
+
         handleKeyboardEvents(window);
 
+        shaderCache.update();
+
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        glm::vec3 cubePositions[] = {
-            glm::vec3( 0.0f,  0.0f,  0.0f),
-            glm::vec3( 2.0f,  5.0f, -15.0f),
-            glm::vec3(-1.5f, -2.2f, -2.5f),
-            glm::vec3(-3.8f, -2.0f, -12.3f),
-            glm::vec3( 2.4f, -0.4f, -3.5f),
-            glm::vec3(-1.7f,  3.0f, -7.5f),
-            glm::vec3( 1.3f, -2.0f, -2.5f),
-            glm::vec3( 1.5f,  2.0f, -2.5f),
-            glm::vec3( 1.5f,  0.2f, -1.5f),
-            glm::vec3(-1.3f,  1.0f, -1.5f)
-        };
-
-        glm::mat4 model, view, proj;
+        glm::mat4 view, proj;
         view = proj = glm::mat4(1.0f);
 
         view = camera.getViewMatrix();
-        proj = glm::perspective(glm::radians(45.0f), (float)(width / height), 0.1f, 100.0f);
+        // Cascades are fitted to this projection, so it has to use the real aspect ratio
+        const float aspectRatio = (float)framebufferWidth / (float)std::max(framebufferHeight, 1);
+        proj = camera.getProjectionMatrix(aspectRatio);
 
-        // glm::vec3 lightPos(sin(glfwGetTime() * 1.2f) * 2.0f, sin(glfwGetTime() * 1.2f) * 1.5f, cos(glfwGetTime() * 1.2f) * 2.0f);
-        glm::vec3 lightPos(1.0f, 2.0f, 2.0f);
+        Shader &lightingShader = lightingShaders[spotLight ? 1 : 0];
 
         lightingShader.use();
         lightingShader.setVec3("light.position", camera.pos);
@@ -290,53 +573,86 @@ int main(void)
 
         lightingShader.setVec3("cameraPos", camera.pos);
 
-        lightingShader.setMat4("view", view);
-        lightingShader.setMat4("proj", proj);
+        // Camera matrices shared by every shader through the FrameData uniform block
+        frameData.beginFrame();
+        glm::mat4 frameMatrices[2] = { view, proj };
+        RingAllocation frameUniforms = frameData.allocateUniform(sizeof(frameMatrices));
+        memcpy(frameUniforms.data, frameMatrices, sizeof(frameMatrices));
 
-        // Diffuse map
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, diffuseMapID);
+        // Only moved nodes and their descendants get new world matrices
+        hierarchy.update();
 
-        // Specular map
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, specularMapID);
+        // Frustum cull on the job system, then draw what's left
+        cullEntities(world, hierarchy, Frustum(proj * view), jobSystem, visibleEntities);
 
-        glBindVertexArray(VAO);
-
-        for(int i = 0; i < 10; ++i)
+        // Queue visible draws with sort keys so program and texture changes are grouped
+        renderQueue.reset();
+        renderQueue.depthPrepass = depthPrepass;
+        for (const Entity &entity : visibleEntities)
         {
-            model = glm::mat4(1.0f);
-            model = glm::translate(model, cubePositions[i]);
-            lightingShader.setMat4("model", model);
-
-            glDrawArrays(GL_TRIANGLES, 0, 36);
+            const SceneNode* node = world.getComponent<SceneNode>(entity);
+            const MeshRef* mesh = world.getComponent<MeshRef>(entity);
+            const MaterialRef* material = world.getComponent<MaterialRef>(entity);
+
+            if (!mesh || !material)
+                continue;
+
+            DrawPacket packet;
+            // Lit materials are authored against the base permutation, draw them with the active one
+            packet.program = material->shaderProgramID == lightingShaders[0].shaderProgramID ? lightingShader.shaderProgramID : material->shaderProgramID;
+            packet.vertexArray = mesh->VAO;
+            packet.diffuseMap = material->diffuseMapID;
+            packet.specularMap = material->specularMapID;
+            packet.material = getMaterialID(material->shine);
+            packet.shine = material->shine;
+            packet.first = mesh->firstVertex;
+            packet.count = mesh->vertexCount;
+            packet.indexed = mesh->indexed;
+            packet.model = hierarchy.getWorldMatrix(node->node);
+            packet.normalMatrix = hierarchy.getNormalMatrix(node->node);
+
+            float viewDepth = glm::dot(glm::vec3(packet.model[3]) - camera.pos, camera.front);
+            renderQueue.submit(packet, RenderPass::Opaque, false, viewDepth);
         }
 
-        lampShader.use();
-        lampShader.setMat4("view", view);
-        lampShader.setMat4("proj", proj);
+        renderQueue.sort();
 
-        // model = glm::translate(model, lightPos);
-        // model = glm::scale(model, glm::vec3(0.2f));
-        // lampShader.setMat4("model", model);
-        for(int i = 0; i < 4; ++i)
-        {
-            model = glm::mat4(1.0f);
-            model = glm::translate(model, pointLightPositions[i]);
-            model = glm::scale(model, glm::vec3(0.2f));
-            lampShader.setMat4("model", model);
+        commands.reset();
+        gpuProfiler.beginScope(commands, "Frame");
 
-            glDrawArrays(GL_TRIANGLES, 0, 36);
-        }
+        // Shadow cascades follow the camera, each culls and records its own depth pass in parallel
+        shadows.update(camera, aspectRatio, dirLightDirection);
+        gpuProfiler.beginScope(commands, "Shadows");
+        shadows.render(world, hierarchy, jobSystem, frameData, commands, depthShader.shaderProgramID);
+        gpuProfiler.endScope(commands);
+
+        gpuProfiler.beginScope(commands, "Main pass");
+        commands.setViewport(0, 0, framebufferWidth, framebufferHeight);
+        commands.bindBufferRange(BufferTarget::Uniform, 0, frameUniforms.buffer, frameUniforms.offset, frameUniforms.size);
+        shadows.apply(commands, lightingShader.shaderProgramID);
+        renderQueue.record(commands);
+        gpuProfiler.endScope(commands);
 
-        glBindVertexArray(lightVAO);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
+        gpuProfiler.endScope(commands);
+
+        // Programs were bound directly above when setting per-frame uniforms
+        backend.invalidateState();
+        backend.execute(commands);
+
+        // Fence this frame's ring segment before it gets reused
+        frameData.endFrame();
+
+        Profiler::instance().collect();
+        if (writeTrace)
+            Profiler::instance().writeChromeTrace("trace.json");
 
         glfwSwapBuffers(window);
 
         glfwPollEvents();
     }
 
+    deleteGltfModel(gltfModel);
+
     glfwTerminate();
     return 0;
 }
\ No newline at end of file
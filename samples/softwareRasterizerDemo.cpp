@@ -0,0 +1,268 @@
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+
+#include "../lib/Jobs/jobSystem.cpp"
+#include "../lib/Profiler/profiler.cpp"
+#include "../lib/Profiler/frameStats.cpp"
+#include "../lib/Texture/stb_image.cpp"
+#include "../lib/Texture/pngWriter.cpp"
+#include "../lib/Camera/camera.cpp"
+#include "../lib/ECS/ecs.cpp"
+#include "../lib/ECS/components.h"
+#include "../lib/Math/batchMath.cpp"
+#include "../lib/Scene/transformHierarchy.cpp"
+#include "../lib/Culling/frustum.cpp"
+#include "../lib/Culling/entityCuller.cpp"
+#include "../lib/Render/softwareRasterizer.cpp"
+
+/*  The lightingDemo scene rendered on the CPU, no GL context or window needed.
+    The camera orbits the cubes, frame times are printed and the last frame is saved:
+
+        softwareRasterizerDemo [--frames N] [--size WxH] [--output FILE]
+
+    Run from the repository root so the textures resolve. */
+
+// Names the scene's components refer to, there is no GL to hand them out
+const unsigned int CUBE_MESH = 1, LAMP_MESH = 2;
+const unsigned int DIFFUSE_MAP = 1, SPECULAR_MAP = 2;
+
+Camera camera;
+
+std::vector<SoftwareVertex> defineCube()
+{
+    float vertices[] = {
+        /* Vertex Position */ /* Normal Vector */ /* Texture Co-ordinates */
+        -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f, 0.0f,
+        0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f, 0.0f,
+        0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f, 1.0f,
+        0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f, 1.0f,
+        -0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f, 1.0f,
+        -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f, 0.0f,
+
+        -0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   0.0f, 0.0f,
+        0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   1.0f, 0.0f,
+        0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   1.0f, 1.0f,
+        0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   1.0f, 1.0f,
+        -0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   0.0f, 1.0f,
+        -0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   0.0f, 0.0f,
+
+        -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
+        -0.5f,  0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  1.0f, 1.0f,
+        -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
+        -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
+        -0.5f, -0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  0.0f, 0.0f,
+        -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
+
+        0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
+        0.5f,  0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f,
+        0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
+        0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
+        0.5f, -0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  0.0f, 0.0f,
+        0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
+
+        -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f, 1.0f,
+        0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  1.0f, 1.0f,
+        0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f, 0.0f,
+        0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f, 0.0f,
+        -0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  0.0f, 0.0f,
+        -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f, 1.0f,
+
+        -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f, 1.0f,
+        0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  1.0f, 1.0f,
+        0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f, 0.0f,
+        0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f, 0.0f,
+        -0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  0.0f, 0.0f,
+        -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f, 1.0f
+    };
+
+    // SoftwareVertex has the buffer's interleaved layout
+    static_assert(sizeof(SoftwareVertex) == sizeof(float) * 8, "SoftwareVertex must be tightly packed");
+
+    std::vector<SoftwareVertex> cube(sizeof(vertices) / (8 * sizeof(float)));
+    memcpy(cube.data(), vertices, sizeof(vertices));
+    return cube;
+}
+
+// Decodes bottom row first like Texture::loadBatch, so texture coordinates match the GL path
+bool loadTexture(SoftwareRasterizer &rasterizer, const unsigned int name, const char* path)
+{
+    int width, height, channels;
+    unsigned char* pixels = stbi_load(path, &width, &height, &channels, 0);
+    if (!pixels)
+    {
+        std::cout << "ERROR: SoftwareRasterizerDemo -> Failed to load texture at " << path << std::endl;
+        return false;
+    }
+
+    rasterizer.addTexture(name, width, height, channels, pixels);
+    stbi_image_free(pixels);
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    int frames = 120;
+    int width = 800, height = 600;
+    const char* outputPath = "software.png";
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "--frames") && i + 1 < argc)
+            frames = std::max(atoi(argv[++i]), 1);
+        else if (!strcmp(argv[i], "--size") && i + 1 < argc)
+        {
+            if (sscanf(argv[++i], "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0)
+            {
+                std::cout << "ERROR: SoftwareRasterizerDemo -> Invalid --size, expected WIDTHxHEIGHT" << std::endl;
+                return -1;
+            }
+        }
+        else if (!strcmp(argv[i], "--output") && i + 1 < argc)
+            outputPath = argv[++i];
+        else
+        {
+            std::cout << "ERROR: SoftwareRasterizerDemo -> Unknown argument " << argv[i] << std::endl;
+            return -1;
+        }
+    }
+
+    JobSystem jobSystem;
+    Profiler::instance().setThreadName("Main");
+
+    SoftwareRasterizer rasterizer(width, height, jobSystem);
+
+    const std::vector<SoftwareVertex> cube = defineCube();
+    rasterizer.addMesh(CUBE_MESH, cube);
+    rasterizer.addMesh(LAMP_MESH, cube);
+
+    stbi_set_flip_vertically_on_load(true);
+    if (!loadTexture(rasterizer, DIFFUSE_MAP, "assets/Textures/diffuse_wood_container.png") ||
+        !loadTexture(rasterizer, SPECULAR_MAP, "assets/Textures/specular_wood_container.png"))
+        return -1;
+
+    // Same entities as lightingDemo
+    World world;
+    TransformHierarchy hierarchy;
+    hierarchy.jobSystem = &jobSystem;
+
+    glm::vec3 cubePositions[] = {
+        glm::vec3( 0.0f,  0.0f,  0.0f),
+        glm::vec3( 2.0f,  5.0f, -15.0f),
+        glm::vec3(-1.5f, -2.2f, -2.5f),
+        glm::vec3(-3.8f, -2.0f, -12.3f),
+        glm::vec3( 2.4f, -0.4f, -3.5f),
+        glm::vec3(-1.7f,  3.0f, -7.5f),
+        glm::vec3( 1.3f, -2.0f, -2.5f),
+        glm::vec3( 1.5f,  2.0f, -2.5f),
+        glm::vec3( 1.5f,  0.2f, -1.5f),
+        glm::vec3(-1.3f,  1.0f, -1.5f)
+    };
+
+    const MeshRef cubeMesh = { CUBE_MESH, 0, 36, false };
+    const MaterialRef woodMaterial = { 0, DIFFUSE_MAP, SPECULAR_MAP, 0.4f * 128.0f };
+    const Bounds cubeBounds = { glm::vec3(0.0f), glm::vec3(0.5f) };
+
+    for (const glm::vec3 &position : cubePositions)
+    {
+        SceneNode node = { hierarchy.createNode(InvalidNode, position) };
+        world.createEntity(Transform { position, glm::vec3(0.0f), glm::vec3(1.0f) }, node, cubeMesh, woodMaterial, cubeBounds);
+    }
+
+    glm::vec3 pointLightPositions[] = {
+        glm::vec3( 0.7f,  0.2f,  2.0f),
+        glm::vec3( 2.3f, -3.3f, -4.0f),
+        glm::vec3(-4.0f,  2.0f, -12.0f),
+        glm::vec3( 0.0f,  0.0f, -3.0f)
+    };
+
+    const MeshRef lampMesh = { LAMP_MESH, 0, 36, false };
+    const MaterialRef lampMaterial = { 0, 0, 0, 0.0f };
+    const PointLight lampLight = {
+        glm::vec3(0.05f, 0.05f, 0.05f), glm::vec3(0.8f, 0.8f, 0.8f), glm::vec3(1.0f, 1.0f, 1.0f),
+        1.0f, 0.09f, 0.032f
+    };
+
+    for (const glm::vec3 &position : pointLightPositions)
+    {
+        SceneNode node = { hierarchy.createNode(InvalidNode, position, glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(0.2f)) };
+        world.createEntity(Transform { position, glm::vec3(0.0f), glm::vec3(0.2f) }, node, lampMesh, lampMaterial, cubeBounds, lampLight);
+    }
+
+    // lightingDemo's lighting.frag uniforms
+    SoftwareLighting lighting;
+    lighting.dirDirection = glm::vec3(-0.2f, -1.0f, -0.3f);
+    lighting.dirAmbient = glm::vec3(0.05f, 0.05f, 0.05f);
+    lighting.dirDiffuse = glm::vec3(0.4f, 0.4f, 0.4f);
+    lighting.dirSpecular = glm::vec3(0.5f, 0.5f, 0.5f);
+
+    world.view<Transform, PointLight>().each([&](Transform &transform, PointLight &pointLight)
+    {
+        lighting.pointLights.push_back({ transform.position, pointLight });
+    });
+
+    const glm::mat4 proj = camera.getProjectionMatrix((float)width / (float)height);
+    const glm::vec3 orbitCenter = glm::vec3(0.0f, 0.0f, -6.0f);
+
+    std::vector<Entity> visibleEntities;
+    std::vector<double> frameTimes;
+    SoftwareRasterStats totals = { 0, 0, 0, 0, 0, 0 };
+
+    for (int frame = 0; frame < frames; ++frame)
+    {
+        PROFILE_SCOPE("Frame");
+        uint64_t frameStart = Profiler::now();
+
+        // One full orbit over the run, the same path as sceneBenchmark's lighting scene
+        float angle = glm::radians(360.0f * frame / frames);
+        camera.pos = orbitCenter + glm::vec3(glm::sin(angle) * 10.0f, 2.0f, glm::cos(angle) * 10.0f);
+        camera.front = glm::normalize(orbitCenter - camera.pos);
+
+        const glm::mat4 view = camera.getViewMatrix();
+        lighting.cameraPos = camera.pos;
+
+        hierarchy.update();
+        cullEntities(world, hierarchy, Frustum(proj * view), jobSystem, visibleEntities);
+
+        rasterizer.beginFrame(view, proj, lighting);
+        for (const Entity &entity : visibleEntities)
+        {
+            const SceneNode* node = world.getComponent<SceneNode>(entity);
+            const MeshRef* mesh = world.getComponent<MeshRef>(entity);
+            const MaterialRef* material = world.getComponent<MaterialRef>(entity);
+
+            if (mesh && material)
+                rasterizer.draw(*mesh, *material, hierarchy.getWorldMatrix(node->node), hierarchy.getNormalMatrix(node->node));
+        }
+
+        SoftwareRasterStats stats = rasterizer.endFrame();
+        frameTimes.push_back((Profiler::now() - frameStart) / 1e6);
+
+        totals.draws += stats.draws;
+        totals.triangles += stats.triangles;
+        totals.trianglesRasterized += stats.trianglesRasterized;
+        totals.binnedTriangles += stats.binnedTriangles;
+        totals.blocksRejected += stats.blocksRejected;
+        totals.pixelsShaded += stats.pixelsShaded;
+
+        Profiler::instance().collect();
+    }
+
+    std::cout << "Software rasterizer, " << width << "x" << height << " on " << jobSystem.getThreadCount() << " threads" << std::endl;
+    printFrameTimeStats("Frames", computeFrameTimeStats(frameTimes));
+    printf("    per frame: %.1f draws, %.1f triangles, %.1f rasterized, %.1f binned, %.1f blocks rejected, %.0f pixels shaded\n",
+           (double)totals.draws / frames, (double)totals.triangles / frames, (double)totals.trianglesRasterized / frames,
+           (double)totals.binnedTriangles / frames, (double)totals.blocksRejected / frames, (double)totals.pixelsShaded / frames);
+
+    std::vector<unsigned char> pixels = rasterizer.readPixels();
+    if (!PNGWriter::write(outputPath, rasterizer.getWidth(), rasterizer.getHeight(), 4, pixels.data()))
+        return -1;
+
+    std::cout << "Last frame written to " << outputPath << std::endl;
+    return 0;
+}
@@ -0,0 +1,96 @@
+#version 460 core
+
+in vec3 FragPos;
+in vec3 Normal;
+in vec2 TexCoords;
+
+struct DirectedLight
+{
+    vec3 direction;
+
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+struct Material
+{
+    sampler2D diffuse;
+    sampler2D specular;
+    float shine;
+};
+
+uniform Material material;
+uniform DirectedLight dirLight;
+
+uniform vec3 cameraPos;
+
+#include "include/frameData.glsl"
+#include "include/clusters.glsl"
+
+out vec4 FragColor;
+
+vec3 applyDirectedLight(DirectedLight light, vec3 normal, vec3 viewDirection, vec3 diffuseColor, vec3 specularColor)
+{
+    vec3 lightDirection = normalize(-light.direction);
+
+    float diffuseValue = max(dot(normal, lightDirection), 0.0);
+
+    vec3 reflectDirection = reflect(-lightDirection, normal);
+    float specularValue = pow(max(dot(viewDirection, reflectDirection), 0.0), material.shine);
+
+    vec3 ambient = light.ambient * diffuseColor;
+    vec3 diffuse = light.diffuse * diffuseValue * diffuseColor;
+    vec3 specular = light.specular * specularValue * specularColor;
+
+    return (ambient + diffuse + specular);
+}
+
+vec3 applyPointLight(ClusterLight light, vec3 normal, vec3 viewDirection, vec3 diffuseColor, vec3 specularColor)
+{
+    vec3 lightDirection = light.positionRange.xyz - FragPos;
+    vec3 normalizedLightDirection = normalize(lightDirection);
+
+    // Diffuse
+    float diffuseValue = max(dot(normal, normalizedLightDirection), 0.0);
+
+    // Specular
+    vec3 reflectDirection = reflect(-normalizedLightDirection, normal);
+    float specularValue = pow(max(dot(viewDirection, reflectDirection), 0.0), material.shine);
+
+    vec3 ambient = light.ambient.xyz * diffuseColor;
+    vec3 diffuse = light.diffuse.xyz * diffuseValue * diffuseColor;
+    vec3 specular = light.specular.xyz * specularValue * specularColor;
+
+    float distanceFromLight = length(lightDirection);
+    float attenuation = 1.0 / (light.attenuation.x + (light.attenuation.y * distanceFromLight) + (light.attenuation.z * distanceFromLight * distanceFromLight));
+
+    // Fade to zero at the cluster range so lights don't pop at cluster borders
+    float window = clamp(1.0 - pow(distanceFromLight / light.positionRange.w, 4.0), 0.0, 1.0);
+    attenuation *= window * window;
+
+    return (ambient + diffuse + specular) * attenuation;
+}
+
+void main()
+{
+    vec3 normalizedNormal = normalize(Normal);
+    vec3 cameraDirection = normalize(cameraPos - FragPos);
+
+    vec3 diffuseColor = vec3(texture(material.diffuse, TexCoords));
+    vec3 specularColor = vec3(texture(material.specular, TexCoords));
+
+    vec3 result = vec3(0.0);
+
+    // Directional light
+    result += applyDirectedLight(dirLight, normalizedNormal, cameraDirection, diffuseColor, specularColor);
+
+    // Only the point lights touching this fragment's cluster
+    uvec2 range = clusterRanges[getClusterIndex(FragPos)];
+    for (uint i = 0; i < range.y; ++i)
+    {
+        result += applyPointLight(lights[lightIndices[range.x + i]], normalizedNormal, cameraDirection, diffuseColor, specularColor);
+    }
+
+    FragColor = vec4(result, 1.0);
+}
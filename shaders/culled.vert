@@ -0,0 +1,26 @@
+#version 460 core
+
+// Draw parameters are core from 4.6 on, 4.5 contexts get them from the extension
+#if __VERSION__ < 460
+#extension GL_ARB_shader_draw_parameters : require
+#define BASE_INSTANCE gl_BaseInstanceARB
+#else
+#define BASE_INSTANCE gl_BaseInstance
+#endif
+
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aColor;
+layout (location = 2) in vec2 aTexCoord;
+
+// Indexed by the baseInstance the culling pass writes into each draw command
+layout (std430, binding = 4) readonly buffer ModelMatrices { mat4 models[]; };
+
+uniform mat4 viewProj;
+
+out vec2 texCoord;
+
+void main()
+{
+   gl_Position = viewProj * models[BASE_INSTANCE] * vec4(aPos, 1.0);
+   texCoord = aTexCoord;
+}
@@ -0,0 +1,102 @@
+#version 460 core
+
+in vec2 TexCoords;
+
+struct DirectedLight
+{
+    vec3 direction;
+
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+#include "include/frameData.glsl"
+#include "include/clusters.glsl"
+
+// Bound to the units in gBuffer.h
+layout(binding = 0) uniform sampler2D gAlbedoSpecular;
+layout(binding = 1) uniform sampler2D gNormalShine;
+layout(binding = 2) uniform sampler2D gDepth;
+
+uniform DirectedLight dirLight;
+
+uniform vec3 cameraPos;
+uniform mat4 inverseViewProj;
+
+out vec4 FragColor;
+
+vec3 applyDirectedLight(DirectedLight light, vec3 normal, vec3 viewDirection, vec3 diffuseColor, vec3 specularColor, float shine)
+{
+    vec3 lightDirection = normalize(-light.direction);
+
+    float diffuseValue = max(dot(normal, lightDirection), 0.0);
+
+    vec3 reflectDirection = reflect(-lightDirection, normal);
+    float specularValue = pow(max(dot(viewDirection, reflectDirection), 0.0), shine);
+
+    vec3 ambient = light.ambient * diffuseColor;
+    vec3 diffuse = light.diffuse * diffuseValue * diffuseColor;
+    vec3 specular = light.specular * specularValue * specularColor;
+
+    return (ambient + diffuse + specular);
+}
+
+vec3 applyPointLight(ClusterLight light, vec3 fragPos, vec3 normal, vec3 viewDirection, vec3 diffuseColor, vec3 specularColor, float shine)
+{
+    vec3 lightDirection = light.positionRange.xyz - fragPos;
+    vec3 normalizedLightDirection = normalize(lightDirection);
+
+    // Diffuse
+    float diffuseValue = max(dot(normal, normalizedLightDirection), 0.0);
+
+    // Specular
+    vec3 reflectDirection = reflect(-normalizedLightDirection, normal);
+    float specularValue = pow(max(dot(viewDirection, reflectDirection), 0.0), shine);
+
+    vec3 ambient = light.ambient.xyz * diffuseColor;
+    vec3 diffuse = light.diffuse.xyz * diffuseValue * diffuseColor;
+    vec3 specular = light.specular.xyz * specularValue * specularColor;
+
+    float distanceFromLight = length(lightDirection);
+    float attenuation = 1.0 / (light.attenuation.x + (light.attenuation.y * distanceFromLight) + (light.attenuation.z * distanceFromLight * distanceFromLight));
+
+    float window = clamp(1.0 - pow(distanceFromLight / light.positionRange.w, 4.0), 0.0, 1.0);
+    attenuation *= window * window;
+
+    return (ambient + diffuse + specular) * attenuation;
+}
+
+void main()
+{
+    vec4 normalShine = texture(gNormalShine, TexCoords);
+
+    // Nothing was rasterized here
+    if (dot(normalShine.xyz, normalShine.xyz) == 0.0)
+        discard;
+
+    // World position from depth
+    float depth = texture(gDepth, TexCoords).r;
+    vec4 clipPos = vec4(vec3(TexCoords, depth) * 2.0 - 1.0, 1.0);
+    vec4 worldPos = inverseViewProj * clipPos;
+    vec3 fragPos = worldPos.xyz / worldPos.w;
+
+    vec4 albedoSpecular = texture(gAlbedoSpecular, TexCoords);
+    vec3 diffuseColor = albedoSpecular.rgb;
+    vec3 specularColor = vec3(albedoSpecular.a);
+
+    vec3 normal = normalize(normalShine.xyz);
+    vec3 cameraDirection = normalize(cameraPos - fragPos);
+    float shine = normalShine.w;
+
+    vec3 result = applyDirectedLight(dirLight, normal, cameraDirection, diffuseColor, specularColor, shine);
+
+    // Shading cost depends on pixels and lights per cluster, not on scene geometry
+    uvec2 range = clusterRanges[getClusterIndex(fragPos)];
+    for (uint i = 0; i < range.y; ++i)
+    {
+        result += applyPointLight(lights[lightIndices[range.x + i]], fragPos, normal, cameraDirection, diffuseColor, specularColor, shine);
+    }
+
+    FragColor = vec4(result, 1.0);
+}
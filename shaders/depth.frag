@@ -0,0 +1,6 @@
+#version 460 core
+
+// Depth only, color writes are masked off during the pre-pass
+void main()
+{
+}
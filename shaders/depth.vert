@@ -0,0 +1,16 @@
+#version 460 core
+
+layout (location = 0) in vec3 aPos;
+
+uniform mat4 model;
+
+#include "include/frameData.glsl"
+
+// Same expression as lighting.vert and invariant in both, so the opaque pass can depth test with GL_EQUAL
+invariant gl_Position;
+
+void main()
+{
+   vec3 fragPos = vec3(model * vec4(aPos, 1.0));
+   gl_Position = proj * view * vec4(fragPos, 1.0);
+}
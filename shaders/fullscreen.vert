@@ -0,0 +1,10 @@
+#version 460 core
+
+// One triangle covering the screen, generated from gl_VertexID so no vertex buffer is needed
+out vec2 TexCoords;
+
+void main()
+{
+    TexCoords = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    gl_Position = vec4(TexCoords * 2.0 - 1.0, 0.0, 1.0);
+}
@@ -0,0 +1,26 @@
+#version 460 core
+
+in vec3 FragPos;
+in vec3 Normal;
+in vec2 TexCoords;
+
+struct Material
+{
+    sampler2D diffuse;
+    sampler2D specular;
+    float shine;
+};
+
+uniform Material material;
+
+// Layout must match GBuffer's attachments
+layout (location = 0) out vec4 AlbedoSpecular;
+layout (location = 1) out vec4 NormalShine;
+
+void main()
+{
+    AlbedoSpecular.rgb = texture(material.diffuse, TexCoords).rgb;
+    AlbedoSpecular.a = texture(material.specular, TexCoords).r;
+
+    NormalShine = vec4(normalize(Normal), material.shine);
+}
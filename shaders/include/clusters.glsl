@@ -0,0 +1,43 @@
+// Clustered light lists, see clusteredLighting.h. Needs FrameData for the view matrix
+
+// Must match GpuPointLight in clusteredLighting.h
+struct ClusterLight
+{
+    vec4 positionRange;
+    vec4 ambient;
+    vec4 diffuse;
+    vec4 specular;
+    vec4 attenuation;
+};
+
+layout (std430, binding = 1) readonly buffer Lights
+{
+    ClusterLight lights[];
+};
+
+// (offset, count) into lightIndices for every cluster
+layout (std430, binding = 2) readonly buffer ClusterGrid
+{
+    uvec2 clusterRanges[];
+};
+
+layout (std430, binding = 3) readonly buffer LightIndices
+{
+    uint lightIndices[];
+};
+
+uniform vec4 clusterGrid;       // x, y, z cluster counts
+uniform vec4 clusterDepth;      // near, far, slices / log(far / near)
+uniform vec4 viewportSize;
+
+uint getClusterIndex(vec3 worldPos)
+{
+    float viewDepth = -(view * vec4(worldPos, 1.0)).z;
+
+    uint slice = uint(max(log(viewDepth / clusterDepth.x) * clusterDepth.z, 0.0));
+    uvec3 grid = uvec3(clusterGrid.xyz);
+    uvec2 tile = uvec2(gl_FragCoord.xy / viewportSize.xy * clusterGrid.xy);
+
+    uvec3 cluster = min(uvec3(tile, slice), grid - 1);
+    return (cluster.z * grid.y + cluster.y) * grid.x + cluster.x;
+}
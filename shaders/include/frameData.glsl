@@ -0,0 +1,6 @@
+// Per-frame camera data, written once per frame into a persistently mapped ring buffer
+layout (std140, binding = 0) uniform FrameData
+{
+    mat4 view;
+    mat4 proj;
+};
@@ -0,0 +1,41 @@
+// Cascaded shadow maps for the directional light, see cascadedShadows.h. Needs FrameData
+
+#define MAX_SHADOW_CASCADES 4
+layout (binding = 3) uniform sampler2DArrayShadow shadowMap;
+uniform mat4 lightViewProj[MAX_SHADOW_CASCADES];
+uniform vec4 cascadeSplits;
+uniform int cascadeCount;
+uniform float shadowTexelSize;
+
+float computeShadow(vec3 worldPos, vec3 normal, vec3 lightDirection)
+{
+    if (cascadeCount <= 0)
+        return 1.0;
+
+    float viewDepth = -(view * vec4(worldPos, 1.0)).z;
+    if (viewDepth > cascadeSplits[cascadeCount - 1])
+        return 1.0;
+
+    int cascade = 0;
+    while (cascade < cascadeCount - 1 && viewDepth > cascadeSplits[cascade])
+        ++cascade;
+
+    vec4 lightSpacePos = lightViewProj[cascade] * vec4(worldPos, 1.0);
+    vec3 shadowCoords = lightSpacePos.xyz / lightSpacePos.w * 0.5 + 0.5;
+
+    // Slope scaled bias against shadow acne on surfaces facing away from the light
+    float bias = max(0.002 * (1.0 - dot(normal, lightDirection)), 0.0005);
+
+    // 3x3 PCF, every tap is itself a bilinear 2x2 comparison
+    float lit = 0.0;
+    for (int x = -1; x <= 1; ++x)
+    {
+        for (int y = -1; y <= 1; ++y)
+        {
+            vec2 offset = vec2(x, y) * shadowTexelSize;
+            lit += texture(shadowMap, vec4(shadowCoords.xy + offset, cascade, shadowCoords.z - bias));
+        }
+    }
+
+    return lit / 9.0;
+}
@@ -3,10 +3,14 @@
 layout (location = 0) in vec3 aPos;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 proj;
+
+#include "include/frameData.glsl"
+
+// Matches depth.vert so lamps also pass the GL_EQUAL test after a pre-pass
+invariant gl_Position;
 
 void main()
 {
-   gl_Position = proj * view * model * vec4(aPos, 1.0);
+   vec3 fragPos = vec3(model * vec4(aPos, 1.0));
+   gl_Position = proj * view * vec4(fragPos, 1.0);
 }
\ No newline at end of file
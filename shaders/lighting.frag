@@ -53,11 +53,26 @@ uniform Material material;
 uniform Light light;
 uniform DirectedLight dirLight;
 
+// Permutation defines, injected by ShaderPreprocessor:
+//   POINT_LIGHTS   size of the pointLights array
+//   SHADOWS        cascaded shadow maps for dirLight
+//   SPOT_LIGHT     camera mounted spotlight driven by `light`
+#ifndef POINT_LIGHTS
 #define POINT_LIGHTS 4
+#endif
+
+#if POINT_LIGHTS > 0
 uniform PointLight pointLights[POINT_LIGHTS];
+#endif
 
 uniform vec3 cameraPos;
 
+#include "include/frameData.glsl"
+
+#ifdef SHADOWS
+#include "include/shadows.glsl"
+#endif
+
 out vec4 FragColor;
 
 vec3 applyDirectedLight(DirectedLight light, vec3 normal, vec3 viewDirection)
@@ -73,6 +88,13 @@ vec3 applyDirectedLight(DirectedLight light, vec3 normal, vec3 viewDirection)
     vec3 diffuse = light.diffuse * diffuseValue * vec3(texture(material.diffuse, TexCoords));
     vec3 specular = light.specular * specularValue * vec3(texture(material.specular, TexCoords));
 
+#ifdef SHADOWS
+    // Ambient stays, shadows only block direct light
+    float shadow = computeShadow(FragPos, normal, lightDirection);
+    diffuse *= shadow;
+    specular *= shadow;
+#endif
+
     return (ambient + diffuse + specular);
 }
 
@@ -101,6 +123,43 @@ vec3 applyPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDirec
     return attenuatedResult;
 }
 
+#ifdef SPOT_LIGHT
+vec3 applySpotLight(Light light, vec3 normal, vec3 fragPos, vec3 viewDirection)
+{
+    vec3 lightDirection = light.position - fragPos;
+    vec3 normalizedLightDirection = normalize(lightDirection);
+
+    float diffuseValue = max(dot(normal, normalizedLightDirection), 0.0);
+
+    vec3 reflectDirection = reflect(-normalizedLightDirection, normal);
+    float specularValue = pow(max(dot(viewDirection, reflectDirection), 0.0), material.shine);
+
+    vec3 ambient = light.ambient * vec3(texture(material.diffuse, TexCoords));
+    vec3 diffuse = light.diffuse * diffuseValue * vec3(texture(material.diffuse, TexCoords));
+    vec3 specular = light.specular * specularValue * vec3(texture(material.specular, TexCoords));
+
+    // `light.direction` is the vector from the spotlight to the exact location it is aiming at,
+    // while `normalizedLightDirection` is the normalized vector from the fragment to the spotlight position.
+    // Theta is the cosine of the angle between them (dot product)
+    float theta = dot(normalizedLightDirection, normalize(-light.direction));
+
+    // Light edge smoothing
+    float epsilon = light.cutOff - light.outerCutOff;
+
+    // Fade out the light effect by interpolating the intensity between the inner cone
+    // and the outer cone, within a range of 0-1. This maximizes the intensity inside the inner cone,
+    // does not illuminate fragments outside the outer cone, and interpolates the intensity between the two cones.
+    float intensity = clamp((theta - light.outerCutOff) / epsilon, 0.0, 1.0);
+    diffuse *= intensity;
+    specular *= intensity;
+
+    float distanceFromLight = length(lightDirection);
+    float attenuation = 1.0 / (light.attConstant + (light.attLinear * distanceFromLight) + (light.attQuadratic * distanceFromLight * distanceFromLight));
+
+    return (ambient + diffuse + specular) * attenuation;
+}
+#endif
+
 void main()
 {
     vec3 normalizedNormal = normalize(Normal);
@@ -112,28 +171,17 @@ void main()
     result += applyDirectedLight(dirLight, normalizedNormal, cameraDirection);
 
     // Point lights
+#if POINT_LIGHTS > 0
     for (int i = 0; i < POINT_LIGHTS; ++i)
     {
         result += applyPointLight(pointLights[i], normalizedNormal, FragPos, cameraDirection);
     }
+#endif
 
     // Spotlight
-    // result += applySpotLight(spotLight, normalizedNormal, FragPos, cameraDirection);
+#ifdef SPOT_LIGHT
+    result += applySpotLight(light, normalizedNormal, FragPos, cameraDirection);
+#endif
 
     FragColor = vec4(result, 1.0);
-
-    // // `light.direction` is the vector from the spotlight to the exact location it is aiming at,
-    // // while `normalizedLightDirection` is the normalized vector from the fragment to the spotlight position.
-    // // Theta is the cosine of the angle between them (dot product)
-    // float theta = dot(normalizedLightDirection, normalize(-light.direction));
-
-    // // Light edge smoothing
-    // float epsilon = light.cutOff - light.outerCutOff;
-
-    // // Fade out the light effect by interpolating the intensity between the inner cone
-    // // and the outer cone, within a range of 0-1. This maximizes the intensity inside the inner cone,
-    // // does not illuminate fragments outside the outer cone, and interpolates the intensity between the two cones.
-    // float intensity = clamp((theta - light.outerCutOff) / epsilon, 0.0, 1.0);
-    // diffuse *= intensity;
-    // specular *= intensity;
-}
\ No newline at end of file
+}
@@ -5,20 +5,26 @@ layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 proj;
+
+#include "include/frameData.glsl"
+
+// transpose(inverse(model)), precomputed per object on the CPU
+uniform mat3 normalMatrix;
 
 out vec3 FragPos;
 out vec3 Normal;
 out vec2 TexCoords;
 
+// Must produce bit-identical depth to depth.vert for the GL_EQUAL test after a pre-pass
+invariant gl_Position;
+
 void main()
 {
    FragPos = vec3(model * vec4(aPos, 1.0));
    gl_Position = proj * view * vec4(FragPos, 1.0);
    TexCoords = aTexCoords;
 
-   // Compute normal matrix to adjust for non-uniform scaling
-   // (Expensive to compute in the shader, but fine for demo purposes)
-   Normal = mat3(transpose(inverse(model))) * aNormal;
+   // Normal matrix adjusts for non-uniform scaling, not normalized here
+   // since the fragment shader renormalizes after interpolation anyway
+   Normal = normalMatrix * aNormal;
 }
\ No newline at end of file
@@ -0,0 +1,58 @@
+#include <iostream>
+#include <vector>
+#include <atomic>
+
+#include "../lib/Jobs/jobSystem.cpp"
+
+/*  Checks every job runs exactly once when a worker keeps far more jobs outstanding than its
+    deque and job pool hold, so jobs spill into the shared queue and onto the heap. Returns
+    non-zero on failure. */
+
+const uint32_t JobCount = 10000;
+
+bool checkRuns(const std::vector<std::atomic<int>> &runs, const char* name)
+{
+    for (uint32_t i = 0; i < runs.size(); ++i)
+    {
+        if (runs[i].load() != 1)
+        {
+            std::cout << "FAILED: " << name << " -> job " << i << " ran " << runs[i].load() << " times" << std::endl;
+            return false;
+        }
+    }
+
+    std::cout << "PASSED: " << name << std::endl;
+    return true;
+}
+
+int main()
+{
+    JobSystem jobSystem;
+    bool passed = true;
+
+    // Queued by the main thread, which is worker 0
+    for (int round = 0; round < 3; ++round)
+    {
+        std::vector<std::atomic<int>> runs(JobCount);
+        JobCounter counter { 0 };
+        for (uint32_t i = 0; i < JobCount; ++i)
+            jobSystem.run([&runs, i]() { runs[i].fetch_add(1); }, &counter);
+
+        jobSystem.wait(counter);
+        passed = checkRuns(runs, "Main thread") && passed;
+    }
+
+    // Queued from inside a job, on whichever worker picks it up
+    std::vector<std::atomic<int>> runs(JobCount);
+    JobCounter counter { 0 };
+    jobSystem.run([&]()
+    {
+        for (uint32_t i = 0; i < JobCount; ++i)
+            jobSystem.run([&runs, i]() { runs[i].fetch_add(1); }, &counter);
+    }, &counter);
+
+    jobSystem.wait(counter);
+    passed = checkRuns(runs, "Worker") && passed;
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,114 @@
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "../lib/Jobs/jobSystem.cpp"
+#include "../lib/Profiler/profiler.cpp"
+#include "../lib/Platform/mappedFile.cpp"
+#include "../lib/Platform/asyncFileReader.cpp"
+#include "../lib/Assets/assetPack.cpp"
+
+/*  Builds an asset pack from files and directories, or lists one:
+
+        assetPacker [--compression none|lz4|zstd] [--level N] output.pack inputs...
+        assetPacker --list input.pack
+
+    Directories are added recursively. Assets are stored under their paths as given, so
+    run it from the directory the engine runs in (e.g. `assetPacker assets.pack assets`).
+    lz4 and zstd need the tool built with -DASSET_PACK_WITH_LZ4 -llz4 / -DASSET_PACK_WITH_ZSTD -lzstd. */
+
+int listPack(const char* path)
+{
+    AssetPack pack;
+    if (!pack.open(path))
+        return -1;
+
+    for (uint32_t i = 0; i < pack.getEntryCount(); ++i)
+    {
+        const AssetPackBlob &blob = pack.getEntryBlob(i);
+        const char* compression = blob.compression == AssetCompression::LZ4 ? "lz4" : blob.compression == AssetCompression::Zstd ? "zstd" : "none";
+        std::cout << pack.getEntryPath(i) << "  " << blob.size << " -> " << blob.storedSize << " bytes (" << compression
+                  << ") at " << blob.offset << std::endl;
+    }
+
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc == 3 && !strcmp(argv[1], "--list"))
+        return listPack(argv[2]);
+
+    AssetPackWriter writer;
+    const char* outputPath = NULL;
+    std::vector<std::string> inputs;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "--compression") && i + 1 < argc)
+        {
+            std::string name = argv[++i];
+            if (name == "none")
+                writer.compression = AssetCompression::None;
+            else if (name == "lz4")
+                writer.compression = AssetCompression::LZ4;
+            else if (name == "zstd")
+                writer.compression = AssetCompression::Zstd;
+            else
+            {
+                std::cout << "ERROR: AssetPacker -> Unknown compression " << name << std::endl;
+                return -1;
+            }
+        }
+        else if (!strcmp(argv[i], "--level") && i + 1 < argc)
+            writer.level = atoi(argv[++i]);
+        else if (!outputPath)
+            outputPath = argv[i];
+        else
+            inputs.push_back(argv[i]);
+    }
+
+    if (!outputPath || inputs.empty())
+    {
+        std::cout << "Usage: assetPacker [--compression none|lz4|zstd] [--level N] output.pack inputs..." << std::endl;
+        std::cout << "       assetPacker --list input.pack" << std::endl;
+        return -1;
+    }
+
+    // Sorted so the same inputs always give the same pack. A previous build of the output is skipped
+    std::vector<std::string> files;
+    for (const std::string &input : inputs)
+    {
+        std::error_code error;
+        if (std::filesystem::is_directory(input, error))
+        {
+            for (const std::filesystem::directory_entry &entry : std::filesystem::recursive_directory_iterator(input, error))
+                if (entry.is_regular_file() && !std::filesystem::equivalent(entry.path(), outputPath, error))
+                    files.push_back(entry.path().generic_string());
+        }
+        else
+            files.push_back(input);
+    }
+    std::sort(files.begin(), files.end());
+
+    uint64_t inputBytes = 0;
+    for (const std::string &file : files)
+    {
+        if (!writer.addFile(file.c_str()))
+            return -1;
+        inputBytes += std::filesystem::file_size(file);
+    }
+
+    JobSystem jobSystem;
+    if (!writer.write(outputPath, jobSystem))
+        return -1;
+
+    std::cout << "Packed " << writer.getEntryCount() << " assets (" << writer.getBlobCount() << " distinct) from " << inputBytes
+              << " bytes into " << std::filesystem::file_size(outputPath) << " bytes: " << outputPath << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,91 @@
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <iostream>
+#include <chrono>
+#include <cstring>
+#include <string>
+
+#include "../lib/Jobs/jobSystem.cpp"
+#include "../lib/Profiler/profiler.cpp"
+#include "../lib/Texture/texture.cpp"
+#include "../lib/Platform/mappedFile.cpp"
+#include "../lib/Json/json.cpp"
+#include "../lib/Mesh/mesh.cpp"
+#include "../lib/Mesh/objLoader.cpp"
+#include "../lib/Mesh/gltfLoader.cpp"
+#include "../lib/Mesh/bakedMesh.cpp"
+
+/*  Converts an OBJ, glTF or GLB file into the engine's baked mesh format:
+
+        meshBaker input.(obj|gltf|glb) output.bmesh
+
+    glTF scenes are flattened into one mesh in world space. Material map paths are kept
+    as the loaders resolve them, relative to the working directory, so bake from the
+    directory the engine runs in. No GL context is created. */
+
+bool endsWith(const std::string &text, const char* suffix)
+{
+    size_t length = strlen(suffix);
+    return text.size() >= length && text.compare(text.size() - length, length, suffix) == 0;
+}
+
+double secondsSince(const std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 3)
+    {
+        std::cout << "Usage: meshBaker input.(obj|gltf|glb) output.bmesh" << std::endl;
+        return -1;
+    }
+
+    const std::string inputPath = argv[1];
+    JobSystem jobSystem;
+    Mesh mesh;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    bool loaded;
+    if (endsWith(inputPath, ".gltf") || endsWith(inputPath, ".glb"))
+    {
+        GltfLoader loader(jobSystem);
+        loaded = loader.loadMesh(argv[1], mesh);
+    }
+    else
+    {
+        ObjLoader loader(jobSystem);
+        loaded = loader.load(argv[1], mesh);
+    }
+
+    if (!loaded)
+        return -1;
+
+    double loadSeconds = secondsSince(start);
+    start = std::chrono::steady_clock::now();
+
+    if (!writeBakedMesh(argv[2], mesh))
+        return -1;
+
+    double bakeSeconds = secondsSince(start);
+
+    // Read it back the way the engine will, which also validates what was written
+    start = std::chrono::steady_clock::now();
+    BakedMesh baked;
+    if (!baked.open(argv[2]))
+        return -1;
+
+    double openSeconds = secondsSince(start);
+
+    const BakedMeshHeader &header = baked.getHeader();
+    std::cout << "Baked " << argv[1] << " -> " << argv[2] << ": " << header.vertexCount << " vertices, " << header.indexCount / 3
+              << " triangles, " << header.subMeshCount << " sub meshes, " << header.meshletCount << " meshlets, "
+              << header.materialCount << " materials" << std::endl;
+    std::cout << "Load " << loadSeconds * 1000.0 << " ms, bake " << bakeSeconds * 1000.0 << " ms, open baked "
+              << openSeconds * 1000.0 << " ms" << std::endl;
+
+    return 0;
+}